@@ -4,10 +4,28 @@
 
 #include "tensor.hpp"
 #include "tensor_trig.hpp"
+#include "tensor_views.hpp"
+#include "tensor_join.hpp"
+#include "tensor_random.hpp"
+#include "tensor_reductions.hpp"
+#include "tensor_linalg.hpp"
+#include "tensor_decompositions.hpp"
+#include "tensor_einsum.hpp"
+#include "tensor_conv.hpp"
+#include "tensor_fft.hpp"
+#include "tensor_sort.hpp"
+#include "tensor_scan.hpp"
+#include "tensor_histogram.hpp"
+#include "static_tensor.hpp"
 #include "operators.hpp"
 #include "tensor_indexing.hpp"
 #include "tensor_iterators.hpp"
 #include "tensor_scatter_gather.hpp"
+#include "sparse.hpp"
+#include "dyn_tensor.hpp"
+#include "tensor_mask.hpp"
+#include "ragged.hpp"
+#include "blocked.hpp"
 #include "types.hpp"
 
 // clang-format on
\ No newline at end of file
@@ -0,0 +1,477 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "operators.hpp"
+#include "tensor.hpp"
+#include "tensor_join.hpp"
+#include "tensor_reductions.hpp"
+#include "tensor_views.hpp"
+
+// Coroutine-based asynchronous execution.
+//
+// Every async_* function starts its work on an Executor and immediately returns a Task that can be co_await-ed from
+// another coroutine or waited on with get(). Each call declares which tensors it reads and writes; the executor keeps
+// the last writer and the readers since then for every buffer, so an operation waits for earlier writers of what it
+// reads and for earlier readers and writers of what it writes, and everything else runs concurrently. Ordering is
+// tracked per buffer, so all views of one buffer are ordered together.
+//
+// Tensors are captured as views sharing their buffer, not copied; synchronous writes to a tensor that still has
+// pending async operations are not ordered against them.
+namespace tt::inline v1 {
+    class Executor;
+
+    namespace detail {
+        // Completion flag of a task plus the coroutines waiting on it
+        class Completion {
+          public:
+            [[nodiscard]] auto done() const -> bool {
+                std::lock_guard lock(this->mutex_);
+                return this->done_;
+            }
+
+            // Registers h to be resumed on completion; false if already complete
+            auto add_waiter(std::coroutine_handle<> h) -> bool {
+                std::lock_guard lock(this->mutex_);
+                if (this->done_) {
+                    return false;
+                }
+                this->waiters_.push_back(h);
+                return true;
+            }
+
+            void wait() const {
+                std::unique_lock lock(this->mutex_);
+                this->cv_.wait(lock, [this] { return this->done_; });
+            }
+
+            void complete() {
+                std::vector<std::coroutine_handle<>> waiters;
+                {
+                    std::lock_guard lock(this->mutex_);
+                    this->done_ = true;
+                    waiters.swap(this->waiters_);
+                }
+                this->cv_.notify_all();
+                for (auto h : waiters) {
+                    h.resume();
+                }
+            }
+
+          private:
+            mutable std::mutex mutex_;
+            mutable std::condition_variable cv_;
+            bool done_ = false;
+            std::vector<std::coroutine_handle<>> waiters_;
+        };
+
+        // Awaiters hold plain pointers; whoever creates them keeps the completion alive across the co_await
+        struct CompletionAwaiter {
+            Completion* completion;
+
+            [[nodiscard]] auto await_ready() const -> bool {
+                return this->completion->done();
+            }
+
+            auto await_suspend(std::coroutine_handle<> h) -> bool {
+                return this->completion->add_waiter(h);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        template <typename T>
+        struct TaskState : Completion {
+            std::optional<T> value;
+            std::exception_ptr error;
+
+            auto take() -> T {
+                if (this->error) {
+                    std::rethrow_exception(this->error);
+                }
+                return std::move(*this->value);
+            }
+        };
+
+        template <>
+        struct TaskState<void> : Completion {
+            std::exception_ptr error;
+
+            void take() const {
+                if (this->error) {
+                    std::rethrow_exception(this->error);
+                }
+            }
+        };
+
+        template <typename T>
+        struct PromiseBase {
+            std::shared_ptr<TaskState<T>> state = std::make_shared<TaskState<T>>();
+
+            auto initial_suspend() noexcept -> std::suspend_never {
+                return {};
+            }
+
+            // Completing here resumes waiters before the frame is destroyed; the result lives on in the shared state
+            auto final_suspend() noexcept {
+                struct Final {
+                    TaskState<T>* state;
+
+                    auto await_ready() noexcept -> bool {
+                        this->state->complete();
+                        return true;
+                    }
+
+                    void await_suspend(std::coroutine_handle<>) noexcept {}
+
+                    void await_resume() noexcept {}
+                };
+                return Final{this->state.get()};
+            }
+
+            void unhandled_exception() {
+                this->state->error = std::current_exception();
+            }
+        };
+    }  // namespace detail
+
+    // Handle to an eagerly started coroutine. The result can be taken once, by get() or co_await.
+    template <typename T = void>
+    class Task {
+      public:
+        struct promise_type : detail::PromiseBase<T> {
+            auto get_return_object() -> Task {
+                return Task(this->state);
+            }
+
+            template <typename U>
+            void return_value(U&& value) {
+                this->state->value.emplace(std::forward<U>(value));
+            }
+        };
+
+        [[nodiscard]] auto done() const -> bool {
+            return this->state_->done();
+        }
+
+        // Blocks the calling thread; must not be called from an executor thread
+        auto get() -> T {
+            this->state_->wait();
+            return this->state_->take();
+        }
+
+        auto operator co_await() {
+            struct Awaiter : detail::CompletionAwaiter {
+                detail::TaskState<T>* state;
+
+                auto await_resume() -> T {
+                    return this->state->take();
+                }
+            };
+            return Awaiter{{this->state_.get()}, this->state_.get()};
+        }
+
+        [[nodiscard]] auto completion() const -> std::shared_ptr<detail::Completion> {
+            return this->state_;
+        }
+
+      private:
+        std::shared_ptr<detail::TaskState<T>> state_;
+
+        explicit Task(std::shared_ptr<detail::TaskState<T>> state) : state_(std::move(state)) {}
+    };
+
+    template <>
+    struct Task<void>::promise_type : detail::PromiseBase<void> {
+        auto get_return_object() -> Task {
+            return Task(this->state);
+        }
+
+        void return_void() {}
+    };
+
+    // Resumes coroutines on a fixed set of threads. Kernels called from a task still parallelize through the global
+    // thread pool.
+    class Executor {
+      public:
+        explicit Executor(int64_t num_threads = std::max<int64_t>(std::thread::hardware_concurrency(), 2)) {
+            for (int64_t t = 0; t < std::max<int64_t>(num_threads, 1); ++t) {
+                this->workers_.emplace_back([this] { this->worker(); });
+            }
+        }
+
+        Executor(const Executor&) = delete;
+        auto operator=(const Executor&) -> Executor& = delete;
+
+        // Work already queued is finished before the threads exit
+        ~Executor() {
+            {
+                std::lock_guard lock(this->mutex_);
+                this->stop_ = true;
+            }
+            this->cv_.notify_all();
+            for (auto& worker : this->workers_) {
+                worker.join();
+            }
+        }
+
+        void post(std::coroutine_handle<> h) {
+            {
+                std::lock_guard lock(this->mutex_);
+                this->queue_.push_back(h);
+            }
+            this->cv_.notify_one();
+        }
+
+        // co_await executor.schedule() continues the coroutine on one of the executor's threads
+        auto schedule() {
+            struct Awaiter {
+                Executor* executor;
+
+                [[nodiscard]] auto await_ready() const noexcept -> bool {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<> h) const {
+                    this->executor->post(h);
+                }
+
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{this};
+        }
+
+        // Starts fn() on the executor once the earlier operations touching `reads` and `writes` allow it
+        template <typename F>
+        auto launch(const std::vector<const void*>& reads, const std::vector<const void*>& writes, F fn)
+            -> Task<std::invoke_result_t<F&>> {
+            std::lock_guard lock(this->deps_mutex_);
+            std::vector<std::shared_ptr<detail::Completion>> deps;
+            for (const void* buffer : reads) {
+                auto& access = this->accesses_[buffer];
+                if (access.last_write) {
+                    deps.push_back(access.last_write);
+                }
+            }
+            for (const void* buffer : writes) {
+                auto& access = this->accesses_[buffer];
+                if (access.last_write) {
+                    deps.push_back(access.last_write);
+                }
+                deps.insert(deps.end(), access.reads.begin(), access.reads.end());
+            }
+
+            auto task = run_after(*this, std::move(deps), std::move(fn));
+            for (const void* buffer : reads) {
+                auto& access = this->accesses_[buffer];
+                std::erase_if(access.reads, [](const auto& c) { return c->done(); });
+                access.reads.push_back(task.completion());
+            }
+            for (const void* buffer : writes) {
+                auto& access = this->accesses_[buffer];
+                access.reads.clear();
+                access.last_write = task.completion();
+            }
+            this->prune();
+            return task;
+        }
+
+      private:
+        struct Access {
+            std::shared_ptr<detail::Completion> last_write;
+            std::vector<std::shared_ptr<detail::Completion>> reads;
+        };
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<std::coroutine_handle<>> queue_;
+        bool stop_ = false;
+
+        std::mutex deps_mutex_;
+        std::unordered_map<const void*, Access> accesses_;
+        size_t prune_at_ = 64;
+
+        template <typename F>
+        static auto run_after(Executor& executor, std::vector<std::shared_ptr<detail::Completion>> deps, F fn)
+            -> Task<std::invoke_result_t<F&>> {
+            for (auto& dep : deps) {
+                co_await detail::CompletionAwaiter{dep.get()};
+            }
+            co_await executor.schedule();
+            if constexpr (std::is_void_v<std::invoke_result_t<F&>>) {
+                fn();
+            } else {
+                co_return fn();
+            }
+        }
+
+        // Drops buffers whose operations have all finished, once the table has doubled since the last sweep
+        void prune() {
+            if (this->accesses_.size() < this->prune_at_) {
+                return;
+            }
+            std::erase_if(this->accesses_, [](const auto& entry) {
+                const Access& access = entry.second;
+                return (!access.last_write || access.last_write->done()) &&
+                       std::all_of(access.reads.begin(), access.reads.end(), [](const auto& c) { return c->done(); });
+            });
+            this->prune_at_ = std::max<size_t>(64, 2 * this->accesses_.size());
+        }
+
+        void worker() {
+            while (true) {
+                std::coroutine_handle<> h;
+                {
+                    std::unique_lock lock(this->mutex_);
+                    this->cv_.wait(lock, [this] { return this->stop_ || !this->queue_.empty(); });
+                    if (this->queue_.empty()) {
+                        return;
+                    }
+                    h = this->queue_.front();
+                    this->queue_.pop_front();
+                }
+                h.resume();
+            }
+        }
+    };
+
+    inline auto default_executor() -> Executor& {
+        static Executor executor;
+        return executor;
+    }
+
+    namespace detail {
+        // Identifies the buffer behind a tensor for dependency tracking
+        template <typename T>
+        auto buffer_of(const Tensor<T>& t) -> const void* {
+            return t.data() - t.storage_offset();
+        }
+
+        // A view of the whole tensor, so the task keeps the buffer alive without copying it
+        template <typename T>
+        auto alias(const Tensor<T>& t) -> Tensor<T> {
+            return t.view();
+        }
+
+        template <typename T, typename Op>
+        auto async_binary(const Tensor<T>& a, const Tensor<T>& b, Op op, Executor& ex) -> Task<Tensor<T>> {
+            if (a.shape() != b.shape()) {
+                throw std::runtime_error("Shapes are not the same");
+            }
+            return ex.launch({buffer_of(a), buffer_of(b)}, {}, [a = alias(a), b = alias(b), op] { return op(a, b); });
+        }
+    }  // namespace detail
+
+    template <typename T>
+    auto async_add(const Tensor<T>& a, const Tensor<T>& b, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return detail::async_binary(a, b, [](const auto& x, const auto& y) { return x + y; }, ex);
+    }
+
+    template <typename T>
+    auto async_sub(const Tensor<T>& a, const Tensor<T>& b, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return detail::async_binary(a, b, [](const auto& x, const auto& y) { return x - y; }, ex);
+    }
+
+    template <typename T>
+    auto async_mul(const Tensor<T>& a, const Tensor<T>& b, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return detail::async_binary(a, b, [](const auto& x, const auto& y) { return x * y; }, ex);
+    }
+
+    template <typename T>
+    auto async_div(const Tensor<T>& a, const Tensor<T>& b, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return detail::async_binary(a, b, [](const auto& x, const auto& y) { return x / y; }, ex);
+    }
+
+    // Elementwise f over a, into a new tensor
+    template <typename T, typename F>
+    auto async_map(const Tensor<T>& a, F f, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return ex.launch({detail::buffer_of(a)}, {}, [a = detail::alias(a), f] {
+            Tensor<T> result(a.shape());
+            std::transform(a.begin(), a.end(), result.data(), f);
+            return result;
+        });
+    }
+
+    // In-place elementwise f over a
+    template <typename T, typename F>
+    auto async_map_(Tensor<T>& a, F f, Executor& ex = default_executor()) -> Task<> {
+        return ex.launch({}, {detail::buffer_of(a)}, [a = detail::alias(a), f]() mutable {
+            std::transform(a.begin(), a.end(), a.begin(), f);
+        });
+    }
+
+    template <typename T>
+    auto async_sum(const Tensor<T>& a, Executor& ex = default_executor()) -> Task<T> {
+        return ex.launch({detail::buffer_of(a)}, {}, [a = detail::alias(a)] { return a.sum(); });
+    }
+
+    template <typename T>
+    auto async_sum(const Tensor<T>& a, SizeType dim, Executor& ex = default_executor()) -> Task<Tensor<T>> {
+        return ex.launch({detail::buffer_of(a)}, {}, [a = detail::alias(a), dim] { return a.sum(dim); });
+    }
+
+    template <typename T>
+    auto async_mean(const Tensor<T>& a, Executor& ex = default_executor()) -> Task<T> {
+        return ex.launch({detail::buffer_of(a)}, {}, [a = detail::alias(a)] { return a.mean(); });
+    }
+
+    template <typename T>
+    auto async_copy(const Tensor<T>& src, Tensor<T>& dst, Executor& ex = default_executor()) -> Task<> {
+        if (src.shape() != dst.shape()) {
+            throw std::runtime_error("Shapes are not the same");
+        }
+        return ex.launch({detail::buffer_of(src)}, {detail::buffer_of(dst)},
+                         [src = detail::alias(src), dst = detail::alias(dst)]() mutable {
+                             detail::copy_into(src, dst);
+                         });
+    }
+
+    // Reads numel() raw elements from the file at `offset` bytes into the contiguous tensor dst
+    template <typename T>
+    auto async_load(std::string path, Tensor<T>& dst, std::streamoff offset = 0, Executor& ex = default_executor())
+        -> Task<> {
+        if (!dst._is_contiguous()) {
+            throw std::runtime_error("async_load: tensor is not contiguous");
+        }
+        auto load = [path = std::move(path), dst = detail::alias(dst), offset]() mutable {
+            std::ifstream in(path, std::ios::binary);
+            in.seekg(offset);
+            in.read(reinterpret_cast<char*>(dst.data()), static_cast<std::streamsize>(dst.numel() * sizeof(T)));
+            if (!in) {
+                throw std::runtime_error("async_load: could not read " + path);
+            }
+        };
+        return ex.launch({}, {detail::buffer_of(dst)}, std::move(load));
+    }
+
+    // Writes the elements of src, in row-major order, to the file at path
+    template <typename T>
+    auto async_save(const Tensor<T>& src, std::string path, Executor& ex = default_executor()) -> Task<> {
+        return ex.launch({detail::buffer_of(src)}, {}, [src = detail::alias(src), path = std::move(path)] {
+            const Tensor<T> data = src._is_contiguous() ? detail::alias(src) : src.contiguous();
+            std::ofstream out(path, std::ios::binary);
+            const auto bytes = static_cast<std::streamsize>(data.numel() * sizeof(T));
+            out.write(reinterpret_cast<const char*>(data.data()), bytes);
+            if (!out) {
+                throw std::runtime_error("async_save: could not write " + path);
+            }
+        });
+    }
+};  // namespace tt::inline v1
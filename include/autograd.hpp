@@ -0,0 +1,818 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_linalg.hpp"
+
+// Reverse-mode automatic differentiation over Tensor.
+//
+// A Tape records every operation applied to its Vars. Values produced on the tape are always contiguous and live in
+// buffers drawn from a per-tape pool; backward() releases intermediate values and gradients back to that pool as soon
+// as the last operation that needs them has been differentiated. Calling reset() between iterations keeps both the
+// recorded node objects and the pooled buffers, so a training loop with a fixed graph stops allocating tensor storage
+// after the first iteration.
+namespace tt::inline v1::autograd {
+    template <typename T>
+    class Tape;
+
+    template <typename T>
+    class Var {
+      public:
+        Var() = default;
+
+        [[nodiscard]] auto value() const -> const Tensor<T>& {
+            return this->tape_->value(*this);
+        }
+
+        [[nodiscard]] auto grad() const -> const Tensor<T>& {
+            return this->tape_->grad(*this);
+        }
+
+        [[nodiscard]] auto tape() const noexcept -> Tape<T>* {
+            return this->tape_;
+        }
+
+        [[nodiscard]] auto id() const noexcept -> SizeType {
+            return this->id_;
+        }
+
+      private:
+        friend class Tape<T>;
+
+        Var(Tape<T>* tape, SizeType id) : tape_(tape), id_(id) {}
+
+        Tape<T>* tape_ = nullptr;
+        SizeType id_ = -1;
+    };
+
+    enum class Op {
+        Leaf,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Neg,
+        Sin,
+        Cos,
+        Tan,
+        Sum,
+        SumDim,
+        Mean,
+        MatMul,
+        Permute,
+        Reshape,
+        Checkpoint,
+    };
+
+    namespace detail {
+        // Free list of contiguous buffers, matched by shape first and by element count second
+        template <typename T>
+        class BufferPool {
+          public:
+            auto acquire(const IndexType& shape) -> Tensor<T> {
+                for (auto it = this->free_.rbegin(); it != this->free_.rend(); ++it) {
+                    if (it->shape() == shape) {
+                        return this->take(it);
+                    }
+                }
+                const SizeType numel = tt::cumprod(shape);
+                for (auto it = this->free_.rbegin(); it != this->free_.rend(); ++it) {
+                    if (it->numel() == numel) {
+                        Tensor<T> tensor = this->take(it);
+                        tensor.reshape_(shape);
+                        return tensor;
+                    }
+                }
+                return Tensor<T>(shape);
+            }
+
+            void release(Tensor<T>&& tensor) {
+                if (tensor.numel() > 0) {
+                    this->free_.push_back(std::move(tensor));
+                }
+            }
+
+            void clear() {
+                this->free_.clear();
+            }
+
+          private:
+            std::vector<Tensor<T>> free_;
+
+            auto take(typename std::vector<Tensor<T>>::reverse_iterator it) -> Tensor<T> {
+                Tensor<T> tensor = std::move(*it);
+                *it = std::move(this->free_.back());
+                this->free_.pop_back();
+                return tensor;
+            }
+        };
+
+        // Copies (or accumulates) the strided layout described by shape/strides at src into contiguous dst
+        template <typename T>
+        void copy_strided(const T* src, const IndexType& shape, const IndexType& strides, T* dst, bool accumulate) {
+            const auto ndim = static_cast<SizeType>(shape.size());
+            const SizeType numel = tt::cumprod(shape);
+            const SizeType inner = shape[ndim - 1];
+            const SizeType inner_stride = strides[ndim - 1];
+
+            SizeType offset = 0;
+            IndexType idx(ndim, 0);
+            for (SizeType base = 0; base < numel; base += inner) {
+                for (SizeType j = 0; j < inner; ++j) {
+                    if (accumulate) {
+                        dst[base + j] += src[offset + j * inner_stride];
+                    } else {
+                        dst[base + j] = src[offset + j * inner_stride];
+                    }
+                }
+                for (SizeType d = ndim - 2; d >= 0; --d) {
+                    offset += strides[d];
+                    if (++idx[d] < shape[d]) {
+                        break;
+                    }
+                    offset -= strides[d] * shape[d];
+                    idx[d] = 0;
+                }
+            }
+        }
+    }  // namespace detail
+
+    template <typename T>
+    class Tape {
+      public:
+        using CheckpointFn = std::function<Var<T>(Tape&, const std::vector<Var<T>>&)>;
+
+        Tape() = default;
+        Tape(const Tape&) = delete;
+        auto operator=(const Tape&) -> Tape& = delete;
+
+        ////////////////////////////////////////////////////////////////////
+        // Recording
+        ////////////////////////////////////////////////////////////////////
+        auto leaf(const Tensor<T>& value, bool requires_grad = true) -> Var<T> {
+            Tensor<T> out = this->pool_.acquire(value.shape());
+            std::copy(value.begin(), value.end(), out.data());
+            return this->push(Op::Leaf, std::move(out), requires_grad);
+        }
+
+        auto add(const Var<T>& a, const Var<T>& b) -> Var<T> {
+            return this->binary(Op::Add, a, b, std::plus<>{});
+        }
+
+        auto sub(const Var<T>& a, const Var<T>& b) -> Var<T> {
+            return this->binary(Op::Sub, a, b, std::minus<>{});
+        }
+
+        auto mul(const Var<T>& a, const Var<T>& b) -> Var<T> {
+            return this->binary(Op::Mul, a, b, std::multiplies<>{});
+        }
+
+        auto div(const Var<T>& a, const Var<T>& b) -> Var<T> {
+            return this->binary(Op::Div, a, b, std::divides<>{});
+        }
+
+        auto neg(const Var<T>& a) -> Var<T> {
+            return this->unary(Op::Neg, a, std::negate<>{});
+        }
+
+        auto sin(const Var<T>& a) -> Var<T> {
+            return this->unary(Op::Sin, a, [](T x) { return std::sin(x); });
+        }
+
+        auto cos(const Var<T>& a) -> Var<T> {
+            return this->unary(Op::Cos, a, [](T x) { return std::cos(x); });
+        }
+
+        auto tan(const Var<T>& a) -> Var<T> {
+            return this->unary(Op::Tan, a, [](T x) { return std::tan(x); });
+        }
+
+        auto sum(const Var<T>& a) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            Tensor<T> out = this->pool_.acquire({1});
+            out.data()[0] = std::reduce(in.data(), in.data() + in.numel(), T{});
+            return this->push(Op::Sum, std::move(out), a);
+        }
+
+        auto mean(const Var<T>& a) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            Tensor<T> out = this->pool_.acquire({1});
+            out.data()[0] = std::reduce(in.data(), in.data() + in.numel(), T{}) / static_cast<T>(in.numel());
+            return this->push(Op::Mean, std::move(out), a);
+        }
+
+        auto sum(const Var<T>& a, SizeType dim) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            if (dim < 0 || dim >= in.dim()) {
+                throw std::runtime_error("sum: dim out of bounds");
+            }
+            IndexType shape = in.shape();
+            shape.erase(shape.begin() + dim);
+            if (shape.empty()) {
+                shape.push_back(1);
+            }
+
+            const auto [outer, len, inner] = split_at(in.shape(), dim);
+            Tensor<T> out = this->pool_.acquire(shape);
+            const T* src = in.data();
+            T* dst = out.data();
+            std::fill(dst, dst + outer * inner, T{});
+            for (SizeType o = 0; o < outer; ++o) {
+                for (SizeType k = 0; k < len; ++k) {
+                    const T* row = src + (o * len + k) * inner;
+                    for (SizeType i = 0; i < inner; ++i) {
+                        dst[o * inner + i] += row[i];
+                    }
+                }
+            }
+            Var<T> result = this->push(Op::SumDim, std::move(out), a);
+            this->nodes_[result.id_].dim = dim;
+            return result;
+        }
+
+        auto matmul(const Var<T>& a, const Var<T>& b) -> Var<T> {
+            const Tensor<T>& lhs = this->value(a);
+            const Tensor<T>& rhs = this->value(b);
+            if (lhs.dim() != 2 || rhs.dim() != 2 || lhs.shape(1) != rhs.shape(0)) {
+                throw std::runtime_error("matmul: incompatible shapes");
+            }
+            Tensor<T> out = this->pool_.acquire({lhs.shape(0), rhs.shape(1)});
+            tt::matmul_into(lhs, rhs, out);
+            return this->push(Op::MatMul, std::move(out), a, b, true, true);
+        }
+
+        auto permute(const Var<T>& a, const IndexType& axes) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            const IndexType shape = tt::permute_vec(in.shape(), axes);
+            Tensor<T> out = this->pool_.acquire(shape);
+            detail::copy_strided(in.data(), shape, tt::permute_vec(in.strides(), axes), out.data(), false);
+            Var<T> result = this->push(Op::Permute, std::move(out), a);
+            this->nodes_[result.id_].param = axes;
+            return result;
+        }
+
+        auto reshape(const Var<T>& a, const IndexType& shape) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            if (tt::cumprod(shape) != in.numel()) {
+                throw std::runtime_error("reshape: total size of new array must be unchanged");
+            }
+            Tensor<T> out = this->pool_.acquire(shape);
+            std::copy(in.data(), in.data() + in.numel(), out.data());
+            return this->push(Op::Reshape, std::move(out), a);
+        }
+
+        // Runs fn on a private tape and records only its output. The intermediate values of fn are dropped right away
+        // and recomputed during backward(), trading one extra forward pass of fn for their memory.
+        auto checkpoint(CheckpointFn fn, const std::vector<Var<T>>& inputs) -> Var<T> {
+            bool requires_grad = false;
+            for (const auto& input : inputs) {
+                this->check_owned(input);
+                requires_grad = requires_grad || this->nodes_[input.id_].requires_grad;
+            }
+
+            SizeType id = this->next_node();
+            Node& node = this->nodes_[id];
+            node.op = Op::Checkpoint;
+            if (!node.sub) {
+                node.sub = std::make_unique<Tape>();
+            }
+            node.fn = std::move(fn);
+            node.inputs.clear();
+            for (const auto& input : inputs) {
+                node.inputs.push_back(input.id_);
+                this->nodes_[input.id_].pending++;
+            }
+
+            Tape& sub = *node.sub;
+            Var<T> out = sub.replay(*this, node);
+            node.value = this->pool_.acquire(sub.value(out).shape());
+            std::copy(sub.value(out).data(), sub.value(out).data() + sub.value(out).numel(), node.value.data());
+            node.shape = node.value.shape();
+            node.requires_grad = requires_grad;
+            sub.reset();
+            return {this, id};
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Differentiation
+        ////////////////////////////////////////////////////////////////////
+
+        // Accumulates d(root)/d(leaf) into the gradient of every leaf that requires it. The root is seeded with ones,
+        // so for a non-scalar root this computes the gradient of root.sum(). Intermediate values are released on the
+        // way, so a graph can only be differentiated once; a second backward() through it throws.
+        void backward(const Var<T>& root) {
+            this->check_owned(root);
+            Node& node = this->nodes_[root.id_];
+            if (!node.requires_grad) {
+                throw std::runtime_error("backward: root does not require grad");
+            }
+            this->check_retained(root.id_);
+            this->acquire_grad(node);
+            std::fill(node.grad.data(), node.grad.data() + node.grad.numel(), static_cast<T>(1));
+            this->run_backward(root.id_);
+        }
+
+        // Same as backward(), but seeds the root with the given gradient instead of ones
+        void backward(const Var<T>& root, const Tensor<T>& seed) {
+            this->check_owned(root);
+            Node& node = this->nodes_[root.id_];
+            if (seed.shape() != node.shape) {
+                throw std::runtime_error("backward: seed has the wrong shape");
+            }
+            if (!node.requires_grad) {
+                return;
+            }
+            this->check_retained(root.id_);
+            this->acquire_grad(node);
+            std::copy(seed.begin(), seed.end(), node.grad.data());
+            this->run_backward(root.id_);
+        }
+
+        [[nodiscard]] auto value(const Var<T>& v) const -> const Tensor<T>& {
+            this->check_owned(v);
+            const Node& node = this->nodes_[v.id_];
+            if (!node.has_value) {
+                throw std::runtime_error("value: the value of this variable was released by backward()");
+            }
+            return node.value;
+        }
+
+        [[nodiscard]] auto grad(const Var<T>& v) const -> const Tensor<T>& {
+            this->check_owned(v);
+            const Node& node = this->nodes_[v.id_];
+            if (!node.has_grad) {
+                throw std::runtime_error("grad: no gradient has been computed for this variable");
+            }
+            return node.grad;
+        }
+
+        [[nodiscard]] auto size() const noexcept -> SizeType {
+            return this->size_;
+        }
+
+        // Forgets every recorded operation. Node objects and buffers are kept for the next recording.
+        void reset() {
+            for (SizeType i = 0; i < this->size_; ++i) {
+                Node& node = this->nodes_[i];
+                this->release_value(node);
+                this->release_grad(node);
+            }
+            this->size_ = 0;
+        }
+
+        // Returns all pooled memory to the system
+        void shrink() {
+            this->reset();
+            this->pool_.clear();
+            for (auto& node : this->nodes_) {
+                if (node.sub) {
+                    node.sub->shrink();
+                }
+            }
+        }
+
+      private:
+        struct Node {
+            Op op = Op::Leaf;
+            SizeType lhs = -1;
+            SizeType rhs = -1;
+            SizeType dim = 0;
+            IndexType shape;
+            IndexType param;
+
+            Tensor<T> value;
+            Tensor<T> grad;
+            bool has_value = false;
+            bool has_grad = false;
+            bool requires_grad = false;
+
+            // number of backward steps that still need this node's value
+            SizeType pending = 0;
+
+            CheckpointFn fn;
+            std::vector<SizeType> inputs;
+            std::unique_ptr<Tape> sub;
+        };
+
+        std::vector<Node> nodes_;
+        SizeType size_ = 0;
+        detail::BufferPool<T> pool_;
+
+        void check_owned(const Var<T>& v) const {
+            if (v.tape_ != this || v.id_ < 0 || v.id_ >= this->size_) {
+                throw std::runtime_error("autograd: variable does not belong to this tape");
+            }
+        }
+
+        // backward() returns the values of differentiated intermediate nodes to the pool, so a graph can be
+        // differentiated once. Checked up front, before any gradient is touched: every operation the root depends
+        // on must still hold its value.
+        void check_retained(SizeType root) const {
+            std::vector<bool> reached(static_cast<size_t>(root + 1), false);
+            reached[static_cast<size_t>(root)] = true;
+            for (SizeType id = root; id >= 0; --id) {
+                const Node& node = this->nodes_[id];
+                if (!reached[static_cast<size_t>(id)] || node.op == Op::Leaf) {
+                    continue;
+                }
+                if (!node.has_value) {
+                    throw std::runtime_error(
+                        "backward: values needed for the gradient were released by an earlier backward(); record the "
+                        "computation again to differentiate it again");
+                }
+                for (const SizeType input : {node.lhs, node.rhs}) {
+                    if (input >= 0) {
+                        reached[static_cast<size_t>(input)] = true;
+                    }
+                }
+                for (const SizeType input : node.inputs) {
+                    reached[static_cast<size_t>(input)] = true;
+                }
+            }
+        }
+
+        auto next_node() -> SizeType {
+            if (this->size_ == static_cast<SizeType>(this->nodes_.size())) {
+                this->nodes_.emplace_back();
+            }
+            Node& node = this->nodes_[this->size_];
+            node.lhs = -1;
+            node.rhs = -1;
+            node.dim = 0;
+            node.has_value = true;
+            node.has_grad = false;
+            node.pending = 0;
+            return this->size_++;
+        }
+
+        auto push(Op op, Tensor<T>&& value, bool requires_grad) -> Var<T> {
+            SizeType id = this->next_node();
+            Node& node = this->nodes_[id];
+            node.op = op;
+            node.shape = value.shape();
+            node.value = std::move(value);
+            node.requires_grad = requires_grad;
+            return {this, id};
+        }
+
+        // Records an op on its operands; the *_value flags mark which operand values its backward step reads
+        auto push(Op op, Tensor<T>&& value, const Var<T>& a, bool lhs_value = false) -> Var<T> {
+            return this->push(op, std::move(value), a, Var<T>(), lhs_value, false);
+        }
+
+        auto push(Op op, Tensor<T>&& value, const Var<T>& a, const Var<T>& b, bool lhs_value, bool rhs_value)
+            -> Var<T> {
+            bool requires_grad = this->nodes_[a.id_].requires_grad;
+            if (lhs_value) {
+                this->nodes_[a.id_].pending++;
+            }
+            if (b.tape_ != nullptr) {
+                requires_grad = requires_grad || this->nodes_[b.id_].requires_grad;
+                if (rhs_value) {
+                    this->nodes_[b.id_].pending++;
+                }
+            }
+            Var<T> result = this->push(op, std::move(value), requires_grad);
+            Node& node = this->nodes_[result.id_];
+            node.lhs = a.id_;
+            node.rhs = b.tape_ != nullptr ? b.id_ : -1;
+            if (op == Op::Tan) {
+                node.pending++;
+            }
+            return result;
+        }
+
+        template <typename F>
+        auto unary(Op op, const Var<T>& a, F f) -> Var<T> {
+            const Tensor<T>& in = this->value(a);
+            Tensor<T> out = this->pool_.acquire(in.shape());
+            std::transform(in.data(), in.data() + in.numel(), out.data(), f);
+            return this->push(op, std::move(out), a, op == Op::Sin || op == Op::Cos);
+        }
+
+        template <typename F>
+        auto binary(Op op, const Var<T>& a, const Var<T>& b, F f) -> Var<T> {
+            const Tensor<T>& lhs = this->value(a);
+            const Tensor<T>& rhs = this->value(b);
+            if (lhs.shape() != rhs.shape()) {
+                throw std::runtime_error("Shapes are not the same");
+            }
+            Tensor<T> out = this->pool_.acquire(lhs.shape());
+            std::transform(lhs.data(), lhs.data() + lhs.numel(), rhs.data(), out.data(), f);
+            const bool saves = op == Op::Mul || op == Op::Div;
+            return this->push(op, std::move(out), a, b, saves, saves);
+        }
+
+        // Re-runs a checkpointed function on this (sub) tape, reading its inputs from the parent tape
+        auto replay(Tape& parent, const Node& node) -> Var<T> {
+            this->reset();
+            std::vector<Var<T>> leaves;
+            leaves.reserve(node.inputs.size());
+            for (SizeType input : node.inputs) {
+                const Node& in = parent.nodes_[input];
+                leaves.push_back(this->leaf(in.value, in.requires_grad));
+            }
+            return node.fn(*this, leaves);
+        }
+
+        static auto split_at(const IndexType& shape, SizeType dim) -> std::tuple<SizeType, SizeType, SizeType> {
+            SizeType outer = 1;
+            SizeType inner = 1;
+            for (SizeType i = 0; i < dim; ++i) {
+                outer *= shape[i];
+            }
+            for (SizeType i = dim + 1; i < static_cast<SizeType>(shape.size()); ++i) {
+                inner *= shape[i];
+            }
+            return {outer, shape[dim], inner};
+        }
+
+        void acquire_grad(Node& node) {
+            if (!node.has_grad) {
+                node.grad = this->pool_.acquire(node.shape);
+                node.has_grad = true;
+            }
+        }
+
+        void release_value(Node& node) {
+            if (node.has_value) {
+                this->pool_.release(std::move(node.value));
+                node.has_value = false;
+            }
+        }
+
+        void release_grad(Node& node) {
+            if (node.has_grad) {
+                this->pool_.release(std::move(node.grad));
+                node.has_grad = false;
+            }
+        }
+
+        void consume(SizeType id) {
+            Node& node = this->nodes_[id];
+            if (--node.pending == 0 && node.op != Op::Leaf) {
+                this->release_value(node);
+            }
+        }
+
+        // Calls kernel(dst, overwrite) on the gradient buffer of node id. The first contribution overwrites the
+        // freshly acquired buffer, later ones accumulate in place.
+        template <typename F>
+        void accumulate(SizeType id, F kernel) {
+            Node& node = this->nodes_[id];
+            if (!node.requires_grad) {
+                return;
+            }
+            const bool overwrite = !node.has_grad;
+            this->acquire_grad(node);
+            kernel(node.grad.data(), overwrite);
+        }
+
+        template <typename F>
+        void accumulate_each(SizeType id, SizeType n, F f) {
+            this->accumulate(id, [n, &f](T* dst, bool overwrite) {
+                if (overwrite) {
+                    for (SizeType i = 0; i < n; ++i) {
+                        dst[i] = f(i);
+                    }
+                } else {
+                    for (SizeType i = 0; i < n; ++i) {
+                        dst[i] += f(i);
+                    }
+                }
+            });
+        }
+
+        void run_backward(SizeType root) {
+            for (SizeType id = root; id >= 0; --id) {
+                Node& node = this->nodes_[id];
+                if (node.op == Op::Leaf) {
+                    continue;
+                }
+                if (node.has_grad) {
+                    this->backward_node(node);
+                }
+                // the root keeps its value, everything else is returned to the pool once differentiated
+                if (id != root && node.pending == 0) {
+                    this->release_value(node);
+                }
+                this->release_grad(node);
+            }
+        }
+
+        void backward_node(Node& node) {
+            const T* g = node.grad.data();
+            const SizeType n = node.grad.numel();
+
+            switch (node.op) {
+                case Op::Leaf:
+                    break;
+                case Op::Add:
+                    this->accumulate_each(node.lhs, n, [g](SizeType i) { return g[i]; });
+                    this->accumulate_each(node.rhs, n, [g](SizeType i) { return g[i]; });
+                    break;
+                case Op::Sub:
+                    this->accumulate_each(node.lhs, n, [g](SizeType i) { return g[i]; });
+                    this->accumulate_each(node.rhs, n, [g](SizeType i) { return -g[i]; });
+                    break;
+                case Op::Mul: {
+                    const T* a = this->nodes_[node.lhs].value.data();
+                    const T* b = this->nodes_[node.rhs].value.data();
+                    this->accumulate_each(node.lhs, n, [g, b](SizeType i) { return g[i] * b[i]; });
+                    this->accumulate_each(node.rhs, n, [g, a](SizeType i) { return g[i] * a[i]; });
+                    this->consume(node.lhs);
+                    this->consume(node.rhs);
+                    break;
+                }
+                case Op::Div: {
+                    const T* a = this->nodes_[node.lhs].value.data();
+                    const T* b = this->nodes_[node.rhs].value.data();
+                    this->accumulate_each(node.lhs, n, [g, b](SizeType i) { return g[i] / b[i]; });
+                    this->accumulate_each(node.rhs, n, [g, a, b](SizeType i) { return -g[i] * a[i] / (b[i] * b[i]); });
+                    this->consume(node.lhs);
+                    this->consume(node.rhs);
+                    break;
+                }
+                case Op::Neg:
+                    this->accumulate_each(node.lhs, n, [g](SizeType i) { return -g[i]; });
+                    break;
+                case Op::Sin: {
+                    const T* x = this->nodes_[node.lhs].value.data();
+                    this->accumulate_each(node.lhs, n, [g, x](SizeType i) { return g[i] * std::cos(x[i]); });
+                    this->consume(node.lhs);
+                    break;
+                }
+                case Op::Cos: {
+                    const T* x = this->nodes_[node.lhs].value.data();
+                    this->accumulate_each(node.lhs, n, [g, x](SizeType i) { return -g[i] * std::sin(x[i]); });
+                    this->consume(node.lhs);
+                    break;
+                }
+                case Op::Tan: {
+                    const T* y = node.value.data();
+                    this->accumulate_each(node.lhs, n, [g, y](SizeType i) { return g[i] * (1 + y[i] * y[i]); });
+                    node.pending--;
+                    break;
+                }
+                case Op::Sum: {
+                    const T s = g[0];
+                    this->accumulate_each(node.lhs, tt::cumprod(this->nodes_[node.lhs].shape),
+                                          [s](SizeType) { return s; });
+                    break;
+                }
+                case Op::Mean: {
+                    const SizeType count = tt::cumprod(this->nodes_[node.lhs].shape);
+                    const T s = g[0] / static_cast<T>(count);
+                    this->accumulate_each(node.lhs, count, [s](SizeType) { return s; });
+                    break;
+                }
+                case Op::SumDim: {
+                    const auto [outer, len, inner] = split_at(this->nodes_[node.lhs].shape, node.dim);
+                    const SizeType row = len * inner;
+                    const SizeType cols = inner;
+                    this->accumulate_each(node.lhs, outer * row, [g, row, cols](SizeType i) {
+                        return g[(i / row) * cols + i % cols];
+                    });
+                    break;
+                }
+                case Op::MatMul: {
+                    const Node& lhs = this->nodes_[node.lhs];
+                    const Node& rhs = this->nodes_[node.rhs];
+                    const SizeType M = lhs.shape[0];
+                    const SizeType K = lhs.shape[1];
+                    const SizeType N = rhs.shape[1];
+                    const T* a = lhs.value.data();
+                    const T* b = rhs.value.data();
+                    // dA = dC * B^T, dB = A^T * dC. B^T is packed into a pooled buffer first: gemm only tiles and
+                    // parallelizes when the right operand has unit column stride.
+                    this->accumulate(node.lhs, [&](T* dst, bool overwrite) {
+                        Tensor<T> bt = this->pool_.acquire({N, K});
+                        tt::detail::transpose_into(b, K, N, bt.data());
+                        tt::detail::gemm(M, K, N, g, N, 1, bt.data(), K, 1, dst, K, 1, !overwrite);
+                        this->pool_.release(std::move(bt));
+                    });
+                    this->accumulate(node.rhs, [&](T* dst, bool overwrite) {
+                        tt::detail::gemm(K, N, M, a, 1, K, g, N, 1, dst, N, 1, !overwrite);
+                    });
+                    this->consume(node.lhs);
+                    this->consume(node.rhs);
+                    break;
+                }
+                case Op::Permute: {
+                    // the gradient of the input is the output gradient viewed through the inverse permutation
+                    const IndexType& axes = node.param;
+                    const IndexType& in_shape = this->nodes_[node.lhs].shape;
+                    const IndexType g_strides = tt::calc_strides(node.shape);
+                    IndexType strides(axes.size());
+                    for (size_t i = 0; i < axes.size(); ++i) {
+                        strides[axes[i]] = g_strides[i];
+                    }
+                    this->accumulate(node.lhs, [&](T* dst, bool overwrite) {
+                        detail::copy_strided(g, in_shape, strides, dst, !overwrite);
+                    });
+                    break;
+                }
+                case Op::Reshape:
+                    this->accumulate_each(node.lhs, n, [g](SizeType i) { return g[i]; });
+                    break;
+                case Op::Checkpoint: {
+                    Tape& sub = *node.sub;
+                    Var<T> out = sub.replay(*this, node);
+                    sub.backward(out, node.grad);
+                    for (size_t i = 0; i < node.inputs.size(); ++i) {
+                        const Node& leaf = sub.nodes_[i];
+                        if (!leaf.has_grad) {
+                            continue;
+                        }
+                        const T* src = leaf.grad.data();
+                        this->accumulate_each(node.inputs[i], leaf.grad.numel(), [src](SizeType j) { return src[j]; });
+                    }
+                    sub.reset();
+                    for (SizeType input : node.inputs) {
+                        this->consume(input);
+                    }
+                    break;
+                }
+            }
+        }
+    };
+
+    template <typename T>
+    auto operator+(const Var<T>& a, const Var<T>& b) -> Var<T> {
+        return a.tape()->add(a, b);
+    }
+
+    template <typename T>
+    auto operator-(const Var<T>& a, const Var<T>& b) -> Var<T> {
+        return a.tape()->sub(a, b);
+    }
+
+    template <typename T>
+    auto operator*(const Var<T>& a, const Var<T>& b) -> Var<T> {
+        return a.tape()->mul(a, b);
+    }
+
+    template <typename T>
+    auto operator/(const Var<T>& a, const Var<T>& b) -> Var<T> {
+        return a.tape()->div(a, b);
+    }
+
+    template <typename T>
+    auto operator-(const Var<T>& a) -> Var<T> {
+        return a.tape()->neg(a);
+    }
+
+    template <typename T>
+    auto sin(const Var<T>& a) -> Var<T> {
+        return a.tape()->sin(a);
+    }
+
+    template <typename T>
+    auto cos(const Var<T>& a) -> Var<T> {
+        return a.tape()->cos(a);
+    }
+
+    template <typename T>
+    auto tan(const Var<T>& a) -> Var<T> {
+        return a.tape()->tan(a);
+    }
+
+    template <typename T>
+    auto sum(const Var<T>& a) -> Var<T> {
+        return a.tape()->sum(a);
+    }
+
+    template <typename T>
+    auto sum(const Var<T>& a, SizeType dim) -> Var<T> {
+        return a.tape()->sum(a, dim);
+    }
+
+    template <typename T>
+    auto mean(const Var<T>& a) -> Var<T> {
+        return a.tape()->mean(a);
+    }
+
+    template <typename T>
+    auto matmul(const Var<T>& a, const Var<T>& b) -> Var<T> {
+        return a.tape()->matmul(a, b);
+    }
+
+    template <typename T>
+    auto permute(const Var<T>& a, const IndexType& axes) -> Var<T> {
+        return a.tape()->permute(a, axes);
+    }
+
+    template <typename T>
+    auto reshape(const Var<T>& a, const IndexType& shape) -> Var<T> {
+        return a.tape()->reshape(a, shape);
+    }
+};  // namespace tt::inline v1::autograd
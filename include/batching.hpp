@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_join.hpp"
+#include "tensor_views.hpp"
+#include "utils/MpscQueue.hpp"
+
+// Dynamic batching for serving.
+//
+// Producer threads submit single samples; a dedicated thread drains them from a lock-free queue, copies up to
+// max_batch_size of them into a batch buffer allocated once up front, runs the batched function on a view of the
+// filled rows and hands each caller a view of its row of the result. A partial batch is dispatched once the oldest
+// sample in it has waited max_delay.
+namespace tt::inline v1 {
+    struct BatcherOptions {
+        SizeType max_batch_size = 32;
+        std::chrono::microseconds max_delay{1000};
+        // rounded up to a power of two; submit() waits for space when the queue is full
+        size_t queue_capacity = 1024;
+    };
+
+    template <typename T>
+    class DynamicBatcher {
+      public:
+        // Maps a batch of shape {n, sample_shape...} to a result whose first dimension is also n
+        using BatchFn = std::function<Tensor<T>(const Tensor<T>&)>;
+
+        DynamicBatcher(const IndexType& sample_shape, BatchFn fn, BatcherOptions options = {})
+            : options_(options),
+              sample_shape_(sample_shape),
+              fn_(std::move(fn)),
+              queue_(std::bit_ceil(std::max<size_t>(options.queue_capacity, 2))),
+              batch_(batch_shape(sample_shape, options.max_batch_size)) {
+            this->worker_ = std::thread([this] { this->run(); });
+        }
+
+        DynamicBatcher(const DynamicBatcher&) = delete;
+        auto operator=(const DynamicBatcher&) -> DynamicBatcher& = delete;
+
+        // Samples already submitted are still processed before the worker exits
+        ~DynamicBatcher() {
+            this->stop_.store(true);
+            this->wake();
+            this->worker_.join();
+        }
+
+        // The future holds this sample's row of the batched result, a view sharing the result's buffer
+        auto submit(Tensor<T> sample) -> std::future<Tensor<T>> {
+            if (sample.shape() != this->sample_shape_) {
+                throw std::runtime_error("DynamicBatcher: Shapes are not the same");
+            }
+            if (this->stop_.load()) {
+                throw std::runtime_error("DynamicBatcher: batcher is shutting down");
+            }
+            Request request{std::move(sample), {}, Clock::now()};
+            auto future = request.promise.get_future();
+            while (!this->queue_.try_push(request)) {
+                std::this_thread::yield();
+            }
+            this->wake();
+            return future;
+        }
+
+        [[nodiscard]] auto batches_run() const noexcept -> uint64_t {
+            return this->batches_run_.load();
+        }
+
+      private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Request {
+            Tensor<T> sample;
+            std::promise<Tensor<T>> promise;
+            Clock::time_point arrival;
+        };
+
+        BatcherOptions options_;
+        IndexType sample_shape_;
+        BatchFn fn_;
+        MpscQueue<Request> queue_;
+        Tensor<T> batch_;
+        std::vector<Request> pending_;
+
+        std::thread worker_;
+        std::atomic<bool> stop_{false};
+        std::atomic<bool> sleeping_{false};
+        std::atomic<uint64_t> batches_run_{0};
+        std::mutex mutex_;
+        std::condition_variable cv_;
+
+        static auto batch_shape(IndexType shape, SizeType n) -> IndexType {
+            if (n <= 0) {
+                throw std::runtime_error("DynamicBatcher: max_batch_size must be positive");
+            }
+            shape.insert(shape.begin(), n);
+            return shape;
+        }
+
+        // Producers only take the lock when the worker is (about to be) asleep. The fence here and the one after
+        // sleeping_ is set pair up (store, fence, load on both sides), so either the producer sees the worker
+        // going to sleep or the worker sees the queued request; without them both loads could read the old values
+        // and the worker would sleep with a request queued.
+        void wake() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (this->sleeping_.load()) {
+                std::lock_guard lock(this->mutex_);
+                this->cv_.notify_one();
+            }
+        }
+
+        // Sleeps until the queue is non-empty, stop is requested or the deadline passes
+        void wait_until(std::optional<Clock::time_point> deadline) {
+            std::unique_lock lock(this->mutex_);
+            this->sleeping_.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto ready = [this] { return !this->queue_.empty() || this->stop_.load(); };
+            if (deadline) {
+                this->cv_.wait_until(lock, *deadline, ready);
+            } else {
+                this->cv_.wait(lock, ready);
+            }
+            this->sleeping_.store(false);
+        }
+
+        void run() {
+            const auto max = static_cast<size_t>(this->options_.max_batch_size);
+            this->pending_.reserve(max);
+            while (true) {
+                std::optional<Clock::time_point> deadline;
+                while (this->pending_.size() < max) {
+                    if (auto request = this->queue_.try_pop()) {
+                        if (this->pending_.empty()) {
+                            deadline = request->arrival + this->options_.max_delay;
+                        }
+                        this->pending_.push_back(std::move(*request));
+                        continue;
+                    }
+                    if (this->stop_.load() && this->queue_.empty()) {
+                        break;
+                    }
+                    if (deadline && Clock::now() >= *deadline) {
+                        break;
+                    }
+                    this->wait_until(deadline);
+                }
+                if (this->pending_.empty()) {
+                    return;
+                }
+                this->dispatch();
+            }
+        }
+
+        void dispatch() {
+            const auto n = static_cast<SizeType>(this->pending_.size());
+            this->batches_run_++;
+            try {
+                for (SizeType i = 0; i < n; ++i) {
+                    auto row = this->batch_.select(0, i);
+                    detail::copy_into(this->pending_[i].sample, row);
+                }
+                Tensor<T> result = this->fn_(this->batch_.narrow(0, 0, n));
+                if (result.dim() == 0 || result.shape(0) != n) {
+                    throw std::runtime_error("DynamicBatcher: batched result has the wrong first dimension");
+                }
+                // results must not alias the batch buffer, which the next batch overwrites
+                if (result.shares_storage(this->batch_)) {
+                    result = Tensor<T>(result);
+                }
+                for (SizeType i = 0; i < n; ++i) {
+                    this->pending_[i].promise.set_value(result.select(0, i));
+                }
+            } catch (...) {
+                for (auto& request : this->pending_) {
+                    try {
+                        request.promise.set_exception(std::current_exception());
+                    } catch (const std::future_error&) {
+                        // already satisfied before the failure
+                    }
+                }
+            }
+            this->pending_.clear();
+        }
+    };
+};  // namespace tt::inline v1
@@ -0,0 +1,568 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "concepts.hpp"
+#include "operators.hpp"
+#include "tensor.hpp"
+#include "tensor_views.hpp"
+#include "tensor_conv.hpp"
+#include "tensor_reductions.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    // Splits dim into blocks of `block` elements and moves the position within a block innermost, e.g. dim 1 with
+    // block 8 turns NCHW into NCHW8c: physical shape (N, ceil(C / 8), H, W, 8). The last block of dim is padded.
+    struct BlockedLayout {
+        SizeType dim = 1;
+        SizeType block = 8;
+
+        [[nodiscard]] auto blocks(SizeType extent) const -> SizeType {
+            return (extent + this->block - 1) / this->block;
+        }
+
+        [[nodiscard]] auto physical_shape(const IndexType& shape) const -> IndexType {
+            IndexType physical = shape;
+            physical[this->dim] = this->blocks(shape[this->dim]);
+            physical.push_back(this->block);
+            return physical;
+        }
+
+        friend auto operator==(const BlockedLayout&, const BlockedLayout&) -> bool = default;
+    };
+
+    // Tensor stored in a blocked layout. Blocked indexing is not affine in the logical indices, so rather than a
+    // TensorIndexer the elements live in a plain contiguous tensor of the physical shape, next to the logical shape.
+    // Padding lanes of the last block are kept at zero, so sums and convolutions can run over whole blocks.
+    template <typename T>
+    class BlockedTensor {
+      public:
+        using ValueType = T;
+
+        // Zero-filled
+        BlockedTensor(IndexType shape, BlockedLayout layout)
+            : shape_(std::move(shape)), layout_(layout), data_(BlockedTensor::checked_physical(this->shape_, layout)) {}
+
+        // Wraps a tensor already in the physical layout; its padding lanes must be zero
+        static auto from_storage(IndexType shape, BlockedLayout layout, Tensor<T> storage) -> BlockedTensor {
+            BlockedTensor result(std::move(shape), layout, std::move(storage));
+            TINYTEN_CHECK(result.data_.shape() == layout.physical_shape(result.shape_) && result.data_._is_contiguous(),
+                          "BlockedTensor: storage does not match the layout");
+            return result;
+        }
+
+        // Reorders a plain tensor into the layout
+        static auto from_tensor(const Tensor<T>& plain, BlockedLayout layout) -> BlockedTensor {
+            BlockedTensor result(plain.shape(), layout);
+            const Tensor<T> src = detail::packed(plain);
+            const T* in = src.data();
+            T* out = result.data_.data();
+            result.reorder([in, out](SizeType plain_offset, SizeType blocked_offset) {
+                out[blocked_offset] = in[plain_offset];
+            });
+            return result;
+        }
+
+        [[nodiscard]] auto to_tensor() const -> Tensor<T> {
+            Tensor<T> result(this->shape_);
+            const T* in = this->data_.data();
+            T* out = result.data();
+            this->reorder([in, out](SizeType plain_offset, SizeType blocked_offset) {
+                out[plain_offset] = in[blocked_offset];
+            });
+            return result;
+        }
+
+        [[nodiscard]] auto shape() const noexcept -> const IndexType& {
+            return this->shape_;
+        }
+
+        [[nodiscard]] auto shape(SizeType i) const -> SizeType {
+            TINYTEN_CHECK(i >= 0 && i < this->dim(), "shape: index out of bounds");
+            return this->shape_[i];
+        }
+
+        [[nodiscard]] auto dim() const noexcept -> SizeType {
+            return static_cast<SizeType>(this->shape_.size());
+        }
+
+        [[nodiscard]] auto numel() const noexcept -> SizeType {
+            return tt::cumprod(this->shape_);
+        }
+
+        [[nodiscard]] auto layout() const noexcept -> const BlockedLayout& {
+            return this->layout_;
+        }
+
+        // The physical tensor, padding included
+        [[nodiscard]] auto storage() const noexcept -> const Tensor<T>& {
+            return this->data_;
+        }
+
+        template <std::convertible_to<SizeType>... I>
+        auto operator()(I... i) -> T& {
+            return this->data_.data()[this->offset_of({static_cast<SizeType>(i)...})];
+        }
+
+        template <std::convertible_to<SizeType>... I>
+        auto operator()(I... i) const -> const T& {
+            return this->data_.data()[this->offset_of({static_cast<SizeType>(i)...})];
+        }
+
+        template <typename F>
+        auto map_(F f) -> BlockedTensor& {
+            T* vals = this->data_.data();
+            tt::parallel_for(0, this->data_.numel(), 1 << 14, [&](SizeType lo, SizeType hi) {
+                std::transform(vals + lo, vals + hi, vals + lo, f);
+            });
+            this->zero_padding_();
+            return *this;
+        }
+
+        template <typename F>
+        [[nodiscard]] auto map(F f) const -> BlockedTensor {
+            return BlockedTensor(*this).map_(f);
+        }
+
+        // this = f(this, other) elementwise over the physical storage of two tensors of the same shape and layout
+        template <typename F>
+        auto zip_(const BlockedTensor& other, F f) -> BlockedTensor& {
+            TINYTEN_CHECK(this->shape_ == other.shape_ && this->layout_ == other.layout_,
+                          "BlockedTensor: shapes or layouts are not the same");
+            T* vals = this->data_.data();
+            const T* rhs = other.data_.data();
+            tt::parallel_for(0, this->data_.numel(), 1 << 14, [&](SizeType lo, SizeType hi) {
+                std::transform(vals + lo, vals + hi, rhs + lo, vals + lo, f);
+            });
+            this->zero_padding_();
+            return *this;
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Reductions, computed on the blocked storage
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] auto sum() const -> T requires SupportsAdd<T> {
+            return this->data_.sum();
+        }
+
+        [[nodiscard]] auto mean() const -> T requires SupportsDiv<T> {
+            return this->data_.sum() / static_cast<T>(this->numel());
+        }
+
+        [[nodiscard]] auto max() const -> T {
+            return this->extreme("max", [](const T& a, const T& b) { return a < b ? b : a; });
+        }
+
+        [[nodiscard]] auto min() const -> T {
+            return this->extreme("min", [](const T& a, const T& b) { return b < a ? b : a; });
+        }
+
+        // Sum over a dim other than the blocked one; the result keeps the layout
+        [[nodiscard]] auto sum(SizeType dim) const -> BlockedTensor requires SupportsAdd<T> {
+            TINYTEN_CHECK(dim >= 0 && dim < this->dim() && dim != this->layout_.dim,
+                          "sum: dim out of bounds or blocked (see sum_blocked_dim)");
+            IndexType shape = this->shape_;
+            shape.erase(shape.begin() + dim);
+            BlockedLayout layout = this->layout_;
+            if (dim < layout.dim) {
+                --layout.dim;
+            }
+            return BlockedTensor(std::move(shape), layout, this->data_.sum(dim));
+        }
+
+        // Sum over the blocked dim, as a plain tensor without that dim
+        [[nodiscard]] auto sum_blocked_dim() const -> Tensor<T> requires SupportsAdd<T> {
+            const Tensor<T> blocks = this->data_.sum(this->layout_.dim);
+            if (this->dim() == 1) {
+                return Tensor<T>({1}, blocks.sum());
+            }
+            return blocks.sum(blocks.dim() - 1);
+        }
+
+      private:
+        IndexType shape_;
+        BlockedLayout layout_;
+        Tensor<T> data_;
+
+        BlockedTensor(IndexType shape, BlockedLayout layout, Tensor<T> data)
+            : shape_(std::move(shape)), layout_(layout), data_(std::move(data)) {}
+
+        static auto checked_physical(const IndexType& shape, const BlockedLayout& layout) -> Tensor<T> {
+            TINYTEN_CHECK(layout.dim >= 0 && layout.dim < static_cast<SizeType>(shape.size()) && layout.block > 0,
+                          "BlockedTensor: invalid layout");
+            return Tensor<T>(layout.physical_shape(shape));
+        }
+
+        // Product of the dims before and after the blocked one
+        [[nodiscard]] auto outer() const -> SizeType {
+            return std::reduce(this->shape_.begin(), this->shape_.begin() + this->layout_.dim, SizeType{1},
+                               std::multiplies<>{});
+        }
+
+        [[nodiscard]] auto inner() const -> SizeType {
+            return std::reduce(this->shape_.begin() + this->layout_.dim + 1, this->shape_.end(), SizeType{1},
+                               std::multiplies<>{});
+        }
+
+        [[nodiscard]] auto offset_of(const IndexType& indices) const -> SizeType {
+            TINYTEN_CHECK_INDEX(static_cast<SizeType>(indices.size()) == this->dim(), "Wrong number of indices");
+            const SizeType b = this->layout_.block;
+            SizeType offset = 0;
+            for (SizeType d = 0; d < this->dim(); ++d) {
+                TINYTEN_CHECK_INDEX(indices[d] >= 0 && indices[d] < this->shape_[d], "Index out of bounds");
+                if (d == this->layout_.dim) {
+                    offset = offset * this->layout_.blocks(this->shape_[d]) + indices[d] / b;
+                } else {
+                    offset = offset * this->shape_[d] + indices[d];
+                }
+            }
+            return offset * b + indices[this->layout_.dim] % b;
+        }
+
+        // Calls f(plain_offset, blocked_offset) for every element. Each task takes one block of one outer index: a
+        // (lanes x inner) tile of the plain tensor, read row by row and written transposed.
+        template <typename F>
+        void reorder(F f) const {
+            const SizeType b = this->layout_.block;
+            const SizeType channels = this->shape_[this->layout_.dim];
+            const SizeType blocks = this->layout_.blocks(channels);
+            const SizeType inner = this->inner();
+            const SizeType grain = std::max<SizeType>(1, 4096 / std::max<SizeType>(inner * b, 1));
+            tt::parallel_for(0, this->outer() * blocks, grain, [&](SizeType lo, SizeType hi) {
+                for (SizeType t = lo; t < hi; ++t) {
+                    const SizeType o = t / blocks;
+                    const SizeType cb = t % blocks;
+                    const SizeType lanes = std::min(b, channels - cb * b);
+                    for (SizeType l = 0; l < lanes; ++l) {
+                        const SizeType plain = (o * channels + cb * b + l) * inner;
+                        const SizeType blocked = t * inner * b + l;
+                        for (SizeType i = 0; i < inner; ++i) {
+                            f(plain + i, blocked + i * b);
+                        }
+                    }
+                }
+            });
+        }
+
+        template <typename Op>
+        [[nodiscard]] auto extreme(const char* name, Op op) const -> T {
+            if (this->numel() == 0) {
+                throw std::runtime_error(std::string(name) + ": tensor is empty");
+            }
+            const SizeType b = this->layout_.block;
+            const SizeType channels = this->shape_[this->layout_.dim];
+            const SizeType blocks = this->layout_.blocks(channels);
+            const SizeType inner = this->inner();
+            const T* data = this->data_.data();
+            T acc = data[0];
+            for (SizeType t = 0; t < this->outer() * blocks; ++t) {
+                // padding lanes are skipped, a zero there must not win
+                const SizeType lanes = std::min(b, channels - (t % blocks) * b);
+                for (SizeType i = 0; i < inner; ++i) {
+                    const T* block = data + (t * inner + i) * b;
+                    for (SizeType l = 0; l < lanes; ++l) {
+                        acc = op(acc, block[l]);
+                    }
+                }
+            }
+            return acc;
+        }
+
+        // Restores the zero padding after an op that may have written to it
+        void zero_padding_() {
+            const SizeType b = this->layout_.block;
+            const SizeType channels = this->shape_[this->layout_.dim];
+            const SizeType lanes = channels % b;
+            if (lanes == 0) {
+                return;
+            }
+            const SizeType blocks = this->layout_.blocks(channels);
+            const SizeType inner = this->inner();
+            T* data = this->data_.data();
+            for (SizeType o = 0; o < this->outer(); ++o) {
+                T* last = data + (o * blocks + blocks - 1) * inner * b;
+                for (SizeType i = 0; i < inner; ++i) {
+                    std::fill(last + i * b + lanes, last + (i + 1) * b, T{});
+                }
+            }
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    // Elementwise ops; both operands must have the same shape and layout
+    ////////////////////////////////////////////////////////////////////
+    template <typename T>
+    auto operator+(const BlockedTensor<T>& a, const BlockedTensor<T>& b) -> BlockedTensor<T> requires SupportsAdd<T> {
+        return BlockedTensor<T>(a).zip_(b, std::plus<>{});
+    }
+
+    template <typename T>
+    auto operator-(const BlockedTensor<T>& a, const BlockedTensor<T>& b) -> BlockedTensor<T> requires SupportsSub<T> {
+        return BlockedTensor<T>(a).zip_(b, std::minus<>{});
+    }
+
+    template <typename T>
+    auto operator*(const BlockedTensor<T>& a, const BlockedTensor<T>& b) -> BlockedTensor<T> requires SupportsMul<T> {
+        return BlockedTensor<T>(a).zip_(b, std::multiplies<>{});
+    }
+
+    template <typename T>
+    auto operator/(const BlockedTensor<T>& a, const BlockedTensor<T>& b) -> BlockedTensor<T> requires SupportsDiv<T> {
+        return BlockedTensor<T>(a).zip_(b, std::divides<>{});
+    }
+
+    template <typename T>
+    auto operator+(const BlockedTensor<T>& a, const T& scalar) -> BlockedTensor<T> requires SupportsAdd<T> {
+        return a.map([scalar](const T& x) { return x + scalar; });
+    }
+
+    template <typename T>
+    auto operator-(const BlockedTensor<T>& a, const T& scalar) -> BlockedTensor<T> requires SupportsSub<T> {
+        return a.map([scalar](const T& x) { return x - scalar; });
+    }
+
+    template <typename T>
+    auto operator*(const BlockedTensor<T>& a, const T& scalar) -> BlockedTensor<T> requires SupportsMul<T> {
+        return a.map([scalar](const T& x) { return x * scalar; });
+    }
+
+    template <typename T>
+    auto operator/(const BlockedTensor<T>& a, const T& scalar) -> BlockedTensor<T> requires SupportsDiv<T> {
+        return a.map([scalar](const T& x) { return x / scalar; });
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Convolution and pooling on channel-blocked NCHWc tensors
+    ////////////////////////////////////////////////////////////////////
+
+    // A (K, C, KH, KW) convolution weight reordered once into (K / b, C / b, KH, KW, b_in, b_out) blocks, so the
+    // innermost loop of the convolution updates b output channels with contiguous weights
+    template <typename T>
+    struct PackedConv2dWeight {
+        Tensor<T> data;
+        SizeType K;
+        SizeType C;
+        SizeType KH;
+        SizeType KW;
+        SizeType block;
+
+        static auto from_tensor(const Tensor<T>& weight, SizeType block) -> PackedConv2dWeight {
+            if (weight.dim() != 4) {
+                throw std::runtime_error("conv2d: weight must be (K, C, KH, KW)");
+            }
+            TINYTEN_CHECK(block > 0, "conv2d: invalid block size");
+            PackedConv2dWeight packed{{}, weight.shape(0), weight.shape(1), weight.shape(2), weight.shape(3), block};
+            const SizeType kb = (packed.K + block - 1) / block;
+            const SizeType cb = (packed.C + block - 1) / block;
+            packed.data = Tensor<T>({kb, cb, packed.KH, packed.KW, block, block});
+            T* out = packed.data.data();
+            for (SizeType k = 0; k < packed.K; ++k) {
+                for (SizeType c = 0; c < packed.C; ++c) {
+                    for (SizeType kh = 0; kh < packed.KH; ++kh) {
+                        for (SizeType kw = 0; kw < packed.KW; ++kw) {
+                            const SizeType tap = ((k / block * cb + c / block) * packed.KH + kh) * packed.KW + kw;
+                            out[(tap * block + c % block) * block + k % block] = weight(k, c, kh, kw);
+                        }
+                    }
+                }
+            }
+            return packed;
+        }
+    };
+
+    namespace detail {
+        template <typename T>
+        void check_nchwc(const BlockedTensor<T>& input, const char* what) {
+            if (input.dim() != 4 || input.layout().dim != 1) {
+                throw std::runtime_error(std::string(what) + ": input must be NCHW blocked along C");
+            }
+        }
+
+        template <typename T>
+        auto conv2d_blocked(const BlockedTensor<T>& input, const PackedConv2dWeight<T>& weight, const Tensor<T>* bias,
+                            const Conv2dOptions& opts) -> BlockedTensor<T> {
+            check_nchwc(input, "conv2d");
+            const SizeType b = input.layout().block;
+            if (weight.block != b || weight.C != input.shape(1)) {
+                throw std::runtime_error("conv2d: weight does not match the input channels or block");
+            }
+            if (opts.groups != 1) {
+                throw std::runtime_error("conv2d: blocked convolution supports groups = 1 only");
+            }
+            if (bias != nullptr && (bias->dim() != 1 || bias->shape(0) != weight.K)) {
+                throw std::runtime_error("conv2d: bias must have shape (K)");
+            }
+            const auto [sh, sw] = opts.stride;
+            const auto [ph, pw] = opts.padding;
+            const auto [dh, dw] = opts.dilation;
+            if (sh < 1 || sw < 1 || dh < 1 || dw < 1 || ph < 0 || pw < 0) {
+                throw std::runtime_error("conv2d: invalid stride, padding or dilation");
+            }
+            const SizeType N = input.shape(0);
+            const SizeType H = input.shape(2);
+            const SizeType W = input.shape(3);
+            const SizeType KH = weight.KH;
+            const SizeType KW = weight.KW;
+            const SizeType OH = conv_out_size(H, KH, sh, ph, dh);
+            const SizeType OW = conv_out_size(W, KW, sw, pw, dw);
+            const SizeType cb = input.layout().blocks(input.shape(1));
+            const SizeType kb = (weight.K + b - 1) / b;
+
+            const BlockedLayout layout{1, b};
+            Tensor<T> out(layout.physical_shape({N, weight.K, OH, OW}));
+            const T* in = input.storage().data();
+            const T* w = weight.data.data();
+            Tensor<T> bias_blocks({kb * b});
+            if (bias != nullptr) {
+                std::copy(bias->begin(), bias->end(), bias_blocks.data());
+            }
+
+            // one task per output row of one output channel block; the b output lanes are the innermost loop
+            tt::parallel_for(0, N * kb * OH, 1, [&](SizeType lo, SizeType hi) {
+                for (SizeType t = lo; t < hi; ++t) {
+                    const SizeType n = t / (kb * OH);
+                    const SizeType k = t / OH % kb;
+                    const SizeType oh = t % OH;
+                    T* orow = out.data() + t * OW * b;
+                    for (SizeType ow = 0; ow < OW; ++ow) {
+                        std::copy(bias_blocks.data() + k * b, bias_blocks.data() + (k + 1) * b, orow + ow * b);
+                    }
+                    for (SizeType c = 0; c < cb; ++c) {
+                        for (SizeType kh = 0; kh < KH; ++kh) {
+                            const SizeType ih = oh * sh - ph + kh * dh;
+                            if (ih < 0 || ih >= H) {
+                                continue;
+                            }
+                            const T* irow = in + ((n * cb + c) * H + ih) * W * b;
+                            for (SizeType kw = 0; kw < KW; ++kw) {
+                                const T* wt = w + (((k * cb + c) * KH + kh) * KW + kw) * b * b;
+                                for (SizeType ow = 0; ow < OW; ++ow) {
+                                    const SizeType iw = ow * sw - pw + kw * dw;
+                                    if (iw < 0 || iw >= W) {
+                                        continue;
+                                    }
+                                    const T* x = irow + iw * b;
+                                    T* o = orow + ow * b;
+                                    for (SizeType ci = 0; ci < b; ++ci) {
+                                        const T xv = x[ci];
+                                        const T* wrow = wt + ci * b;
+                                        for (SizeType co = 0; co < b; ++co) {
+                                            o[co] += xv * wrow[co];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+            return BlockedTensor<T>::from_storage({N, weight.K, OH, OW}, layout, std::move(out));
+        }
+
+        template <typename T, typename Init, typename Step, typename Finish>
+        auto pool2d_blocked(const BlockedTensor<T>& input, const Pool2dOptions& opts, Init init, Step step,
+                            Finish finish) -> BlockedTensor<T> {
+            check_nchwc(input, "pool2d");
+            const auto [KH, KW] = opts.kernel;
+            const auto [sh, sw] = opts.stride;
+            const auto [ph, pw] = opts.padding;
+            const auto [dh, dw] = opts.dilation;
+            if (sh < 1 || sw < 1 || dh < 1 || dw < 1 || KH < 1 || KW < 1) {
+                throw std::runtime_error("pool2d: invalid kernel, stride or dilation");
+            }
+            if (2 * ph > KH || 2 * pw > KW) {
+                throw std::runtime_error("pool2d: padding must be at most half the kernel size");
+            }
+            const SizeType b = input.layout().block;
+            const SizeType H = input.shape(2);
+            const SizeType W = input.shape(3);
+            const SizeType OH = conv_out_size(H, KH, sh, ph, dh);
+            const SizeType OW = conv_out_size(W, KW, sw, pw, dw);
+            if (!pool_windows_hit_input(H, OH, KH, sh, ph, dh) || !pool_windows_hit_input(W, OW, KW, sw, pw, dw)) {
+                throw std::runtime_error("pool2d: a pooling window lies entirely in the padding");
+            }
+            const SizeType planes = input.shape(0) * input.layout().blocks(input.shape(1));
+            const IndexType shape{input.shape(0), input.shape(1), OH, OW};
+            Tensor<T> out(input.layout().physical_shape(shape));
+            const T* in = input.storage().data();
+            tt::parallel_for(0, planes, 1, [&](SizeType lo, SizeType hi) {
+                std::vector<decltype(init())> acc(b);
+                for (SizeType p = lo; p < hi; ++p) {
+                    const T* src = in + p * H * W * b;
+                    T* dst = out.data() + p * OH * OW * b;
+                    for (SizeType oh = 0; oh < OH; ++oh) {
+                        for (SizeType ow = 0; ow < OW; ++ow) {
+                            std::fill(acc.begin(), acc.end(), init());
+                            SizeType count = 0;
+                            for (SizeType kh = 0; kh < KH; ++kh) {
+                                const SizeType ih = oh * sh - ph + kh * dh;
+                                if (ih < 0 || ih >= H) {
+                                    continue;
+                                }
+                                for (SizeType kw = 0; kw < KW; ++kw) {
+                                    const SizeType iw = ow * sw - pw + kw * dw;
+                                    if (iw >= 0 && iw < W) {
+                                        const T* x = src + (ih * W + iw) * b;
+                                        for (SizeType l = 0; l < b; ++l) {
+                                            acc[l] = step(acc[l], x[l]);
+                                        }
+                                        ++count;
+                                    }
+                                }
+                            }
+                            T* o = dst + (oh * OW + ow) * b;
+                            for (SizeType l = 0; l < b; ++l) {
+                                o[l] = finish(acc[l], count);
+                            }
+                        }
+                    }
+                }
+            });
+            // a window over zero padding lanes yields zero for max and average alike
+            return BlockedTensor<T>::from_storage(shape, input.layout(), std::move(out));
+        }
+    }  // namespace detail
+
+    // input (N, C, H, W) blocked along C, weight (K, C, KH, KW) -> (N, K, OH, OW) blocked along K with the same block
+    template <typename T>
+    auto conv2d(const BlockedTensor<T>& input, const PackedConv2dWeight<T>& weight, const Conv2dOptions& opts = {})
+        -> BlockedTensor<T> {
+        return detail::conv2d_blocked(input, weight, static_cast<const Tensor<T>*>(nullptr), opts);
+    }
+
+    template <typename T>
+    auto conv2d(const BlockedTensor<T>& input, const PackedConv2dWeight<T>& weight, const Tensor<T>& bias,
+                const Conv2dOptions& opts = {}) -> BlockedTensor<T> {
+        return detail::conv2d_blocked(input, weight, &bias, opts);
+    }
+
+    // Packs the weight on every call; pack it once with PackedConv2dWeight::from_tensor when it is reused
+    template <typename T>
+    auto conv2d(const BlockedTensor<T>& input, const Tensor<T>& weight, const Conv2dOptions& opts = {})
+        -> BlockedTensor<T> {
+        return conv2d(input, PackedConv2dWeight<T>::from_tensor(weight, input.layout().block), opts);
+    }
+
+    template <typename T>
+    auto max_pool2d(const BlockedTensor<T>& input, const Pool2dOptions& opts = {}) -> BlockedTensor<T> {
+        return detail::pool2d_blocked(
+            input, opts, [] { return std::numeric_limits<T>::lowest(); }, [](T acc, T v) { return std::max(acc, v); },
+            [](T acc, SizeType) { return acc; });
+    }
+
+    // Padded positions are excluded from the average. As for plain tensors, every window must overlap the input.
+    template <typename T>
+    auto avg_pool2d(const BlockedTensor<T>& input, const Pool2dOptions& opts = {}) -> BlockedTensor<T> {
+        return detail::pool2d_blocked(
+            input, opts, [] { return T{}; }, [](T acc, T v) { return acc + v; },
+            [](T acc, SizeType count) { return acc / static_cast<T>(count); });
+    }
+};  // namespace tt::inline v1
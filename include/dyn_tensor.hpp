@@ -0,0 +1,275 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "operators.hpp"
+#include "tensor.hpp"
+#include "tensor_views.hpp"
+
+namespace tt::inline v1 {
+    // Element types a DynTensor can hold. The order matches the alternatives of DynTensor::Variant.
+    enum class DType { Int8, UInt8, Int16, Int32, Int64, Float32, Float64 };
+
+    template <typename T>
+    concept SupportedDType = std::same_as<T, int8_t> || std::same_as<T, uint8_t> || std::same_as<T, int16_t> ||
+                             std::same_as<T, int32_t> || std::same_as<T, int64_t> || std::same_as<T, float> ||
+                             std::same_as<T, double>;
+
+    template <SupportedDType T>
+    inline constexpr DType dtype_of = std::is_same_v<T, int8_t>    ? DType::Int8
+                                      : std::is_same_v<T, uint8_t> ? DType::UInt8
+                                      : std::is_same_v<T, int16_t> ? DType::Int16
+                                      : std::is_same_v<T, int32_t> ? DType::Int32
+                                      : std::is_same_v<T, int64_t> ? DType::Int64
+                                      : std::is_same_v<T, float>   ? DType::Float32
+                                                                   : DType::Float64;
+
+    // Calls f(std::type_identity<T>{}) for the element type of dtype. This is the single switch a runtime-typed
+    // caller needs; everything inside f is compiled per type.
+    template <typename F>
+    decltype(auto) visit_dtype(DType dtype, F&& f) {
+        switch (dtype) {
+            case DType::Int8:
+                return std::forward<F>(f)(std::type_identity<int8_t>{});
+            case DType::UInt8:
+                return std::forward<F>(f)(std::type_identity<uint8_t>{});
+            case DType::Int16:
+                return std::forward<F>(f)(std::type_identity<int16_t>{});
+            case DType::Int32:
+                return std::forward<F>(f)(std::type_identity<int32_t>{});
+            case DType::Int64:
+                return std::forward<F>(f)(std::type_identity<int64_t>{});
+            case DType::Float32:
+                return std::forward<F>(f)(std::type_identity<float>{});
+            case DType::Float64:
+                return std::forward<F>(f)(std::type_identity<double>{});
+        }
+        throw std::runtime_error("visit_dtype: unknown dtype");
+    }
+
+    inline auto dtype_size(DType dtype) -> SizeType {
+        return visit_dtype(dtype, [](auto tag) { return static_cast<SizeType>(sizeof(typename decltype(tag)::type)); });
+    }
+
+    inline auto dtype_name(DType dtype) -> const char* {
+        switch (dtype) {
+            case DType::Int8:
+                return "int8";
+            case DType::UInt8:
+                return "uint8";
+            case DType::Int16:
+                return "int16";
+            case DType::Int32:
+                return "int32";
+            case DType::Int64:
+                return "int64";
+            case DType::Float32:
+                return "float32";
+            case DType::Float64:
+                return "float64";
+        }
+        return "unknown";
+    }
+
+    // Tensor whose element type is only known at runtime. It holds one typed Tensor (and so the same shared buffer
+    // and indexer); every operation dispatches on the dtype once and then runs the typed kernel. as<T>() hands out
+    // a typed view of the same buffer.
+    class DynTensor {
+      public:
+        using Variant = std::variant<Tensor<int8_t>, Tensor<uint8_t>, Tensor<int16_t>, Tensor<int32_t>, Tensor<int64_t>,
+                                     Tensor<float>, Tensor<double>>;
+
+        DynTensor() : tensor_(Tensor<float>()) {}
+
+        // Zero-filled
+        DynTensor(DType dtype, const IndexType& shape)
+            : tensor_(visit_dtype(dtype, [&shape](auto tag) -> Variant {
+                  return Tensor<typename decltype(tag)::type>(shape);
+              })) {}
+
+        // Takes the tensor as any Tensor is passed by value: move it in, or pass view() to share its buffer
+        template <SupportedDType T>
+        DynTensor(Tensor<T> tensor) : tensor_(std::move(tensor)) {}
+
+        [[nodiscard]] auto dtype() const noexcept -> DType {
+            return static_cast<DType>(this->tensor_.index());
+        }
+
+        [[nodiscard]] auto element_size() const -> SizeType {
+            return dtype_size(this->dtype());
+        }
+
+        template <SupportedDType T>
+        [[nodiscard]] auto is() const noexcept -> bool {
+            return std::holds_alternative<Tensor<T>>(this->tensor_);
+        }
+
+        // A typed view sharing this tensor's buffer; T must be the dtype
+        template <SupportedDType T>
+        [[nodiscard]] auto as() const -> Tensor<T> {
+            if (!this->is<T>()) {
+                throw std::runtime_error("DynTensor::as: dtype mismatch");
+            }
+            return std::get<Tensor<T>>(this->tensor_).view();
+        }
+
+        // Calls f with the typed tensor
+        template <typename F>
+        decltype(auto) visit(F&& f) {
+            return std::visit(std::forward<F>(f), this->tensor_);
+        }
+
+        template <typename F>
+        decltype(auto) visit(F&& f) const {
+            return std::visit(std::forward<F>(f), this->tensor_);
+        }
+
+        [[nodiscard]] auto numel() const -> SizeType {
+            return this->visit([](const auto& t) { return t.numel(); });
+        }
+
+        [[nodiscard]] auto shape() const -> const IndexType& {
+            return this->visit([](const auto& t) -> const IndexType& { return t.shape(); });
+        }
+        [[nodiscard]] auto shape(SizeType i) const -> SizeType {
+            return this->visit([i](const auto& t) { return t.shape(i); });
+        }
+
+        [[nodiscard]] auto dim() const -> SizeType {
+            return this->visit([](const auto& t) { return t.dim(); });
+        }
+
+        [[nodiscard]] auto strides() const -> const IndexType& {
+            return this->visit([](const auto& t) -> const IndexType& { return t.strides(); });
+        }
+
+        [[nodiscard]] auto _is_contiguous() const -> bool {
+            return this->visit([](const auto& t) { return t._is_contiguous(); });
+        }
+
+        // Untyped pointer to the first element, e.g. to read a file straight into the buffer
+        [[nodiscard]] auto data() -> void* {
+            return this->visit([](auto& t) -> void* { return t.data(); });
+        }
+
+        [[nodiscard]] auto data() const -> const void* {
+            return this->visit([](const auto& t) -> const void* { return t.data(); });
+        }
+
+        [[nodiscard]] auto nbytes() const -> SizeType {
+            return this->numel() * this->element_size();
+        }
+
+        [[nodiscard]] auto shares_storage(const DynTensor& other) const -> bool {
+            return this->dtype() == other.dtype() &&
+                   this->visit([&other](const auto& t) {
+                       using T = typename std::decay_t<decltype(t)>::ValueType;
+                       return t.shares_storage(std::get<Tensor<T>>(other.tensor_));
+                   });
+        }
+
+        // Converted copy; elements are cast one by one into the new buffer
+        [[nodiscard]] auto to(DType dtype) const -> DynTensor {
+            return this->visit([dtype](const auto& t) {
+                return visit_dtype(dtype, [&t](auto tag) -> DynTensor {
+                    using U = typename decltype(tag)::type;
+                    return detail::map_promoted<U>(t, [](U x) { return x; });
+                });
+            });
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Views and layout, with the same semantics as on Tensor
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] auto view() const -> DynTensor {
+            return this->visit([](const auto& t) -> DynTensor { return t.view(); });
+        }
+
+        [[nodiscard]] auto narrow(SizeType dim, SizeType start, SizeType length) const -> DynTensor {
+            return this->visit([=](const auto& t) -> DynTensor { return t.narrow(dim, start, length); });
+        }
+
+        [[nodiscard]] auto select(SizeType dim, SizeType index) const -> DynTensor {
+            return this->visit([=](const auto& t) -> DynTensor { return t.select(dim, index); });
+        }
+
+        [[nodiscard]] auto reshape(const IndexType& shape) const -> DynTensor {
+            return this->visit([&shape](const auto& t) -> DynTensor { return t.reshape(shape); });
+        }
+
+        [[nodiscard]] auto permute(const IndexType& axes) const -> DynTensor {
+            return this->visit([&axes](const auto& t) -> DynTensor { return t.permute(axes); });
+        }
+
+        [[nodiscard]] auto contiguous() const -> DynTensor {
+            return this->visit([](const auto& t) -> DynTensor { return t.contiguous(); });
+        }
+
+      private:
+        Variant tensor_;
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    // Operators; dtypes are promoted as for typed tensors (see operators.hpp)
+    ////////////////////////////////////////////////////////////////////
+    namespace detail {
+        template <typename Op>
+        auto zip_dyn(const DynTensor& a, const DynTensor& b, Op op) -> DynTensor {
+            return a.visit([&](const auto& x) {
+                return b.visit([&](const auto& y) -> DynTensor {
+                    using R = promote_t<typename std::decay_t<decltype(x)>::ValueType,
+                                        typename std::decay_t<decltype(y)>::ValueType>;
+                    return detail::zip_promoted<R>(x, y, op);
+                });
+            });
+        }
+
+        template <Arithmetic S, typename Op>
+        auto map_dyn(const DynTensor& a, S scalar, Op op) -> DynTensor {
+            return a.visit([&](const auto& x) -> DynTensor {
+                using R = scalar_promote_t<typename std::decay_t<decltype(x)>::ValueType, S>;
+                return detail::map_promoted<R>(x, [&op, s = static_cast<R>(scalar)](R v) { return op(v, s); });
+            });
+        }
+    }  // namespace detail
+
+    inline auto operator+(const DynTensor& a, const DynTensor& b) -> DynTensor {
+        return detail::zip_dyn(a, b, std::plus<>{});
+    }
+
+    inline auto operator-(const DynTensor& a, const DynTensor& b) -> DynTensor {
+        return detail::zip_dyn(a, b, std::minus<>{});
+    }
+
+    inline auto operator*(const DynTensor& a, const DynTensor& b) -> DynTensor {
+        return detail::zip_dyn(a, b, std::multiplies<>{});
+    }
+
+    inline auto operator/(const DynTensor& a, const DynTensor& b) -> DynTensor {
+        return detail::zip_dyn(a, b, std::divides<>{});
+    }
+
+    template <Arithmetic S>
+    auto operator+(const DynTensor& a, S scalar) -> DynTensor {
+        return detail::map_dyn(a, scalar, std::plus<>{});
+    }
+
+    template <Arithmetic S>
+    auto operator-(const DynTensor& a, S scalar) -> DynTensor {
+        return detail::map_dyn(a, scalar, std::minus<>{});
+    }
+
+    template <Arithmetic S>
+    auto operator*(const DynTensor& a, S scalar) -> DynTensor {
+        return detail::map_dyn(a, scalar, std::multiplies<>{});
+    }
+
+    template <Arithmetic S>
+    auto operator/(const DynTensor& a, S scalar) -> DynTensor {
+        return detail::map_dyn(a, scalar, std::divides<>{});
+    }
+};  // namespace tt::inline v1
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <concepts>
 #include <functional>
-#include <stdexcept>
+#include <type_traits>
 
 #include "concepts.hpp"
 #include "tensor.hpp"
+#include "utils/Check.hpp"
 
 namespace tt::inline v1 {
     template <typename T>
@@ -12,9 +15,7 @@ namespace tt::inline v1 {
 
     template <typename T>
     constexpr auto operator+(const Tensor<T>& a, const Tensor<T>& b) requires SupportsAdd<T> {
-        if (a.shape() != b.shape()) {
-            throw std::runtime_error("Shapes are not the same");
-        }
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
         Tensor<T> result(a.shape());
         std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::plus<>{});
         return result;
@@ -22,9 +23,7 @@ namespace tt::inline v1 {
 
     template <typename T>
     constexpr auto operator-(const Tensor<T>& a, const Tensor<T>& b) requires SupportsSub<T> {
-        if (a.shape() != b.shape()) {
-            throw std::runtime_error("Shapes are not the same");
-        }
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
         Tensor<T> result(a.shape());
         std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::minus<>{});
         return result;
@@ -32,9 +31,7 @@ namespace tt::inline v1 {
 
     template <typename T>
     constexpr auto operator*(const Tensor<T>& a, const Tensor<T>& b) requires SupportsMul<T> {
-        if (a.shape() != b.shape()) {
-            throw std::runtime_error("Shapes are not the same");
-        }
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
         Tensor<T> result(a.shape());
         std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::multiplies<>{});
         return result;
@@ -42,12 +39,238 @@ namespace tt::inline v1 {
 
     template <typename T>
     constexpr auto operator/(const Tensor<T>& a, const Tensor<T>& b) requires SupportsDiv<T> {
-        if (a.shape() != b.shape()) {
-            throw std::runtime_error("Shapes are not the same");
-        }
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
         Tensor<T> result(a.shape());
         std::transform(a.begin(), a.end(), b.begin(), result.begin(), std::divides<>{});
         return result;
     }
 
+    template <typename T>
+    constexpr auto operator+=(Tensor<T>& a, const Tensor<T>& b) -> Tensor<T>& requires SupportsAdd<T> {
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+        std::transform(a.begin(), a.end(), b.begin(), a.begin(), std::plus<>{});
+        return a;
+    }
+
+    template <typename T>
+    constexpr auto operator-=(Tensor<T>& a, const Tensor<T>& b) -> Tensor<T>& requires SupportsSub<T> {
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+        std::transform(a.begin(), a.end(), b.begin(), a.begin(), std::minus<>{});
+        return a;
+    }
+
+    template <typename T>
+    constexpr auto operator*=(Tensor<T>& a, const Tensor<T>& b) -> Tensor<T>& requires SupportsMul<T> {
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+        std::transform(a.begin(), a.end(), b.begin(), a.begin(), std::multiplies<>{});
+        return a;
+    }
+
+    template <typename T>
+    constexpr auto operator/=(Tensor<T>& a, const Tensor<T>& b) -> Tensor<T>& requires SupportsDiv<T> {
+        TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+        std::transform(a.begin(), a.end(), b.begin(), a.begin(), std::divides<>{});
+        return a;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Mixed-dtype and scalar operators
+    ////////////////////////////////////////////////////////////////////
+
+    // Tensors of different arithmetic types combine in their common type (int + float is float, float + double is
+    // double). A scalar only widens the tensor's type when it is of a different kind (floating vs integral), so
+    // Tensor<float> * 2.0 stays float while Tensor<int> * 0.5 is double.
+    template <typename T, typename U>
+    using promote_t = std::common_type_t<T, U>;
+
+    template <typename T, typename S>
+    using scalar_promote_t =
+        std::conditional_t<std::is_floating_point_v<T> == std::is_floating_point_v<S>, T, std::common_type_t<T, S>>;
+
+    template <typename T>
+    concept Arithmetic = std::is_arithmetic_v<T>;
+
+    namespace detail {
+        // Operands are converted to R as they are loaded inside the loop, so no converted copy is materialized
+        template <typename R, typename A, typename B, typename Op>
+        auto zip_promoted(const Tensor<A>& a, const Tensor<B>& b, Op op) -> Tensor<R> {
+            TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+            Tensor<R> result(a.shape());
+            R* out = result.data();
+            if (a._is_contiguous() && b._is_contiguous()) {
+                const A* pa = a.data();
+                const B* pb = b.data();
+                const SizeType n = result.numel();
+                for (SizeType i = 0; i < n; ++i) {
+                    out[i] = op(static_cast<R>(pa[i]), static_cast<R>(pb[i]));
+                }
+            } else {
+                std::transform(a.begin(), a.end(), b.begin(), out,
+                               [op](const A& x, const B& y) { return op(static_cast<R>(x), static_cast<R>(y)); });
+            }
+            return result;
+        }
+
+        template <typename R, typename A, typename Op>
+        auto map_promoted(const Tensor<A>& a, Op op) -> Tensor<R> {
+            Tensor<R> result(a.shape());
+            R* out = result.data();
+            if (a._is_contiguous()) {
+                const A* pa = a.data();
+                const SizeType n = result.numel();
+                for (SizeType i = 0; i < n; ++i) {
+                    out[i] = op(static_cast<R>(pa[i]));
+                }
+            } else {
+                std::transform(a.begin(), a.end(), out, [op](const A& x) { return op(static_cast<R>(x)); });
+            }
+            return result;
+        }
+
+        // a = op(a, b) computed in the common type and converted back, as for built-in compound assignment
+        template <typename A, typename B, typename Op>
+        void update_promoted(Tensor<A>& a, const Tensor<B>& b, Op op) {
+            using R = promote_t<A, B>;
+            TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+            std::transform(a.begin(), a.end(), b.begin(), a.begin(), [op](const A& x, const B& y) {
+                return static_cast<A>(op(static_cast<R>(x), static_cast<R>(y)));
+            });
+        }
+    }  // namespace detail
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator+(const Tensor<T>& a, const Tensor<U>& b) -> Tensor<promote_t<T, U>> {
+        return detail::zip_promoted<promote_t<T, U>>(a, b, std::plus<>{});
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator+(const Tensor<T>& a, S scalar) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return x + s; });
+    }
+
+    template <Arithmetic S, Arithmetic T>
+    auto operator+(S scalar, const Tensor<T>& a) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return s + x; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator+=(Tensor<T>& a, const Tensor<U>& b) -> Tensor<T>& {
+        detail::update_promoted(a, b, std::plus<>{});
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator+=(Tensor<T>& a, S scalar) -> Tensor<T>& {
+        using R = promote_t<T, S>;
+        const auto s = static_cast<R>(scalar);
+        std::transform(a.begin(), a.end(), a.begin(),
+                       [s](const T& x) { return static_cast<T>(static_cast<R>(x) + s); });
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator-(const Tensor<T>& a, const Tensor<U>& b) -> Tensor<promote_t<T, U>> {
+        return detail::zip_promoted<promote_t<T, U>>(a, b, std::minus<>{});
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator-(const Tensor<T>& a, S scalar) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return x - s; });
+    }
+
+    template <Arithmetic S, Arithmetic T>
+    auto operator-(S scalar, const Tensor<T>& a) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return s - x; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator-=(Tensor<T>& a, const Tensor<U>& b) -> Tensor<T>& {
+        detail::update_promoted(a, b, std::minus<>{});
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator-=(Tensor<T>& a, S scalar) -> Tensor<T>& {
+        using R = promote_t<T, S>;
+        const auto s = static_cast<R>(scalar);
+        std::transform(a.begin(), a.end(), a.begin(),
+                       [s](const T& x) { return static_cast<T>(static_cast<R>(x) - s); });
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator*(const Tensor<T>& a, const Tensor<U>& b) -> Tensor<promote_t<T, U>> {
+        return detail::zip_promoted<promote_t<T, U>>(a, b, std::multiplies<>{});
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator*(const Tensor<T>& a, S scalar) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return x * s; });
+    }
+
+    template <Arithmetic S, Arithmetic T>
+    auto operator*(S scalar, const Tensor<T>& a) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return s * x; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator*=(Tensor<T>& a, const Tensor<U>& b) -> Tensor<T>& {
+        detail::update_promoted(a, b, std::multiplies<>{});
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator*=(Tensor<T>& a, S scalar) -> Tensor<T>& {
+        using R = promote_t<T, S>;
+        const auto s = static_cast<R>(scalar);
+        std::transform(a.begin(), a.end(), a.begin(),
+                       [s](const T& x) { return static_cast<T>(static_cast<R>(x) * s); });
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator/(const Tensor<T>& a, const Tensor<U>& b) -> Tensor<promote_t<T, U>> {
+        return detail::zip_promoted<promote_t<T, U>>(a, b, std::divides<>{});
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator/(const Tensor<T>& a, S scalar) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return x / s; });
+    }
+
+    template <Arithmetic S, Arithmetic T>
+    auto operator/(S scalar, const Tensor<T>& a) -> Tensor<scalar_promote_t<T, S>> {
+        using R = scalar_promote_t<T, S>;
+        return detail::map_promoted<R>(a, [s = static_cast<R>(scalar)](R x) { return s / x; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+        requires(!std::same_as<T, U>)
+    auto operator/=(Tensor<T>& a, const Tensor<U>& b) -> Tensor<T>& {
+        detail::update_promoted(a, b, std::divides<>{});
+        return a;
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator/=(Tensor<T>& a, S scalar) -> Tensor<T>& {
+        using R = promote_t<T, S>;
+        const auto s = static_cast<R>(scalar);
+        std::transform(a.begin(), a.end(), a.begin(),
+                       [s](const T& x) { return static_cast<T>(static_cast<R>(x) / s); });
+        return a;
+    }
 }  // namespace tt::inline v1
\ No newline at end of file
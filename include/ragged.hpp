@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "concepts.hpp"
+#include "operators.hpp"
+#include "tensor.hpp"
+#include "tensor_mask.hpp"
+#include "tensor_views.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // Elements per row of a tensor of this shape: the product of every dim but the first
+        inline auto row_numel(const IndexType& shape) -> SizeType {
+            return shape.empty() ? 0 : std::reduce(shape.begin() + 1, shape.end(), SizeType{1}, std::multiplies<>{});
+        }
+    }  // namespace detail
+
+    // Batch of variable-length segments packed into one buffer. values has shape (total, inner...): segment i owns
+    // rows [offsets[i], offsets[i + 1]) of it, so a batch of sequences of feature vectors is stored without padding.
+    // Elementwise ops run over the packed values only.
+    template <typename T>
+    class RaggedTensor {
+      public:
+        using ValueType = T;
+
+        // Takes the tensors as any Tensor is passed by value; a contiguous view passed in keeps sharing its buffer
+        RaggedTensor(Tensor<int64_t> offsets, Tensor<T> values)
+            : offsets_(std::move(offsets)), values_(std::move(values)) {
+            if (this->offsets_.dim() != 1 || this->offsets_.numel() < 1) {
+                throw std::runtime_error("RaggedTensor: offsets must have shape (segments + 1)");
+            }
+            this->offsets_ = detail::packed(this->offsets_);
+            this->values_ = detail::packed(this->values_);
+            const int64_t* off = this->offsets_.data();
+            if (off[0] != 0 || off[this->num_segments()] != this->values_.shape(0)) {
+                throw std::runtime_error("RaggedTensor: offsets must start at 0 and end at the number of value rows");
+            }
+            for (SizeType i = 0; i < this->num_segments(); ++i) {
+                if (off[i + 1] < off[i]) {
+                    throw std::runtime_error("RaggedTensor: offsets must be non-decreasing");
+                }
+            }
+        }
+
+        static auto from_lengths(const std::vector<int64_t>& lengths, Tensor<T> values) -> RaggedTensor {
+            Tensor<int64_t> offsets({static_cast<SizeType>(lengths.size()) + 1});
+            offsets.data()[0] = 0;
+            std::inclusive_scan(lengths.begin(), lengths.end(), offsets.data() + 1);
+            return RaggedTensor(std::move(offsets), std::move(values));
+        }
+
+        // Packs the segments one after another; they must agree in every dim but the first
+        static auto from_tensors(const std::vector<Tensor<T>>& segments) -> RaggedTensor {
+            if (segments.empty()) {
+                throw std::runtime_error("RaggedTensor: no segments given");
+            }
+            const IndexType inner(segments[0].shape().begin() + 1, segments[0].shape().end());
+            std::vector<int64_t> lengths;
+            for (const auto& s : segments) {
+                if (IndexType(s.shape().begin() + 1, s.shape().end()) != inner) {
+                    throw std::runtime_error("RaggedTensor: segments differ in their trailing dims");
+                }
+                lengths.push_back(s.shape(0));
+            }
+            IndexType shape{std::reduce(lengths.begin(), lengths.end(), int64_t{0})};
+            shape.insert(shape.end(), inner.begin(), inner.end());
+            Tensor<T> values(shape);
+            T* out = values.data();
+            for (const auto& s : segments) {
+                out = std::copy(s.begin(), s.end(), out);
+            }
+            return from_lengths(lengths, std::move(values));
+        }
+
+        // Keeps the entries of padded (shape (segments, max_length, inner...)) whose mask (shape (segments,
+        // max_length)) is set, in order; the mask need not be a prefix of each row
+        static auto from_padded(const Tensor<T>& padded, const Mask& mask) -> RaggedTensor {
+            TINYTEN_CHECK(padded.dim() >= 2, "RaggedTensor: padded tensor needs a segment and a length dim");
+            TINYTEN_CHECK(mask.dim() == 2 && mask.shape(0) == padded.shape(0) && mask.shape(1) == padded.shape(1),
+                          "RaggedTensor: mask must have shape (segments, max_length)");
+            const Tensor<T> dense = detail::packed(padded);
+            const Mask bits = detail::packed(mask);
+            const SizeType rows = padded.shape(0);
+            const SizeType cols = padded.shape(1);
+            const SizeType inner = detail::row_numel(IndexType(padded.shape().begin() + 1, padded.shape().end()));
+
+            Tensor<int64_t> offsets({rows + 1});
+            int64_t* off = offsets.data();
+            off[0] = 0;
+            tt::parallel_for(0, rows, 64, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    off[i + 1] = std::count_if(bits.data() + i * cols, bits.data() + (i + 1) * cols,
+                                               [](uint8_t b) { return b != 0; });
+                }
+            });
+            std::inclusive_scan(off, off + rows + 1, off);
+
+            IndexType shape(padded.shape().begin() + 1, padded.shape().end());
+            shape[0] = off[rows];
+            Tensor<T> values(shape);
+            tt::parallel_for_segments(off, rows, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    T* out = values.data() + off[i] * inner;
+                    for (SizeType j = 0; j < cols; ++j) {
+                        if (bits.data()[i * cols + j]) {
+                            const T* row = dense.data() + (i * cols + j) * inner;
+                            out = std::copy(row, row + inner, out);
+                        }
+                    }
+                }
+            });
+            return RaggedTensor(std::move(offsets), std::move(values));
+        }
+
+        // Keeps the first lengths[i] entries of row i of padded
+        static auto from_padded(const Tensor<T>& padded, const std::vector<int64_t>& lengths) -> RaggedTensor {
+            TINYTEN_CHECK(padded.dim() >= 2 && static_cast<SizeType>(lengths.size()) == padded.shape(0),
+                          "RaggedTensor: need one length per row of the padded tensor");
+            Mask mask({padded.shape(0), padded.shape(1)});
+            for (SizeType i = 0; i < padded.shape(0); ++i) {
+                TINYTEN_CHECK(lengths[i] >= 0 && lengths[i] <= padded.shape(1), "RaggedTensor: length out of bounds");
+                std::fill(mask.data() + i * padded.shape(1), mask.data() + i * padded.shape(1) + lengths[i], 1);
+            }
+            return from_padded(padded, mask);
+        }
+
+        // Dense tensor of shape (segments, max_length, inner...) with the tail of every shorter segment set to
+        // pad, and the mask marking the entries that hold values
+        [[nodiscard]] auto to_padded(const T& pad = T{}) const -> std::pair<Tensor<T>, Mask> {
+            const SizeType rows = this->num_segments();
+            const SizeType cols = this->max_length();
+            const SizeType inner = this->inner_numel();
+            IndexType shape = this->values_.shape();
+            shape[0] = cols;
+            shape.insert(shape.begin(), rows);
+            Tensor<T> padded(shape, pad);
+            Mask mask({rows, cols});
+            const int64_t* off = this->offset_ptr();
+            tt::parallel_for_segments(off, rows, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    std::copy(this->value_ptr() + off[i] * inner, this->value_ptr() + off[i + 1] * inner,
+                              padded.data() + i * cols * inner);
+                    std::fill(mask.data() + i * cols, mask.data() + i * cols + (off[i + 1] - off[i]), 1);
+                }
+            });
+            return {std::move(padded), std::move(mask)};
+        }
+
+        [[nodiscard]] auto num_segments() const noexcept -> SizeType {
+            return this->offsets_.numel() - 1;
+        }
+
+        // Number of packed rows across all segments
+        [[nodiscard]] auto num_rows() const noexcept -> SizeType {
+            return this->values_.shape(0);
+        }
+
+        [[nodiscard]] auto numel() const noexcept -> SizeType {
+            return this->values_.numel();
+        }
+
+        // Elements per packed row
+        [[nodiscard]] auto inner_numel() const noexcept -> SizeType {
+            return detail::row_numel(this->values_.shape());
+        }
+
+        [[nodiscard]] auto inner_shape() const -> IndexType {
+            return IndexType(this->values_.shape().begin() + 1, this->values_.shape().end());
+        }
+
+        [[nodiscard]] auto length(SizeType i) const -> SizeType {
+            TINYTEN_CHECK(i >= 0 && i < this->num_segments(), "RaggedTensor: segment out of bounds");
+            return this->offset_ptr()[i + 1] - this->offset_ptr()[i];
+        }
+
+        [[nodiscard]] auto lengths() const -> Tensor<int64_t> {
+            Tensor<int64_t> result({this->num_segments()});
+            // offsets start at 0, so the first difference is the first offset past it
+            std::adjacent_difference(this->offset_ptr() + 1, this->offset_ptr() + this->num_segments() + 1,
+                                     result.data());
+            return result;
+        }
+
+        [[nodiscard]] auto max_length() const -> SizeType {
+            SizeType result = 0;
+            for (SizeType i = 0; i < this->num_segments(); ++i) {
+                result = std::max<SizeType>(result, this->offset_ptr()[i + 1] - this->offset_ptr()[i]);
+            }
+            return result;
+        }
+
+        // Segment i as a view of the packed values
+        [[nodiscard]] auto segment(SizeType i) const -> Tensor<T> {
+            TINYTEN_CHECK(i >= 0 && i < this->num_segments(), "RaggedTensor: segment out of bounds");
+            return this->values_.narrow(0, this->offset_ptr()[i], this->length(i));
+        }
+
+        [[nodiscard]] auto offsets() const noexcept -> const Tensor<int64_t>& {
+            return this->offsets_;
+        }
+
+        [[nodiscard]] auto values() const noexcept -> const Tensor<T>& {
+            return this->values_;
+        }
+
+        template <typename U>
+        [[nodiscard]] auto same_layout(const RaggedTensor<U>& other) const -> bool {
+            return this->inner_shape() == other.inner_shape() && this->offsets_.numel() == other.offsets().numel() &&
+                   std::equal(this->offset_ptr(), this->offset_ptr() + this->offsets_.numel(), other.offsets().data());
+        }
+
+        template <typename F>
+        auto map_(F f) -> RaggedTensor& {
+            T* vals = this->values_.data();
+            tt::parallel_for(0, this->numel(), 1 << 14, [&](SizeType lo, SizeType hi) {
+                std::transform(vals + lo, vals + hi, vals + lo, f);
+            });
+            return *this;
+        }
+
+        template <typename F>
+        [[nodiscard]] auto map(F f) const -> RaggedTensor {
+            return RaggedTensor(*this).map_(f);
+        }
+
+      private:
+        Tensor<int64_t> offsets_;
+        Tensor<T> values_;
+
+        [[nodiscard]] auto offset_ptr() const -> const int64_t* {
+            return this->offsets_.data();
+        }
+
+        [[nodiscard]] auto value_ptr() const -> const T* {
+            return this->values_.data();
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    // Elementwise ops on the packed values; both operands must have the same segments
+    ////////////////////////////////////////////////////////////////////
+    namespace detail {
+        template <typename T, typename U, typename F>
+        auto zip_ragged(const RaggedTensor<T>& a, const RaggedTensor<U>& b, F f) {
+            TINYTEN_CHECK(a.same_layout(b), "RaggedTensor: segments are not the same");
+            auto values = f(a.values(), b.values());
+            return RaggedTensor<typename decltype(values)::ValueType>(a.offsets().view(), std::move(values));
+        }
+
+        template <typename T, typename F>
+        auto map_ragged(const RaggedTensor<T>& a, F f) {
+            auto values = f(a.values());
+            return RaggedTensor<typename decltype(values)::ValueType>(a.offsets().view(), std::move(values));
+        }
+    }  // namespace detail
+
+    template <Arithmetic T, Arithmetic U>
+    auto operator+(const RaggedTensor<T>& a, const RaggedTensor<U>& b) -> RaggedTensor<promote_t<T, U>> {
+        return detail::zip_ragged(a, b, [](const auto& x, const auto& y) { return x + y; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+    auto operator-(const RaggedTensor<T>& a, const RaggedTensor<U>& b) -> RaggedTensor<promote_t<T, U>> {
+        return detail::zip_ragged(a, b, [](const auto& x, const auto& y) { return x - y; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+    auto operator*(const RaggedTensor<T>& a, const RaggedTensor<U>& b) -> RaggedTensor<promote_t<T, U>> {
+        return detail::zip_ragged(a, b, [](const auto& x, const auto& y) { return x * y; });
+    }
+
+    template <Arithmetic T, Arithmetic U>
+    auto operator/(const RaggedTensor<T>& a, const RaggedTensor<U>& b) -> RaggedTensor<promote_t<T, U>> {
+        return detail::zip_ragged(a, b, [](const auto& x, const auto& y) { return x / y; });
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator+(const RaggedTensor<T>& a, S scalar) -> RaggedTensor<scalar_promote_t<T, S>> {
+        return detail::map_ragged(a, [scalar](const auto& x) { return x + scalar; });
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator-(const RaggedTensor<T>& a, S scalar) -> RaggedTensor<scalar_promote_t<T, S>> {
+        return detail::map_ragged(a, [scalar](const auto& x) { return x - scalar; });
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator*(const RaggedTensor<T>& a, S scalar) -> RaggedTensor<scalar_promote_t<T, S>> {
+        return detail::map_ragged(a, [scalar](const auto& x) { return x * scalar; });
+    }
+
+    template <Arithmetic T, Arithmetic S>
+    auto operator/(const RaggedTensor<T>& a, S scalar) -> RaggedTensor<scalar_promote_t<T, S>> {
+        return detail::map_ragged(a, [scalar](const auto& x) { return x / scalar; });
+    }
+
+    template <Arithmetic S, Arithmetic T>
+    auto operator*(S scalar, const RaggedTensor<T>& a) -> RaggedTensor<scalar_promote_t<T, S>> {
+        return a * scalar;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Segment reductions: row i of the result reduces rows [offsets[i], offsets[i + 1]) of values. Segments are
+    // spread over the pool in blocks of roughly equal length; an empty segment reduces to T{}.
+    ////////////////////////////////////////////////////////////////////
+    namespace detail {
+        // out = first row, then op(out, row) for every further row, then finish(out, length)
+        template <typename T, typename Op, typename Finish>
+        auto segment_reduce(const Tensor<T>& values, const Tensor<int64_t>& offsets, Op op, Finish finish)
+            -> Tensor<T> {
+            TINYTEN_CHECK(values.dim() >= 1 && offsets.dim() == 1 && offsets.numel() >= 1,
+                          "segment reduction: values must have shape (total, ...), offsets shape (segments + 1)");
+            const Tensor<T> vals = packed(values);
+            const Tensor<int64_t> offs = packed(offsets);
+            const int64_t* off = offs.data();
+            const SizeType segments = offs.numel() - 1;
+            TINYTEN_CHECK(off[0] == 0 && off[segments] == values.shape(0),
+                          "segment reduction: offsets must start at 0 and end at the number of value rows");
+            TINYTEN_CHECK(std::is_sorted(off, off + segments + 1), "segment reduction: offsets must be non-decreasing");
+            IndexType shape = values.shape();
+            shape[0] = segments;
+            Tensor<T> result(shape);
+            const SizeType inner = row_numel(shape);
+            const T* src = vals.data();
+            T* dst = result.data();
+            tt::parallel_for_segments(off, segments, [&](SizeType lo, SizeType hi) {
+                for (SizeType s = lo; s < hi; ++s) {
+                    const SizeType len = off[s + 1] - off[s];
+                    if (len <= 0) {
+                        continue;
+                    }
+                    T* out = dst + s * inner;
+                    const T* row = src + off[s] * inner;
+                    std::copy(row, row + inner, out);
+                    for (SizeType r = 1; r < len; ++r) {
+                        row += inner;
+                        for (SizeType j = 0; j < inner; ++j) {
+                            out[j] = op(out[j], row[j]);
+                        }
+                    }
+                    finish(out, inner, len);
+                }
+            });
+            return result;
+        }
+
+        struct NoFinish {
+            template <typename T>
+            void operator()(T*, SizeType, SizeType) const {}
+        };
+    }  // namespace detail
+
+    template <typename T>
+    auto segment_sum(const Tensor<T>& values, const Tensor<int64_t>& offsets) -> Tensor<T> requires SupportsAdd<T> {
+        return detail::segment_reduce(values, offsets, std::plus<>{}, detail::NoFinish{});
+    }
+
+    template <typename T>
+    auto segment_mean(const Tensor<T>& values, const Tensor<int64_t>& offsets) -> Tensor<T> requires SupportsAdd<T> {
+        return detail::segment_reduce(values, offsets, std::plus<>{}, [](T* out, SizeType inner, SizeType len) {
+            for (SizeType j = 0; j < inner; ++j) {
+                out[j] /= static_cast<T>(len);
+            }
+        });
+    }
+
+    template <typename T>
+    auto segment_max(const Tensor<T>& values, const Tensor<int64_t>& offsets) -> Tensor<T> {
+        return detail::segment_reduce(
+            values, offsets, [](const T& a, const T& b) { return a < b ? b : a; }, detail::NoFinish{});
+    }
+
+    template <typename T>
+    auto segment_min(const Tensor<T>& values, const Tensor<int64_t>& offsets) -> Tensor<T> {
+        return detail::segment_reduce(
+            values, offsets, [](const T& a, const T& b) { return b < a ? b : a; }, detail::NoFinish{});
+    }
+
+    template <typename T>
+    auto segment_sum(const RaggedTensor<T>& ragged) -> Tensor<T> requires SupportsAdd<T> {
+        return segment_sum(ragged.values(), ragged.offsets());
+    }
+
+    template <typename T>
+    auto segment_mean(const RaggedTensor<T>& ragged) -> Tensor<T> requires SupportsAdd<T> {
+        return segment_mean(ragged.values(), ragged.offsets());
+    }
+
+    template <typename T>
+    auto segment_max(const RaggedTensor<T>& ragged) -> Tensor<T> {
+        return segment_max(ragged.values(), ragged.offsets());
+    }
+
+    template <typename T>
+    auto segment_min(const RaggedTensor<T>& ragged) -> Tensor<T> {
+        return segment_min(ragged.values(), ragged.offsets());
+    }
+};  // namespace tt::inline v1
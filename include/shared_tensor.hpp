@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dyn_tensor.hpp"
+#include "tensor.hpp"
+#include "tensor_views.hpp"
+#include "utils/Check.hpp"
+#include "utils/SharedMemory.hpp"
+
+// Tensors in POSIX shared memory, for worker processes on one host.
+//
+// A shared tensor's buffer is a shm_open segment (StorageOptions::shared). share() describes a tensor by a small
+// handle (segment name, dtype, shape, strides, offset) that can be sent to another process in any way, e.g. as one
+// line of text over a pipe; open_shared() maps the segment there and views the same elements without copying.
+// Segments are reference counted across processes and unlinked when the last tensor or handle referring to them is
+// gone. SharedTensorPool recycles a fixed ring of segments for a producer that keeps sending tensors of one shape.
+namespace tt::inline v1 {
+    // Carries one reference on its segment, which open_shared takes over: open a handle exactly once, or drop it with
+    // release_shared
+    struct SharedTensorHandle {
+        std::string name;
+        DType dtype = DType::Float32;
+        IndexType shape;
+        IndexType strides;
+        SizeType offset = 0;
+
+        // "name dtype rank shape... strides... offset"
+        [[nodiscard]] auto to_string() const -> std::string {
+            std::ostringstream out;
+            out << this->name << ' ' << static_cast<int>(this->dtype) << ' ' << this->shape.size();
+            for (const SizeType s : this->shape) {
+                out << ' ' << s;
+            }
+            for (const SizeType s : this->strides) {
+                out << ' ' << s;
+            }
+            out << ' ' << this->offset;
+            return out.str();
+        }
+
+        static auto from_string(const std::string& text) -> SharedTensorHandle {
+            std::istringstream in(text);
+            SharedTensorHandle handle;
+            int dtype = -1;
+            size_t rank = 0;
+            in >> handle.name >> dtype >> rank;
+            if (!in || dtype < 0 || dtype > static_cast<int>(DType::Float64) || rank > 64) {
+                throw std::runtime_error("SharedTensorHandle: malformed handle");
+            }
+            handle.dtype = static_cast<DType>(dtype);
+            handle.shape.resize(rank);
+            handle.strides.resize(rank);
+            for (auto& s : handle.shape) {
+                in >> s;
+            }
+            for (auto& s : handle.strides) {
+                in >> s;
+            }
+            in >> handle.offset;
+            if (!in) {
+                throw std::runtime_error("SharedTensorHandle: malformed handle");
+            }
+            return handle;
+        }
+    };
+
+    namespace detail {
+        // A contiguous tensor over the whole segment. The buffer takes its own reference; `adopt` additionally hands
+        // over one the caller held (from creating the segment or from a handle), also when construction fails.
+        template <SupportedDType T>
+        auto segment_tensor(std::shared_ptr<SharedSegment> segment, bool adopt) -> Tensor<T> {
+            struct Release {
+                SharedSegment* segment;
+                ~Release() {
+                    if (this->segment != nullptr) {
+                        this->segment->release();
+                    }
+                }
+            } release{adopt ? segment.get() : nullptr};
+            StorageOptions options;
+            options.shared = std::move(segment);
+            const auto numel = static_cast<SizeType>(options.shared->bytes() / sizeof(T));
+            return Tensor<T>({numel}, options);
+        }
+
+        template <SupportedDType T>
+        auto new_segment_tensor(const IndexType& shape) -> Tensor<T> {
+            TINYTEN_CHECK(!shape.empty(), "shared_tensor: rank-0 tensors are not supported");
+            const SizeType numel = tt::cumprod(shape);
+            auto segment = SharedSegment::create(unique_segment_name(), static_cast<size_t>(numel) * sizeof(T));
+            Tensor<T> tensor = segment_tensor<T>(std::move(segment), true);
+            tensor.reshape_(shape);
+            return tensor;
+        }
+    }  // namespace detail
+
+    template <typename T>
+    auto is_shared(const Tensor<T>& tensor) -> bool {
+        return tensor.storage_options().shared != nullptr;
+    }
+
+    // Zero-filled tensor in a new segment
+    template <SupportedDType T>
+    auto shared_tensor(const IndexType& shape) -> Tensor<T> {
+        return detail::new_segment_tensor<T>(shape);
+    }
+
+    // Contiguous copy of tensor in a new segment
+    template <SupportedDType T>
+    auto to_shared(const Tensor<T>& tensor) -> Tensor<T> {
+        Tensor<T> result = detail::new_segment_tensor<T>(tensor.shape());
+        if (tensor._is_contiguous()) {
+            std::copy(tensor.data(), tensor.data() + tensor.numel(), result.data());
+        } else {
+            std::copy(tensor.begin(), tensor.end(), result.data());
+        }
+        return result;
+    }
+
+    // Handle to a tensor (or view) in shared memory, holding a reference for the time it is in flight
+    template <SupportedDType T>
+    auto share(const Tensor<T>& tensor) -> SharedTensorHandle {
+        const auto& segment = tensor.storage_options().shared;
+        TINYTEN_CHECK(segment != nullptr, "share: tensor is not in shared memory (see to_shared)");
+        segment->retain();
+        return {segment->name(), dtype_of<T>, tensor.shape(), tensor.strides(), tensor.storage_offset()};
+    }
+
+    // Views the shared tensor in place, taking over the handle's reference
+    template <SupportedDType T>
+    auto open_shared(const SharedTensorHandle& handle) -> Tensor<T> {
+        TINYTEN_CHECK(handle.dtype == dtype_of<T>, "open_shared: dtype mismatch");
+        return detail::segment_tensor<T>(detail::SharedSegment::open(handle.name), true)
+            .as_strided(handle.shape, handle.strides, handle.offset);
+    }
+
+    inline auto open_shared(const SharedTensorHandle& handle) -> DynTensor {
+        return visit_dtype(handle.dtype, [&handle](auto tag) {
+            return DynTensor(open_shared<typename decltype(tag)::type>(handle));
+        });
+    }
+
+    // Drops a handle that will not be opened
+    inline void release_shared(const SharedTensorHandle& handle) {
+        detail::SharedSegment::open(handle.name)->release();
+    }
+
+    // A ring of segments holding tensors of one shape. acquire() hands the slots out in turn; a slot is free again
+    // once every tensor over it and every handle to it, in any process, is gone, and acquire() waits for that. The
+    // contents of a recycled slot are whatever its last user left.
+    template <SupportedDType T>
+    class SharedTensorPool {
+      public:
+        SharedTensorPool(IndexType shape, SizeType slots) : shape_(std::move(shape)) {
+            TINYTEN_CHECK(!this->shape_.empty() && slots > 0, "SharedTensorPool: invalid shape or slot count");
+            const auto bytes = static_cast<size_t>(tt::cumprod(this->shape_)) * sizeof(T);
+            this->segments_.reserve(static_cast<size_t>(slots));
+            try {
+                for (SizeType i = 0; i < slots; ++i) {
+                    // the pool keeps the creator's reference of every slot
+                    this->segments_.push_back(detail::SharedSegment::create(detail::unique_segment_name(), bytes));
+                }
+            } catch (...) {
+                for (const auto& segment : this->segments_) {
+                    segment->release();
+                }
+                throw;
+            }
+        }
+
+        SharedTensorPool(const SharedTensorPool&) = delete;
+        auto operator=(const SharedTensorPool&) -> SharedTensorPool& = delete;
+
+        ~SharedTensorPool() {
+            for (const auto& segment : this->segments_) {
+                segment->release();
+            }
+        }
+
+        // The next slot of the ring, waiting until it is free
+        auto acquire() -> Tensor<T> {
+            for (int spins = 0;; ++spins) {
+                if (auto tensor = this->try_acquire()) {
+                    return std::move(*tensor);
+                }
+                if (spins < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+        }
+
+        // The next slot of the ring, or nothing if it is still in use
+        auto try_acquire() -> std::optional<Tensor<T>> {
+            std::lock_guard lock(this->mutex_);
+            const auto& segment = this->segments_[this->next_];
+            if (segment->refs() != 1) {
+                return std::nullopt;
+            }
+            this->next_ = (this->next_ + 1) % this->segments_.size();
+            Tensor<T> tensor = detail::segment_tensor<T>(segment, false);
+            tensor.reshape_(this->shape_);
+            return tensor;
+        }
+
+        [[nodiscard]] auto slots() const noexcept -> SizeType {
+            return static_cast<SizeType>(this->segments_.size());
+        }
+
+        [[nodiscard]] auto shape() const noexcept -> const IndexType& {
+            return this->shape_;
+        }
+
+      private:
+        IndexType shape_;
+        std::vector<std::shared_ptr<detail::SharedSegment>> segments_;
+        std::mutex mutex_;
+        size_t next_ = 0;
+    };
+};  // namespace tt::inline v1
@@ -0,0 +1,577 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "concepts.hpp"
+#include "tensor.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    template <typename T>
+    class SparseCSR;
+
+    // Coordinate-format sparse tensor of any rank. indices has shape (dim, nnz): column k holds the coordinates of
+    // values(k). Duplicate coordinates are allowed and are summed by to_dense() and coalesce().
+    template <typename T>
+    class SparseCOO {
+      public:
+        using ValueType = T;
+
+        SparseCOO(IndexType shape, Tensor<int64_t> indices, Tensor<T> values)
+            : shape_(std::move(shape)), indices_(std::move(indices)), values_(std::move(values)) {
+            if (this->indices_.dim() != 2 || this->indices_.shape(0) != this->dim()) {
+                throw std::runtime_error("SparseCOO: indices must have shape (dim, nnz)");
+            }
+            if (this->values_.dim() != 1 || this->values_.shape(0) != this->indices_.shape(1)) {
+                throw std::runtime_error("SparseCOO: values must have shape (nnz)");
+            }
+            this->indices_ = this->indices_.contiguous();
+            this->values_ = this->values_.contiguous();
+            const int64_t* idx = this->indices_.data();
+            for (SizeType d = 0; d < this->dim(); ++d) {
+                for (SizeType k = 0; k < this->nnz(); ++k) {
+                    if (idx[d * this->nnz() + k] < 0 || idx[d * this->nnz() + k] >= this->shape_[d]) {
+                        throw std::runtime_error("SparseCOO: index out of bounds");
+                    }
+                }
+            }
+        }
+
+        static auto from_dense(const Tensor<T>& dense) -> SparseCOO {
+            std::vector<int64_t> flat;
+            std::vector<T> vals;
+            SizeType i = 0;
+            for (const T& v : dense) {
+                if (v != T{}) {
+                    flat.push_back(i);
+                    vals.push_back(v);
+                }
+                ++i;
+            }
+
+            const auto nnz = static_cast<SizeType>(flat.size());
+            const IndexType canon = tt::calc_strides(dense.shape());
+            Tensor<int64_t> indices({dense.dim(), nnz});
+            Tensor<T> values({nnz});
+            for (SizeType k = 0; k < nnz; ++k) {
+                int64_t rem = flat[k];
+                for (SizeType d = 0; d < dense.dim(); ++d) {
+                    indices.data()[d * nnz + k] = rem / canon[d];
+                    rem %= canon[d];
+                }
+                values.data()[k] = vals[k];
+            }
+            return SparseCOO(dense.shape(), std::move(indices), std::move(values));
+        }
+
+        [[nodiscard]] auto to_dense() const -> Tensor<T> {
+            Tensor<T> dense(this->shape_);
+            T* out = dense.data();
+            for (SizeType k = 0; k < this->nnz(); ++k) {
+                out[this->linear_index(k)] += this->values_.data()[k];
+            }
+            return dense;
+        }
+
+        // Sorts the stored elements in row-major order and sums duplicates
+        [[nodiscard]] auto coalesce() const -> SparseCOO {
+            const SizeType n = this->nnz();
+            std::vector<int64_t> linear(n);
+            std::vector<int64_t> order(n);
+            for (SizeType k = 0; k < n; ++k) {
+                linear[k] = this->linear_index(k);
+            }
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) { return linear[a] < linear[b]; });
+
+            std::vector<int64_t> uniq;
+            std::vector<T> vals;
+            for (SizeType k = 0; k < n; ++k) {
+                if (!uniq.empty() && uniq.back() == linear[order[k]]) {
+                    vals.back() += this->values_.data()[order[k]];
+                } else {
+                    uniq.push_back(linear[order[k]]);
+                    vals.push_back(this->values_.data()[order[k]]);
+                }
+            }
+
+            const auto m = static_cast<SizeType>(uniq.size());
+            const IndexType canon = tt::calc_strides(this->shape_);
+            Tensor<int64_t> indices({this->dim(), m});
+            Tensor<T> values({m});
+            for (SizeType k = 0; k < m; ++k) {
+                int64_t rem = uniq[k];
+                for (SizeType d = 0; d < this->dim(); ++d) {
+                    indices.data()[d * m + k] = rem / canon[d];
+                    rem %= canon[d];
+                }
+                values.data()[k] = vals[k];
+            }
+            return SparseCOO(this->shape_, std::move(indices), std::move(values));
+        }
+
+        [[nodiscard]] auto to_csr() const -> SparseCSR<T>;
+
+        [[nodiscard]] auto nnz() const noexcept -> SizeType {
+            return this->values_.numel();
+        }
+
+        [[nodiscard]] auto shape() const noexcept -> const IndexType& {
+            return this->shape_;
+        }
+
+        [[nodiscard]] auto dim() const noexcept -> SizeType {
+            return static_cast<SizeType>(this->shape_.size());
+        }
+
+        [[nodiscard]] auto numel() const noexcept -> SizeType {
+            return tt::cumprod(this->shape_);
+        }
+
+        [[nodiscard]] auto indices() const noexcept -> const Tensor<int64_t>& {
+            return this->indices_;
+        }
+
+        [[nodiscard]] auto values() const noexcept -> const Tensor<T>& {
+            return this->values_;
+        }
+
+        // Applies f to the stored values only; f must map zero to zero for the result to be meaningful
+        template <typename F>
+        auto map_(F f) -> SparseCOO& {
+            std::transform(this->values_.data(), this->values_.data() + this->nnz(), this->values_.data(), f);
+            return *this;
+        }
+
+        template <typename F>
+        [[nodiscard]] auto map(F f) const -> SparseCOO {
+            return SparseCOO(*this).map_(f);
+        }
+
+        [[nodiscard]] auto sum() const -> T {
+            return std::reduce(this->values_.data(), this->values_.data() + this->nnz(), T{});
+        }
+
+      private:
+        IndexType shape_;
+        Tensor<int64_t> indices_;
+        Tensor<T> values_;
+
+        [[nodiscard]] auto linear_index(SizeType k) const -> int64_t {
+            int64_t linear = 0;
+            for (SizeType d = 0; d < this->dim(); ++d) {
+                linear = linear * this->shape_[d] + this->indices_.data()[d * this->nnz() + k];
+            }
+            return linear;
+        }
+    };
+
+    // Compressed sparse row matrix. Row i stores its column indices, in increasing order, in
+    // col_indices[crow_indices[i] : crow_indices[i + 1]] and the matching values at the same positions in values.
+    template <typename T>
+    class SparseCSR {
+      public:
+        using ValueType = T;
+
+        SparseCSR(IndexType shape, Tensor<int64_t> crow_indices, Tensor<int64_t> col_indices, Tensor<T> values)
+            : shape_(std::move(shape)),
+              crow_(std::move(crow_indices)),
+              col_(std::move(col_indices)),
+              values_(std::move(values)) {
+            if (this->shape_.size() != 2) {
+                throw std::runtime_error("SparseCSR: only 2-D matrices are supported");
+            }
+            if (this->crow_.dim() != 1 || this->crow_.shape(0) != this->rows() + 1) {
+                throw std::runtime_error("SparseCSR: crow_indices must have shape (rows + 1)");
+            }
+            if (this->col_.dim() != 1 || this->values_.dim() != 1 || this->col_.shape(0) != this->values_.shape(0)) {
+                throw std::runtime_error("SparseCSR: col_indices and values must have shape (nnz)");
+            }
+            this->crow_ = this->crow_.contiguous();
+            this->col_ = this->col_.contiguous();
+            this->values_ = this->values_.contiguous();
+
+            const int64_t* crow = this->crow_.data();
+            const int64_t* col = this->col_.data();
+            if (crow[0] != 0 || crow[this->rows()] != this->nnz()) {
+                throw std::runtime_error("SparseCSR: crow_indices must start at 0 and end at nnz");
+            }
+            for (SizeType i = 0; i < this->rows(); ++i) {
+                if (crow[i + 1] < crow[i]) {
+                    throw std::runtime_error("SparseCSR: crow_indices must be non-decreasing");
+                }
+                for (int64_t k = crow[i]; k < crow[i + 1]; ++k) {
+                    if (col[k] < 0 || col[k] >= this->cols() || (k > crow[i] && col[k] <= col[k - 1])) {
+                        throw std::runtime_error("SparseCSR: column indices must be in range and sorted within a row");
+                    }
+                }
+            }
+        }
+
+        static auto from_dense(const Tensor<T>& dense) -> SparseCSR {
+            if (dense.dim() != 2) {
+                throw std::runtime_error("SparseCSR: only 2-D matrices are supported");
+            }
+            const SizeType rows = dense.shape(0);
+            const SizeType cols = dense.shape(1);
+            const SizeType rs = dense.stride(0);
+            const SizeType cs = dense.stride(1);
+            const T* src = dense.data();
+
+            // count, scan, fill: both passes are independent across rows
+            Tensor<int64_t> crow({rows + 1});
+            int64_t* counts = crow.data();
+            counts[0] = 0;
+            tt::parallel_for(0, rows, 64, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    int64_t c = 0;
+                    for (SizeType j = 0; j < cols; ++j) {
+                        c += src[i * rs + j * cs] != T{};
+                    }
+                    counts[i + 1] = c;
+                }
+            });
+            std::inclusive_scan(counts, counts + rows + 1, counts);
+
+            const SizeType nnz = counts[rows];
+            Tensor<int64_t> col({nnz});
+            Tensor<T> values({nnz});
+            tt::parallel_for(0, rows, 64, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    int64_t k = counts[i];
+                    for (SizeType j = 0; j < cols; ++j) {
+                        const T v = src[i * rs + j * cs];
+                        if (v != T{}) {
+                            col.data()[k] = j;
+                            values.data()[k] = v;
+                            ++k;
+                        }
+                    }
+                }
+            });
+            return SparseCSR({rows, cols}, std::move(crow), std::move(col), std::move(values));
+        }
+
+        [[nodiscard]] auto to_dense() const -> Tensor<T> {
+            Tensor<T> dense(this->shape_);
+            T* out = dense.data();
+            const SizeType cols = this->cols();
+            this->for_each_row_block([&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    for (int64_t k = this->crow_ptr()[i]; k < this->crow_ptr()[i + 1]; ++k) {
+                        out[i * cols + this->col_ptr()[k]] = this->value_ptr()[k];
+                    }
+                }
+            });
+            return dense;
+        }
+
+        [[nodiscard]] auto to_coo() const -> SparseCOO<T> {
+            Tensor<int64_t> indices({2, this->nnz()});
+            int64_t* rows = indices.data();
+            int64_t* cols = indices.data() + this->nnz();
+            for (SizeType i = 0; i < this->rows(); ++i) {
+                std::fill(rows + this->crow_ptr()[i], rows + this->crow_ptr()[i + 1], i);
+            }
+            std::copy(this->col_ptr(), this->col_ptr() + this->nnz(), cols);
+            return SparseCOO<T>(this->shape_, std::move(indices), Tensor<T>(this->values_));
+        }
+
+        [[nodiscard]] auto nnz() const noexcept -> SizeType {
+            return this->values_.numel();
+        }
+
+        [[nodiscard]] auto shape() const noexcept -> const IndexType& {
+            return this->shape_;
+        }
+
+        [[nodiscard]] auto rows() const noexcept -> SizeType {
+            return this->shape_[0];
+        }
+
+        [[nodiscard]] auto cols() const noexcept -> SizeType {
+            return this->shape_[1];
+        }
+
+        [[nodiscard]] auto numel() const noexcept -> SizeType {
+            return this->rows() * this->cols();
+        }
+
+        [[nodiscard]] auto crow_indices() const noexcept -> const Tensor<int64_t>& {
+            return this->crow_;
+        }
+
+        [[nodiscard]] auto col_indices() const noexcept -> const Tensor<int64_t>& {
+            return this->col_;
+        }
+
+        [[nodiscard]] auto values() const noexcept -> const Tensor<T>& {
+            return this->values_;
+        }
+
+        // Applies f to the stored values only; f must map zero to zero for the result to be meaningful
+        template <typename F>
+        auto map_(F f) -> SparseCSR& {
+            T* vals = this->values_.data();
+            tt::parallel_for(0, this->nnz(), 1 << 14, [&](SizeType lo, SizeType hi) {
+                std::transform(vals + lo, vals + hi, vals + lo, f);
+            });
+            return *this;
+        }
+
+        template <typename F>
+        [[nodiscard]] auto map(F f) const -> SparseCSR {
+            return SparseCSR(*this).map_(f);
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Reductions, implicit zeros are never visited
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] auto sum() const -> T {
+            return std::reduce(this->value_ptr(), this->value_ptr() + this->nnz(), T{});
+        }
+
+        [[nodiscard]] auto sum(SizeType dim) const -> Tensor<T> {
+            if (dim == 1) {
+                Tensor<T> result({this->rows()});
+                T* out = result.data();
+                this->for_each_row_block([&](SizeType lo, SizeType hi) {
+                    for (SizeType i = lo; i < hi; ++i) {
+                        out[i] = std::reduce(this->value_ptr() + this->crow_ptr()[i],
+                                             this->value_ptr() + this->crow_ptr()[i + 1], T{});
+                    }
+                });
+                return result;
+            }
+            if (dim == 0) {
+                Tensor<T> result({this->cols()});
+                T* out = result.data();
+                for (SizeType k = 0; k < this->nnz(); ++k) {
+                    out[this->col_ptr()[k]] += this->value_ptr()[k];
+                }
+                return result;
+            }
+            throw std::runtime_error("sum: dim out of bounds");
+        }
+
+        [[nodiscard]] auto max() const -> T {
+            return this->extreme("max", [](T a, T b) { return std::max(a, b); });
+        }
+
+        [[nodiscard]] auto min() const -> T {
+            return this->extreme("min", [](T a, T b) { return std::min(a, b); });
+        }
+
+        // Calls f(row_lo, row_hi) on row blocks holding roughly equal numbers of stored elements, in parallel
+        template <typename F>
+        void for_each_row_block(F&& f) const {
+            tt::parallel_for_segments(this->crow_ptr(), this->rows(), std::forward<F>(f));
+        }
+
+      private:
+        IndexType shape_;
+        Tensor<int64_t> crow_;
+        Tensor<int64_t> col_;
+        Tensor<T> values_;
+
+        template <typename U>
+        friend class SparseCSR;
+
+        [[nodiscard]] auto crow_ptr() const -> const int64_t* {
+            return this->crow_.data();
+        }
+
+        [[nodiscard]] auto col_ptr() const -> const int64_t* {
+            return this->col_.data();
+        }
+
+        [[nodiscard]] auto value_ptr() const -> const T* {
+            return this->values_.data();
+        }
+
+        template <typename Op>
+        [[nodiscard]] auto extreme(const char* name, Op op) const -> T {
+            if (this->numel() == 0) {
+                throw std::runtime_error(std::string(name) + ": tensor is empty");
+            }
+            if (this->nnz() == 0) {
+                return T{};
+            }
+            T acc = std::reduce(this->value_ptr() + 1, this->value_ptr() + this->nnz(), this->value_ptr()[0], op);
+            return this->nnz() < this->numel() ? op(acc, T{}) : acc;
+        }
+    };
+
+    template <typename T>
+    auto SparseCOO<T>::to_csr() const -> SparseCSR<T> {
+        if (this->dim() != 2) {
+            throw std::runtime_error("to_csr: only 2-D tensors can be converted");
+        }
+        const SparseCOO sorted = this->coalesce();
+        const SizeType nnz = sorted.nnz();
+        const int64_t* rows = sorted.indices_.data();
+        Tensor<int64_t> crow({this->shape_[0] + 1});
+        Tensor<int64_t> col({nnz});
+        for (SizeType k = 0; k < nnz; ++k) {
+            crow.data()[rows[k] + 1]++;
+        }
+        std::inclusive_scan(crow.data(), crow.data() + crow.numel(), crow.data());
+        std::copy(sorted.indices_.data() + nnz, sorted.indices_.data() + 2 * nnz, col.data());
+        return SparseCSR<T>(this->shape_, std::move(crow), std::move(col), Tensor<T>(sorted.values_));
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Sparsity-preserving elementwise ops
+    ////////////////////////////////////////////////////////////////////
+    template <typename T>
+    auto operator*(const SparseCSR<T>& a, const T& scalar) -> SparseCSR<T> requires SupportsMul<T> {
+        return a.map([scalar](T x) { return x * scalar; });
+    }
+
+    template <typename T>
+    auto operator*(const T& scalar, const SparseCSR<T>& a) -> SparseCSR<T> requires SupportsMul<T> {
+        return a * scalar;
+    }
+
+    // Elementwise product with a dense matrix, which keeps the sparsity pattern of a
+    template <typename T>
+    auto operator*(const SparseCSR<T>& a, const Tensor<T>& b) -> SparseCSR<T> requires SupportsMul<T> {
+        if (a.shape() != b.shape()) {
+            throw std::runtime_error("Shapes are not the same");
+        }
+        Tensor<T> values({a.nnz()});
+        const int64_t* crow = a.crow_indices().data();
+        const int64_t* col = a.col_indices().data();
+        const T* av = a.values().data();
+        a.for_each_row_block([&](SizeType lo, SizeType hi) {
+            for (SizeType i = lo; i < hi; ++i) {
+                for (int64_t k = crow[i]; k < crow[i + 1]; ++k) {
+                    values.data()[k] = av[k] * b.data()[i * b.stride(0) + col[k] * b.stride(1)];
+                }
+            }
+        });
+        return SparseCSR<T>(a.shape(), a.crow_indices(), a.col_indices(), std::move(values));
+    }
+
+    // Sum of two sparse matrices; the result stores the union of both patterns
+    template <typename T>
+    auto operator+(const SparseCSR<T>& a, const SparseCSR<T>& b) -> SparseCSR<T> requires SupportsAdd<T> {
+        if (a.shape() != b.shape()) {
+            throw std::runtime_error("Shapes are not the same");
+        }
+        const SizeType rows = a.rows();
+        const int64_t* ac = a.crow_indices().data();
+        const int64_t* bc = b.crow_indices().data();
+        const int64_t* aj = a.col_indices().data();
+        const int64_t* bj = b.col_indices().data();
+        const T* av = a.values().data();
+        const T* bv = b.values().data();
+
+        // merge the sorted column lists of row i, calling emit(col, value) for every output element
+        auto merge_row = [&](SizeType i, auto&& emit) {
+            int64_t p = ac[i];
+            int64_t q = bc[i];
+            while (p < ac[i + 1] || q < bc[i + 1]) {
+                if (q == bc[i + 1] || (p < ac[i + 1] && aj[p] < bj[q])) {
+                    emit(aj[p], av[p]);
+                    ++p;
+                } else if (p == ac[i + 1] || bj[q] < aj[p]) {
+                    emit(bj[q], bv[q]);
+                    ++q;
+                } else {
+                    emit(aj[p], av[p] + bv[q]);
+                    ++p;
+                    ++q;
+                }
+            }
+        };
+
+        Tensor<int64_t> crow({rows + 1});
+        int64_t* counts = crow.data();
+        counts[0] = 0;
+        tt::parallel_for(0, rows, 64, [&](SizeType lo, SizeType hi) {
+            for (SizeType i = lo; i < hi; ++i) {
+                int64_t c = 0;
+                merge_row(i, [&c](int64_t, const T&) { ++c; });
+                counts[i + 1] = c;
+            }
+        });
+        std::inclusive_scan(counts, counts + rows + 1, counts);
+
+        Tensor<int64_t> col({counts[rows]});
+        Tensor<T> values({counts[rows]});
+        tt::parallel_for(0, rows, 64, [&](SizeType lo, SizeType hi) {
+            for (SizeType i = lo; i < hi; ++i) {
+                int64_t k = counts[i];
+                merge_row(i, [&](int64_t j, const T& v) {
+                    col.data()[k] = j;
+                    values.data()[k] = v;
+                    ++k;
+                });
+            }
+        });
+        return SparseCSR<T>(a.shape(), std::move(crow), std::move(col), std::move(values));
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Sparse-dense products
+    ////////////////////////////////////////////////////////////////////
+
+    // a (M x K) times a dense vector (K) or matrix (K x N); rows of the result are computed in parallel
+    template <typename T>
+    auto matmul(const SparseCSR<T>& a, const Tensor<T>& b) -> Tensor<T> requires SupportsAdd<T> && SupportsMul<T> {
+        if ((b.dim() != 1 && b.dim() != 2) || b.shape(0) != a.cols()) {
+            throw std::runtime_error("matmul: incompatible shapes");
+        }
+        const int64_t* crow = a.crow_indices().data();
+        const int64_t* col = a.col_indices().data();
+        const T* av = a.values().data();
+        const T* bp = b.data();
+        const SizeType rs = b.stride(0);
+
+        if (b.dim() == 1) {
+            Tensor<T> result({a.rows()});
+            T* out = result.data();
+            a.for_each_row_block([&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    T acc{};
+                    for (int64_t k = crow[i]; k < crow[i + 1]; ++k) {
+                        acc += av[k] * bp[col[k] * rs];
+                    }
+                    out[i] = acc;
+                }
+            });
+            return result;
+        }
+
+        const SizeType N = b.shape(1);
+        const SizeType cs = b.stride(1);
+        Tensor<T> result({a.rows(), N});
+        T* out = result.data();
+        a.for_each_row_block([&](SizeType lo, SizeType hi) {
+            for (SizeType i = lo; i < hi; ++i) {
+                T* orow = out + i * N;
+                for (int64_t k = crow[i]; k < crow[i + 1]; ++k) {
+                    const T v = av[k];
+                    const T* brow = bp + col[k] * rs;
+                    if (cs == 1) {
+                        for (SizeType j = 0; j < N; ++j) {
+                            orow[j] += v * brow[j];
+                        }
+                    } else {
+                        for (SizeType j = 0; j < N; ++j) {
+                            orow[j] += v * brow[j * cs];
+                        }
+                    }
+                }
+            }
+        });
+        return result;
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+
+#include "concepts.hpp"
+#include "tensor.hpp"
+#include "types.hpp"
+#include "utils/Check.hpp"
+
+namespace tt::inline v1 {
+    // Tensor whose shape is part of its type. Elements live inline in a std::array, so every member is usable in
+    // constant evaluation: small lookup tables and coefficient tensors can be built at compile time and baked into
+    // the binary. Operands of different shapes do not match any operator, so mismatches are compile errors and no
+    // shape is compared at runtime.
+    template <typename T, SizeType... Dims>
+    class StaticTensor {
+        static_assert(sizeof...(Dims) > 0, "StaticTensor: at least one dimension is required");
+        static_assert(((Dims > 0) && ...), "StaticTensor: dimensions must be positive");
+
+      public:
+        using ValueType = T;
+
+        static constexpr SizeType rank = sizeof...(Dims);
+        static constexpr SizeType size = (Dims * ...);
+        static constexpr std::array<SizeType, rank> static_shape{Dims...};
+        static constexpr std::array<SizeType, rank> static_strides = [] {
+            std::array<SizeType, rank> strides{};
+            SizeType stride = 1;
+            for (auto i = rank - 1; i >= 0; --i) {
+                strides[i] = stride;
+                stride *= static_shape[i];
+            }
+            return strides;
+        }();
+
+        ////////////////////////////////////////////////////////////////////
+        // Constructors
+        ////////////////////////////////////////////////////////////////////
+        constexpr StaticTensor() = default;
+
+        // Elements in row-major order
+        constexpr StaticTensor(std::initializer_list<T> values) {
+            if (static_cast<SizeType>(values.size()) != size) {
+                throw std::runtime_error("StaticTensor: wrong number of elements");
+            }
+            std::copy(values.begin(), values.end(), this->data_.begin());
+        }
+
+        constexpr explicit StaticTensor(const std::array<T, size>& values) : data_(values) {}
+
+        constexpr auto static full(const ValueType& value) -> StaticTensor {
+            StaticTensor tensor;
+            tensor.data_.fill(value);
+            return tensor;
+        }
+
+        template <typename U = ValueType>
+        constexpr auto static iota(U value = {}) -> StaticTensor {
+            StaticTensor tensor;
+            for (auto& x : tensor.data_) {
+                x = value++;
+            }
+            return tensor;
+        }
+
+        // Element i is f(i), i being the flat (row-major) index
+        template <typename F>
+        constexpr auto static generate(F f) -> StaticTensor {
+            StaticTensor tensor;
+            for (SizeType i = 0; i < size; ++i) {
+                tensor.data_[i] = f(i);
+            }
+            return tensor;
+        }
+
+        // Copies a dynamic tensor, which must have this shape
+        static auto from_tensor(const Tensor<T>& tensor) -> StaticTensor {
+            if (tensor.shape() != IndexType(static_shape.begin(), static_shape.end())) {
+                throw std::runtime_error("StaticTensor: Shapes are not the same");
+            }
+            StaticTensor result;
+            std::copy(tensor.begin(), tensor.end(), result.data_.begin());
+            return result;
+        }
+
+        [[nodiscard]] auto to_tensor() const -> Tensor<T> {
+            Tensor<T> tensor(IndexType(static_shape.begin(), static_shape.end()));
+            std::copy(this->data_.begin(), this->data_.end(), tensor.data());
+            return tensor;
+        }
+
+        [[nodiscard]] constexpr auto numel() const noexcept -> SizeType {
+            return size;
+        }
+
+        [[nodiscard]] constexpr auto dim() const noexcept -> SizeType {
+            return rank;
+        }
+
+        [[nodiscard]] constexpr auto shape() const noexcept -> const std::array<SizeType, rank>& {
+            return static_shape;
+        }
+        [[nodiscard]] constexpr auto shape(SizeType i) const -> SizeType {
+            TINYTEN_CHECK(i >= 0 && i < rank, "shape: index out of bounds");
+            return static_shape[i];
+        }
+
+        [[nodiscard]] constexpr auto strides() const noexcept -> const std::array<SizeType, rank>& {
+            return static_strides;
+        }
+
+        [[nodiscard]] constexpr auto data() noexcept -> ValueType* {
+            return this->data_.data();
+        }
+
+        [[nodiscard]] constexpr auto data() const noexcept -> const ValueType* {
+            return this->data_.data();
+        }
+
+        constexpr auto flat(SizeType i) -> ValueType& {
+            TINYTEN_CHECK_INDEX(i >= 0 && i < size, "flat: index out of bounds");
+            return this->data_[i];
+        }
+        [[nodiscard]] constexpr auto flat(SizeType i) const -> const ValueType& {
+            TINYTEN_CHECK_INDEX(i >= 0 && i < size, "flat: index out of bounds");
+            return this->data_[i];
+        }
+
+        // The number of indices is checked at compile time, their range like Tensor's (see utils/Check.hpp); a
+        // failed check in constant evaluation is a compile error
+        template <std::convertible_to<SizeType>... I>
+        constexpr auto operator()(I... i) -> ValueType& requires(sizeof...(I) == rank) {
+            return this->data_[ravel_index(i...)];
+        }
+
+        template <std::convertible_to<SizeType>... I>
+        constexpr auto operator()(I... i) const -> const ValueType& requires(sizeof...(I) == rank) {
+            return this->data_[ravel_index(i...)];
+        }
+
+        template <std::convertible_to<SizeType>... I>
+        [[nodiscard]] constexpr auto ravel_index(I... i) const -> SizeType requires(sizeof...(I) == rank) {
+            const std::array<SizeType, rank> indices{static_cast<SizeType>(i)...};
+            SizeType index = 0;
+            for (SizeType d = 0; d < rank; ++d) {
+                TINYTEN_CHECK_INDEX(indices[d] >= 0 && indices[d] < static_shape[d], "operator(): index out of bounds");
+                index += indices[d] * static_strides[d];
+            }
+            return index;
+        }
+
+        // Iterators
+        constexpr auto begin() noexcept -> ValueType* {
+            return this->data_.data();
+        }
+        [[nodiscard]] constexpr auto begin() const noexcept -> const ValueType* {
+            return this->data_.data();
+        }
+        constexpr auto end() noexcept -> ValueType* {
+            return this->data_.data() + size;
+        }
+        [[nodiscard]] constexpr auto end() const noexcept -> const ValueType* {
+            return this->data_.data() + size;
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Reductions
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] constexpr auto sum() const -> ValueType requires SupportsAdd<ValueType> {
+            ValueType total{};
+            for (const auto& x : this->data_) {
+                total = total + x;
+            }
+            return total;
+        }
+
+        [[nodiscard]] constexpr auto max() const -> ValueType {
+            return *std::max_element(this->data_.begin(), this->data_.end());
+        }
+
+        [[nodiscard]] constexpr auto min() const -> ValueType {
+            return *std::min_element(this->data_.begin(), this->data_.end());
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Misc functions
+        ////////////////////////////////////////////////////////////////////
+        template <typename F>
+        constexpr auto map_(F f) -> StaticTensor& {
+            for (auto& x : this->data_) {
+                x = f(x);
+            }
+            return *this;
+        }
+
+        template <typename F>
+        [[nodiscard]] constexpr auto map(F f) const -> StaticTensor {
+            return StaticTensor(*this).map_(f);
+        }
+
+        friend constexpr auto operator==(const StaticTensor&, const StaticTensor&) -> bool = default;
+
+      private:
+        std::array<T, size> data_{};
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    // Operators; both operands have the same type, so there is nothing to check at runtime
+    ////////////////////////////////////////////////////////////////////
+    namespace detail {
+        template <typename T, SizeType... Dims, typename Op>
+        constexpr auto static_zip(const StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b, Op op)
+            -> StaticTensor<T, Dims...> {
+            StaticTensor<T, Dims...> result;
+            for (SizeType i = 0; i < result.numel(); ++i) {
+                result.flat(i) = op(a.flat(i), b.flat(i));
+            }
+            return result;
+        }
+    }  // namespace detail
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator+(const StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        requires SupportsAdd<T> {
+        return detail::static_zip(a, b, std::plus<>{});
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator-(const StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        requires SupportsSub<T> {
+        return detail::static_zip(a, b, std::minus<>{});
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator*(const StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        requires SupportsMul<T> {
+        return detail::static_zip(a, b, std::multiplies<>{});
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator/(const StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        requires SupportsDiv<T> {
+        return detail::static_zip(a, b, std::divides<>{});
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator+=(StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        -> StaticTensor<T, Dims...>& requires SupportsAdd<T> {
+        return a = a + b;
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator-=(StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        -> StaticTensor<T, Dims...>& requires SupportsSub<T> {
+        return a = a - b;
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator*=(StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        -> StaticTensor<T, Dims...>& requires SupportsMul<T> {
+        return a = a * b;
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator/=(StaticTensor<T, Dims...>& a, const StaticTensor<T, Dims...>& b)
+        -> StaticTensor<T, Dims...>& requires SupportsDiv<T> {
+        return a = a / b;
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator*(const StaticTensor<T, Dims...>& a, const T& scalar) requires SupportsMul<T> {
+        return a.map([&scalar](const T& x) { return x * scalar; });
+    }
+
+    template <typename T, SizeType... Dims>
+    constexpr auto operator*(const T& scalar, const StaticTensor<T, Dims...>& a) requires SupportsMul<T> {
+        return a * scalar;
+    }
+
+    // Inner dimensions are matched by the type, so only {M, K} x {K, N} compiles
+    template <typename T, SizeType M, SizeType K, SizeType N>
+    constexpr auto matmul(const StaticTensor<T, M, K>& a, const StaticTensor<T, K, N>& b) -> StaticTensor<T, M, N>
+        requires SupportsAdd<T> && SupportsMul<T> {
+        StaticTensor<T, M, N> result;
+        for (SizeType i = 0; i < M; ++i) {
+            for (SizeType k = 0; k < K; ++k) {
+                const T aik = a(i, k);
+                for (SizeType j = 0; j < N; ++j) {
+                    result(i, j) = result(i, j) + aik * b(k, j);
+                }
+            }
+        }
+        return result;
+    }
+
+    template <typename T, SizeType M, SizeType N>
+    constexpr auto transpose(const StaticTensor<T, M, N>& a) -> StaticTensor<T, N, M> {
+        StaticTensor<T, N, M> result;
+        for (SizeType i = 0; i < M; ++i) {
+            for (SizeType j = 0; j < N; ++j) {
+                result(j, i) = a(i, j);
+            }
+        }
+        return result;
+    }
+};  // namespace tt::inline v1
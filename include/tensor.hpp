@@ -1,40 +1,80 @@
 #pragma once
 
 #include <algorithm>
-#include <cassert>
 #include <execution>
+#include <memory>
 #include <numeric>
-#include <random>
+#include <source_location>
 #include <utility>
 #include <vector>
 
 #include "concepts.hpp"
 #include "tensor_indexer.hpp"
 #include "types.hpp"
+#include "utils/Allocator.hpp"
+#include "utils/Check.hpp"
 #include "utils/ShapeIterator.hpp"
 #include "utils/TensorIterator.hpp"
 #include "utils/utils.hpp"
 
 namespace tt::inline v1 {
+    class Generator;
+
     template <typename T>
     class Tensor {
       public:
         using ValueType = T;
-        using ContainerType = std::vector<T>;
+        using ContainerType = std::vector<T, Allocator<T>>;
 
         ////////////////////////////////////////////////////////////////////
         // Constructors
         ////////////////////////////////////////////////////////////////////
-        Tensor() : indexer_(TensorIndexer<T>::contigous({})) {}
+        Tensor() : indexer_(TensorIndexer<T>::contigous({})), data_(std::make_shared<ContainerType>()) {}
+
+        // `site` is recorded for memory_snapshot when memory tracking is on
+        Tensor(IndexType shape, std::source_location site = std::source_location::current())
+            : indexer_(TensorIndexer<T>::contigous(shape)),
+              data_(std::make_shared<ContainerType>(this->indexer_.numel())) {
+            this->track_(site);
+        }
 
-        Tensor(IndexType shape) : indexer_(TensorIndexer<T>::contigous(shape)) {
-            this->data_.resize(this->indexer_.numel());
+        // Buffer backed according to `options` instead of the global storage options
+        Tensor(IndexType shape, const StorageOptions& options,
+               std::source_location site = std::source_location::current())
+            : indexer_(TensorIndexer<T>::contigous(shape)),
+              data_(std::make_shared<ContainerType>(this->indexer_.numel(), Allocator<T>(options))) {
+            this->track_(site);
         }
 
-        Tensor(const IndexType shape, const ValueType& value) : Tensor(shape) {
-            std::fill(this->data_.begin(), this->data_.end(), value);
+        Tensor(const IndexType shape, const ValueType& value,
+               std::source_location site = std::source_location::current())
+            : Tensor(shape, site) {
+            std::fill(this->data_->begin(), this->data_->end(), value);
         }
 
+        // Copies are deep. A tensor spanning its whole buffer keeps its strides; a view (see narrow/select) is
+        // copied into a new contiguous buffer holding only its own elements.
+        Tensor(const Tensor& other) : indexer_(other.indexer_) {
+            if (other._covers_storage()) {
+                this->data_ = std::make_shared<ContainerType>(*other.data_);
+            } else {
+                this->indexer_ = TensorIndexer<T>::contigous(other.shape());
+                this->data_ = std::make_shared<ContainerType>(other.begin(), other.end());
+            }
+        }
+
+        Tensor(Tensor&&) noexcept = default;
+
+        // Rebinds this tensor; assigning to a view does not write into the buffer it shares
+        auto operator=(const Tensor& other) -> Tensor& {
+            if (this != &other) {
+                *this = Tensor(other);
+            }
+            return *this;
+        }
+
+        auto operator=(Tensor&&) noexcept -> Tensor& = default;
+
         template <typename U = ValueType>
         constexpr auto static iota(const IndexType shape, U value = {}) -> Tensor {
             Tensor tensor(shape);
@@ -42,15 +82,20 @@ namespace tt::inline v1 {
             return tensor;
         }
 
-        auto static randn(const IndexType shape) -> Tensor {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::normal_distribution<> d(static_cast<ValueType>(0), static_cast<ValueType>(1));
-            Tensor tensor(shape);
+        ////////////////////////////////////////////////////////////////////
+        // Random tensors; the overloads without a generator draw from default_generator()
+        ////////////////////////////////////////////////////////////////////
+        auto static rand(const IndexType& shape) -> Tensor;
+        auto static rand(const IndexType& shape, Generator& gen) -> Tensor;
 
-            std::generate(tensor.begin(), tensor.end(), [&d, &gen] { return d(gen); });
-            return tensor;
-        }
+        auto static randn(const IndexType& shape) -> Tensor;
+        auto static randn(const IndexType& shape, Generator& gen) -> Tensor;
+
+        auto static randint(ValueType low, ValueType high, const IndexType& shape) -> Tensor;
+        auto static randint(ValueType low, ValueType high, const IndexType& shape, Generator& gen) -> Tensor;
+
+        auto static bernoulli(double p, const IndexType& shape) -> Tensor;
+        auto static bernoulli(double p, const IndexType& shape, Generator& gen) -> Tensor;
 
         [[nodiscard]] constexpr auto numel() const noexcept -> SizeType {
             return this->indexer_.numel();
@@ -79,10 +124,39 @@ namespace tt::inline v1 {
             return this->indexer_._is_contiguous();
         }
 
-        constexpr void reshape_(const IndexType& shape) {
-            if (cumprod(shape) != this->numel()) {
-                throw std::runtime_error("reshape: total size of new array must be unchanged");
+        // Pointer to the first element of this tensor, which is storage_offset() elements into its buffer
+        [[nodiscard]] constexpr auto data() noexcept -> ValueType* {
+            return this->data_->data() + this->offset_;
+        }
+
+        [[nodiscard]] constexpr auto data() const noexcept -> const ValueType* {
+            return this->data_->data() + this->offset_;
+        }
+
+        [[nodiscard]] auto storage_options() const -> StorageOptions {
+            return this->data_->get_allocator().options();
+        }
+
+        [[nodiscard]] constexpr auto storage_offset() const noexcept -> SizeType {
+            return this->offset_;
+        }
+
+        // True when both tensors are backed by the same buffer, e.g. a tensor and a view of it
+        [[nodiscard]] auto shares_storage(const Tensor& other) const noexcept -> bool {
+            return this->data_ == other.data_;
+        }
+
+        [[nodiscard]] auto contiguous() const -> Tensor {
+            if (this->_is_contiguous()) {
+                return *this;
             }
+            Tensor tensor(this->shape());
+            std::copy(this->begin(), this->end(), tensor.data());
+            return tensor;
+        }
+
+        constexpr void reshape_(const IndexType& shape) {
+            TINYTEN_CHECK(cumprod(shape) == this->numel(), "reshape: total size of new array must be unchanged");
             // right now we cannot reshape a non-contiguous tensor
             if (!this->_is_contiguous()) {
                 throw std::runtime_error("reshape: tensor is not contiguous");
@@ -108,6 +182,18 @@ namespace tt::inline v1 {
             return tensor;
         }
 
+        ////////////////////////////////////////////////////////////////////
+        // Views; the result shares this tensor's buffer, so writes through it are visible in both
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] auto view() const -> Tensor;
+        [[nodiscard]] auto narrow(SizeType dim, SizeType start, SizeType length) const -> Tensor;
+        [[nodiscard]] auto select(SizeType dim, SizeType index) const -> Tensor;
+        [[nodiscard]] auto flip(const IndexType& dims) const -> Tensor;
+        [[nodiscard]] auto diagonal(SizeType offset = 0, SizeType dim1 = 0, SizeType dim2 = 1) const -> Tensor;
+        [[nodiscard]] auto unfold(SizeType dim, SizeType size, SizeType step) const -> Tensor;
+        [[nodiscard]] auto as_strided(const IndexType& shape, const IndexType& strides, SizeType offset = 0) const
+            -> Tensor;
+
         constexpr auto flat(SizeType i) -> ValueType&;
         [[nodiscard]] constexpr auto flat(SizeType i) const -> const ValueType&;
 
@@ -162,6 +248,24 @@ namespace tt::inline v1 {
         constexpr auto csc_() -> Tensor& requires SupportsCsc<ValueType>;
         [[nodiscard]] constexpr auto csc() const -> Tensor;
 
+        ////////////////////////////////////////////////////////////////////
+        // Reductions
+        ////////////////////////////////////////////////////////////////////
+        [[nodiscard]] auto sum() const -> ValueType requires SupportsAdd<ValueType>;
+        [[nodiscard]] auto sum(SizeType dim) const -> Tensor requires SupportsAdd<ValueType>;
+
+        [[nodiscard]] auto mean() const -> ValueType requires SupportsDiv<ValueType>;
+        [[nodiscard]] auto mean(SizeType dim) const -> Tensor requires SupportsDiv<ValueType>;
+
+        [[nodiscard]] auto max() const -> ValueType;
+        [[nodiscard]] auto max(SizeType dim) const -> Tensor;
+
+        [[nodiscard]] auto min() const -> ValueType;
+        [[nodiscard]] auto min(SizeType dim) const -> Tensor;
+
+        template <typename Op>
+        [[nodiscard]] auto reduce(SizeType dim, ValueType init, Op op) const -> Tensor;
+
         ////////////////////////////////////////////////////////////////////
         // Misc functions
         ////////////////////////////////////////////////////////////////////
@@ -169,14 +273,19 @@ namespace tt::inline v1 {
 
         template <typename U>
         constexpr auto astype() -> Tensor<U> {
-            Tensor<U> res(this->indexer_.shape_, this->indexer_.strides_);
+            Tensor<U> res = this->_covers_storage() ? Tensor<U>(this->indexer_.shape_, this->indexer_.strides_)
+                                                    : Tensor<U>(this->indexer_.shape_);
             std::transform(
                 this->begin(), this->end(), res.begin(), [](T & x) constexpr { return static_cast<U>(x); });
             return res;
         }
 
         constexpr auto map_(ValueType (*f)(ValueType)) -> Tensor& {
-            std::transform(std::execution::unseq, this->data_.begin(), this->data_.end(), this->data_.begin(), f);
+            if (this->_is_contiguous()) {
+                std::transform(std::execution::unseq, this->data(), this->data() + this->numel(), this->data(), f);
+            } else {
+                std::transform(this->begin(), this->end(), this->begin(), f);
+            }
             return *this;
         }
 
@@ -186,7 +295,8 @@ namespace tt::inline v1 {
 
       private:
         TensorIndexer<T> indexer_;
-        ContainerType data_;
+        std::shared_ptr<ContainerType> data_;
+        SizeType offset_ = 0;
 
         template <typename U>
         friend class Tensor;
@@ -194,5 +304,22 @@ namespace tt::inline v1 {
         Tensor(const IndexType& dimensions, const IndexType& strides) : Tensor(dimensions) {
             this->indexer_.strides_ = strides;
         }
+
+        Tensor(std::shared_ptr<ContainerType> data, SizeType offset, TensorIndexer<T> indexer)
+            : indexer_(std::move(indexer)), data_(std::move(data)), offset_(offset) {}
+
+        [[nodiscard]] constexpr auto _offset_of(const SizeType* indices, SizeType n) const -> SizeType;
+
+        void track_(const std::source_location& site) const {
+            auto& accounting = detail::MemoryAccounting::instance();
+            if (accounting.tracking() && !this->data_->empty()) {
+                accounting.annotate(this->data_->data(), this->shape(), site);
+            }
+        }
+
+        [[nodiscard]] auto _covers_storage() const -> bool {
+            return this->offset_ == 0 && static_cast<SizeType>(this->data_->size()) == this->numel() &&
+                   this->indexer_._is_dense();
+        }
     };
 };  // namespace tt::inline v1
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_linalg.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    struct Conv2dOptions {
+        std::array<SizeType, 2> stride{1, 1};
+        std::array<SizeType, 2> padding{0, 0};
+        std::array<SizeType, 2> dilation{1, 1};
+        SizeType groups = 1;
+    };
+
+    struct Pool2dOptions {
+        std::array<SizeType, 2> kernel{2, 2};
+        std::array<SizeType, 2> stride{2, 2};
+        std::array<SizeType, 2> padding{0, 0};
+        std::array<SizeType, 2> dilation{1, 1};
+    };
+
+    enum class ConvAlgorithm {
+        Auto,
+        Im2col,
+        Direct,
+    };
+
+    namespace detail {
+        struct ConvGeometry {
+            SizeType N, C, H, W;
+            SizeType K, KH, KW;
+            SizeType OH, OW;
+            SizeType groups, Cg, Kg;
+            SizeType sh, sw, ph, pw, dh, dw;
+        };
+
+        inline auto conv_out_size(SizeType in, SizeType kernel, SizeType stride, SizeType pad, SizeType dilation)
+            -> SizeType {
+            const SizeType span = dilation * (kernel - 1) + 1;
+            if (in + 2 * pad < span) {
+                throw std::runtime_error("conv: kernel is larger than the padded input");
+            }
+            return (in + 2 * pad - span) / stride + 1;
+        }
+
+        // Whether each of the `out` pooling windows along one dim has a tap inside the input. With dilation a window
+        // can straddle the input and still see only padding.
+        inline auto pool_windows_hit_input(SizeType in, SizeType out, SizeType kernel, SizeType stride, SizeType pad,
+                                           SizeType dilation) -> bool {
+            for (SizeType o = 0; o < out; ++o) {
+                bool hit = false;
+                for (SizeType k = 0; k < kernel && !hit; ++k) {
+                    const SizeType i = o * stride - pad + k * dilation;
+                    hit = i >= 0 && i < in;
+                }
+                if (!hit) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Unfolds the receptive fields of one group of one image into a (Cg * KH * KW) x (OH * OW) matrix
+        template <typename T>
+        void im2col(const T* in, const ConvGeometry& g, T* col) {
+            const SizeType plane = g.OH * g.OW;
+            for (SizeType c = 0; c < g.Cg; ++c) {
+                const T* src = in + c * g.H * g.W;
+                for (SizeType kh = 0; kh < g.KH; ++kh) {
+                    for (SizeType kw = 0; kw < g.KW; ++kw) {
+                        T* dst = col + ((c * g.KH + kh) * g.KW + kw) * plane;
+                        for (SizeType oh = 0; oh < g.OH; ++oh) {
+                            const SizeType ih = oh * g.sh - g.ph + kh * g.dh;
+                            T* row = dst + oh * g.OW;
+                            if (ih < 0 || ih >= g.H) {
+                                std::fill(row, row + g.OW, T{});
+                                continue;
+                            }
+                            for (SizeType ow = 0; ow < g.OW; ++ow) {
+                                const SizeType iw = ow * g.sw - g.pw + kw * g.dw;
+                                row[ow] = (iw >= 0 && iw < g.W) ? src[ih * g.W + iw] : T{};
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // Accumulates the contribution of a single input plane and kernel tap into one output plane. Output rows
+        // are processed in blocks so the block stays in L1 while every tap of the filter is applied to it.
+        template <typename T>
+        void conv_direct_plane(const T* in, const T* w, const ConvGeometry& g, T* out) {
+            constexpr SizeType ROWS = 8;
+            for (SizeType oh0 = 0; oh0 < g.OH; oh0 += ROWS) {
+                const SizeType oh1 = std::min(oh0 + ROWS, g.OH);
+                for (SizeType c = 0; c < g.Cg; ++c) {
+                    const T* src = in + c * g.H * g.W;
+                    for (SizeType kh = 0; kh < g.KH; ++kh) {
+                        for (SizeType kw = 0; kw < g.KW; ++kw) {
+                            const T wv = w[(c * g.KH + kh) * g.KW + kw];
+                            // valid output columns for this tap: 0 <= ow * sw - pw + kw * dw < W
+                            const SizeType off = kw * g.dw - g.pw;
+                            const SizeType ow0 = off >= 0 ? 0 : (-off + g.sw - 1) / g.sw;
+                            const SizeType ow1 = std::min(g.OW, off >= g.W ? 0 : (g.W - off + g.sw - 1) / g.sw);
+                            for (SizeType oh = oh0; oh < oh1; ++oh) {
+                                const SizeType ih = oh * g.sh - g.ph + kh * g.dh;
+                                if (ih < 0 || ih >= g.H) {
+                                    continue;
+                                }
+                                const T* srow = src + ih * g.W;
+                                T* orow = out + oh * g.OW;
+                                if (g.sw == 1) {
+                                    for (SizeType ow = ow0; ow < ow1; ++ow) {
+                                        orow[ow] += wv * srow[ow + off];
+                                    }
+                                } else {
+                                    for (SizeType ow = ow0; ow < ow1; ++ow) {
+                                        orow[ow] += wv * srow[ow * g.sw + off];
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        // im2col pays off once the GEMM is large enough to amortize the unfold; depthwise and tiny-channel
+        // convolutions have too short a reduction dimension and go direct
+        inline auto pick_conv_algorithm(const ConvGeometry& g, SizeType elem_size) -> ConvAlgorithm {
+            const SizeType reduction = g.Cg * g.KH * g.KW;
+            if (g.Cg == 1 || reduction < 16) {
+                return ConvAlgorithm::Direct;
+            }
+            const SizeType col_bytes = reduction * g.OH * g.OW * elem_size;
+            if (col_bytes > (SizeType{64} << 20)) {
+                return ConvAlgorithm::Direct;
+            }
+            return ConvAlgorithm::Im2col;
+        }
+
+        template <typename T>
+        auto conv2d_impl(const Tensor<T>& input, const Tensor<T>& weight, const Tensor<T>* bias,
+                         const Conv2dOptions& opts, ConvAlgorithm algo) -> Tensor<T> {
+            if (input.dim() != 4 || weight.dim() != 4) {
+                throw std::runtime_error("conv2d: input must be NCHW and weight (K, C / groups, KH, KW)");
+            }
+            ConvGeometry g{};
+            g.N = input.shape(0);
+            g.C = input.shape(1);
+            g.H = input.shape(2);
+            g.W = input.shape(3);
+            g.K = weight.shape(0);
+            g.KH = weight.shape(2);
+            g.KW = weight.shape(3);
+            g.groups = opts.groups;
+            if (g.groups < 1 || g.C % g.groups != 0 || g.K % g.groups != 0) {
+                throw std::runtime_error("conv2d: channels must be divisible by groups");
+            }
+            g.Cg = g.C / g.groups;
+            g.Kg = g.K / g.groups;
+            if (weight.shape(1) != g.Cg) {
+                throw std::runtime_error("conv2d: weight has the wrong number of input channels");
+            }
+            if (bias != nullptr && (bias->dim() != 1 || bias->shape(0) != g.K)) {
+                throw std::runtime_error("conv2d: bias must have shape (K)");
+            }
+            g.sh = opts.stride[0];
+            g.sw = opts.stride[1];
+            g.ph = opts.padding[0];
+            g.pw = opts.padding[1];
+            g.dh = opts.dilation[0];
+            g.dw = opts.dilation[1];
+            if (g.sh < 1 || g.sw < 1 || g.dh < 1 || g.dw < 1 || g.ph < 0 || g.pw < 0) {
+                throw std::runtime_error("conv2d: invalid stride, padding or dilation");
+            }
+            g.OH = conv_out_size(g.H, g.KH, g.sh, g.ph, g.dh);
+            g.OW = conv_out_size(g.W, g.KW, g.sw, g.pw, g.dw);
+
+            Tensor<T> in_buf;
+            Tensor<T> w_buf;
+            const Tensor<T>& in = input._is_contiguous() ? input : (in_buf = input.contiguous());
+            const Tensor<T>& w = weight._is_contiguous() ? weight : (w_buf = weight.contiguous());
+            Tensor<T> out({g.N, g.K, g.OH, g.OW});
+            const SizeType plane = g.OH * g.OW;
+            const SizeType in_image = g.C * g.H * g.W;
+            const SizeType w_filter = g.Cg * g.KH * g.KW;
+
+            if (algo == ConvAlgorithm::Auto) {
+                algo = pick_conv_algorithm(g, static_cast<SizeType>(sizeof(T)));
+            }
+
+            if (algo == ConvAlgorithm::Direct) {
+                // one task per (image, output channel) plane
+                tt::parallel_for(0, g.N * g.K, 1, [&](SizeType lo, SizeType hi) {
+                    for (SizeType t = lo; t < hi; ++t) {
+                        const SizeType n = t / g.K;
+                        const SizeType k = t % g.K;
+                        const SizeType grp = k / g.Kg;
+                        conv_direct_plane(in.data() + n * in_image + grp * g.Cg * g.H * g.W,
+                                          w.data() + k * w_filter, g, out.data() + t * plane);
+                    }
+                });
+            } else {
+                const bool pointwise = g.KH == 1 && g.KW == 1 && g.sh == 1 && g.sw == 1 && g.ph == 0 && g.pw == 0;
+                auto run_unit = [&](SizeType n, SizeType grp, std::vector<T>& col) {
+                    const T* src = in.data() + n * in_image + grp * g.Cg * g.H * g.W;
+                    if (!pointwise) {
+                        col.resize(w_filter * plane);
+                        im2col(src, g, col.data());
+                        src = col.data();
+                    }
+                    T* dst = out.data() + (n * g.K + grp * g.Kg) * plane;
+                    detail::gemm(g.Kg, plane, w_filter, w.data() + grp * g.Kg * w_filter, w_filter, 1, src, plane, 1,
+                                 dst, plane, 1, false);
+                };
+
+                const SizeType units = g.N * g.groups;
+                if (units >= tt::get_num_threads()) {
+                    // enough independent images/groups: one unfold buffer per worker, serial GEMMs
+                    tt::parallel_for(0, units, 1, [&](SizeType lo, SizeType hi) {
+                        std::vector<T> col;
+                        for (SizeType u = lo; u < hi; ++u) {
+                            run_unit(u / g.groups, u % g.groups, col);
+                        }
+                    });
+                } else {
+                    // few images: let the GEMM split output channels across threads instead
+                    std::vector<T> col;
+                    for (SizeType u = 0; u < units; ++u) {
+                        run_unit(u / g.groups, u % g.groups, col);
+                    }
+                }
+            }
+
+            if (bias != nullptr) {
+                const Tensor<T> b = bias->contiguous();
+                tt::parallel_for(0, g.N * g.K, 16, [&](SizeType lo, SizeType hi) {
+                    for (SizeType t = lo; t < hi; ++t) {
+                        T* dst = out.data() + t * plane;
+                        const T bv = b.data()[t % g.K];
+                        for (SizeType i = 0; i < plane; ++i) {
+                            dst[i] += bv;
+                        }
+                    }
+                });
+            }
+            return out;
+        }
+
+        template <typename T, typename Init, typename Step, typename Finish>
+        auto pool2d_impl(const Tensor<T>& input, const Pool2dOptions& opts, Init init, Step step, Finish finish)
+            -> Tensor<T> {
+            if (input.dim() != 4) {
+                throw std::runtime_error("pool2d: input must be NCHW");
+            }
+            const SizeType KH = opts.kernel[0];
+            const SizeType KW = opts.kernel[1];
+            const SizeType sh = opts.stride[0];
+            const SizeType sw = opts.stride[1];
+            const SizeType ph = opts.padding[0];
+            const SizeType pw = opts.padding[1];
+            const SizeType dh = opts.dilation[0];
+            const SizeType dw = opts.dilation[1];
+            if (sh < 1 || sw < 1 || dh < 1 || dw < 1 || KH < 1 || KW < 1) {
+                throw std::runtime_error("pool2d: invalid kernel, stride or dilation");
+            }
+            if (2 * ph > KH || 2 * pw > KW) {
+                throw std::runtime_error("pool2d: padding must be at most half the kernel size");
+            }
+            const SizeType H = input.shape(2);
+            const SizeType W = input.shape(3);
+            const SizeType OH = conv_out_size(H, KH, sh, ph, dh);
+            const SizeType OW = conv_out_size(W, KW, sw, pw, dw);
+            if (!pool_windows_hit_input(H, OH, KH, sh, ph, dh) || !pool_windows_hit_input(W, OW, KW, sw, pw, dw)) {
+                throw std::runtime_error("pool2d: a pooling window lies entirely in the padding");
+            }
+
+            Tensor<T> in_buf;
+            const Tensor<T>& in = input._is_contiguous() ? input : (in_buf = input.contiguous());
+            Tensor<T> out({input.shape(0), input.shape(1), OH, OW});
+            tt::parallel_for(0, input.shape(0) * input.shape(1), 4, [&](SizeType lo, SizeType hi) {
+                for (SizeType p = lo; p < hi; ++p) {
+                    const T* src = in.data() + p * H * W;
+                    T* dst = out.data() + p * OH * OW;
+                    for (SizeType oh = 0; oh < OH; ++oh) {
+                        for (SizeType ow = 0; ow < OW; ++ow) {
+                            auto acc = init();
+                            SizeType count = 0;
+                            for (SizeType kh = 0; kh < KH; ++kh) {
+                                const SizeType ih = oh * sh - ph + kh * dh;
+                                if (ih < 0 || ih >= H) {
+                                    continue;
+                                }
+                                for (SizeType kw = 0; kw < KW; ++kw) {
+                                    const SizeType iw = ow * sw - pw + kw * dw;
+                                    if (iw >= 0 && iw < W) {
+                                        acc = step(acc, src[ih * W + iw]);
+                                        ++count;
+                                    }
+                                }
+                            }
+                            dst[oh * OW + ow] = finish(acc, count, KH * KW);
+                        }
+                    }
+                }
+            });
+            return out;
+        }
+
+        // Views an NCL tensor as NC1L (or a (K, C, L) weight as (K, C, 1, L))
+        template <typename T>
+        auto unsqueeze_h(const Tensor<T>& t) -> Tensor<T> {
+            return t.contiguous().reshape({t.shape(0), t.shape(1), 1, t.shape(2)});
+        }
+
+        template <typename T>
+        auto squeeze_h(Tensor<T>&& t) -> Tensor<T> {
+            t.reshape_({t.shape(0), t.shape(1), t.shape(3)});
+            return std::move(t);
+        }
+    }  // namespace detail
+
+    ////////////////////////////////////////////////////////////////////
+    // Convolution
+    ////////////////////////////////////////////////////////////////////
+
+    // input (N, C, H, W), weight (K, C / groups, KH, KW) -> (N, K, OH, OW)
+    template <typename T>
+    auto conv2d(const Tensor<T>& input, const Tensor<T>& weight, const Conv2dOptions& opts = {},
+                ConvAlgorithm algo = ConvAlgorithm::Auto) -> Tensor<T> {
+        return detail::conv2d_impl(input, weight, static_cast<const Tensor<T>*>(nullptr), opts, algo);
+    }
+
+    template <typename T>
+    auto conv2d(const Tensor<T>& input, const Tensor<T>& weight, const Tensor<T>& bias, const Conv2dOptions& opts = {},
+                ConvAlgorithm algo = ConvAlgorithm::Auto) -> Tensor<T> {
+        return detail::conv2d_impl(input, weight, &bias, opts, algo);
+    }
+
+    // input (N, C, L), weight (K, C / groups, KL) -> (N, K, OL)
+    template <typename T>
+    auto conv1d(const Tensor<T>& input, const Tensor<T>& weight, SizeType stride = 1, SizeType padding = 0,
+                SizeType dilation = 1, SizeType groups = 1, ConvAlgorithm algo = ConvAlgorithm::Auto) -> Tensor<T> {
+        if (input.dim() != 3 || weight.dim() != 3) {
+            throw std::runtime_error("conv1d: input must be NCL and weight (K, C / groups, KL)");
+        }
+        const Conv2dOptions opts{{1, stride}, {0, padding}, {1, dilation}, groups};
+        return detail::squeeze_h(conv2d(detail::unsqueeze_h(input), detail::unsqueeze_h(weight), opts, algo));
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Pooling. Every window must overlap the input: padding of more than half the kernel, or a dilation that leaves
+    // some window with only padded taps, throws.
+    ////////////////////////////////////////////////////////////////////
+    template <typename T>
+    auto max_pool2d(const Tensor<T>& input, const Pool2dOptions& opts = {}) -> Tensor<T> {
+        return detail::pool2d_impl(
+            input, opts, [] { return std::numeric_limits<T>::lowest(); }, [](T acc, T v) { return std::max(acc, v); },
+            [](T acc, SizeType, SizeType) { return acc; });
+    }
+
+    // Padded positions are excluded from the average
+    template <typename T>
+    auto avg_pool2d(const Tensor<T>& input, const Pool2dOptions& opts = {}) -> Tensor<T> {
+        return detail::pool2d_impl(
+            input, opts, [] { return T{}; }, [](T acc, T v) { return acc + v; },
+            [](T acc, SizeType count, SizeType) { return acc / static_cast<T>(count); });
+    }
+
+    template <typename T>
+    auto max_pool1d(const Tensor<T>& input, SizeType kernel, SizeType stride, SizeType padding = 0) -> Tensor<T> {
+        if (input.dim() != 3) {
+            throw std::runtime_error("max_pool1d: input must be NCL");
+        }
+        return detail::squeeze_h(max_pool2d(detail::unsqueeze_h(input), {{1, kernel}, {1, stride}, {0, padding}}));
+    }
+
+    template <typename T>
+    auto avg_pool1d(const Tensor<T>& input, SizeType kernel, SizeType stride, SizeType padding = 0) -> Tensor<T> {
+        if (input.dim() != 3) {
+            throw std::runtime_error("avg_pool1d: input must be NCL");
+        }
+        return detail::squeeze_h(avg_pool2d(detail::unsqueeze_h(input), {{1, kernel}, {1, stride}, {0, padding}}));
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,610 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_views.hpp"
+#include "tensor_linalg.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+// Factorizations and solves of batched dense matrices: every (..., rows, cols) tensor is a batch of row-major
+// matrices over its leading dims, and the matrices of a batch are spread over the thread pool.
+namespace tt::inline v1 {
+    namespace detail {
+        // Matrices up to this size run kernels instantiated for their exact size, so every loop has a constant trip
+        // count the compiler unrolls
+        constexpr SizeType LINALG_SMALL_MAX = 8;
+        // Matrices larger than this are factored and solved in panels of this many columns (or rows), with the
+        // trailing updates done by gemm
+        constexpr SizeType LINALG_BLOCK = 64;
+
+        // Calls f with n as a std::integral_constant when n <= LINALG_SMALL_MAX, else as a SizeType
+        template <typename F>
+        void with_static_size(SizeType n, F&& f) {
+            switch (n) {
+                case 1:
+                    return f(std::integral_constant<SizeType, 1>{});
+                case 2:
+                    return f(std::integral_constant<SizeType, 2>{});
+                case 3:
+                    return f(std::integral_constant<SizeType, 3>{});
+                case 4:
+                    return f(std::integral_constant<SizeType, 4>{});
+                case 5:
+                    return f(std::integral_constant<SizeType, 5>{});
+                case 6:
+                    return f(std::integral_constant<SizeType, 6>{});
+                case 7:
+                    return f(std::integral_constant<SizeType, 7>{});
+                case 8:
+                    return f(std::integral_constant<SizeType, 8>{});
+                default:
+                    return f(n);
+            }
+        }
+
+        template <typename Size>
+        constexpr bool is_static_size = !std::is_same_v<std::remove_cvref_t<Size>, SizeType>;
+
+        // Number of matrices in a (..., rows, cols) tensor
+        template <typename T>
+        auto matrix_batch(const Tensor<T>& t, const char* what) -> SizeType {
+            if (t.dim() < 2) {
+                throw std::runtime_error(std::string(what) + ": expected a (..., rows, cols) tensor");
+            }
+            return std::reduce(t.shape().begin(), t.shape().end() - 2, SizeType{1}, std::multiplies<>{});
+        }
+
+        template <typename T>
+        auto square_size(const Tensor<T>& a, const char* what) -> SizeType {
+            matrix_batch(a, what);
+            if (a.shape(a.dim() - 1) != a.shape(a.dim() - 2)) {
+                throw std::runtime_error(std::string(what) + ": matrices must be square");
+            }
+            return a.shape(a.dim() - 1);
+        }
+
+        // Checks the (..., n, n) coefficients against the (..., n, k) right-hand sides: the same leading dims, or a
+        // single matrix shared by every right-hand side
+        template <typename T>
+        void check_system(const Tensor<T>& a, const Tensor<T>& b, const char* what) {
+            const SizeType n = square_size(a, what);
+            matrix_batch(b, what);
+            if (b.shape(b.dim() - 2) != n) {
+                throw std::runtime_error(std::string(what) + ": right-hand sides must have as many rows as the matrix");
+            }
+            const bool same_batch = a.dim() == b.dim() && std::equal(a.shape().begin(), a.shape().end() - 2,
+                                                                     b.shape().begin());
+            if (!same_batch && a.dim() != 2) {
+                throw std::runtime_error(std::string(what) +
+                                         ": batch dims of the matrices and right-hand sides differ");
+            }
+        }
+
+        // Runs f(i) for every matrix i of a batch, each taking about `cost` flops
+        template <typename F>
+        void for_each_matrix(SizeType batch, SizeType cost, F f) {
+            const SizeType grain = std::max<SizeType>(1, (SizeType{1} << 15) / std::max<SizeType>(cost, 1));
+            tt::parallel_for(0, batch, grain, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    f(i);
+                }
+            });
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Cholesky
+        ////////////////////////////////////////////////////////////////////
+
+        // Lower Cholesky factor of the n x n matrix at a (row stride lda) in place, row by row so that every inner
+        // product runs over two contiguous row prefixes. Reads only the lower triangle; false if not positive definite
+        template <typename T, typename Size, typename Ld>
+        auto cholesky_unblocked(T* a, Size size, Ld ld) -> bool {
+            const SizeType n = size;
+            const SizeType lda = ld;
+            for (SizeType i = 0; i < n; ++i) {
+                T* ri = a + i * lda;
+                for (SizeType j = 0; j <= i; ++j) {
+                    const T* rj = a + j * lda;
+                    T s = ri[j];
+                    for (SizeType k = 0; k < j; ++k) {
+                        s -= ri[k] * rj[k];
+                    }
+                    if (j < i) {
+                        ri[j] = s / rj[j];
+                    } else if (s > T{0}) {
+                        ri[i] = std::sqrt(s);
+                    } else {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // Right-looking blocked Cholesky of the contiguous n x n matrix at a: factor a diagonal block, solve the
+        // panel below it, and update the trailing matrix with one gemm
+        template <typename T>
+        auto cholesky_blocked(T* a, SizeType n) -> bool {
+            std::vector<T> work;
+            for (SizeType k = 0; k < n; k += LINALG_BLOCK) {
+                const SizeType kb = std::min(LINALG_BLOCK, n - k);
+                T* akk = a + k * n + k;
+                if (!cholesky_unblocked(akk, kb, n)) {
+                    return false;
+                }
+                const SizeType m = n - k - kb;
+                if (m == 0) {
+                    break;
+                }
+                // A21 = A21 L11^-T, one row at a time
+                T* a21 = akk + kb * n;
+                for (SizeType r = 0; r < m; ++r) {
+                    T* row = a21 + r * n;
+                    for (SizeType j = 0; j < kb; ++j) {
+                        const T* lj = akk + j * n;
+                        T s = row[j];
+                        for (SizeType c = 0; c < j; ++c) {
+                            s -= row[c] * lj[c];
+                        }
+                        row[j] = s / lj[j];
+                    }
+                }
+                // A22 -= A21 A21^T with -A21 and A21^T packed contiguous for gemm's unit-stride path; this also
+                // updates the upper triangle, which is never read and zeroed at the end
+                work.resize(static_cast<size_t>(2 * m * kb));
+                T* neg = work.data();
+                T* transposed = neg + m * kb;
+                for (SizeType r = 0; r < m; ++r) {
+                    for (SizeType c = 0; c < kb; ++c) {
+                        neg[r * kb + c] = -a21[r * n + c];
+                        transposed[c * m + r] = a21[r * n + c];
+                    }
+                }
+                gemm(m, m, kb, neg, kb, SizeType{1}, transposed, m, SizeType{1}, a21 + kb, n, SizeType{1}, true);
+            }
+            return true;
+        }
+
+        template <typename T, typename Size>
+        auto cholesky_factor(T* a, Size size) -> bool {
+            if constexpr (is_static_size<Size>) {
+                return cholesky_unblocked(a, size, size);
+            } else {
+                return size > LINALG_BLOCK ? cholesky_blocked(a, size) : cholesky_unblocked(a, size, size);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // LU
+        ////////////////////////////////////////////////////////////////////
+
+        // Partial-pivoting LU of columns [k0, k1) of the n x n matrix at a (row stride lda), from row k0 down. Swaps
+        // whole rows, stores the multipliers below the diagonal and updates only columns below k1. pivots[k] is the
+        // row swapped with row k. False if a pivot is zero, in which case its column is left as is.
+        template <typename T, typename Size, typename Ld>
+        auto lu_panel(T* a, Size size, Ld ld, SizeType k0, SizeType k1, int64_t* pivots) -> bool {
+            const SizeType n = size;
+            const SizeType lda = ld;
+            bool nonsingular = true;
+            for (SizeType k = k0; k < k1; ++k) {
+                SizeType p = k;
+                T best = std::abs(a[k * lda + k]);
+                for (SizeType i = k + 1; i < n; ++i) {
+                    if (std::abs(a[i * lda + k]) > best) {
+                        best = std::abs(a[i * lda + k]);
+                        p = i;
+                    }
+                }
+                pivots[k] = p;
+                if (p != k) {
+                    std::swap_ranges(a + k * lda, a + k * lda + n, a + p * lda);
+                }
+                const T* rk = a + k * lda;
+                if (rk[k] == T{0}) {
+                    nonsingular = false;
+                    continue;
+                }
+                for (SizeType i = k + 1; i < n; ++i) {
+                    T* ri = a + i * lda;
+                    const T l = ri[k] /= rk[k];
+                    for (SizeType j = k + 1; j < k1; ++j) {
+                        ri[j] -= l * rk[j];
+                    }
+                }
+            }
+            return nonsingular;
+        }
+
+        // Right-looking blocked LU of the contiguous n x n matrix at a: factor a panel, solve the block row right of
+        // it with the panel's unit lower triangle, and update the trailing matrix with one gemm
+        template <typename T>
+        auto lu_blocked(T* a, SizeType n, int64_t* pivots) -> bool {
+            std::vector<T> work;
+            bool nonsingular = true;
+            for (SizeType k = 0; k < n; k += LINALG_BLOCK) {
+                const SizeType kend = std::min(k + LINALG_BLOCK, n);
+                nonsingular = lu_panel(a, n, n, k, kend, pivots) && nonsingular;
+                const SizeType m = n - kend;
+                if (m == 0) {
+                    break;
+                }
+                // U12 = L11^-1 A12
+                for (SizeType i = k + 1; i < kend; ++i) {
+                    T* ri = a + i * n;
+                    for (SizeType j = k; j < i; ++j) {
+                        const T l = ri[j];
+                        const T* rj = a + j * n;
+                        for (SizeType c = kend; c < n; ++c) {
+                            ri[c] -= l * rj[c];
+                        }
+                    }
+                }
+                // A22 -= L21 U12
+                const SizeType kb = kend - k;
+                work.resize(static_cast<size_t>(m * kb));
+                for (SizeType r = 0; r < m; ++r) {
+                    for (SizeType c = 0; c < kb; ++c) {
+                        work[r * kb + c] = -a[(kend + r) * n + k + c];
+                    }
+                }
+                gemm(m, m, kb, work.data(), kb, SizeType{1}, a + k * n + kend, n, SizeType{1}, a + kend * n + kend, n,
+                     SizeType{1}, true);
+            }
+            return nonsingular;
+        }
+
+        template <typename T, typename Size>
+        auto lu_factor(T* a, Size size, int64_t* pivots) -> bool {
+            if constexpr (is_static_size<Size>) {
+                return lu_panel(a, size, size, 0, size, pivots);
+            } else {
+                return size > LINALG_BLOCK ? lu_blocked(a, size, pivots) : lu_panel(a, size, size, 0, size, pivots);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////
+        // Triangular solves
+        ////////////////////////////////////////////////////////////////////
+
+        // Solves A X = B in place on the n x k block at x (row stride k) for the triangular n x n matrix A addressed
+        // through (rsa, csa), so a transposed factor is just swapped strides. Rows of X are combined whole, so every
+        // inner loop is unit stride.
+        template <typename T, typename Size>
+        void trsm_unblocked(const T* a, SizeType rsa, SizeType csa, Size size, T* x, SizeType k, bool upper,
+                            bool unit) {
+            const SizeType n = size;
+            for (SizeType step = 0; step < n; ++step) {
+                const SizeType i = upper ? n - 1 - step : step;
+                T* xi = x + i * k;
+                const SizeType j0 = upper ? i + 1 : 0;
+                const SizeType j1 = upper ? n : i;
+                for (SizeType j = j0; j < j1; ++j) {
+                    const T aij = a[i * rsa + j * csa];
+                    const T* xj = x + j * k;
+                    for (SizeType c = 0; c < k; ++c) {
+                        xi[c] -= aij * xj[c];
+                    }
+                }
+                if (!unit) {
+                    const T inv = T{1} / a[i * rsa + i * csa];
+                    for (SizeType c = 0; c < k; ++c) {
+                        xi[c] *= inv;
+                    }
+                }
+            }
+        }
+
+        // Blocked over rows of X: the contribution of the already solved rows to a block of LINALG_BLOCK rows is
+        // subtracted with one gemm, then the diagonal block is solved unblocked
+        template <typename T>
+        void trsm_blocked(const T* a, SizeType rsa, SizeType csa, SizeType n, T* x, SizeType k, bool upper,
+                          bool unit) {
+            std::vector<T> work;
+            for (SizeType step = 0; step < n; step += LINALG_BLOCK) {
+                const SizeType nb = std::min(LINALG_BLOCK, n - step);
+                const SizeType i0 = upper ? n - step - nb : step;
+                // solved rows [s0, s1)
+                const SizeType s0 = upper ? i0 + nb : 0;
+                const SizeType s1 = upper ? n : i0;
+                const SizeType ns = s1 - s0;
+                if (ns > 0) {
+                    work.resize(static_cast<size_t>(nb * ns));
+                    for (SizeType r = 0; r < nb; ++r) {
+                        for (SizeType c = 0; c < ns; ++c) {
+                            work[r * ns + c] = -a[(i0 + r) * rsa + (s0 + c) * csa];
+                        }
+                    }
+                    gemm(nb, k, ns, work.data(), ns, SizeType{1}, x + s0 * k, k, SizeType{1}, x + i0 * k, k,
+                         SizeType{1}, true);
+                }
+                trsm_unblocked(a + i0 * rsa + i0 * csa, rsa, csa, nb, x + i0 * k, k, upper, unit);
+            }
+        }
+
+        template <typename T, typename Size>
+        void trsm(const T* a, SizeType rsa, SizeType csa, Size size, T* x, SizeType k, bool upper, bool unit) {
+            if constexpr (is_static_size<Size>) {
+                trsm_unblocked(a, rsa, csa, size, x, k, upper, unit);
+            } else if (size > LINALG_BLOCK) {
+                trsm_blocked(a, rsa, csa, size, x, k, upper, unit);
+            } else {
+                trsm_unblocked(a, rsa, csa, size, x, k, upper, unit);
+            }
+        }
+
+        // Solves P^-1 L U X = B in place for a packed LU factorization (see lu)
+        template <typename T, typename Size>
+        void lu_solve_inplace(const T* lu, const int64_t* pivots, Size size, T* x, SizeType k) {
+            const SizeType n = size;
+            for (SizeType i = 0; i < n; ++i) {
+                if (pivots[i] != i) {
+                    std::swap_ranges(x + i * k, x + (i + 1) * k, x + pivots[i] * k);
+                }
+            }
+            trsm(lu, n, SizeType{1}, size, x, k, false, true);
+            trsm(lu, n, SizeType{1}, size, x, k, true, false);
+        }
+
+        // The right-hand sides of A X = B, copied to be solved in place, and which matrix of A goes with each
+        template <typename T>
+        struct System {
+            Tensor<T> x;
+            SizeType batch;
+            SizeType n;
+            SizeType k;
+            bool shared;
+
+            [[nodiscard]] auto matrix(SizeType i) const -> SizeType {
+                return this->shared ? 0 : i;
+            }
+
+            [[nodiscard]] auto rhs(SizeType i) -> T* {
+                return this->x.data() + i * this->n * this->k;
+            }
+        };
+
+        template <typename T>
+        auto make_system(const Tensor<T>& a, const Tensor<T>& b, const char* what) -> System<T> {
+            check_system(a, b, what);
+            return {b.contiguous(), matrix_batch(b, what), b.shape(b.dim() - 2), b.shape(b.dim() - 1), a.dim() == 2};
+        }
+    }  // namespace detail
+
+    // Lower triangular L with A = L L^T for every symmetric positive definite matrix of a (..., n, n) tensor, reading
+    // only the lower triangle of A; upper = true returns U = L^T instead. Throws if a matrix is not positive definite.
+    template <std::floating_point T>
+    auto cholesky(const Tensor<T>& a, bool upper = false) -> Tensor<T> {
+        const SizeType n = detail::square_size(a, "cholesky");
+        const SizeType batch = detail::matrix_batch(a, "cholesky");
+        Tensor<T> out = a.contiguous();
+        detail::with_static_size(n, [&](auto size) {
+            detail::for_each_matrix(batch, n * n * n / 3, [&](SizeType i) {
+                T* m = out.data() + i * n * n;
+                if (!detail::cholesky_factor(m, size)) {
+                    throw std::runtime_error("cholesky: matrix " + std::to_string(i) + " is not positive definite");
+                }
+                for (SizeType r = 0; r < n; ++r) {
+                    for (SizeType c = r + 1; c < n; ++c) {
+                        m[r * n + c] = upper ? std::exchange(m[c * n + r], T{0}) : T{0};
+                    }
+                }
+            });
+        });
+        return out;
+    }
+
+    // Packed LU factorization with partial pivoting of every matrix of a (..., n, n) tensor, as LAPACK's getrf:
+    // P A = L U with the unit lower L stored below the diagonal and U on and above it, and pivots (..., n) holding the
+    // row swapped with row k at step k. Singular matrices are factored too; solving with them fails.
+    template <std::floating_point T>
+    auto lu(const Tensor<T>& a) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        const SizeType n = detail::square_size(a, "lu");
+        const SizeType batch = detail::matrix_batch(a, "lu");
+        Tensor<T> out = a.contiguous();
+        Tensor<int64_t> pivots(IndexType(a.shape().begin(), a.shape().end() - 1));
+        detail::with_static_size(n, [&](auto size) {
+            detail::for_each_matrix(batch, 2 * n * n * n / 3, [&](SizeType i) {
+                detail::lu_factor(out.data() + i * n * n, size, pivots.data() + i * n);
+            });
+        });
+        return {std::move(out), std::move(pivots)};
+    }
+
+    // X with A X = B for triangular matrices A (..., n, n) and right-hand sides B (..., n, k); A is either batched
+    // like B or a single matrix. Only the triangle of A selected by `upper` is read, and its diagonal is taken as
+    // ones when unitriangular.
+    template <std::floating_point T>
+    auto solve_triangular(const Tensor<T>& a, const Tensor<T>& b, bool upper, bool unitriangular = false)
+        -> Tensor<T> {
+        auto sys = detail::make_system(a, b, "solve_triangular");
+        const Tensor<T> coeffs = detail::packed(a);
+        detail::with_static_size(sys.n, [&](auto size) {
+            detail::for_each_matrix(sys.batch, sys.n * sys.n * sys.k, [&](SizeType i) {
+                detail::trsm(coeffs.data() + sys.matrix(i) * sys.n * sys.n, sys.n, SizeType{1}, size, sys.rhs(i), sys.k,
+                             upper, unitriangular);
+            });
+        });
+        return std::move(sys.x);
+    }
+
+    // X with A X = B given the lower Cholesky factor L of A (see cholesky)
+    template <std::floating_point T>
+    auto cholesky_solve(const Tensor<T>& l, const Tensor<T>& b) -> Tensor<T> {
+        auto sys = detail::make_system(l, b, "cholesky_solve");
+        const Tensor<T> factor = detail::packed(l);
+        detail::with_static_size(sys.n, [&](auto size) {
+            detail::for_each_matrix(sys.batch, 2 * sys.n * sys.n * sys.k, [&](SizeType i) {
+                const T* m = factor.data() + sys.matrix(i) * sys.n * sys.n;
+                T* x = sys.rhs(i);
+                detail::trsm(m, sys.n, SizeType{1}, size, x, sys.k, false, false);
+                // L^T is L with its strides swapped
+                detail::trsm(m, SizeType{1}, sys.n, size, x, sys.k, true, false);
+            });
+        });
+        return std::move(sys.x);
+    }
+
+    // X with A X = B given the packed LU factorization of A (see lu)
+    template <std::floating_point T>
+    auto lu_solve(const Tensor<T>& lu, const Tensor<int64_t>& pivots, const Tensor<T>& b) -> Tensor<T> {
+        auto sys = detail::make_system(lu, b, "lu_solve");
+        TINYTEN_CHECK(pivots.numel() * sys.n == lu.numel(), "lu_solve: pivots do not match the factorization");
+        const Tensor<T> factor = detail::packed(lu);
+        const Tensor<int64_t> piv = detail::packed(pivots);
+        detail::with_static_size(sys.n, [&](auto size) {
+            detail::for_each_matrix(sys.batch, 2 * sys.n * sys.n * sys.k, [&](SizeType i) {
+                const SizeType m = sys.matrix(i);
+                detail::lu_solve_inplace(factor.data() + m * sys.n * sys.n, piv.data() + m * sys.n, size, sys.rhs(i),
+                                         sys.k);
+            });
+        });
+        return std::move(sys.x);
+    }
+
+    // X with A X = B for general square matrices, by LU with partial pivoting; throws if a matrix is singular
+    template <std::floating_point T>
+    auto solve(const Tensor<T>& a, const Tensor<T>& b) -> Tensor<T> {
+        auto sys = detail::make_system(a, b, "solve");
+        const SizeType n = sys.n;
+        const SizeType matrices = sys.shared ? 1 : sys.batch;
+        Tensor<T> factor = a.contiguous();
+        std::vector<int64_t> pivots(static_cast<size_t>(matrices * n));
+        detail::with_static_size(n, [&](auto size) {
+            // a matrix shared by every right-hand side is factored once
+            detail::for_each_matrix(matrices, 2 * n * n * n / 3, [&](SizeType i) {
+                if (!detail::lu_factor(factor.data() + i * n * n, size, pivots.data() + i * n)) {
+                    throw std::runtime_error("solve: matrix " + std::to_string(i) + " is singular");
+                }
+            });
+            detail::for_each_matrix(sys.batch, 2 * n * n * sys.k, [&](SizeType i) {
+                const SizeType m = sys.matrix(i);
+                detail::lu_solve_inplace(factor.data() + m * n * n, pivots.data() + m * n, size, sys.rhs(i), sys.k);
+            });
+        });
+        return std::move(sys.x);
+    }
+
+    // Inverse of every matrix of a (..., n, n) tensor, by LU with partial pivoting; throws if a matrix is singular
+    template <std::floating_point T>
+    auto inverse(const Tensor<T>& a) -> Tensor<T> {
+        const SizeType n = detail::square_size(a, "inverse");
+        const SizeType batch = detail::matrix_batch(a, "inverse");
+        Tensor<T> factor = a.contiguous();
+        Tensor<T> out(a.shape());
+        std::vector<int64_t> pivots(static_cast<size_t>(batch * n));
+        detail::with_static_size(n, [&](auto size) {
+            detail::for_each_matrix(batch, 2 * n * n * n, [&](SizeType i) {
+                T* m = factor.data() + i * n * n;
+                int64_t* piv = pivots.data() + i * n;
+                if (!detail::lu_factor(m, size, piv)) {
+                    throw std::runtime_error("inverse: matrix " + std::to_string(i) + " is singular");
+                }
+                T* x = out.data() + i * n * n;
+                for (SizeType r = 0; r < n; ++r) {
+                    x[r * n + r] = T{1};
+                }
+                detail::lu_solve_inplace(m, piv, size, x, n);
+            });
+        });
+        return out;
+    }
+
+    // Reduced QR factorization by Householder reflections of every matrix of a (..., m, n) tensor: A = Q R with Q
+    // (..., m, K) having orthonormal columns and R (..., K, n) upper triangular, K = min(m, n)
+    template <std::floating_point T>
+    auto qr(const Tensor<T>& a) -> std::pair<Tensor<T>, Tensor<T>> {
+        const SizeType batch = detail::matrix_batch(a, "qr");
+        const SizeType m = a.shape(a.dim() - 2);
+        const SizeType n = a.shape(a.dim() - 1);
+        const SizeType K = std::min(m, n);
+        Tensor<T> work = a.contiguous();
+        IndexType q_shape = a.shape();
+        q_shape.back() = K;
+        IndexType r_shape = a.shape();
+        r_shape[r_shape.size() - 2] = K;
+        Tensor<T> q(q_shape);
+        Tensor<T> r(r_shape);
+        detail::for_each_matrix(batch, 2 * m * n * K, [&](SizeType i) {
+            T* w = work.data() + i * m * n;
+            std::vector<T> tau(static_cast<size_t>(K));
+            std::vector<T> acc(static_cast<size_t>(std::max(n, K)));
+            // reflector k maps column k below the diagonal onto its first entry; v (with v_k = 1) is stored below
+            // the diagonal, and applied to the trailing columns as A -= tau v (v^T A), streaming over whole rows
+            for (SizeType k = 0; k < K; ++k) {
+                T norm2 = 0;
+                for (SizeType row = k + 1; row < m; ++row) {
+                    norm2 += w[row * n + k] * w[row * n + k];
+                }
+                const T x0 = w[k * n + k];
+                if (norm2 == T{0}) {
+                    tau[k] = 0;
+                    continue;
+                }
+                const T beta = x0 >= T{0} ? -std::sqrt(x0 * x0 + norm2) : std::sqrt(x0 * x0 + norm2);
+                tau[k] = (beta - x0) / beta;
+                const T scale = T{1} / (x0 - beta);
+                for (SizeType row = k + 1; row < m; ++row) {
+                    w[row * n + k] *= scale;
+                }
+                w[k * n + k] = beta;
+                std::fill(acc.begin(), acc.begin() + (n - k - 1), T{0});
+                for (SizeType row = k; row < m; ++row) {
+                    const T v = row == k ? T{1} : w[row * n + k];
+                    const T* wr = w + row * n + k + 1;
+                    for (SizeType c = 0; c < n - k - 1; ++c) {
+                        acc[c] += v * wr[c];
+                    }
+                }
+                for (SizeType row = k; row < m; ++row) {
+                    const T v = tau[k] * (row == k ? T{1} : w[row * n + k]);
+                    T* wr = w + row * n + k + 1;
+                    for (SizeType c = 0; c < n - k - 1; ++c) {
+                        wr[c] -= v * acc[c];
+                    }
+                }
+            }
+            T* ri = r.data() + i * K * n;
+            for (SizeType row = 0; row < K; ++row) {
+                std::copy(w + row * n + row, w + (row + 1) * n, ri + row * n + row);
+            }
+            // Q = H_0 ... H_{K-1} applied to the first K columns of the identity, last reflector first
+            T* qi = q.data() + i * m * K;
+            for (SizeType row = 0; row < K; ++row) {
+                qi[row * K + row] = T{1};
+            }
+            for (SizeType k = K - 1; k >= 0; --k) {
+                if (tau[k] == T{0}) {
+                    continue;
+                }
+                std::fill(acc.begin(), acc.begin() + (K - k), T{0});
+                for (SizeType row = k; row < m; ++row) {
+                    const T v = row == k ? T{1} : w[row * n + k];
+                    const T* qrow = qi + row * K + k;
+                    for (SizeType c = 0; c < K - k; ++c) {
+                        acc[c] += v * qrow[c];
+                    }
+                }
+                for (SizeType row = k; row < m; ++row) {
+                    const T v = tau[k] * (row == k ? T{1} : w[row * n + k]);
+                    T* qrow = qi + row * K + k;
+                    for (SizeType c = 0; c < K - k; ++c) {
+                        qrow[c] -= v * acc[c];
+                    }
+                }
+            }
+        });
+        return {std::move(q), std::move(r)};
+    }
+};  // namespace tt::inline v1
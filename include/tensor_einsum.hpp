@@ -0,0 +1,521 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_linalg.hpp"
+#include "tensor_reductions.hpp"
+#include "tensor_views.hpp"
+#include "utils/Check.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/ThreadPool.hpp"
+
+// Einstein summation.
+//
+// A subscript string such as "bij,bjk->bik" is parsed once and cached. For every set of operand shapes a pairwise
+// contraction order is chosen that minimizes the multiply-adds (and then the size of the intermediates), and that
+// order is cached alongside the parsed expression. Both caches keep only the most recently used entries (see
+// EINSUM_CACHE_MAX), so programs with dynamic shapes or generated subscripts do not grow them without bound. Each
+// pairwise contraction sums out labels no later step needs, arranges both operands as [batch, free, contracted]
+// matrices, through permuted views when their layout already allows it, and runs one GEMM per batch entry.
+namespace tt::inline v1 {
+    // Operands beyond this count are ordered greedily instead of by exhaustive search over subsets
+    constexpr size_t EINSUM_OPTIMAL_MAX = 8;
+    // Parsed expressions cached process-wide, and contraction paths cached per expression (one per set of shapes)
+    constexpr size_t EINSUM_CACHE_MAX = 256;
+    constexpr size_t EINSUM_PATHS_MAX = 64;
+
+    // Parsed subscripts. Labels are single letters; without "->" the output holds every label that appears exactly
+    // once, in alphabetical order. Ellipses are not supported.
+    struct EinsumExpr {
+        std::vector<std::string> inputs;
+        std::string output;
+
+        // Pairwise contraction steps over operand slots: step (i, j) replaces slot i with the contraction of slots
+        // i and j and empties slot j
+        using Path = std::vector<std::pair<size_t, size_t>>;
+
+        static auto parse(const std::string& subscripts) -> EinsumExpr;
+    };
+
+    inline auto EinsumExpr::parse(const std::string& subscripts) -> EinsumExpr {
+        EinsumExpr expr;
+        std::string spec;
+        for (char c : subscripts) {
+            if (c != ' ') {
+                spec.push_back(c);
+            }
+        }
+        const auto arrow = spec.find("->");
+        const std::string lhs = spec.substr(0, arrow);
+        size_t start = 0;
+        while (true) {
+            const auto comma = lhs.find(',', start);
+            expr.inputs.push_back(lhs.substr(start, comma - start));
+            if (comma == std::string::npos) {
+                break;
+            }
+            start = comma + 1;
+        }
+
+        std::map<char, int> counts;
+        for (const auto& in : expr.inputs) {
+            for (char c : in) {
+                if (!std::isalpha(static_cast<unsigned char>(c))) {
+                    throw std::runtime_error("einsum: invalid subscript '" + std::string(1, c) + "'");
+                }
+                counts[c]++;
+            }
+        }
+        if (arrow != std::string::npos) {
+            expr.output = spec.substr(arrow + 2);
+            for (char c : expr.output) {
+                if (counts.count(c) == 0) {
+                    throw std::runtime_error("einsum: output subscript '" + std::string(1, c) +
+                                             "' does not appear in the inputs");
+                }
+                if (std::count(expr.output.begin(), expr.output.end(), c) != 1) {
+                    throw std::runtime_error("einsum: output subscript repeated");
+                }
+            }
+        } else {
+            for (auto [c, n] : counts) {
+                if (n == 1) {
+                    expr.output.push_back(c);
+                }
+            }
+        }
+        return expr;
+    }
+
+    namespace detail {
+        // A parsed expression and the contraction paths recently used with it, keyed by operand shapes
+        struct EinsumEntry {
+            EinsumExpr expr;
+            std::mutex mutex;
+            LruCache<std::vector<IndexType>, EinsumExpr::Path> paths{EINSUM_PATHS_MAX};
+        };
+
+        struct EinsumCache {
+            std::mutex mutex;
+            LruCache<std::string, std::shared_ptr<EinsumEntry>> entries{EINSUM_CACHE_MAX};
+        };
+
+        // Never destroyed, like the region cache
+        inline auto einsum_cache() -> EinsumCache& {
+            static auto* cache = new EinsumCache();
+            return *cache;
+        }
+
+        // Process-wide cache of parsed expressions. An entry evicted while in use stays alive with its users.
+        inline auto einsum_entry(const std::string& subscripts) -> std::shared_ptr<EinsumEntry> {
+            auto& cache = einsum_cache();
+            std::lock_guard lock(cache.mutex);
+            if (auto* entry = cache.entries.find(subscripts)) {
+                return *entry;
+            }
+            auto entry = std::make_shared<EinsumEntry>();
+            entry->expr = EinsumExpr::parse(subscripts);
+            return cache.entries.insert(subscripts, std::move(entry));
+        }
+
+        // Labels of a contraction of operands carrying `a` and `b` that are still needed by `keep`
+        inline auto kept_labels(const std::string& a, const std::string& b, const std::string& keep) -> std::string {
+            std::string out;
+            for (char c : a + b) {
+                if (keep.find(c) != std::string::npos && out.find(c) == std::string::npos) {
+                    out.push_back(c);
+                }
+            }
+            return out;
+        }
+
+        inline auto label_volume(const std::string& labels, const std::map<char, SizeType>& sizes) -> double {
+            double v = 1.0;
+            for (char c : labels) {
+                v *= static_cast<double>(sizes.at(c));
+            }
+            return v;
+        }
+
+        inline auto union_labels(const std::string& a, const std::string& b) -> std::string {
+            std::string out = a;
+            for (char c : b) {
+                if (out.find(c) == std::string::npos) {
+                    out.push_back(c);
+                }
+            }
+            return out;
+        }
+
+        // Labels needed outside of the operands in `subset`: the output's and those of every other operand
+        inline auto outside_labels(const std::vector<std::string>& inputs, const std::string& output, uint32_t subset)
+            -> std::string {
+            std::string keep = output;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if ((subset & (1U << i)) == 0) {
+                    keep += inputs[i];
+                }
+            }
+            return keep;
+        }
+
+        // Exhaustive search over subsets: the best way to contract subset S is the cheapest split into two parts
+        // that are each contracted the best way first
+        inline auto optimal_path(const std::vector<std::string>& inputs, const std::string& output,
+                                 const std::map<char, SizeType>& sizes) -> EinsumExpr::Path {
+            const size_t n = inputs.size();
+            const uint32_t full = (1U << n) - 1;
+            std::vector<std::string> labels(full + 1);
+            std::vector<double> cost(full + 1, std::numeric_limits<double>::infinity());
+            std::vector<uint32_t> split(full + 1, 0);
+            for (uint32_t s = 1; s <= full; ++s) {
+                std::string all;
+                for (size_t i = 0; i < n; ++i) {
+                    if (s & (1U << i)) {
+                        all = union_labels(all, inputs[i]);
+                    }
+                }
+                labels[s] = kept_labels(all, "", outside_labels(inputs, output, s));
+                if ((s & (s - 1)) == 0) {
+                    cost[s] = 0.0;
+                    continue;
+                }
+                for (uint32_t a = (s - 1) & s; a > 0; a = (a - 1) & s) {
+                    const uint32_t b = s ^ a;
+                    if (a < b) {
+                        continue;
+                    }
+                    const double flops = label_volume(union_labels(labels[a], labels[b]), sizes);
+                    const double c = cost[a] + cost[b] + flops + label_volume(labels[s], sizes);
+                    if (c < cost[s]) {
+                        cost[s] = c;
+                        split[s] = a;
+                    }
+                }
+            }
+
+            // Replays the splits bottom-up; every subset lives in the slot of its lowest operand
+            EinsumExpr::Path path;
+            auto emit = [&](auto&& self, uint32_t s) -> size_t {
+                if ((s & (s - 1)) == 0) {
+                    return static_cast<size_t>(std::countr_zero(s));
+                }
+                const size_t i = self(self, split[s]);
+                const size_t j = self(self, s ^ split[s]);
+                path.emplace_back(std::min(i, j), std::max(i, j));
+                return std::min(i, j);
+            };
+            emit(emit, full);
+            return path;
+        }
+
+        // Repeatedly contracts the pair with the fewest multiply-adds, then the smallest result
+        inline auto greedy_path(std::vector<std::string> inputs, const std::string& output,
+                                const std::map<char, SizeType>& sizes) -> EinsumExpr::Path {
+            EinsumExpr::Path path;
+            std::vector<bool> live(inputs.size(), true);
+            for (size_t step = 1; step < inputs.size(); ++step) {
+                double best = std::numeric_limits<double>::infinity();
+                double best_size = best;
+                size_t bi = 0;
+                size_t bj = 0;
+                std::string best_labels;
+                for (size_t i = 0; i < inputs.size(); ++i) {
+                    for (size_t j = i + 1; j < inputs.size() && live[i]; ++j) {
+                        if (!live[j]) {
+                            continue;
+                        }
+                        std::string keep = output;
+                        for (size_t k = 0; k < inputs.size(); ++k) {
+                            if (live[k] && k != i && k != j) {
+                                keep += inputs[k];
+                            }
+                        }
+                        const std::string out = kept_labels(inputs[i], inputs[j], keep);
+                        const double flops = label_volume(union_labels(inputs[i], inputs[j]), sizes);
+                        const double size = label_volume(out, sizes);
+                        if (flops < best || (flops == best && size < best_size)) {
+                            best = flops;
+                            best_size = size;
+                            bi = i;
+                            bj = j;
+                            best_labels = out;
+                        }
+                    }
+                }
+                path.emplace_back(bi, bj);
+                inputs[bi] = best_labels;
+                live[bj] = false;
+            }
+            return path;
+        }
+
+        inline auto label_sizes(const std::vector<std::string>& inputs, const std::vector<IndexType>& shapes)
+            -> std::map<char, SizeType> {
+            std::map<char, SizeType> sizes;
+            for (size_t i = 0; i < inputs.size(); ++i) {
+                if (static_cast<SizeType>(inputs[i].size()) != static_cast<SizeType>(shapes[i].size()) &&
+                    !(inputs[i].empty() && shapes[i] == IndexType{1})) {
+                    throw std::runtime_error("einsum: operand " + std::to_string(i) +
+                                             " has the wrong number of dimensions");
+                }
+                for (size_t d = 0; d < inputs[i].size(); ++d) {
+                    auto [it, inserted] = sizes.emplace(inputs[i][d], shapes[i][d]);
+                    if (!inserted && it->second != shapes[i][d]) {
+                        throw std::runtime_error("einsum: size mismatch for subscript '" +
+                                                 std::string(1, inputs[i][d]) + "'");
+                    }
+                }
+            }
+            return sizes;
+        }
+    }  // namespace detail
+
+    // Contraction order einsum uses for operands of these shapes, computed once per expression and shapes
+    inline auto einsum_path(const std::string& subscripts, const std::vector<IndexType>& shapes) -> EinsumExpr::Path {
+        const auto entry = detail::einsum_entry(subscripts);
+        std::lock_guard lock(entry->mutex);
+        if (const auto* path = entry->paths.find(shapes)) {
+            return *path;
+        }
+        const auto& expr = entry->expr;
+        const auto sizes = detail::label_sizes(expr.inputs, shapes);
+        auto path = expr.inputs.size() <= EINSUM_OPTIMAL_MAX ? detail::optimal_path(expr.inputs, expr.output, sizes)
+                                                             : detail::greedy_path(expr.inputs, expr.output, sizes);
+        return entry->paths.insert(shapes, std::move(path));
+    }
+
+    namespace detail {
+        template <typename T>
+        struct EinsumOperand {
+            Tensor<T> tensor;
+            std::string labels;
+        };
+
+        // Maps one operand to `out` labels: repeated input labels take the diagonal, labels missing from `out` are
+        // summed. Walks every combination of the distinct input labels once.
+        template <typename T>
+        auto einsum_unary(const EinsumOperand<T>& in, const std::string& out, const std::map<char, SizeType>& sizes)
+            -> Tensor<T> {
+            std::string distinct;
+            IndexType in_strides;
+            for (size_t d = 0; d < in.labels.size(); ++d) {
+                const auto pos = distinct.find(in.labels[d]);
+                if (pos == std::string::npos) {
+                    distinct.push_back(in.labels[d]);
+                    in_strides.push_back(in.tensor.stride(static_cast<int>(d)));
+                } else {
+                    in_strides[pos] += in.tensor.stride(static_cast<int>(d));
+                }
+            }
+
+            IndexType out_shape;
+            for (char c : out) {
+                out_shape.push_back(sizes.at(c));
+            }
+            if (out_shape.empty()) {
+                out_shape.push_back(1);
+            }
+            Tensor<T> result(out_shape);
+            const IndexType canon = tt::calc_strides(out_shape);
+            IndexType out_strides(distinct.size(), 0);
+            IndexType extent(distinct.size());
+            for (size_t d = 0; d < distinct.size(); ++d) {
+                extent[d] = sizes.at(distinct[d]);
+                if (const auto pos = out.find(distinct[d]); pos != std::string::npos) {
+                    out_strides[d] = canon[pos];
+                }
+            }
+
+            const T* src = in.tensor.data();
+            T* dst = result.data();
+            const SizeType total = distinct.empty() ? 1 : tt::cumprod(extent);
+            IndexType idx(distinct.size(), 0);
+            SizeType si = 0;
+            SizeType di = 0;
+            for (SizeType n = 0; n < total; ++n) {
+                dst[di] += src[si];
+                for (auto d = static_cast<SizeType>(distinct.size()) - 1; d >= 0; --d) {
+                    si += in_strides[d];
+                    di += out_strides[d];
+                    if (++idx[d] < extent[d]) {
+                        break;
+                    }
+                    si -= in_strides[d] * extent[d];
+                    di -= out_strides[d] * extent[d];
+                    idx[d] = 0;
+                }
+            }
+            return result;
+        }
+
+        // A view of the operand with its dims in the order of `labels`
+        template <typename T>
+        auto arranged(const EinsumOperand<T>& op, const std::string& labels) -> Tensor<T> {
+            Tensor<T> view = op.tensor.view();
+            if (!labels.empty()) {
+                IndexType axes;
+                for (char c : labels) {
+                    axes.push_back(static_cast<SizeType>(op.labels.find(c)));
+                }
+                view.permute_(axes);
+            }
+            return view;
+        }
+
+        // Contracts two operands down to the labels in `keep`, as one GEMM per entry of the batch labels
+        template <typename T>
+        auto contract_pair(const EinsumOperand<T>& a, const EinsumOperand<T>& b, const std::string& keep,
+                           const std::map<char, SizeType>& sizes) -> EinsumOperand<T> {
+            std::string batch;
+            std::string m_labels;
+            std::string n_labels;
+            std::string k_labels;
+            for (char c : a.labels) {
+                const bool in_b = b.labels.find(c) != std::string::npos;
+                const bool kept = keep.find(c) != std::string::npos;
+                if (in_b && kept) {
+                    batch.push_back(c);
+                } else if (in_b) {
+                    k_labels.push_back(c);
+                } else if (kept) {
+                    m_labels.push_back(c);
+                }
+            }
+            for (char c : b.labels) {
+                if (a.labels.find(c) == std::string::npos && keep.find(c) != std::string::npos) {
+                    n_labels.push_back(c);
+                }
+            }
+
+            // labels only one side carries and nothing later needs are summed out before the product
+            auto reduce_side = [&](const EinsumOperand<T>& op, const std::string& wanted) {
+                if (op.labels.size() == wanted.size()) {
+                    return EinsumOperand<T>{op.tensor.view(), op.labels};
+                }
+                return EinsumOperand<T>{einsum_unary(op, wanted, sizes), wanted};
+            };
+            const auto ra = reduce_side(a, batch + m_labels + k_labels);
+            const auto rb = reduce_side(b, batch + k_labels + n_labels);
+
+            const SizeType nb = static_cast<SizeType>(label_volume(batch, sizes));
+            const SizeType m = static_cast<SizeType>(label_volume(m_labels, sizes));
+            const SizeType n = static_cast<SizeType>(label_volume(n_labels, sizes));
+            const SizeType k = static_cast<SizeType>(label_volume(k_labels, sizes));
+
+            // A may be read as [batch, M, K] or, through swapped strides, as [batch, K, M]; B has to be [batch, K, N]
+            // for the unit-stride GEMM path. Anything else is copied into that layout.
+            Tensor<T> ta = arranged(ra, batch + m_labels + k_labels);
+            SizeType rsa = k;
+            SizeType csa = 1;
+            if (!ta._is_contiguous()) {
+                Tensor<T> swapped = arranged(ra, batch + k_labels + m_labels);
+                if (swapped._is_contiguous()) {
+                    ta = std::move(swapped);
+                    rsa = 1;
+                    csa = m;
+                } else {
+                    ta = ta.contiguous();
+                }
+            }
+            Tensor<T> tb = arranged(rb, batch + k_labels + n_labels);
+            if (!tb._is_contiguous()) {
+                tb = tb.contiguous();
+            }
+
+            const std::string labels = batch + m_labels + n_labels;
+            IndexType shape;
+            for (char c : labels) {
+                shape.push_back(sizes.at(c));
+            }
+            if (shape.empty()) {
+                shape.push_back(1);
+            }
+            Tensor<T> out(shape);
+            const T* pa = ta.data();
+            const T* pb = tb.data();
+            T* pc = out.data();
+            // batches run in parallel; a single batch parallelizes inside the GEMM instead
+            tt::parallel_for(0, nb, 1, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    detail::gemm(m, n, k, pa + i * m * k, rsa, csa, pb + i * k * n, n, SizeType{1}, pc + i * m * n, n,
+                                 SizeType{1}, false);
+                }
+            });
+            return {std::move(out), labels};
+        }
+    }  // namespace detail
+
+    template <typename T>
+    auto einsum(const std::string& subscripts, const std::vector<const Tensor<T>*>& operands) -> Tensor<T> {
+        const auto entry = detail::einsum_entry(subscripts);
+        const EinsumExpr& expr = entry->expr;
+        if (expr.inputs.size() != operands.size()) {
+            throw std::runtime_error("einsum: expected " + std::to_string(expr.inputs.size()) + " operands, got " +
+                                     std::to_string(operands.size()));
+        }
+        std::vector<IndexType> shapes;
+        for (const auto* op : operands) {
+            shapes.push_back(op->shape());
+        }
+        const auto sizes = detail::label_sizes(expr.inputs, shapes);
+
+        // repeated labels within one operand are reduced to their diagonal up front
+        std::vector<detail::EinsumOperand<T>> slots;
+        std::vector<std::string> labels;
+        for (size_t i = 0; i < operands.size(); ++i) {
+            std::string distinct;
+            for (char c : expr.inputs[i]) {
+                if (distinct.find(c) == std::string::npos) {
+                    distinct.push_back(c);
+                }
+            }
+            detail::EinsumOperand<T> op{operands[i]->view(), expr.inputs[i]};
+            if (distinct.size() != expr.inputs[i].size()) {
+                op = {detail::einsum_unary(op, distinct, sizes), distinct};
+            }
+            labels.push_back(op.labels);
+            slots.push_back(std::move(op));
+        }
+
+        if (slots.size() > 1) {
+            const auto path = einsum_path(subscripts, shapes);
+            std::vector<bool> live(slots.size(), true);
+            for (auto [i, j] : path) {
+                live[j] = false;
+                std::string keep = expr.output;
+                for (size_t s = 0; s < slots.size(); ++s) {
+                    if (live[s] && s != i) {
+                        keep += slots[s].labels;
+                    }
+                }
+                slots[i] = detail::contract_pair(slots[i], slots[j], keep, sizes);
+                slots[j] = {};
+            }
+        }
+
+        // the final operand may still carry labels to sum or be in the wrong order
+        const auto& last = slots[0];
+        if (slots.size() > 1 && last.labels == expr.output) {
+            return last.tensor;
+        }
+        return detail::einsum_unary(last, expr.output, sizes);
+    }
+
+    template <typename T, typename... Ts>
+    auto einsum(const std::string& subscripts, const Tensor<T>& first, const Ts&... rest) -> Tensor<T> {
+        return einsum<T>(subscripts, std::vector<const Tensor<T>*>{&first, &rest...});
+    }
+};  // namespace tt::inline v1
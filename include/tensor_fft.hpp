@@ -0,0 +1,628 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <concepts>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "utils/Check.hpp"
+#include "utils/LruCache.hpp"
+#include "utils/ThreadPool.hpp"
+
+// Discrete Fourier transforms.
+//
+// Lengths whose prime factors are all at most FFT_MAX_RADIX run as a mixed-radix Stockham FFT: every stage reads one
+// buffer and writes the other, so the output comes out in natural order without a bit-reversal pass, and the
+// innermost loop of each butterfly runs over unit-stride sub-transforms. Other lengths go through Bluestein's
+// algorithm, a convolution done with a power-of-two transform. Plans are built once per length and cached, keeping
+// the FFT_PLAN_CACHE_MAX most recently used lengths; lanes along the transformed dim are gathered into per-thread
+// buffers and transformed in parallel.
+namespace tt::inline v1 {
+    using complex64 = std::complex<float>;
+    using complex128 = std::complex<double>;
+
+    template <typename T>
+    struct is_complex : std::false_type {};
+
+    template <typename R>
+    struct is_complex<std::complex<R>> : std::true_type {};
+
+    template <typename T>
+    concept Complex = is_complex<T>::value;
+
+    // Largest prime factor handled by a direct butterfly
+    constexpr SizeType FFT_MAX_RADIX = 13;
+    // Plans kept per real type; a Bluestein plan holds O(n) twiddles and an inner plan of up to 4n points
+    constexpr size_t FFT_PLAN_CACHE_MAX = 64;
+
+    namespace detail {
+        // Plain complex product; std::complex's operator* also handles infinities and NaNs, which costs a call
+        template <typename R>
+        inline auto cmul(const std::complex<R>& a, const std::complex<R>& b) -> std::complex<R> {
+            return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+        }
+
+        template <typename R>
+        inline auto mul_neg_i(const std::complex<R>& a) -> std::complex<R> {
+            return {a.imag(), -a.real()};
+        }
+
+        // exp(-2 pi i k / n), evaluated in double so float plans get correctly rounded twiddles
+        template <typename R>
+        inline auto root(SizeType k, SizeType n) -> std::complex<R> {
+            const double angle = -2.0 * std::numbers::pi * static_cast<double>(k % n) / static_cast<double>(n);
+            return {static_cast<R>(std::cos(angle)), static_cast<R>(std::sin(angle))};
+        }
+    }  // namespace detail
+
+    // Forward transform of one length. Inverse transforms reuse it by conjugating input and output.
+    template <std::floating_point R>
+    class FftPlan {
+      public:
+        using Complex = std::complex<R>;
+
+        explicit FftPlan(SizeType n) : n_(n) {
+            TINYTEN_CHECK(n > 0, "fft: length must be positive");
+            std::vector<SizeType> radices;
+            SizeType rest = n;
+            while (rest % 4 == 0) {
+                radices.push_back(4);
+                rest /= 4;
+            }
+            for (SizeType p = 2; p * p <= rest; ++p) {
+                while (rest % p == 0) {
+                    radices.push_back(p);
+                    rest /= p;
+                }
+            }
+            if (rest > 1) {
+                radices.push_back(rest);
+            }
+
+            if (std::any_of(radices.begin(), radices.end(), [](SizeType r) { return r > FFT_MAX_RADIX; })) {
+                this->init_bluestein();
+                return;
+            }
+            SizeType len = n;
+            SizeType stride = 1;
+            for (SizeType r : radices) {
+                Stage stage{r, len, stride, static_cast<SizeType>(this->twiddles_.size()),
+                            static_cast<SizeType>(this->roots_.size())};
+                for (SizeType p = 0; p < len / r; ++p) {
+                    for (SizeType k = 1; k < r; ++k) {
+                        this->twiddles_.push_back(detail::root<R>(p * k, len));
+                    }
+                }
+                if (r != 2 && r != 4) {
+                    for (SizeType t = 0; t < r; ++t) {
+                        this->roots_.push_back(detail::root<R>(t, r));
+                    }
+                }
+                this->stages_.push_back(stage);
+                len /= r;
+                stride *= r;
+            }
+        }
+
+        [[nodiscard]] auto size() const noexcept -> SizeType {
+            return this->n_;
+        }
+
+        // Complex values forward() needs next to the data
+        [[nodiscard]] auto scratch_size() const noexcept -> SizeType {
+            return this->inner_ ? this->inner_->size() + this->inner_->scratch_size() : this->n_;
+        }
+
+        // In-place forward DFT of n contiguous values: X[f] = sum_t x[t] exp(-2 pi i t f / n)
+        void forward(Complex* data, Complex* scratch) const {
+            if (this->inner_) {
+                this->forward_bluestein(data, scratch);
+                return;
+            }
+            Complex* x = data;
+            Complex* y = scratch;
+            for (const Stage& stage : this->stages_) {
+                this->run_stage(stage, x, y);
+                std::swap(x, y);
+            }
+            if (x != data) {
+                std::copy(x, x + this->n_, data);
+            }
+        }
+
+      private:
+        // One pass over all sub-transforms of length `len`; `stride` of them are interleaved element by element
+        struct Stage {
+            SizeType radix;
+            SizeType len;
+            SizeType stride;
+            SizeType twiddles;
+            SizeType roots;
+        };
+
+        SizeType n_;
+        std::vector<Stage> stages_;
+        // per stage, w_len^(p * k) at [p * (radix - 1) + k - 1]
+        std::vector<Complex> twiddles_;
+        // per generic-radix stage, w_radix^t
+        std::vector<Complex> roots_;
+
+        // Bluestein: power-of-two plan, chirp exp(-i pi k^2 / n) and the transform of its conjugate, divided by m
+        std::shared_ptr<const FftPlan> inner_;
+        std::vector<Complex> chirp_;
+        std::vector<Complex> chirp_fft_;
+
+        // Splits each sub-transform of length len into radix interleaved ones of length len / radix (decimation in
+        // frequency): y[q + s * (radix * p + k)] = w_len^(p * k) * sum_j x[q + s * (p + j * m)] * w_radix^(j * k)
+        void run_stage(const Stage& stage, const Complex* x, Complex* y) const {
+            const SizeType r = stage.radix;
+            const SizeType s = stage.stride;
+            const SizeType m = stage.len / r;
+            const Complex* tw = this->twiddles_.data() + stage.twiddles;
+            if (r == 2) {
+                for (SizeType p = 0; p < m; ++p) {
+                    const Complex w = tw[p];
+                    const Complex* x0 = x + s * p;
+                    const Complex* x1 = x + s * (p + m);
+                    Complex* y0 = y + s * 2 * p;
+                    Complex* y1 = y0 + s;
+                    for (SizeType q = 0; q < s; ++q) {
+                        const Complex a = x0[q];
+                        const Complex b = x1[q];
+                        y0[q] = a + b;
+                        y1[q] = detail::cmul(a - b, w);
+                    }
+                }
+                return;
+            }
+            if (r == 4) {
+                for (SizeType p = 0; p < m; ++p) {
+                    const Complex w1 = tw[3 * p];
+                    const Complex w2 = tw[3 * p + 1];
+                    const Complex w3 = tw[3 * p + 2];
+                    const Complex* x0 = x + s * p;
+                    Complex* y0 = y + s * 4 * p;
+                    for (SizeType q = 0; q < s; ++q) {
+                        const Complex a0 = x0[q];
+                        const Complex a1 = x0[q + s * m];
+                        const Complex a2 = x0[q + s * 2 * m];
+                        const Complex a3 = x0[q + s * 3 * m];
+                        const Complex t0 = a0 + a2;
+                        const Complex t1 = a0 - a2;
+                        const Complex t2 = a1 + a3;
+                        const Complex t3 = detail::mul_neg_i(a1 - a3);
+                        y0[q] = t0 + t2;
+                        y0[q + s] = detail::cmul(t1 + t3, w1);
+                        y0[q + 2 * s] = detail::cmul(t0 - t2, w2);
+                        y0[q + 3 * s] = detail::cmul(t1 - t3, w3);
+                    }
+                }
+                return;
+            }
+            const Complex* roots = this->roots_.data() + stage.roots;
+            std::array<Complex, FFT_MAX_RADIX> a;
+            for (SizeType p = 0; p < m; ++p) {
+                for (SizeType q = 0; q < s; ++q) {
+                    for (SizeType j = 0; j < r; ++j) {
+                        a[j] = x[q + s * (p + j * m)];
+                    }
+                    for (SizeType k = 0; k < r; ++k) {
+                        Complex acc = a[0];
+                        for (SizeType j = 1; j < r; ++j) {
+                            acc += detail::cmul(a[j], roots[(j * k) % r]);
+                        }
+                        y[q + s * (r * p + k)] = k == 0 ? acc : detail::cmul(acc, tw[p * (r - 1) + k - 1]);
+                    }
+                }
+            }
+        }
+
+        void init_bluestein() {
+            const SizeType n = this->n_;
+            const auto m = static_cast<SizeType>(std::bit_ceil(static_cast<uint64_t>(2 * n - 1)));
+            this->inner_ = std::make_shared<const FftPlan>(m);
+            this->chirp_.resize(n);
+            for (SizeType k = 0; k < n; ++k) {
+                this->chirp_[k] = detail::root<R>((k * k) % (2 * n), 2 * n);
+            }
+            this->chirp_fft_.assign(m, Complex{});
+            this->chirp_fft_[0] = std::conj(this->chirp_[0]);
+            for (SizeType k = 1; k < n; ++k) {
+                this->chirp_fft_[k] = this->chirp_fft_[m - k] = std::conj(this->chirp_[k]);
+            }
+            std::vector<Complex> scratch(this->inner_->scratch_size());
+            this->inner_->forward(this->chirp_fft_.data(), scratch.data());
+            for (auto& v : this->chirp_fft_) {
+                v /= static_cast<R>(m);
+            }
+        }
+
+        // X[k] = chirp[k] * (a conv b)[k] with a[k] = x[k] * chirp[k] and b[k] = conj(chirp[k]); the inverse
+        // transform of the convolution is a forward one between two conjugations
+        void forward_bluestein(Complex* data, Complex* scratch) const {
+            const SizeType n = this->n_;
+            const SizeType m = this->inner_->size();
+            Complex* a = scratch;
+            Complex* rest = scratch + m;
+            for (SizeType k = 0; k < n; ++k) {
+                a[k] = detail::cmul(data[k], this->chirp_[k]);
+            }
+            std::fill(a + n, a + m, Complex{});
+            this->inner_->forward(a, rest);
+            for (SizeType k = 0; k < m; ++k) {
+                a[k] = std::conj(detail::cmul(a[k], this->chirp_fft_[k]));
+            }
+            this->inner_->forward(a, rest);
+            for (SizeType k = 0; k < n; ++k) {
+                data[k] = detail::cmul(std::conj(a[k]), this->chirp_[k]);
+            }
+        }
+    };
+
+    namespace detail {
+        template <std::floating_point R>
+        struct FftPlanCache {
+            std::mutex mutex;
+            LruCache<SizeType, std::shared_ptr<const FftPlan<R>>> plans{FFT_PLAN_CACHE_MAX};
+        };
+
+        // Never destroyed, like the region cache
+        template <std::floating_point R>
+        auto fft_plan_cache() -> FftPlanCache<R>& {
+            static auto* cache = new FftPlanCache<R>();
+            return *cache;
+        }
+    }  // namespace detail
+
+    // Shared plan for transforms of length n; built on first use and kept while it is among the recently used
+    // lengths. A plan evicted while in use stays alive with its users.
+    template <std::floating_point R>
+    auto fft_plan(SizeType n) -> std::shared_ptr<const FftPlan<R>> {
+        auto& cache = detail::fft_plan_cache<R>();
+        std::lock_guard lock(cache.mutex);
+        if (auto* plan = cache.plans.find(n)) {
+            return *plan;
+        }
+        return cache.plans.insert(n, std::make_shared<const FftPlan<R>>(n));
+    }
+
+    namespace detail {
+        // Calls f(in_offset, out_offset, buffer) for every lane along dim. Lanes are spread over the pool; every
+        // chunk reuses one buffer of buffer_size complex values.
+        template <typename R, typename F>
+        void fft_lanes(const IndexType& shape, const IndexType& in_strides, const IndexType& out_strides, SizeType dim,
+                       SizeType buffer_size, F f) {
+            const auto in_offsets = tt::lane_offsets(shape, in_strides, dim);
+            const auto out_offsets = tt::lane_offsets(shape, out_strides, dim);
+            const auto lanes = static_cast<SizeType>(in_offsets.size());
+            const SizeType grain = std::max<SizeType>(1, 4096 / std::max<SizeType>(buffer_size, 1));
+            tt::parallel_for(0, lanes, grain, [&](SizeType lo, SizeType hi) {
+                std::vector<std::complex<R>> buffer(buffer_size);
+                for (SizeType l = lo; l < hi; ++l) {
+                    f(in_offsets[l], out_offsets[l], buffer.data());
+                }
+            });
+        }
+
+        template <typename R>
+        auto fft_complex(const Tensor<std::complex<R>>& input, SizeType dim, bool inverse)
+            -> Tensor<std::complex<R>> {
+            using C = std::complex<R>;
+            TINYTEN_CHECK(dim >= 0 && dim < input.dim(), "fft: dim out of bounds");
+            const SizeType n = input.shape(dim);
+            const auto plan = fft_plan<R>(n);
+            Tensor<C> result(input.shape());
+            const SizeType is = input.stride(dim);
+            const SizeType os = result.stride(dim);
+            const C* src = input.data();
+            C* dst = result.data();
+            const R scale = inverse ? R{1} / static_cast<R>(n) : R{1};
+            fft_lanes<R>(input.shape(), input.strides(), result.strides(), dim, n + plan->scratch_size(),
+                         [&](SizeType in_offset, SizeType out_offset, C* lane) {
+                             for (SizeType i = 0; i < n; ++i) {
+                                 const C v = src[in_offset + i * is];
+                                 lane[i] = inverse ? std::conj(v) : v;
+                             }
+                             plan->forward(lane, lane + n);
+                             for (SizeType i = 0; i < n; ++i) {
+                                 dst[out_offset + i * os] = inverse ? std::conj(lane[i]) * scale : lane[i];
+                             }
+                         });
+            return result;
+        }
+
+        template <typename C, typename T, typename F>
+        auto map_complex(const Tensor<T>& input, F f) -> Tensor<C> {
+            Tensor<C> result(input.shape());
+            std::transform(input.begin(), input.end(), result.data(), f);
+            return result;
+        }
+    }  // namespace detail
+
+    ////////////////////////////////////////////////////////////////////
+    // Complex tensors
+    ////////////////////////////////////////////////////////////////////
+    template <std::floating_point R>
+    auto to_complex(const Tensor<R>& re) -> Tensor<std::complex<R>> {
+        return detail::map_complex<std::complex<R>>(re, [](R x) { return std::complex<R>(x); });
+    }
+
+    template <std::floating_point R>
+    auto to_complex(const Tensor<R>& re, const Tensor<R>& im) -> Tensor<std::complex<R>> {
+        TINYTEN_CHECK(re.shape() == im.shape(), "Shapes are not the same");
+        Tensor<std::complex<R>> result(re.shape());
+        std::transform(re.begin(), re.end(), im.begin(), result.data(),
+                       [](R x, R y) { return std::complex<R>(x, y); });
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto real(const Tensor<std::complex<R>>& input) -> Tensor<R> {
+        return detail::map_complex<R>(input, [](const std::complex<R>& v) { return v.real(); });
+    }
+
+    template <std::floating_point R>
+    auto imag(const Tensor<std::complex<R>>& input) -> Tensor<R> {
+        return detail::map_complex<R>(input, [](const std::complex<R>& v) { return v.imag(); });
+    }
+
+    // Magnitude of every element
+    template <std::floating_point R>
+    auto abs(const Tensor<std::complex<R>>& input) -> Tensor<R> {
+        return detail::map_complex<R>(input, [](const std::complex<R>& v) { return std::abs(v); });
+    }
+
+    template <std::floating_point R>
+    auto conj(const Tensor<std::complex<R>>& input) -> Tensor<std::complex<R>> {
+        return detail::map_complex<std::complex<R>>(input, [](const std::complex<R>& v) { return std::conj(v); });
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Transforms along one dim; without a dim they run along the last one. ifft and irfft divide by the length.
+    ////////////////////////////////////////////////////////////////////
+    template <std::floating_point R>
+    auto fft(const Tensor<std::complex<R>>& input, SizeType dim) -> Tensor<std::complex<R>> {
+        return detail::fft_complex(input, dim, false);
+    }
+
+    template <std::floating_point R>
+    auto fft(const Tensor<R>& input, SizeType dim) -> Tensor<std::complex<R>> {
+        return detail::fft_complex(to_complex(input), dim, false);
+    }
+
+    template <std::floating_point R>
+    auto ifft(const Tensor<std::complex<R>>& input, SizeType dim) -> Tensor<std::complex<R>> {
+        return detail::fft_complex(input, dim, true);
+    }
+
+    template <typename T>
+    auto fft(const Tensor<T>& input) {
+        return fft(input, input.dim() - 1);
+    }
+
+    template <std::floating_point R>
+    auto ifft(const Tensor<std::complex<R>>& input) -> Tensor<std::complex<R>> {
+        return ifft(input, input.dim() - 1);
+    }
+
+    // Non-negative frequencies of a real signal: n / 2 + 1 values along dim. An even length is transformed as a
+    // complex signal of half the length, its even and odd samples as real and imaginary parts.
+    template <std::floating_point R>
+    auto rfft(const Tensor<R>& input, SizeType dim) -> Tensor<std::complex<R>> {
+        using C = std::complex<R>;
+        TINYTEN_CHECK(dim >= 0 && dim < input.dim(), "rfft: dim out of bounds");
+        const SizeType n = input.shape(dim);
+        const SizeType bins = n / 2 + 1;
+        IndexType shape = input.shape();
+        shape[dim] = bins;
+        Tensor<C> result(shape);
+        const SizeType is = input.stride(dim);
+        const SizeType os = result.stride(dim);
+        const R* src = input.data();
+        C* dst = result.data();
+
+        if (n % 2 != 0) {
+            const auto plan = fft_plan<R>(n);
+            detail::fft_lanes<R>(input.shape(), input.strides(), result.strides(), dim, n + plan->scratch_size(),
+                                 [&](SizeType in_offset, SizeType out_offset, C* lane) {
+                                     for (SizeType i = 0; i < n; ++i) {
+                                         lane[i] = C(src[in_offset + i * is]);
+                                     }
+                                     plan->forward(lane, lane + n);
+                                     for (SizeType k = 0; k < bins; ++k) {
+                                         dst[out_offset + k * os] = lane[k];
+                                     }
+                                 });
+            return result;
+        }
+
+        const SizeType h = n / 2;
+        const auto plan = fft_plan<R>(h);
+        std::vector<C> w(bins);
+        for (SizeType k = 0; k < bins; ++k) {
+            w[k] = detail::root<R>(k, n);
+        }
+        detail::fft_lanes<R>(
+            input.shape(), input.strides(), result.strides(), dim, h + plan->scratch_size(),
+            [&](SizeType in_offset, SizeType out_offset, C* z) {
+                for (SizeType k = 0; k < h; ++k) {
+                    z[k] = C(src[in_offset + 2 * k * is], src[in_offset + (2 * k + 1) * is]);
+                }
+                plan->forward(z, z + h);
+                // with E and O the transforms of the even and odd samples, Z = E + iO and X[k] = E[k] + w^k O[k]
+                const R half{0.5};
+                for (SizeType k = 0; k < bins; ++k) {
+                    const C zk = z[k % h];
+                    const C zc = std::conj(z[(h - k) % h]);
+                    const C even = (zk + zc) * half;
+                    const C odd = detail::mul_neg_i(zk - zc) * half;
+                    dst[out_offset + k * os] = even + detail::cmul(w[k], odd);
+                }
+            });
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto rfft(const Tensor<R>& input) -> Tensor<std::complex<R>> {
+        return rfft(input, input.dim() - 1);
+    }
+
+    // Inverse of rfft: a real signal of length n from its n / 2 + 1 non-negative frequencies along dim. The
+    // imaginary parts of the zero (and, for even n, the Nyquist) frequency are ignored.
+    template <std::floating_point R>
+    auto irfft(const Tensor<std::complex<R>>& input, SizeType n, SizeType dim) -> Tensor<R> {
+        using C = std::complex<R>;
+        TINYTEN_CHECK(dim >= 0 && dim < input.dim(), "irfft: dim out of bounds");
+        TINYTEN_CHECK(n > 0 && input.shape(dim) == n / 2 + 1, "irfft: input must hold n / 2 + 1 frequencies");
+        IndexType shape = input.shape();
+        shape[dim] = n;
+        Tensor<R> result(shape);
+        const SizeType is = input.stride(dim);
+        const SizeType os = result.stride(dim);
+        const C* src = input.data();
+        R* dst = result.data();
+        const R scale = R{1} / static_cast<R>(n);
+
+        if (n % 2 != 0) {
+            // rebuild the Hermitian spectrum and run a full inverse transform
+            const auto plan = fft_plan<R>(n);
+            detail::fft_lanes<R>(input.shape(), input.strides(), result.strides(), dim, n + plan->scratch_size(),
+                                 [&](SizeType in_offset, SizeType out_offset, C* lane) {
+                                     lane[0] = C(src[in_offset].real());
+                                     for (SizeType k = 1; k <= n / 2; ++k) {
+                                         const C v = src[in_offset + k * is];
+                                         lane[k] = std::conj(v);
+                                         lane[n - k] = v;
+                                     }
+                                     plan->forward(lane, lane + n);
+                                     for (SizeType i = 0; i < n; ++i) {
+                                         dst[out_offset + i * os] = lane[i].real() * scale;
+                                     }
+                                 });
+            return result;
+        }
+
+        const SizeType h = n / 2;
+        const auto plan = fft_plan<R>(h);
+        std::vector<C> w(h);
+        for (SizeType k = 0; k < h; ++k) {
+            w[k] = std::conj(detail::root<R>(k, n));
+        }
+        const R inv_h = R{1} / static_cast<R>(h);
+        detail::fft_lanes<R>(input.shape(), input.strides(), result.strides(), dim, h + plan->scratch_size(),
+                             [&](SizeType in_offset, SizeType out_offset, C* z) {
+                                 // E[k] = (X[k] + conj(X[h - k])) / 2, O[k] = (X[k] - conj(X[h - k])) w^-k / 2;
+                                 // the even and odd samples are the real and imaginary parts of the inverse of
+                                 // E + iO, which is taken as a conjugated forward transform. Only the real parts
+                                 // of X[0] and X[h] are used, so z[0] = conj((X[0] + X[h]) / 2 + i (X[0] - X[h]) / 2).
+                                 const R half{0.5};
+                                 const R x0 = src[in_offset].real();
+                                 const R xh = src[in_offset + h * is].real();
+                                 z[0] = C((x0 + xh) * half, -(x0 - xh) * half);
+                                 for (SizeType k = 1; k < h; ++k) {
+                                     const C xk = src[in_offset + k * is];
+                                     const C xc = std::conj(src[in_offset + (h - k) * is]);
+                                     const C even = (xk + xc) * half;
+                                     const C odd = detail::cmul((xk - xc) * half, w[k]);
+                                     z[k] = std::conj(even + C(-odd.imag(), odd.real()));
+                                 }
+                                 plan->forward(z, z + h);
+                                 for (SizeType k = 0; k < h; ++k) {
+                                     dst[out_offset + 2 * k * os] = z[k].real() * inv_h;
+                                     dst[out_offset + (2 * k + 1) * os] = -z[k].imag() * inv_h;
+                                 }
+                             });
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto irfft(const Tensor<std::complex<R>>& input, SizeType n) -> Tensor<R> {
+        return irfft(input, n, input.dim() - 1);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // N-D transforms, one dim after the other; without dims they cover every dim
+    ////////////////////////////////////////////////////////////////////
+    namespace detail {
+        inline auto all_dims(SizeType rank) -> IndexType {
+            IndexType dims(rank);
+            std::iota(dims.begin(), dims.end(), SizeType{0});
+            return dims;
+        }
+    }  // namespace detail
+
+    template <std::floating_point R>
+    auto fftn(const Tensor<std::complex<R>>& input, const IndexType& dims) -> Tensor<std::complex<R>> {
+        TINYTEN_CHECK(!dims.empty(), "fftn: no dims given");
+        Tensor<std::complex<R>> result = fft(input, dims[0]);
+        for (size_t i = 1; i < dims.size(); ++i) {
+            result = fft(result, dims[i]);
+        }
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto fftn(const Tensor<std::complex<R>>& input) -> Tensor<std::complex<R>> {
+        return fftn(input, detail::all_dims(input.dim()));
+    }
+
+    template <std::floating_point R>
+    auto ifftn(const Tensor<std::complex<R>>& input, const IndexType& dims) -> Tensor<std::complex<R>> {
+        TINYTEN_CHECK(!dims.empty(), "ifftn: no dims given");
+        Tensor<std::complex<R>> result = ifft(input, dims[0]);
+        for (size_t i = 1; i < dims.size(); ++i) {
+            result = ifft(result, dims[i]);
+        }
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto ifftn(const Tensor<std::complex<R>>& input) -> Tensor<std::complex<R>> {
+        return ifftn(input, detail::all_dims(input.dim()));
+    }
+
+    // rfft along the last of dims, then fft along the others
+    template <std::floating_point R>
+    auto rfftn(const Tensor<R>& input, const IndexType& dims) -> Tensor<std::complex<R>> {
+        TINYTEN_CHECK(!dims.empty(), "rfftn: no dims given");
+        Tensor<std::complex<R>> result = rfft(input, dims.back());
+        for (size_t i = 0; i + 1 < dims.size(); ++i) {
+            result = fft(result, dims[i]);
+        }
+        return result;
+    }
+
+    template <std::floating_point R>
+    auto rfftn(const Tensor<R>& input) -> Tensor<std::complex<R>> {
+        return rfftn(input, detail::all_dims(input.dim()));
+    }
+
+    // Inverse of rfftn; n is the real length along the last of dims
+    template <std::floating_point R>
+    auto irfftn(const Tensor<std::complex<R>>& input, SizeType n, const IndexType& dims) -> Tensor<R> {
+        TINYTEN_CHECK(!dims.empty(), "irfftn: no dims given");
+        if (dims.size() == 1) {
+            return irfft(input, n, dims.back());
+        }
+        Tensor<std::complex<R>> spectrum = ifft(input, dims[0]);
+        for (size_t i = 1; i + 1 < dims.size(); ++i) {
+            spectrum = ifft(spectrum, dims[i]);
+        }
+        return irfft(spectrum, n, dims.back());
+    }
+
+    template <std::floating_point R>
+    auto irfftn(const Tensor<std::complex<R>>& input, SizeType n) -> Tensor<R> {
+        return irfftn(input, n, detail::all_dims(input.dim()));
+    }
+};  // namespace tt::inline v1
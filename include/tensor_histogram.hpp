@@ -0,0 +1,484 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_sort.hpp"
+#include "tensor_views.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // Inputs are split across threads only when every thread gets at least this many elements
+        constexpr SizeType HISTOGRAM_CHUNK_MIN = SizeType{1} << 15;
+        // searchsorted runs this many searches in lockstep
+        constexpr SizeType SEARCH_LANES = 8;
+
+        inline auto histogram_chunks(SizeType n) -> SizeType {
+            return std::clamp<SizeType>(n / HISTOGRAM_CHUNK_MIN, 1, thread_pool().size());
+        }
+
+        // Smallest and largest of p[0, n), ignoring NaNs; {max, lowest} when there are none
+        template <typename T>
+        auto value_range(const T* p, SizeType n) -> std::pair<T, T> {
+            const SizeType chunks = histogram_chunks(n);
+            std::vector<std::pair<T, T>> ranges(static_cast<size_t>(chunks),
+                                                {std::numeric_limits<T>::max(), std::numeric_limits<T>::lowest()});
+            thread_pool().run(chunks, [&](int64_t c) {
+                auto [lo, hi] = chunk_range(n, chunks, c);
+                T low = std::numeric_limits<T>::max();
+                T high = std::numeric_limits<T>::lowest();
+                for (SizeType i = lo; i < hi; ++i) {
+                    low = p[i] < low ? p[i] : low;
+                    high = p[i] > high ? p[i] : high;
+                }
+                ranges[static_cast<size_t>(c)] = {low, high};
+            });
+            auto result = ranges.front();
+            for (const auto& [low, high] : ranges) {
+                result = {std::min(result.first, low), std::max(result.second, high)};
+            }
+            return result;
+        }
+
+        // out[bin(i)] += weight(i) for every i in [0, n) whose bin is in [0, bins). Each chunk of the input counts
+        // into a private histogram when those take no more slots than the input has elements, and the private
+        // histograms are summed bin-parallel at the end; with more bins than that, chunks add straight into out
+        // with atomic adds. Floating point weights may then round differently than a serial loop.
+        template <typename W, typename Bin, typename Weight>
+        void accumulate_bins(SizeType n, SizeType bins, W* out, Bin bin, Weight weight) {
+            const SizeType chunks = histogram_chunks(n);
+            if (chunks == 1) {
+                for (SizeType i = 0; i < n; ++i) {
+                    const SizeType b = bin(i);
+                    if (b >= 0 && b < bins) {
+                        out[b] += weight(i);
+                    }
+                }
+                return;
+            }
+            if (bins <= n / chunks) {
+                std::vector<W> counts(static_cast<size_t>(chunks * bins), W{});
+                thread_pool().run(chunks, [&](int64_t c) {
+                    auto [lo, hi] = chunk_range(n, chunks, c);
+                    W* local = counts.data() + c * bins;
+                    for (SizeType i = lo; i < hi; ++i) {
+                        const SizeType b = bin(i);
+                        if (b >= 0 && b < bins) {
+                            local[b] += weight(i);
+                        }
+                    }
+                });
+                parallel_for(0, bins, HISTOGRAM_CHUNK_MIN / chunks, [&](int64_t lo, int64_t hi) {
+                    for (SizeType c = 0; c < chunks; ++c) {
+                        const W* local = counts.data() + c * bins;
+                        for (SizeType b = lo; b < hi; ++b) {
+                            out[b] += local[b];
+                        }
+                    }
+                });
+                return;
+            }
+            thread_pool().run(chunks, [&](int64_t c) {
+                auto [lo, hi] = chunk_range(n, chunks, c);
+                for (SizeType i = lo; i < hi; ++i) {
+                    const SizeType b = bin(i);
+                    if (b >= 0 && b < bins) {
+                        std::atomic_ref<W>(out[b]).fetch_add(weight(i), std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+
+        // Number of elements of seq[0, m) less than v (not greater than v with Right set). Every v takes the same
+        // halving steps, each a conditional move rather than a branch.
+        template <bool Right, typename T>
+        auto bound_index(const T* seq, SizeType m, const T& v) -> SizeType {
+            if (m == 0) {
+                return 0;
+            }
+            const T* base = seq;
+            for (SizeType len = m; len > 1;) {
+                const SizeType half = len / 2;
+                base = (Right ? !(v < base[half]) : base[half] < v) ? base + half : base;
+                len -= half;
+            }
+            return (base - seq) + (Right ? !(v < *base) : *base < v);
+        }
+
+        // bound_index of every value. Since all searches over one sequence take the same number of steps, blocks of
+        // SEARCH_LANES values are searched in lockstep, so their loads are in flight together instead of one
+        // dependent load chain after another.
+        template <bool Right, typename T>
+        void bound_indices(const T* seq, SizeType m, const T* values, SizeType n, int64_t* out) {
+            SizeType i = 0;
+            if (m > 0) {
+                for (; i + SEARCH_LANES <= n; i += SEARCH_LANES) {
+                    std::array<const T*, SEARCH_LANES> base;
+                    base.fill(seq);
+                    const T* v = values + i;
+                    for (SizeType len = m; len > 1;) {
+                        const SizeType half = len / 2;
+                        for (SizeType l = 0; l < SEARCH_LANES; ++l) {
+                            const bool step = Right ? !(v[l] < base[l][half]) : base[l][half] < v[l];
+                            base[l] = step ? base[l] + half : base[l];
+                        }
+                        len -= half;
+                    }
+                    for (SizeType l = 0; l < SEARCH_LANES; ++l) {
+                        out[i + l] = (base[l] - seq) + (Right ? !(v[l] < *base[l]) : *base[l] < v[l]);
+                    }
+                }
+            }
+            for (; i < n; ++i) {
+                out[i] = bound_index<Right>(seq, m, values[i]);
+            }
+        }
+
+        // Spreads every key bit over the whole hash (the murmur3 finalizer)
+        constexpr auto mix_hash(uint64_t h) -> uint64_t {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        // Open-addressing table from keys to a nonzero value, probed linearly and kept at most half full. A slot is
+        // empty while its value is 0.
+        template <typename K>
+        class CountTable {
+          public:
+            struct Slot {
+                K key{};
+                int64_t value = 0;
+            };
+
+            CountTable() : slots_(16), mask_(15) {}
+
+            // Adds value to the key's slot, inserting it if needed
+            void add(K key, uint64_t hash, int64_t value) {
+                if (2 * (this->size_ + 1) > this->slots_.size()) {
+                    this->grow();
+                }
+                for (size_t i = hash & this->mask_;; i = (i + 1) & this->mask_) {
+                    Slot& slot = this->slots_[i];
+                    if (slot.value == 0) {
+                        slot = {key, value};
+                        ++this->size_;
+                        return;
+                    }
+                    if (slot.key == key) {
+                        slot.value += value;
+                        return;
+                    }
+                }
+            }
+
+            // The slot of a key that is in the table
+            [[nodiscard]] auto find(K key, uint64_t hash) -> Slot& {
+                for (size_t i = hash & this->mask_;; i = (i + 1) & this->mask_) {
+                    Slot& slot = this->slots_[i];
+                    if (slot.key == key && slot.value != 0) {
+                        return slot;
+                    }
+                }
+            }
+
+            [[nodiscard]] auto size() const noexcept -> size_t {
+                return this->size_;
+            }
+
+            [[nodiscard]] auto slots() const noexcept -> const std::vector<Slot>& {
+                return this->slots_;
+            }
+
+          private:
+            std::vector<Slot> slots_;
+            size_t mask_;
+            size_t size_ = 0;
+
+            void grow() {
+                std::vector<Slot> old(this->slots_.size() * 2);
+                old.swap(this->slots_);
+                this->mask_ = this->slots_.size() - 1;
+                for (const Slot& slot : old) {
+                    if (slot.value != 0) {
+                        size_t i = mix_hash(slot.key) & this->mask_;
+                        while (this->slots_[i].value != 0) {
+                            i = (i + 1) & this->mask_;
+                        }
+                        this->slots_[i] = slot;
+                    }
+                }
+            }
+        };
+
+        // Hash key of a value: equal values, including 0.0 and -0.0, get equal keys, every NaN gets the same key, and
+        // keys order like sort orders values
+        template <RadixSortable T>
+        constexpr auto unique_key(T v) -> RadixKey<T> {
+            return sort_key(v);
+        }
+    }  // namespace detail
+
+    // Occurrences of every value in input: element v of the result counts the elements equal to v. The result
+    // has max(input) + 1 elements, or minlength if that is more. Values must not be negative.
+    template <std::integral T>
+    auto bincount(const Tensor<T>& input, SizeType minlength = 0) -> Tensor<int64_t> {
+        const Tensor<T> flat = detail::packed(input);
+        const T* p = flat.data();
+        const SizeType n = flat.numel();
+        const auto [lo, hi] = detail::value_range(p, n);
+        TINYTEN_CHECK(n == 0 || lo >= T{}, "bincount: input must not be negative");
+        const SizeType bins = std::max(minlength, n == 0 ? 0 : static_cast<SizeType>(hi) + 1);
+        Tensor<int64_t> result({bins}, 0);
+        detail::accumulate_bins(
+            n, bins, result.data(), [p](SizeType i) { return static_cast<SizeType>(p[i]); },
+            [](SizeType) { return int64_t{1}; });
+        return result;
+    }
+
+    // Sum of the weights of the elements equal to every value, weights having the shape of input
+    template <std::integral T, typename W>
+        requires std::is_arithmetic_v<W> && (!std::is_same_v<W, bool>)
+    auto bincount(const Tensor<T>& input, const Tensor<W>& weights, SizeType minlength = 0) -> Tensor<W> {
+        TINYTEN_CHECK(weights.shape() == input.shape(), "bincount: weights must have the shape of input");
+        const Tensor<T> flat = detail::packed(input);
+        const Tensor<W> flat_weights = detail::packed(weights);
+        const T* p = flat.data();
+        const W* w = flat_weights.data();
+        const SizeType n = flat.numel();
+        const auto [lo, hi] = detail::value_range(p, n);
+        TINYTEN_CHECK(n == 0 || lo >= T{}, "bincount: input must not be negative");
+        const SizeType bins = std::max(minlength, n == 0 ? 0 : static_cast<SizeType>(hi) + 1);
+        Tensor<W> result({bins}, W{});
+        detail::accumulate_bins(
+            n, bins, result.data(), [p](SizeType i) { return static_cast<SizeType>(p[i]); },
+            [w](SizeType i) { return w[i]; });
+        return result;
+    }
+
+    // Counts of input in `bins` equal-width bins over [min, max]: bin i holds [min + i * w, min + (i + 1) * w) and
+    // the last bin also holds max. Elements outside the range and NaNs are not counted. With min == max the range
+    // is that of the data, widened by 1 on both sides if all elements are equal.
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    auto histogram(const Tensor<T>& input, SizeType bins, double min = 0, double max = 0) -> Tensor<int64_t> {
+        TINYTEN_CHECK(bins > 0 && min <= max, "histogram: invalid bins or range");
+        const Tensor<T> flat = detail::packed(input);
+        const T* p = flat.data();
+        const SizeType n = flat.numel();
+        if (min == max && n > 0) {
+            const auto [lo, hi] = detail::value_range(p, n);
+            if (lo <= hi) {
+                min = static_cast<double>(lo);
+                max = static_cast<double>(hi);
+            }
+        }
+        if (min == max) {
+            min -= 1;
+            max += 1;
+        }
+        const double scale = static_cast<double>(bins) / (max - min);
+        Tensor<int64_t> result({bins}, 0);
+        detail::accumulate_bins(
+            n, bins, result.data(),
+            [=](SizeType i) -> SizeType {
+                const auto x = static_cast<double>(p[i]);
+                if (!(x >= min && x <= max)) {
+                    return -1;
+                }
+                return std::min(static_cast<SizeType>((x - min) * scale), bins - 1);
+            },
+            [](SizeType) { return int64_t{1}; });
+        return result;
+    }
+
+    // Counts of input in the bins between consecutive edges, which must be ascending: bin i holds
+    // [edges[i], edges[i + 1]) and the last bin also holds its upper edge. Elements outside the edges are not
+    // counted.
+    template <typename T>
+    auto histogram(const Tensor<T>& input, const Tensor<T>& edges) -> Tensor<int64_t> {
+        TINYTEN_CHECK(edges.dim() == 1 && edges.numel() >= 2, "histogram: edges must be 1-D with at least 2 elements");
+        const Tensor<T> flat = detail::packed(input);
+        const Tensor<T> bounds = detail::packed(edges);
+        const T* p = flat.data();
+        const T* e = bounds.data();
+        const SizeType m = bounds.numel();
+        TINYTEN_CHECK(std::is_sorted(e, e + m), "histogram: edges must be ascending");
+        const SizeType bins = m - 1;
+        Tensor<int64_t> result({bins}, 0);
+        detail::accumulate_bins(
+            flat.numel(), bins, result.data(),
+            [=](SizeType i) -> SizeType {
+                if (p[i] == e[bins]) {
+                    return bins - 1;
+                }
+                return detail::bound_index<true>(e, m, p[i]) - 1;
+            },
+            [](SizeType) { return int64_t{1}; });
+        return result;
+    }
+
+    // Where every element of values would be inserted into the ascending 1-D tensor sorted to keep it sorted: the
+    // number of elements of sorted less than the value, or not greater than it with right set. The result has the
+    // shape of values.
+    template <typename T>
+    auto searchsorted(const Tensor<T>& sorted, const Tensor<T>& values, bool right = false) -> Tensor<int64_t> {
+        TINYTEN_CHECK(sorted.dim() == 1, "searchsorted: sorted must be 1-D");
+        const Tensor<T> seq = detail::packed(sorted);
+        const Tensor<T> flat = detail::packed(values);
+        const T* s = seq.data();
+        const T* v = flat.data();
+        const SizeType m = seq.numel();
+        Tensor<int64_t> result(values.shape());
+        int64_t* out = result.data();
+        parallel_for(0, flat.numel(), detail::HISTOGRAM_CHUNK_MIN, [&](int64_t lo, int64_t hi) {
+            if (right) {
+                detail::bound_indices<true>(s, m, v + lo, hi - lo, out + lo);
+            } else {
+                detail::bound_indices<false>(s, m, v + lo, hi - lo, out + lo);
+            }
+        });
+        return result;
+    }
+
+    template <typename T>
+    struct UniqueResult {
+        Tensor<T> values;         // the distinct elements, ascending
+        Tensor<int64_t> inverse;  // position in values of every input element, shaped like the input
+        Tensor<int64_t> counts;   // occurrences of every value
+    };
+
+    // Distinct elements of input with their counts and, unless return_inverse is false, the inverse indices, so
+    // that values[inverse] rebuilds the input. Equal elements are found with hash tables rather than by sorting
+    // the input: every chunk of the input counts into private open-addressing tables, one per hash partition, the
+    // partitions are merged and sorted in parallel, and only the distinct values are merge-sorted into order. 0.0
+    // and -0.0 are one value, and all NaNs are one value sorted after every number, as in sort.
+    template <detail::RadixSortable T>
+    auto unique(const Tensor<T>& input, bool return_inverse = true) -> UniqueResult<T> {
+        using K = detail::RadixKey<T>;
+        using Table = detail::CountTable<K>;
+        const Tensor<T> flat = detail::packed(input);
+        const T* p = flat.data();
+        const SizeType n = flat.numel();
+        const SizeType chunks = detail::histogram_chunks(n);
+        const auto parts = static_cast<SizeType>(std::bit_ceil(static_cast<uint64_t>(chunks)));
+        const int part_shift = 64 - std::countr_zero(static_cast<uint64_t>(parts));
+        auto part_of = [part_shift](uint64_t hash) -> SizeType {
+            return part_shift == 64 ? 0 : static_cast<SizeType>(hash >> part_shift);
+        };
+
+        // count every chunk into its own tables, one per partition; runs of equal elements are added at once
+        std::vector<Table> tables(static_cast<size_t>(chunks * parts));
+        thread_pool().run(chunks, [&](int64_t c) {
+            auto [lo, hi] = chunk_range(n, chunks, c);
+            Table* local = tables.data() + c * parts;
+            auto flush = [&](K key, int64_t run) {
+                const uint64_t hash = detail::mix_hash(key);
+                local[part_of(hash)].add(key, hash, run);
+            };
+            if (lo == hi) {
+                return;
+            }
+            K key = detail::unique_key(p[lo]);
+            int64_t run = 1;
+            for (SizeType i = lo + 1; i < hi; ++i) {
+                const K next = detail::unique_key(p[i]);
+                if (next == key) {
+                    ++run;
+                } else {
+                    flush(key, run);
+                    key = next;
+                    run = 1;
+                }
+            }
+            flush(key, run);
+        });
+
+        // merge the chunks' tables partition by partition, and sort each partition's distinct keys
+        std::vector<std::pair<K, int64_t>> entries;
+        std::vector<SizeType> offsets(static_cast<size_t>(parts + 1), 0);
+        thread_pool().run(parts, [&](int64_t q) {
+            Table& merged = tables[q];
+            for (SizeType c = 1; c < chunks; ++c) {
+                Table& local = tables[c * parts + q];
+                for (const auto& slot : local.slots()) {
+                    if (slot.value != 0) {
+                        merged.add(slot.key, detail::mix_hash(slot.key), slot.value);
+                    }
+                }
+                local = Table();
+            }
+            offsets[q + 1] = static_cast<SizeType>(merged.size());
+        });
+        for (SizeType q = 0; q < parts; ++q) {
+            offsets[q + 1] += offsets[q];
+        }
+        entries.resize(static_cast<size_t>(offsets[parts]));
+        thread_pool().run(parts, [&](int64_t q) {
+            auto out = entries.begin() + offsets[q];
+            for (const auto& slot : tables[q].slots()) {
+                if (slot.value != 0) {
+                    *out++ = {slot.key, slot.value};
+                }
+            }
+            std::sort(entries.begin() + offsets[q], out);
+        });
+        for (SizeType width = 1; width < parts; width *= 2) {
+            thread_pool().run((parts + 2 * width - 1) / (2 * width), [&](int64_t pair) {
+                const SizeType first = pair * 2 * width;
+                const SizeType middle = std::min(first + width, parts);
+                const SizeType last = std::min(first + 2 * width, parts);
+                std::inplace_merge(entries.begin() + offsets[first], entries.begin() + offsets[middle],
+                                   entries.begin() + offsets[last]);
+            });
+        }
+
+        const auto distinct = static_cast<SizeType>(entries.size());
+        UniqueResult<T> result{Tensor<T>({distinct}), Tensor<int64_t>(), Tensor<int64_t>({distinct})};
+        T* values = result.values.data();
+        int64_t* counts = result.counts.data();
+        parallel_for(0, distinct, detail::HISTOGRAM_CHUNK_MIN, [&](int64_t lo, int64_t hi) {
+            for (SizeType r = lo; r < hi; ++r) {
+                values[r] = detail::radix_value<T>(entries[r].first);
+                counts[r] = entries[r].second;
+            }
+        });
+        if (!return_inverse) {
+            return result;
+        }
+
+        // the merged tables now map every key to its rank + 1, and are only read while the inverse is looked up
+        parallel_for(0, distinct, detail::HISTOGRAM_CHUNK_MIN, [&](int64_t lo, int64_t hi) {
+            for (SizeType r = lo; r < hi; ++r) {
+                const K key = entries[r].first;
+                const uint64_t hash = detail::mix_hash(key);
+                tables[part_of(hash)].find(key, hash).value = r + 1;
+            }
+        });
+        result.inverse = Tensor<int64_t>(input.shape());
+        int64_t* inverse = result.inverse.data();
+        parallel_for(0, n, detail::HISTOGRAM_CHUNK_MIN, [&](int64_t lo, int64_t hi) {
+            for (SizeType i = lo; i < hi; ++i) {
+                const K key = detail::unique_key(p[i]);
+                const uint64_t hash = detail::mix_hash(key);
+                inverse[i] = tables[part_of(hash)].find(key, hash).value - 1;
+            }
+        });
+        return result;
+    }
+};  // namespace tt::inline v1
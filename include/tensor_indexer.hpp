@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "types.hpp"
+#include "utils/Check.hpp"
 #include "utils/ShapeIterator.hpp"
 #include "utils/TensorIterator.hpp"
 #include "utils/utils.hpp"
@@ -32,9 +35,7 @@ namespace tt::inline v1 {
         }
 
         [[nodiscard]] constexpr auto shape(SizeType i) const -> SizeType {
-            if (i >= this->dim()) {
-                throw std::runtime_error("shape: index out of bounds");
-            }
+            TINYTEN_CHECK(i >= 0 && i < this->dim(), "shape: index out of bounds");
             return this->shape_[i];
         }
 
@@ -54,49 +55,74 @@ namespace tt::inline v1 {
             return this->strides_ == this->canon_strides_;
         }
 
-        constexpr auto begin(std::vector<T>& data) -> StridedIterImpl<T> {
-            return {&data[0], 0, this->strides_, this->canon_strides_};
+        // Whether the elements fill numel consecutive slots, each exactly once: the strides are those of a contiguous
+        // tensor with its dims permuted. Flipped (negative), broadcast (zero) and overlapping strides are not dense.
+        [[nodiscard]] auto _is_dense() const -> bool {
+            std::vector<std::pair<SizeType, SizeType>> dims;
+            for (SizeType i = 0; i < this->dim(); ++i) {
+                if (this->shape_[i] != 1) {
+                    dims.emplace_back(this->strides_[i], this->shape_[i]);
+                }
+            }
+            std::sort(dims.begin(), dims.end());
+            SizeType expected = 1;
+            for (auto [stride, size] : dims) {
+                if (stride != expected) {
+                    return false;
+                }
+                expected *= size;
+            }
+            return true;
+        }
+
+        constexpr auto begin(T* data) -> StridedIterImpl<T> {
+            return {data, 0, this->strides_, this->canon_strides_};
         }
 
-        [[nodiscard]] constexpr auto begin(const std::vector<T>& data) const -> StridedIterImpl<const T> {
-            return {&data[0], 0, this->strides_, this->canon_strides_};
+        [[nodiscard]] constexpr auto begin(const T* data) const -> StridedIterImpl<const T> {
+            return {data, 0, this->strides_, this->canon_strides_};
         }
 
-        constexpr auto end(std::vector<T>& data) -> StridedIterImpl<T> {
-            return {&data[0], this->numel(), this->strides_, this->canon_strides_};
+        constexpr auto end(T* data) -> StridedIterImpl<T> {
+            return {data, this->numel(), this->strides_, this->canon_strides_};
         }
 
-        [[nodiscard]] constexpr auto end(const std::vector<T>& data) const -> StridedIterImpl<const T> {
-            return {&data[0], this->numel(), this->strides_, this->canon_strides_};
+        [[nodiscard]] constexpr auto end(const T* data) const -> StridedIterImpl<const T> {
+            return {data, this->numel(), this->strides_, this->canon_strides_};
         }
 
-        constexpr auto stlbegin(std::vector<T>& data) {
+        // The STL iterators address elements [offset, offset + numel) of the backing vector
+        template <typename Container>
+        constexpr auto stlbegin(Container& data, SizeType offset) {
             if (this->_is_contiguous()) {
-                return data.begin();
+                return data.begin() + offset;
             } else {
                 throw std::runtime_error("begin: tensor is not contiguous");
             }
         }
 
-        constexpr auto stlbegin(std::vector<T>& data) const {
+        template <typename Container>
+        constexpr auto stlbegin(const Container& data, SizeType offset) const {
             if (this->_is_contiguous()) {
-                return data.cbegin();
+                return data.cbegin() + offset;
             } else {
                 throw std::runtime_error("begin: tensor is not contiguous");
             }
         }
 
-        constexpr auto stlend(std::vector<T>& data) -> typename std::vector<T>::iterator {
+        template <typename Container>
+        constexpr auto stlend(Container& data, SizeType offset) -> typename Container::iterator {
             if (this->_is_contiguous()) {
-                return data.end();
+                return data.begin() + offset + this->numel();
             } else {
                 throw std::runtime_error("end: tensor is not contiguous");
             }
         }
 
-        constexpr auto stlend(std::vector<T>& data) const -> typename std::vector<T>::const_iterator {
+        template <typename Container>
+        constexpr auto stlend(const Container& data, SizeType offset) const -> typename Container::const_iterator {
             if (this->_is_contiguous()) {
-                return data.cend();
+                return data.cbegin() + offset + this->numel();
             } else {
                 throw std::runtime_error("end: tensor is not contiguous");
             }
@@ -106,8 +132,8 @@ namespace tt::inline v1 {
             return ShapeIter(this->numel(), this->canon_strides_);
         }
 
-        auto strided_iter(std::vector<T>& data) -> StridedIter<T> {
-            return StridedIter<T>(&data[0], this->numel(), this->strides_, this->canon_strides_);
+        auto strided_iter(T* data) -> StridedIter<T> {
+            return StridedIter<T>(data, this->numel(), this->strides_, this->canon_strides_);
         }
     };
 };  // namespace tt::inline v1
\ No newline at end of file
@@ -1,34 +1,47 @@
 #pragma once
 
+#include <array>
+
 #include "tensor.hpp"
+#include "utils/Check.hpp"
 
 namespace tt::inline v1 {
     template <typename T>
     constexpr auto Tensor<T>::flat(SizeType i) -> T& {
-        if (i >= this->numel()) {
-            throw std::runtime_error("flat: index out of bounds");
-        }
-        return this->data_[tt::ravel_unravel(i, this->indexer_.strides(), this->indexer_.canon_strides_)];
+        TINYTEN_CHECK_INDEX(i >= 0 && i < this->numel(), "flat: index out of bounds");
+        return this->data()[tt::ravel_unravel(i, this->indexer_.strides(), this->indexer_.canon_strides_)];
     }
 
     template <typename T>
     constexpr auto Tensor<T>::flat(SizeType i) const -> const T& {
-        if (i >= this->numel()) {
-            throw std::runtime_error("flat: index out of bounds");
+        TINYTEN_CHECK_INDEX(i >= 0 && i < this->numel(), "flat: index out of bounds");
+        return this->data()[tt::ravel_unravel(i, this->indexer_.strides(), this->indexer_.canon_strides_)];
+    }
+
+    // Offset from data() of the element at `indices`. Their number and range are only validated when element
+    // checks are compiled in (see utils/Check.hpp); otherwise this is a plain dot product with the strides.
+    template <typename T>
+    constexpr auto Tensor<T>::_offset_of(const SizeType* indices, SizeType n) const -> SizeType {
+        TINYTEN_CHECK_INDEX(n == this->dim(), "operator(): wrong number of indices");
+        const SizeType* shape = this->indexer_.shape_.data();
+        const SizeType* strides = this->indexer_.strides_.data();
+        SizeType offset = 0;
+        for (SizeType d = 0; d < n; ++d) {
+            TINYTEN_CHECK_INDEX(indices[d] >= 0 && indices[d] < shape[d], "operator(): index out of bounds");
+            offset += indices[d] * strides[d];
         }
-        return this->data_[tt::ravel_unravel(i, this->indexer_.strides(), this->indexer_.canon_strides_)];
+        return offset;
     }
 
     // Indexing with vector
     template <typename T>
     constexpr auto Tensor<T>::operator()(const IndexType& indices) -> T& {
-        return this->data_[tt::ravel_index(indices, this->indexer_.strides())];
+        return this->data()[this->_offset_of(indices.data(), static_cast<SizeType>(indices.size()))];
     }
 
     template <typename T>
     constexpr auto Tensor<T>::operator()(const IndexType& indices) const -> const T& {
-        assert(indices.size() == this->dim());
-        return this->data_[tt::ravel_index(indices, this->indexer_.strides())];
+        return this->data()[this->_offset_of(indices.data(), static_cast<SizeType>(indices.size()))];
     }
 
     template <typename T>
@@ -44,15 +57,15 @@ namespace tt::inline v1 {
     template <typename T>
     template <std::convertible_to<SizeType>... I>
     constexpr auto Tensor<T>::operator()(I... i) -> ValueType& {
-        IndexType indices{static_cast<SizeType>(i)...};
-        return this->data_[tt::ravel_index(indices, this->indexer_.strides())];
+        const std::array<SizeType, sizeof...(I)> indices{static_cast<SizeType>(i)...};
+        return this->data()[this->_offset_of(indices.data(), sizeof...(I))];
     }
 
     template <typename T>
     template <std::convertible_to<SizeType>... I>
     constexpr auto Tensor<T>::operator()(I... i) const -> const ValueType& {
-        IndexType indices{static_cast<SizeType>(i)...};
-        return this->data_[tt::ravel_index(indices, this->indexer_.strides())];
+        const std::array<SizeType, sizeof...(I)> indices{static_cast<SizeType>(i)...};
+        return this->data()[this->_offset_of(indices.data(), sizeof...(I))];
     }
 
     template <typename T>
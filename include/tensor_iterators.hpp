@@ -5,28 +5,28 @@
 namespace tt::inline v1 {
     template <typename T>
     constexpr auto Tensor<T>::begin() -> StridedIterImpl<T> {
-        return this->indexer_.begin(this->data_);
+        return this->indexer_.begin(this->data());
     }
 
     template <typename T>
     constexpr auto Tensor<T>::begin() const -> StridedIterImpl<const T> {
-        return this->indexer_.begin(this->data_);
+        return this->indexer_.begin(this->data());
     }
 
     template <typename T>
     constexpr auto Tensor<T>::end() -> StridedIterImpl<T> {
-        return this->indexer_.end(this->data_);
+        return this->indexer_.end(this->data());
     }
 
     template <typename T>
     constexpr auto Tensor<T>::end() const -> StridedIterImpl<const T> {
-        return this->indexer_.end(this->data_);
+        return this->indexer_.end(this->data());
     }
 
     template <typename T>
     constexpr auto Tensor<T>::stlbegin() {
         if (this->_is_contiguous()) {
-            return this->indexer_.stlbegin(this->data_);
+            return this->indexer_.stlbegin(*this->data_, this->offset_);
         } else {
             throw std::runtime_error("begin: tensor is not contiguous");
         }
@@ -35,7 +35,7 @@ namespace tt::inline v1 {
     template <typename T>
     constexpr auto Tensor<T>::stlbegin() const {
         if (this->_is_contiguous()) {
-            return this->indexer_.stlbegin(this->data_);
+            return this->indexer_.stlbegin(*this->data_, this->offset_);
         } else {
             throw std::runtime_error("begin: tensor is not contiguous");
         }
@@ -44,7 +44,7 @@ namespace tt::inline v1 {
     template <typename T>
     constexpr auto Tensor<T>::stlend() -> typename Tensor::ContainerType::iterator {
         if (this->_is_contiguous()) {
-            return this->indexer_.stlend(this->data_);
+            return this->indexer_.stlend(*this->data_, this->offset_);
         } else {
             throw std::runtime_error("end: tensor is not contiguous");
         }
@@ -53,7 +53,7 @@ namespace tt::inline v1 {
     template <typename T>
     constexpr auto Tensor<T>::stlend() const -> typename Tensor::ContainerType::const_iterator {
         if (this->_is_contiguous()) {
-            return this->indexer_.stlend(this->data_);
+            return this->indexer_.stlend(*this->data_, this->offset_);
         } else {
             throw std::runtime_error("end: tensor is not contiguous");
         }
@@ -66,6 +66,6 @@ namespace tt::inline v1 {
 
     template <typename T>
     auto Tensor<T>::strided_iter() -> StridedIter<T> {
-        return this->indexer_.strided_iter(this->data_);
+        return this->indexer_.strided_iter(this->data());
     }
 };  // namespace tt::inline v1
\ No newline at end of file
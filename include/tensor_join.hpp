@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "tensor.hpp"
+#include "tensor_views.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // Elements copied per task when a copy is split across threads
+        constexpr SizeType COPY_GRAIN = SizeType{1} << 15;
+
+        // Copies src into dst (same shape, any strides). The trailing dimensions laid out contiguously in both are
+        // merged into one run that is copied in bulk; the runs are spread over the thread pool.
+        template <typename T>
+        void copy_into(const Tensor<T>& src, Tensor<T>& dst) {
+            const SizeType numel = dst.numel();
+            if (numel == 0) {
+                return;
+            }
+            const IndexType& shape = dst.shape();
+            const IndexType canon = tt::calc_strides(shape);
+            auto k = static_cast<SizeType>(shape.size());
+            while (k > 0) {
+                const SizeType j = k - 1;
+                if (shape[j] != 1 && (src.stride(j) != canon[j] || dst.stride(j) != canon[j])) {
+                    break;
+                }
+                --k;
+            }
+            const SizeType run = k == 0 ? numel : canon[k - 1];
+            const SizeType outer = numel / run;
+
+            const T* s = src.data();
+            T* d = dst.data();
+            tt::parallel_for(0, outer, std::max<SizeType>(1, COPY_GRAIN / run), [&](SizeType lo, SizeType hi) {
+                for (SizeType o = lo; o < hi; ++o) {
+                    SizeType rem = o;
+                    SizeType so = 0;
+                    SizeType dof = 0;
+                    for (SizeType j = k - 1; j >= 0; --j) {
+                        const SizeType idx = rem % shape[j];
+                        rem /= shape[j];
+                        so += idx * src.stride(j);
+                        dof += idx * dst.stride(j);
+                    }
+                    std::copy_n(s + so, run, d + dof);
+                }
+            });
+        }
+
+        template <typename T>
+        auto cat_shape(const std::vector<Tensor<T>>& tensors, SizeType dim) -> IndexType {
+            if (tensors.empty()) {
+                throw std::runtime_error("cat: expected at least one tensor");
+            }
+            IndexType shape = tensors[0].shape();
+            if (dim < 0 || dim >= static_cast<SizeType>(shape.size())) {
+                throw std::runtime_error("cat: dim out of bounds");
+            }
+            shape[dim] = 0;
+            for (const auto& t : tensors) {
+                if (t.dim() != static_cast<SizeType>(shape.size())) {
+                    throw std::runtime_error("cat: Shapes are not the same");
+                }
+                for (SizeType i = 0; i < t.dim(); ++i) {
+                    if (i != dim && t.shape(i) != shape[i]) {
+                        throw std::runtime_error("cat: Shapes are not the same");
+                    }
+                }
+                shape[dim] += t.shape(dim);
+            }
+            return shape;
+        }
+    }  // namespace detail
+
+    // Concatenates along dim into an existing tensor of the right shape, e.g. a batch buffer reused across calls.
+    // out may itself be a view.
+    template <typename T>
+    void cat_into(const std::vector<Tensor<T>>& tensors, SizeType dim, Tensor<T>& out) {
+        if (detail::cat_shape(tensors, dim) != out.shape()) {
+            throw std::runtime_error("cat: output has the wrong shape");
+        }
+        SizeType start = 0;
+        for (const auto& t : tensors) {
+            auto slot = out.narrow(dim, start, t.shape(dim));
+            detail::copy_into(t, slot);
+            start += t.shape(dim);
+        }
+    }
+
+    template <typename T>
+    auto cat(const std::vector<Tensor<T>>& tensors, SizeType dim) -> Tensor<T> {
+        Tensor<T> result(detail::cat_shape(tensors, dim));
+        cat_into(tensors, dim, result);
+        return result;
+    }
+
+    // Joins equally shaped tensors along a new dimension inserted at dim
+    template <typename T>
+    auto stack(const std::vector<Tensor<T>>& tensors, SizeType dim) -> Tensor<T> {
+        if (tensors.empty()) {
+            throw std::runtime_error("stack: expected at least one tensor");
+        }
+        IndexType shape = tensors[0].shape();
+        if (dim < 0 || dim > static_cast<SizeType>(shape.size())) {
+            throw std::runtime_error("stack: dim out of bounds");
+        }
+        for (const auto& t : tensors) {
+            if (t.shape() != tensors[0].shape()) {
+                throw std::runtime_error("stack: Shapes are not the same");
+            }
+        }
+        shape.insert(shape.begin() + dim, static_cast<SizeType>(tensors.size()));
+
+        Tensor<T> result(shape);
+        for (size_t i = 0; i < tensors.size(); ++i) {
+            auto slot = result.select(dim, static_cast<SizeType>(i));
+            detail::copy_into(tensors[i], slot);
+        }
+        return result;
+    }
+
+    // Views of consecutive pieces of split_size along dim; the last one may be shorter
+    template <typename T>
+    auto split(const Tensor<T>& tensor, SizeType split_size, SizeType dim) -> std::vector<Tensor<T>> {
+        if (split_size <= 0) {
+            throw std::runtime_error("split: split_size must be positive");
+        }
+        if (dim < 0 || dim >= tensor.dim()) {
+            throw std::runtime_error("split: dim out of bounds");
+        }
+        std::vector<Tensor<T>> parts;
+        for (SizeType start = 0; start < tensor.shape(dim); start += split_size) {
+            parts.push_back(tensor.narrow(dim, start, std::min(split_size, tensor.shape(dim) - start)));
+        }
+        return parts;
+    }
+
+    // Views with the given sizes along dim, which must add up to the size of that dimension
+    template <typename T>
+    auto split(const Tensor<T>& tensor, const IndexType& sizes, SizeType dim) -> std::vector<Tensor<T>> {
+        if (dim < 0 || dim >= tensor.dim()) {
+            throw std::runtime_error("split: dim out of bounds");
+        }
+        if (std::reduce(sizes.begin(), sizes.end(), SizeType{0}) != tensor.shape(dim)) {
+            throw std::runtime_error("split: sizes do not add up to the size of dim");
+        }
+        std::vector<Tensor<T>> parts;
+        SizeType start = 0;
+        for (auto size : sizes) {
+            parts.push_back(tensor.narrow(dim, start, size));
+            start += size;
+        }
+        return parts;
+    }
+
+    // At most `chunks` views of equal size along dim (the last may be smaller)
+    template <typename T>
+    auto chunk(const Tensor<T>& tensor, SizeType chunks, SizeType dim) -> std::vector<Tensor<T>> {
+        if (chunks <= 0) {
+            throw std::runtime_error("chunk: chunks must be positive");
+        }
+        if (dim < 0 || dim >= tensor.dim()) {
+            throw std::runtime_error("chunk: dim out of bounds");
+        }
+        return split(tensor, std::max<SizeType>(1, (tensor.shape(dim) + chunks - 1) / chunks), dim);
+    }
+
+    // Views of every slice along dim, with dim removed
+    template <typename T>
+    auto unbind(const Tensor<T>& tensor, SizeType dim) -> std::vector<Tensor<T>> {
+        if (dim < 0 || dim >= tensor.dim()) {
+            throw std::runtime_error("unbind: dim out of bounds");
+        }
+        std::vector<Tensor<T>> parts;
+        parts.reserve(tensor.shape(dim));
+        for (SizeType i = 0; i < tensor.shape(dim); ++i) {
+            parts.push_back(tensor.select(dim, i));
+        }
+        return parts;
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "concepts.hpp"
+#include "tensor.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // C (MxN) = A (MxK) * B (KxN), or C += A * B when accumulating. Every operand is addressed through a
+        // (row, column) stride pair, so transposed operands are just swapped strides.
+        template <typename T>
+        void gemm(SizeType M, SizeType N, SizeType K, const T* a, SizeType rsa, SizeType csa, const T* b, SizeType rsb,
+                  SizeType csb, T* c, SizeType rsc, SizeType csc, bool accumulate) {
+            if (csb != 1 || csc != 1) {
+                for (SizeType i = 0; i < M; ++i) {
+                    T* crow = c + i * rsc;
+                    for (SizeType j = 0; j < N; ++j) {
+                        T acc = accumulate ? crow[j * csc] : T{};
+                        for (SizeType k = 0; k < K; ++k) {
+                            acc += a[i * rsa + k * csa] * b[k * rsb + j * csb];
+                        }
+                        crow[j * csc] = acc;
+                    }
+                }
+                return;
+            }
+
+            // Rows of C are split across threads. Within a row block, K and N are tiled so the touched panel of B
+            // stays in cache while every row of the block streams over it with a unit-stride inner loop.
+            constexpr SizeType KC = 256;
+            constexpr SizeType NC = 1024;
+            const SizeType grain = std::max<SizeType>(1, (SizeType{1} << 16) / std::max<SizeType>(N * K, 1));
+            tt::parallel_for(0, M, grain, [&](SizeType lo, SizeType hi) {
+                if (!accumulate) {
+                    for (SizeType i = lo; i < hi; ++i) {
+                        std::fill(c + i * rsc, c + i * rsc + N, T{});
+                    }
+                }
+                for (SizeType kk = 0; kk < K; kk += KC) {
+                    const SizeType kend = std::min(kk + KC, K);
+                    for (SizeType jj = 0; jj < N; jj += NC) {
+                        const SizeType jn = std::min(NC, N - jj);
+                        for (SizeType i = lo; i < hi; ++i) {
+                            T* crow = c + i * rsc + jj;
+                            for (SizeType k = kk; k < kend; ++k) {
+                                const T aik = a[i * rsa + k * csa];
+                                const T* brow = b + k * rsb + jj;
+                                for (SizeType j = 0; j < jn; ++j) {
+                                    crow[j] += aik * brow[j];
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+        }
+
+        // dst (cols x rows) = src (rows x cols)^T, both row-major, in square tiles so reads and writes both stay in
+        // cache
+        template <typename T>
+        void transpose_into(const T* src, SizeType rows, SizeType cols, T* dst) {
+            constexpr SizeType TILE = 32;
+            tt::parallel_for(0, (rows + TILE - 1) / TILE, 1, [&](SizeType lo, SizeType hi) {
+                for (SizeType ii = lo * TILE; ii < std::min(hi * TILE, rows); ii += TILE) {
+                    const SizeType iend = std::min(ii + TILE, rows);
+                    for (SizeType jj = 0; jj < cols; jj += TILE) {
+                        const SizeType jend = std::min(jj + TILE, cols);
+                        for (SizeType i = ii; i < iend; ++i) {
+                            for (SizeType j = jj; j < jend; ++j) {
+                                dst[j * rows + i] = src[i * cols + j];
+                            }
+                        }
+                    }
+                }
+            });
+        }
+    }  // namespace detail
+
+    template <typename T>
+    void matmul_into(const Tensor<T>& a, const Tensor<T>& b, Tensor<T>& out, bool accumulate = false)
+        requires SupportsAdd<T> && SupportsMul<T>
+    {
+        if (a.dim() != 2 || b.dim() != 2) {
+            throw std::runtime_error("matmul: only 2-D tensors are supported");
+        }
+        TINYTEN_CHECK(a.shape(1) == b.shape(0), "matmul: inner dimensions do not match");
+        TINYTEN_CHECK(out.dim() == 2 && out.shape(0) == a.shape(0) && out.shape(1) == b.shape(1),
+                      "matmul: output has the wrong shape");
+        detail::gemm(a.shape(0), b.shape(1), a.shape(1), a.data(), a.stride(0), a.stride(1), b.data(), b.stride(0),
+                     b.stride(1), out.data(), out.stride(0), out.stride(1), accumulate);
+    }
+
+    template <typename T>
+    auto matmul(const Tensor<T>& a, const Tensor<T>& b) -> Tensor<T> requires SupportsAdd<T> && SupportsMul<T> {
+        if (a.dim() != 2 || b.dim() != 2) {
+            throw std::runtime_error("matmul: only 2-D tensors are supported");
+        }
+        Tensor<T> result({a.shape(0), b.shape(1)});
+        matmul_into(a, b, result);
+        return result;
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "operators.hpp"
+#include "tensor.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+// Comparisons, masks and conditional selection.
+//
+// Comparison operators produce a Mask, a Tensor<uint8_t> holding 0 or 1 per element (std::vector<bool> has no
+// contiguous storage to index into). BitMask packs the same information into one bit per element, 8x smaller, and
+// is built straight from a predicate 64 elements at a time.
+namespace tt::inline v1 {
+    using Mask = Tensor<uint8_t>;
+
+    namespace detail {
+        // Elements per parallel_for chunk of the mask kernels
+        constexpr SizeType MASK_GRAIN = SizeType{1} << 15;
+
+        template <typename R, typename A, typename B, typename Op>
+        auto compare_promoted(const Tensor<A>& a, const Tensor<B>& b, Op op) -> Mask {
+            TINYTEN_CHECK(a.shape() == b.shape(), "Shapes are not the same");
+            Mask result(a.shape());
+            uint8_t* out = result.data();
+            if (a._is_contiguous() && b._is_contiguous()) {
+                const A* pa = a.data();
+                const B* pb = b.data();
+                tt::parallel_for(0, result.numel(), MASK_GRAIN, [&](SizeType lo, SizeType hi) {
+                    for (SizeType i = lo; i < hi; ++i) {
+                        out[i] = static_cast<uint8_t>(op(static_cast<R>(pa[i]), static_cast<R>(pb[i])));
+                    }
+                });
+            } else {
+                std::transform(a.begin(), a.end(), b.begin(), out, [op](const A& x, const B& y) {
+                    return static_cast<uint8_t>(op(static_cast<R>(x), static_cast<R>(y)));
+                });
+            }
+            return result;
+        }
+
+        template <typename T, typename Pred>
+        auto test_each(const Tensor<T>& a, Pred pred) -> Mask {
+            Mask result(a.shape());
+            uint8_t* out = result.data();
+            if (a._is_contiguous()) {
+                const T* pa = a.data();
+                tt::parallel_for(0, result.numel(), MASK_GRAIN, [&](SizeType lo, SizeType hi) {
+                    for (SizeType i = lo; i < hi; ++i) {
+                        out[i] = static_cast<uint8_t>(pred(pa[i]));
+                    }
+                });
+            } else {
+                std::transform(a.begin(), a.end(), out, [pred](const T& x) { return static_cast<uint8_t>(pred(x)); });
+            }
+            return result;
+        }
+    }  // namespace detail
+
+    ////////////////////////////////////////////////////////////////////
+    // Comparisons; mixed types compare in their common type (see promote_t)
+    ////////////////////////////////////////////////////////////////////
+    template <typename T, typename U>
+    auto operator==(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::equal_to<>{});
+    }
+
+    template <typename T, typename U>
+    auto operator!=(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::not_equal_to<>{});
+    }
+
+    template <typename T, typename U>
+    auto operator<(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::less<>{});
+    }
+
+    template <typename T, typename U>
+    auto operator<=(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::less_equal<>{});
+    }
+
+    template <typename T, typename U>
+    auto operator>(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::greater<>{});
+    }
+
+    template <typename T, typename U>
+    auto operator>=(const Tensor<T>& a, const Tensor<U>& b) -> Mask {
+        return detail::compare_promoted<promote_t<T, U>>(a, b, std::greater_equal<>{});
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator==(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x == v; });
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator!=(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x != v; });
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator<(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x < v; });
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator<=(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x <= v; });
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator>(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x > v; });
+    }
+
+    template <typename T, Arithmetic S>
+    auto operator>=(const Tensor<T>& a, S s) -> Mask {
+        return detail::test_each(a, [v = static_cast<promote_t<T, S>>(s)](const T& x) { return x >= v; });
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Mask logic and tests
+    ////////////////////////////////////////////////////////////////////
+    inline auto logical_and(const Mask& a, const Mask& b) -> Mask {
+        return detail::compare_promoted<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return (x != 0) & (y != 0); });
+    }
+
+    inline auto logical_or(const Mask& a, const Mask& b) -> Mask {
+        return detail::compare_promoted<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return (x != 0) | (y != 0); });
+    }
+
+    inline auto logical_xor(const Mask& a, const Mask& b) -> Mask {
+        return detail::compare_promoted<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return (x != 0) ^ (y != 0); });
+    }
+
+    inline auto logical_not(const Mask& a) -> Mask {
+        return detail::test_each(a, [](uint8_t x) { return x == 0; });
+    }
+
+    template <typename T>
+    auto count_nonzero(const Tensor<T>& a) -> SizeType {
+        if (a._is_contiguous()) {
+            const T* p = a.data();
+            return std::count_if(p, p + a.numel(), [](const T& x) { return x != T{}; });
+        }
+        return std::count_if(a.begin(), a.end(), [](const T& x) { return x != T{}; });
+    }
+
+    template <typename T>
+    auto any(const Tensor<T>& a) -> bool {
+        return std::any_of(a.begin(), a.end(), [](const T& x) { return x != T{}; });
+    }
+
+    template <typename T>
+    auto all(const Tensor<T>& a) -> bool {
+        return std::all_of(a.begin(), a.end(), [](const T& x) { return x != T{}; });
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Selection
+    ////////////////////////////////////////////////////////////////////
+
+    // mask ? a : b per element. The choice is a select, not a branch, so the loop vectorizes and does not depend
+    // on how predictable the mask is.
+    template <typename T>
+    auto where(const Mask& mask, const Tensor<T>& a, const Tensor<T>& b) -> Tensor<T> {
+        TINYTEN_CHECK(mask.shape() == a.shape() && a.shape() == b.shape(), "where: Shapes are not the same");
+        Tensor<T> result(a.shape());
+        T* out = result.data();
+        if (mask._is_contiguous() && a._is_contiguous() && b._is_contiguous()) {
+            const uint8_t* m = mask.data();
+            const T* pa = a.data();
+            const T* pb = b.data();
+            tt::parallel_for(0, result.numel(), detail::MASK_GRAIN, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    out[i] = m[i] != 0 ? pa[i] : pb[i];
+                }
+            });
+        } else {
+            auto ia = a.begin();
+            auto ib = b.begin();
+            SizeType i = 0;
+            for (auto m = mask.begin(); m != mask.end(); ++m, ++ia, ++ib) {
+                out[i++] = *m != 0 ? *ia : *ib;
+            }
+        }
+        return result;
+    }
+
+    template <typename T>
+    auto where(const Mask& mask, const Tensor<T>& a, const T& b) -> Tensor<T> {
+        return where(mask, a, Tensor<T>(a.shape(), b));
+    }
+
+    template <typename T>
+    auto masked_fill_(Tensor<T>& a, const Mask& mask, const T& value) -> Tensor<T>& {
+        TINYTEN_CHECK(mask.shape() == a.shape(), "masked_fill: Shapes are not the same");
+        auto m = mask.begin();
+        for (auto it = a.begin(); it != a.end(); ++it, ++m) {
+            *it = *m != 0 ? value : *it;
+        }
+        return a;
+    }
+
+    template <typename T>
+    auto masked_fill(const Tensor<T>& a, const Mask& mask, const T& value) -> Tensor<T> {
+        Tensor<T> result(a);
+        masked_fill_(result, mask, value);
+        return result;
+    }
+
+    ////////////////////////////////////////////////////////////////////
+    // Bit-packed masks
+    ////////////////////////////////////////////////////////////////////
+
+    // One bit per element in row-major order, packed into 64-bit words; bits past numel() are always zero
+    class BitMask {
+      public:
+        BitMask() = default;
+
+        explicit BitMask(IndexType shape)
+            : shape_(std::move(shape)),
+              numel_(tt::cumprod(this->shape_)),
+              words_(static_cast<size_t>((this->numel_ + 63) / 64), 0) {}
+
+        // Bit i is pred(a.flat(i)). Each word is assembled from 64 predicate results shifted into place, without
+        // branches, and words are filled in parallel.
+        template <typename T, typename Pred>
+        static auto from_predicate(const Tensor<T>& a, Pred pred) -> BitMask {
+            BitMask mask(a.shape());
+            if (!a._is_contiguous()) {
+                return from_predicate(a.contiguous(), pred);
+            }
+            const T* p = a.data();
+            const SizeType n = mask.numel_;
+            uint64_t* words = mask.words_.data();
+            tt::parallel_for(0, mask.num_words(), detail::MASK_GRAIN / 64, [&](SizeType lo, SizeType hi) {
+                for (SizeType w = lo; w < hi; ++w) {
+                    const SizeType base = w * 64;
+                    const SizeType count = std::min<SizeType>(64, n - base);
+                    uint64_t bits = 0;
+                    for (SizeType j = 0; j < count; ++j) {
+                        bits |= static_cast<uint64_t>(pred(p[base + j]) ? 1 : 0) << j;
+                    }
+                    words[w] = bits;
+                }
+            });
+            return mask;
+        }
+
+        static auto from_mask(const Mask& mask) -> BitMask {
+            return from_predicate(mask, [](uint8_t x) { return x != 0; });
+        }
+
+        [[nodiscard]] auto to_mask() const -> Mask {
+            Mask mask(this->shape_);
+            uint8_t* out = mask.data();
+            tt::parallel_for(0, this->numel_, detail::MASK_GRAIN, [&](SizeType lo, SizeType hi) {
+                for (SizeType i = lo; i < hi; ++i) {
+                    out[i] = static_cast<uint8_t>((this->words_[i / 64] >> (i % 64)) & 1);
+                }
+            });
+            return mask;
+        }
+
+        [[nodiscard]] auto shape() const noexcept -> const IndexType& {
+            return this->shape_;
+        }
+
+        [[nodiscard]] auto numel() const noexcept -> SizeType {
+            return this->numel_;
+        }
+
+        [[nodiscard]] auto num_words() const noexcept -> SizeType {
+            return static_cast<SizeType>(this->words_.size());
+        }
+
+        [[nodiscard]] auto words() const noexcept -> const uint64_t* {
+            return this->words_.data();
+        }
+
+        [[nodiscard]] auto nbytes() const noexcept -> SizeType {
+            return this->num_words() * static_cast<SizeType>(sizeof(uint64_t));
+        }
+
+        [[nodiscard]] auto test(SizeType i) const -> bool {
+            TINYTEN_CHECK_INDEX(i >= 0 && i < this->numel_, "BitMask: index out of bounds");
+            return ((this->words_[i / 64] >> (i % 64)) & 1) != 0;
+        }
+
+        void set(SizeType i, bool value) {
+            TINYTEN_CHECK_INDEX(i >= 0 && i < this->numel_, "BitMask: index out of bounds");
+            const uint64_t bit = uint64_t{1} << (i % 64);
+            this->words_[i / 64] = value ? this->words_[i / 64] | bit : this->words_[i / 64] & ~bit;
+        }
+
+        [[nodiscard]] auto count() const -> SizeType {
+            SizeType total = 0;
+            for (uint64_t w : this->words_) {
+                total += std::popcount(w);
+            }
+            return total;
+        }
+
+        [[nodiscard]] auto any() const -> bool {
+            return std::any_of(this->words_.begin(), this->words_.end(), [](uint64_t w) { return w != 0; });
+        }
+
+        [[nodiscard]] auto all() const -> bool {
+            return this->count() == this->numel_;
+        }
+
+        friend auto operator&(const BitMask& a, const BitMask& b) -> BitMask {
+            return zip(a, b, [](uint64_t x, uint64_t y) { return x & y; });
+        }
+
+        friend auto operator|(const BitMask& a, const BitMask& b) -> BitMask {
+            return zip(a, b, [](uint64_t x, uint64_t y) { return x | y; });
+        }
+
+        friend auto operator^(const BitMask& a, const BitMask& b) -> BitMask {
+            return zip(a, b, [](uint64_t x, uint64_t y) { return x ^ y; });
+        }
+
+        friend auto operator~(const BitMask& a) -> BitMask {
+            BitMask result(a.shape_);
+            std::transform(a.words_.begin(), a.words_.end(), result.words_.begin(), [](uint64_t w) { return ~w; });
+            result.clear_tail();
+            return result;
+        }
+
+      private:
+        IndexType shape_;
+        SizeType numel_ = 0;
+        std::vector<uint64_t> words_;
+
+        template <typename Op>
+        static auto zip(const BitMask& a, const BitMask& b, Op op) -> BitMask {
+            TINYTEN_CHECK(a.shape_ == b.shape_, "BitMask: Shapes are not the same");
+            BitMask result(a.shape_);
+            std::transform(a.words_.begin(), a.words_.end(), b.words_.begin(), result.words_.begin(), op);
+            return result;
+        }
+
+        void clear_tail() {
+            if (const SizeType rem = this->numel_ % 64; rem != 0) {
+                this->words_.back() &= (uint64_t{1} << rem) - 1;
+            }
+        }
+    };
+
+    template <typename T>
+    auto where(const BitMask& mask, const Tensor<T>& a, const Tensor<T>& b) -> Tensor<T> {
+        return where(mask.to_mask(), a, b);
+    }
+
+    // The elements of a whose bit is set, in row-major order, as a 1-D tensor. Word popcounts give every chunk of
+    // words its output offset up front, so chunks are compacted in parallel by walking only the set bits.
+    template <typename T>
+    auto masked_select(const Tensor<T>& a, const BitMask& mask) -> Tensor<T> {
+        TINYTEN_CHECK(mask.shape() == a.shape(), "masked_select: Shapes are not the same");
+        if (!a._is_contiguous()) {
+            return masked_select(a.contiguous(), mask);
+        }
+        const SizeType words = mask.num_words();
+        const uint64_t* bits = mask.words();
+        const SizeType chunks = std::max<SizeType>(1, std::min(thread_pool().size(), words / 256));
+        std::vector<SizeType> offsets(static_cast<size_t>(chunks) + 1, 0);
+        for (SizeType c = 0; c < chunks; ++c) {
+            auto [lo, hi] = chunk_range(words, chunks, c);
+            SizeType count = 0;
+            for (SizeType w = lo; w < hi; ++w) {
+                count += std::popcount(bits[w]);
+            }
+            offsets[c + 1] = offsets[c] + count;
+        }
+
+        Tensor<T> result({offsets[chunks]});
+        const T* src = a.data();
+        T* dst = result.data();
+        tt::parallel_for(0, chunks, 1, [&](SizeType clo, SizeType chi) {
+            for (SizeType c = clo; c < chi; ++c) {
+                auto [lo, hi] = chunk_range(words, chunks, c);
+                SizeType out = offsets[c];
+                for (SizeType w = lo; w < hi; ++w) {
+                    for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                        dst[out++] = src[w * 64 + std::countr_zero(word)];
+                    }
+                }
+            }
+        });
+        return result;
+    }
+
+    template <typename T>
+    auto masked_select(const Tensor<T>& a, const Mask& mask) -> Tensor<T> {
+        return masked_select(a, BitMask::from_mask(mask));
+    }
+};  // namespace tt::inline v1
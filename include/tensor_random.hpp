@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+
+#include "tensor.hpp"
+#include "utils/Philox.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    // Seed plus a position in the Philox stream. Every fill reserves a contiguous run of counter blocks and element
+    // i of the output is always derived from the same block, so results depend only on (seed, offset) and never on
+    // how the work was split across threads.
+    class Generator {
+      public:
+        explicit Generator(uint64_t seed = 0) : seed_(seed) {}
+
+        Generator(const Generator& other) : seed_(other.seed_), offset_(other.offset_.load()) {}
+
+        auto operator=(const Generator& other) -> Generator& {
+            this->seed_ = other.seed_;
+            this->offset_ = other.offset_.load();
+            return *this;
+        }
+
+        void manual_seed(uint64_t seed) {
+            this->seed_ = seed;
+            this->offset_ = 0;
+        }
+
+        [[nodiscard]] auto seed() const noexcept -> uint64_t {
+            return this->seed_;
+        }
+
+        [[nodiscard]] auto offset() const noexcept -> uint64_t {
+            return this->offset_.load();
+        }
+
+        void set_offset(uint64_t offset) noexcept {
+            this->offset_ = offset;
+        }
+
+        // Claims `blocks` consecutive counter blocks and returns the first
+        auto reserve(uint64_t blocks) noexcept -> uint64_t {
+            return this->offset_.fetch_add(blocks);
+        }
+
+        [[nodiscard]] auto key() const noexcept -> Philox4x32::Key {
+            return {static_cast<uint32_t>(this->seed_), static_cast<uint32_t>(this->seed_ >> 32)};
+        }
+
+      private:
+        uint64_t seed_;
+        std::atomic<uint64_t> offset_{0};
+    };
+
+    inline auto default_generator() -> Generator& {
+        static Generator gen((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}());
+        return gen;
+    }
+
+    inline void manual_seed(uint64_t seed) {
+        default_generator().manual_seed(seed);
+    }
+
+    namespace detail {
+        inline auto unit_float(uint32_t x) -> float {
+            return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+        }
+
+        inline auto unit_double(uint32_t hi, uint32_t lo) -> double {
+            return static_cast<double>(((static_cast<uint64_t>(hi) << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+        }
+
+        template <typename T>
+        using RealFor = std::conditional_t<std::is_same_v<T, double> || std::is_same_v<T, long double>, double, float>;
+
+        constexpr int RANDOM_BATCH = 16;
+
+        // Fills out[0, n) from consecutive Philox blocks, PerBlock elements per block. emit(bits, tmp) turns a batch
+        // of RANDOM_BATCH blocks (bits[lane][block]) into RANDOM_BATCH * PerBlock values; it is written without
+        // branches so the compiler can vectorize it across the batch.
+        template <int PerBlock, typename T, typename Emit>
+        void fill_random(T* out, SizeType n, Generator& gen, Emit emit) {
+            if (n <= 0) {
+                return;
+            }
+            const SizeType blocks = (n + PerBlock - 1) / PerBlock;
+            const uint64_t first = gen.reserve(static_cast<uint64_t>(blocks));
+            const auto key = gen.key();
+
+            // chunk boundaries are multiples of the batch so every batch is generated whole
+            const SizeType batches = (blocks + RANDOM_BATCH - 1) / RANDOM_BATCH;
+            tt::parallel_for(0, batches, 64, [&](SizeType lo, SizeType hi) {
+                uint32_t bits[4][RANDOM_BATCH];
+                T tmp[RANDOM_BATCH * PerBlock];
+                for (SizeType batch = lo; batch < hi; ++batch) {
+                    const SizeType block = batch * RANDOM_BATCH;
+                    Philox4x32::generate_blocks<RANDOM_BATCH>(first + static_cast<uint64_t>(block), 0, key, bits);
+                    emit(bits, tmp);
+                    const SizeType base = block * PerBlock;
+                    std::copy_n(tmp, std::min<SizeType>(RANDOM_BATCH * PerBlock, n - base), out + base);
+                }
+            });
+        }
+
+        template <typename T>
+        void fill_uniform(T* out, SizeType n, Generator& gen) {
+            if constexpr (std::is_same_v<RealFor<T>, double>) {
+                fill_random<2>(out, n, gen, [](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        tmp[2 * i] = static_cast<T>(unit_double(bits[0][i], bits[1][i]));
+                        tmp[2 * i + 1] = static_cast<T>(unit_double(bits[2][i], bits[3][i]));
+                    }
+                });
+            } else {
+                fill_random<4>(out, n, gen, [](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        for (int l = 0; l < 4; ++l) {
+                            tmp[4 * i + l] = static_cast<T>(unit_float(bits[l][i]));
+                        }
+                    }
+                });
+            }
+        }
+
+        // Box-Muller on pairs of uniforms: (u1, u2) -> r * (cos, sin)(2 pi u2) with r = sqrt(-2 log(1 - u1))
+        template <typename T>
+        void fill_normal(T* out, SizeType n, Generator& gen) {
+            using Real = RealFor<T>;
+            constexpr Real two_pi = 2 * std::numbers::pi_v<Real>;
+            if constexpr (std::is_same_v<Real, double>) {
+                fill_random<2>(out, n, gen, [](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    double r[RANDOM_BATCH];
+                    double theta[RANDOM_BATCH];
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        r[i] = std::sqrt(-2.0 * std::log(1.0 - unit_double(bits[0][i], bits[1][i])));
+                        theta[i] = two_pi * unit_double(bits[2][i], bits[3][i]);
+                    }
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        tmp[2 * i] = static_cast<T>(r[i] * std::cos(theta[i]));
+                        tmp[2 * i + 1] = static_cast<T>(r[i] * std::sin(theta[i]));
+                    }
+                });
+            } else {
+                fill_random<4>(out, n, gen, [](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    float r[2 * RANDOM_BATCH];
+                    float theta[2 * RANDOM_BATCH];
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        for (int p = 0; p < 2; ++p) {
+                            r[2 * i + p] = std::sqrt(-2.0f * std::log(1.0f - unit_float(bits[2 * p][i])));
+                            theta[2 * i + p] = two_pi * unit_float(bits[2 * p + 1][i]);
+                        }
+                    }
+                    for (int j = 0; j < 2 * RANDOM_BATCH; ++j) {
+                        tmp[2 * j] = static_cast<T>(r[j] * std::cos(theta[j]));
+                        tmp[2 * j + 1] = static_cast<T>(r[j] * std::sin(theta[j]));
+                    }
+                });
+            }
+        }
+
+        // Uniform integers in [low, high) by multiply-shift on 32 (or 64) random bits
+        template <typename T>
+        void fill_randint(T* out, SizeType n, int64_t low, int64_t high, Generator& gen) {
+            if (high <= low) {
+                throw std::runtime_error("randint: high must be greater than low");
+            }
+            const auto range = static_cast<uint64_t>(high - low);
+            if (range <= (uint64_t{1} << 32)) {
+                fill_random<4>(out, n, gen, [low, range](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        for (int l = 0; l < 4; ++l) {
+                            tmp[4 * i + l] = static_cast<T>(low + static_cast<int64_t>((bits[l][i] * range) >> 32));
+                        }
+                    }
+                });
+            } else {
+                fill_random<2>(out, n, gen, [low, range](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                    for (int i = 0; i < RANDOM_BATCH; ++i) {
+                        for (int p = 0; p < 2; ++p) {
+                            const uint64_t x = (static_cast<uint64_t>(bits[2 * p][i]) << 32) | bits[2 * p + 1][i];
+                            tmp[2 * i + p] = static_cast<T>(low + static_cast<int64_t>(x % range));
+                        }
+                    }
+                });
+            }
+        }
+
+        // 1 with probability p: compares raw 32-bit draws against p * 2^32, no float conversion
+        template <typename T>
+        void fill_bernoulli(T* out, SizeType n, double p, Generator& gen) {
+            if (!(p >= 0.0 && p <= 1.0)) {
+                throw std::runtime_error("bernoulli: p must be in [0, 1]");
+            }
+            const auto threshold = static_cast<uint64_t>(std::ldexp(p, 32));
+            fill_random<4>(out, n, gen, [threshold](const uint32_t(&bits)[4][RANDOM_BATCH], T* tmp) {
+                for (int i = 0; i < RANDOM_BATCH; ++i) {
+                    for (int l = 0; l < 4; ++l) {
+                        tmp[4 * i + l] = static_cast<T>(static_cast<uint64_t>(bits[l][i]) < threshold);
+                    }
+                }
+            });
+        }
+    }  // namespace detail
+
+    template <typename T>
+    auto Tensor<T>::rand(const IndexType& shape, Generator& gen) -> Tensor {
+        Tensor tensor(shape);
+        detail::fill_uniform(tensor.data(), tensor.numel(), gen);
+        return tensor;
+    }
+
+    template <typename T>
+    auto Tensor<T>::rand(const IndexType& shape) -> Tensor {
+        return Tensor::rand(shape, default_generator());
+    }
+
+    template <typename T>
+    auto Tensor<T>::randn(const IndexType& shape, Generator& gen) -> Tensor {
+        Tensor tensor(shape);
+        detail::fill_normal(tensor.data(), tensor.numel(), gen);
+        return tensor;
+    }
+
+    template <typename T>
+    auto Tensor<T>::randn(const IndexType& shape) -> Tensor {
+        return Tensor::randn(shape, default_generator());
+    }
+
+    template <typename T>
+    auto Tensor<T>::randint(T low, T high, const IndexType& shape, Generator& gen) -> Tensor {
+        Tensor tensor(shape);
+        detail::fill_randint(tensor.data(), tensor.numel(), static_cast<int64_t>(low), static_cast<int64_t>(high), gen);
+        return tensor;
+    }
+
+    template <typename T>
+    auto Tensor<T>::randint(T low, T high, const IndexType& shape) -> Tensor {
+        return Tensor::randint(low, high, shape, default_generator());
+    }
+
+    template <typename T>
+    auto Tensor<T>::bernoulli(double p, const IndexType& shape, Generator& gen) -> Tensor {
+        Tensor tensor(shape);
+        detail::fill_bernoulli(tensor.data(), tensor.numel(), p, gen);
+        return tensor;
+    }
+
+    template <typename T>
+    auto Tensor<T>::bernoulli(double p, const IndexType& shape) -> Tensor {
+        return Tensor::bernoulli(p, shape, default_generator());
+    }
+};  // namespace tt::inline v1
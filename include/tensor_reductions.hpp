@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "tensor.hpp"
+
+namespace tt::inline v1 {
+    template <typename T>
+    template <typename Op>
+    auto Tensor<T>::reduce(SizeType dim, T init, Op op) const -> Tensor {
+        if (dim < 0 || dim >= this->dim()) {
+            throw std::runtime_error("reduce: dim out of bounds");
+        }
+
+        IndexType shape = this->shape();
+        shape.erase(shape.begin() + dim);
+        if (shape.empty()) {
+            shape.push_back(1);
+        }
+
+        Tensor result(shape);
+        const auto offsets = tt::lane_offsets(this->shape(), this->strides(), dim);
+        const SizeType len = this->shape(dim);
+        const SizeType step = this->stride(dim);
+        const T* src = this->data();
+        T* dst = result.data();
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            T acc = init;
+            const T* lane = src + offsets[i];
+            for (SizeType k = 0; k < len; ++k) {
+                acc = op(acc, lane[k * step]);
+            }
+            dst[i] = acc;
+        }
+        return result;
+    }
+
+    template <typename T>
+    auto Tensor<T>::sum() const -> T requires SupportsAdd<T> {
+        if (this->_is_contiguous()) {
+            return std::reduce(this->data(), this->data() + this->numel(), T{});
+        }
+        return std::accumulate(this->begin(), this->end(), T{});
+    }
+
+    template <typename T>
+    auto Tensor<T>::sum(SizeType dim) const -> Tensor requires SupportsAdd<T> {
+        return this->reduce(dim, T{}, std::plus<>{});
+    }
+
+    template <typename T>
+    auto Tensor<T>::mean() const -> T requires SupportsDiv<T> {
+        return this->sum() / static_cast<T>(this->numel());
+    }
+
+    template <typename T>
+    auto Tensor<T>::mean(SizeType dim) const -> Tensor requires SupportsDiv<T> {
+        auto result = this->sum(dim);
+        const auto n = static_cast<T>(this->shape(dim));
+        std::transform(result.data(), result.data() + result.numel(), result.data(), [n](T x) { return x / n; });
+        return result;
+    }
+
+    template <typename T>
+    auto Tensor<T>::max() const -> T {
+        if (this->numel() == 0) {
+            throw std::runtime_error("max: tensor is empty");
+        }
+        return std::accumulate(this->begin(), this->end(), std::numeric_limits<T>::lowest(),
+                               [](T a, T b) { return std::max(a, b); });
+    }
+
+    template <typename T>
+    auto Tensor<T>::max(SizeType dim) const -> Tensor {
+        if (this->numel() == 0) {
+            throw std::runtime_error("max: tensor is empty");
+        }
+        return this->reduce(dim, std::numeric_limits<T>::lowest(), [](T a, T b) { return std::max(a, b); });
+    }
+
+    template <typename T>
+    auto Tensor<T>::min() const -> T {
+        if (this->numel() == 0) {
+            throw std::runtime_error("min: tensor is empty");
+        }
+        return std::accumulate(this->begin(), this->end(), std::numeric_limits<T>::max(),
+                               [](T a, T b) { return std::min(a, b); });
+    }
+
+    template <typename T>
+    auto Tensor<T>::min(SizeType dim) const -> Tensor {
+        if (this->numel() == 0) {
+            throw std::runtime_error("min: tensor is empty");
+        }
+        return this->reduce(dim, std::numeric_limits<T>::max(), [](T a, T b) { return std::min(a, b); });
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "utils/Check.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // A lane is split across threads only when every thread gets at least this many elements
+        constexpr SizeType SCAN_CHUNK_MIN = SizeType{1} << 14;
+
+        // Inclusive scan of [0, n): load(i) yields element i and store(i, acc) receives the prefix ending at i. With
+        // `parallel` set, a long range is cut into one block per pool thread: the blocks are reduced in parallel,
+        // their totals scanned serially, and each block is scanned again starting from the total of the blocks
+        // before it. op must be associative; floating point sums may then round differently than a serial scan.
+        template <typename S, typename Load, typename Store, typename Op>
+        void scan_range(SizeType n, Load load, Store store, Op op, bool parallel) {
+            if (n <= 0) {
+                return;
+            }
+            const SizeType chunks = parallel ? std::min(thread_pool().size(), n / SCAN_CHUNK_MIN) : 1;
+            if (chunks < 2) {
+                S acc = load(0);
+                store(0, acc);
+                for (SizeType i = 1; i < n; ++i) {
+                    acc = op(acc, load(i));
+                    store(i, acc);
+                }
+                return;
+            }
+
+            auto& pool = thread_pool();
+            std::vector<S> totals(static_cast<size_t>(chunks));
+            pool.run(chunks, [&](int64_t chunk) {
+                auto [lo, hi] = chunk_range(n, chunks, chunk);
+                S acc = load(lo);
+                for (SizeType i = lo + 1; i < hi; ++i) {
+                    acc = op(acc, load(i));
+                }
+                totals[chunk] = acc;
+            });
+            for (SizeType c = 1; c < chunks; ++c) {
+                totals[c] = op(totals[c - 1], totals[c]);
+            }
+            pool.run(chunks, [&](int64_t chunk) {
+                auto [lo, hi] = chunk_range(n, chunks, chunk);
+                S acc = chunk == 0 ? load(lo) : op(totals[chunk - 1], load(lo));
+                store(lo, acc);
+                for (SizeType i = lo + 1; i < hi; ++i) {
+                    acc = op(acc, load(i));
+                    store(i, acc);
+                }
+            });
+        }
+
+        // Calls f(in_offset, out_offset, parallel) for every lane along dim. Many or short lanes are spread over the
+        // pool as whole lanes; a few long lanes are taken one at a time and each split across the pool instead.
+        template <typename F>
+        void scan_lanes(const IndexType& shape, const IndexType& in_strides, const IndexType& out_strides, SizeType dim,
+                        F f) {
+            const auto in_offsets = tt::lane_offsets(shape, in_strides, dim);
+            const auto out_offsets = tt::lane_offsets(shape, out_strides, dim);
+            const auto lanes = static_cast<SizeType>(in_offsets.size());
+            const SizeType len = shape[dim];
+            if (lanes >= thread_pool().size() || len < 2 * SCAN_CHUNK_MIN) {
+                tt::parallel_for(0, lanes, std::max<SizeType>(1, 4096 / std::max<SizeType>(len, 1)),
+                                 [&](SizeType lo, SizeType hi) {
+                                     for (SizeType l = lo; l < hi; ++l) {
+                                         f(in_offsets[l], out_offsets[l], false);
+                                     }
+                                 });
+                return;
+            }
+            for (SizeType l = 0; l < lanes; ++l) {
+                f(in_offsets[l], out_offsets[l], true);
+            }
+        }
+    }  // namespace detail
+
+    // Inclusive scan along dim with an associative op: out[..., i, ...] = op(... op(in[..., 0, ...], in[..., 1, ...])
+    // ..., in[..., i, ...])
+    template <typename T, typename Op>
+    auto scan(const Tensor<T>& input, SizeType dim, Op op) -> Tensor<T> {
+        TINYTEN_CHECK(dim >= 0 && dim < input.dim(), "scan: dim out of bounds");
+        Tensor<T> result(input.shape());
+        const SizeType in_stride = input.stride(dim);
+        const SizeType out_stride = result.stride(dim);
+        const T* src = input.data();
+        T* dst = result.data();
+        detail::scan_lanes(input.shape(), input.strides(), result.strides(), dim,
+                           [&](SizeType in_offset, SizeType out_offset, bool parallel) {
+                               const T* in = src + in_offset;
+                               T* out = dst + out_offset;
+                               detail::scan_range<T>(
+                                   input.shape(dim), [in, in_stride](SizeType i) { return in[i * in_stride]; },
+                                   [out, out_stride](SizeType i, const T& acc) { out[i * out_stride] = acc; }, op,
+                                   parallel);
+                           });
+        return result;
+    }
+
+    template <typename T>
+    auto cumsum(const Tensor<T>& input, SizeType dim) -> Tensor<T> requires SupportsAdd<T> {
+        return scan(input, dim, std::plus<>{});
+    }
+
+    template <typename T>
+    auto cumprod(const Tensor<T>& input, SizeType dim) -> Tensor<T> requires SupportsMul<T> {
+        return scan(input, dim, std::multiplies<>{});
+    }
+
+    namespace detail {
+        template <typename T, typename Better>
+        auto cum_extreme(const Tensor<T>& input, SizeType dim, Better better) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+            TINYTEN_CHECK(dim >= 0 && dim < input.dim(), "scan: dim out of bounds");
+            Tensor<T> values(input.shape());
+            Tensor<int64_t> indices(input.shape());
+            const SizeType in_stride = input.stride(dim);
+            const SizeType out_stride = values.stride(dim);
+            const T* src = input.data();
+            using Entry = std::pair<T, int64_t>;
+            // later positions win ties, so the index is that of the last occurrence of the running extreme
+            auto op = [better](const Entry& acc, const Entry& x) { return better(acc.first, x.first) ? acc : x; };
+            scan_lanes(input.shape(), input.strides(), values.strides(), dim,
+                       [&](SizeType in_offset, SizeType out_offset, bool parallel) {
+                           const T* in = src + in_offset;
+                           T* v = values.data() + out_offset;
+                           int64_t* idx = indices.data() + out_offset;
+                           scan_range<Entry>(
+                               input.shape(dim), [in, in_stride](SizeType i) { return Entry{in[i * in_stride], i}; },
+                               [v, idx, out_stride](SizeType i, const Entry& acc) {
+                                   v[i * out_stride] = acc.first;
+                                   idx[i * out_stride] = acc.second;
+                               },
+                               op, parallel);
+                       });
+            return {std::move(values), std::move(indices)};
+        }
+    }  // namespace detail
+
+    // Running maximum along dim and the position it was found at
+    template <typename T>
+    auto cummax(const Tensor<T>& input, SizeType dim) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        return detail::cum_extreme(input, dim, [](const T& acc, const T& x) { return x < acc; });
+    }
+
+    template <typename T>
+    auto cummin(const Tensor<T>& input, SizeType dim) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        return detail::cum_extreme(input, dim, [](const T& acc, const T& x) { return acc < x; });
+    }
+};  // namespace tt::inline v1
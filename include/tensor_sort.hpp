@@ -0,0 +1,333 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tensor.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    namespace detail {
+        // Rows at least this long are radix sorted when the element type has an order-preserving unsigned key
+        constexpr SizeType RADIX_SORT_MIN = 1024;
+        // topk keeps a sorted insertion buffer while k is this small, otherwise it selects with nth_element
+        constexpr SizeType TOPK_SMALL_K = 16;
+
+        template <typename T>
+        concept RadixSortable = std::is_integral_v<T> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+        template <typename T>
+        using RadixKey = std::conditional_t<sizeof(T) <= 4, uint32_t, uint64_t>;
+
+        // Maps T to an unsigned integer with the same ordering
+        template <RadixSortable T>
+        constexpr auto radix_key(T v) -> RadixKey<T> {
+            using K = RadixKey<T>;
+            if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+                const K bits = std::bit_cast<K>(v);
+                constexpr K sign = K{1} << (8 * sizeof(K) - 1);
+                return (bits & sign) ? ~bits : (bits | sign);
+            } else if constexpr (std::is_signed_v<T>) {
+                constexpr K sign = K{1} << (8 * sizeof(T) - 1);
+                return static_cast<K>(static_cast<std::make_unsigned_t<T>>(v)) ^ sign;
+            } else {
+                return static_cast<K>(v);
+            }
+        }
+
+        // Inverse of radix_key
+        template <RadixSortable T>
+        constexpr auto radix_value(RadixKey<T> key) -> T {
+            using K = RadixKey<T>;
+            if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+                constexpr K sign = K{1} << (8 * sizeof(K) - 1);
+                return std::bit_cast<T>((key & sign) ? (key ^ sign) : ~key);
+            } else if constexpr (std::is_signed_v<T>) {
+                constexpr K sign = K{1} << (8 * sizeof(T) - 1);
+                return static_cast<T>(static_cast<std::make_unsigned_t<T>>(key ^ sign));
+            } else {
+                return static_cast<T>(key);
+            }
+        }
+
+        template <typename T>
+        struct SortScratch {
+            std::vector<std::pair<T, int64_t>> pairs;
+            std::vector<RadixKey<std::conditional_t<RadixSortable<T>, T, int>>> keys;
+            std::vector<RadixKey<std::conditional_t<RadixSortable<T>, T, int>>> keys_tmp;
+            std::vector<int64_t> idx;
+            std::vector<int64_t> idx_tmp;
+        };
+
+        // The value order of every sort path: -0.0 and 0.0 are equal, and NaNs are all equal and after every number
+        template <typename T>
+        constexpr auto sort_less(const T& a, const T& b) -> bool {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (b != b) {
+                    return a == a;
+                }
+            }
+            return a < b;
+        }
+
+        // radix_key ordering like sort_less
+        template <RadixSortable T>
+        constexpr auto sort_key(T v) -> RadixKey<T> {
+            if constexpr (std::is_floating_point_v<T>) {
+                if (v != v) {
+                    return ~RadixKey<T>{0};
+                }
+                return radix_key(v == T{} ? T{} : v);
+            } else {
+                return radix_key(v);
+            }
+        }
+
+        // Orders by value, ties by original position, so every path produces the same (stable) result
+        template <typename T>
+        constexpr auto before(const std::pair<T, int64_t>& a, const std::pair<T, int64_t>& b, bool descending)
+            -> bool {
+            const bool less = sort_less(a.first, b.first);
+            const bool greater = sort_less(b.first, a.first);
+            if (!less && !greater) {
+                return a.second < b.second;
+            }
+            return descending ? greater : less;
+        }
+
+        // Stable LSD radix sort of a strided row, leaving the sorted original positions in scratch.idx. Passes whose
+        // digit is the same for every key are skipped.
+        template <RadixSortable T>
+        void radix_argsort(const T* src, SizeType stride, SizeType len, bool descending, SortScratch<T>& s) {
+            using K = RadixKey<T>;
+            s.keys.resize(len);
+            s.keys_tmp.resize(len);
+            s.idx.resize(len);
+            s.idx_tmp.resize(len);
+            for (SizeType i = 0; i < len; ++i) {
+                const K key = sort_key(src[i * stride]);
+                s.keys[i] = descending ? static_cast<K>(~key) : key;
+                s.idx[i] = i;
+            }
+
+            constexpr int passes = static_cast<int>(sizeof(T) <= 4 ? sizeof(T) : sizeof(K));
+            for (int pass = 0; pass < passes; ++pass) {
+                const int shift = 8 * pass;
+                std::array<SizeType, 256> count{};
+                for (SizeType i = 0; i < len; ++i) {
+                    count[(s.keys[i] >> shift) & 0xFF]++;
+                }
+                if (std::find(count.begin(), count.end(), len) != count.end()) {
+                    continue;
+                }
+                SizeType sum = 0;
+                for (auto& c : count) {
+                    sum += std::exchange(c, sum);
+                }
+                for (SizeType i = 0; i < len; ++i) {
+                    const SizeType pos = count[(s.keys[i] >> shift) & 0xFF]++;
+                    s.keys_tmp[pos] = s.keys[i];
+                    s.idx_tmp[pos] = s.idx[i];
+                }
+                std::swap(s.keys, s.keys_tmp);
+                std::swap(s.idx, s.idx_tmp);
+            }
+        }
+
+        // Sorts a strided row, writing k leading values and original positions
+        template <typename T>
+        void sort_row(const T* src, SizeType stride, SizeType len, SizeType k, bool descending, T* values,
+                      SizeType vstride, int64_t* indices, SizeType istride, SortScratch<T>& s) {
+            if constexpr (RadixSortable<T>) {
+                if (len >= RADIX_SORT_MIN) {
+                    radix_argsort(src, stride, len, descending, s);
+                    for (SizeType i = 0; i < k; ++i) {
+                        values[i * vstride] = src[s.idx[i] * stride];
+                        indices[i * istride] = s.idx[i];
+                    }
+                    return;
+                }
+            }
+            s.pairs.resize(len);
+            for (SizeType i = 0; i < len; ++i) {
+                s.pairs[i] = {src[i * stride], i};
+            }
+            auto cmp = [descending](const auto& a, const auto& b) { return before(a, b, descending); };
+            if (k < len) {
+                std::partial_sort(s.pairs.begin(), s.pairs.begin() + k, s.pairs.end(), cmp);
+            } else {
+                std::sort(s.pairs.begin(), s.pairs.end(), cmp);
+            }
+            for (SizeType i = 0; i < k; ++i) {
+                values[i * vstride] = s.pairs[i].first;
+                indices[i * istride] = s.pairs[i].second;
+            }
+        }
+
+        // Keeps the k best elements seen so far in a small sorted buffer; each new element is compared against the
+        // current worst and, if better, shifted into place
+        template <typename T>
+        void small_topk_row(const T* src, SizeType stride, SizeType len, SizeType k, bool largest, T* values,
+                            SizeType vstride, int64_t* indices, SizeType istride, SortScratch<T>& s) {
+            s.pairs.resize(k);
+            SizeType filled = 0;
+            for (SizeType i = 0; i < len; ++i) {
+                const std::pair<T, int64_t> item{src[i * stride], i};
+                if (filled == k) {
+                    if (!before(item, s.pairs[k - 1], largest)) {
+                        continue;
+                    }
+                } else {
+                    ++filled;
+                }
+                SizeType pos = filled - 1;
+                while (pos > 0 && before(item, s.pairs[pos - 1], largest)) {
+                    s.pairs[pos] = s.pairs[pos - 1];
+                    --pos;
+                }
+                s.pairs[pos] = item;
+            }
+            for (SizeType i = 0; i < k; ++i) {
+                values[i * vstride] = s.pairs[i].first;
+                indices[i * istride] = s.pairs[i].second;
+            }
+        }
+
+        // Runs f(src, src_stride, values, indices, scratch) on every lane along dim, rows in parallel. Outputs are
+        // contiguous with `out_len` elements along dim.
+        template <typename T, typename F>
+        auto map_lanes(const Tensor<T>& input, SizeType dim, SizeType out_len, F f)
+            -> std::pair<Tensor<T>, Tensor<int64_t>> {
+            if (dim < 0 || dim >= input.dim()) {
+                throw std::runtime_error("sort: dim out of bounds");
+            }
+            IndexType out_shape = input.shape();
+            out_shape[dim] = out_len;
+            Tensor<T> values(out_shape);
+            Tensor<int64_t> indices(out_shape);
+
+            const auto in_offsets = tt::lane_offsets(input.shape(), input.strides(), dim);
+            const auto out_offsets = tt::lane_offsets(out_shape, values.strides(), dim);
+            const SizeType in_stride = input.stride(dim);
+            const SizeType out_stride = values.stride(dim);
+            const SizeType len = input.shape(dim);
+            const auto lanes = static_cast<SizeType>(in_offsets.size());
+
+            tt::parallel_for(0, lanes, std::max<SizeType>(1, 4096 / std::max<SizeType>(len, 1)),
+                             [&](SizeType lo, SizeType hi) {
+                                 SortScratch<T> scratch;
+                                 for (SizeType l = lo; l < hi; ++l) {
+                                     f(input.data() + in_offsets[l], in_stride, values.data() + out_offsets[l],
+                                       indices.data() + out_offsets[l], out_stride, scratch);
+                                 }
+                             });
+            return {std::move(values), std::move(indices)};
+        }
+    }  // namespace detail
+
+    // Sorted values and their original positions along dim. Ties keep their original order.
+    template <typename T>
+    auto sort(const Tensor<T>& input, SizeType dim, bool descending = false) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        const SizeType len = dim >= 0 && dim < input.dim() ? input.shape(dim) : 0;
+        return detail::map_lanes(input, dim, len, [&](const T* src, SizeType stride, T* v, int64_t* idx, SizeType os,
+                                                      detail::SortScratch<T>& s) {
+            detail::sort_row(src, stride, len, len, descending, v, os, idx, os, s);
+        });
+    }
+
+    template <typename T>
+    auto argsort(const Tensor<T>& input, SizeType dim, bool descending = false) -> Tensor<int64_t> {
+        return sort(input, dim, descending).second;
+    }
+
+    // The k largest (or smallest) elements along dim, best first when sorted is set
+    template <typename T>
+    auto topk(const Tensor<T>& input, SizeType k, SizeType dim, bool largest = true, bool sorted = true)
+        -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        const SizeType len = dim >= 0 && dim < input.dim() ? input.shape(dim) : 0;
+        if (k < 0 || k > len) {
+            throw std::runtime_error("topk: k out of range");
+        }
+        return detail::map_lanes(input, dim, k, [&](const T* src, SizeType stride, T* v, int64_t* idx, SizeType os,
+                                                    detail::SortScratch<T>& s) {
+            if (k == 0) {
+                return;
+            }
+            if (k <= detail::TOPK_SMALL_K) {
+                detail::small_topk_row(src, stride, len, k, largest, v, os, idx, os, s);
+                return;
+            }
+            s.pairs.resize(len);
+            for (SizeType i = 0; i < len; ++i) {
+                s.pairs[i] = {src[i * stride], i};
+            }
+            auto cmp = [largest](const auto& a, const auto& b) { return detail::before(a, b, largest); };
+            std::nth_element(s.pairs.begin(), s.pairs.begin() + (k - 1), s.pairs.end(), cmp);
+            if (sorted) {
+                std::sort(s.pairs.begin(), s.pairs.begin() + k, cmp);
+            }
+            for (SizeType i = 0; i < k; ++i) {
+                v[i * os] = s.pairs[i].first;
+                idx[i * os] = s.pairs[i].second;
+            }
+        });
+    }
+
+    // Rearranges every lane so the element at position kth is the one a full sort would put there, with no larger
+    // element before it and no smaller one after it
+    template <typename T>
+    auto partition(const Tensor<T>& input, SizeType kth, SizeType dim) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        const SizeType len = dim >= 0 && dim < input.dim() ? input.shape(dim) : 0;
+        if (kth < 0 || kth >= len) {
+            throw std::runtime_error("partition: kth out of range");
+        }
+        return detail::map_lanes(input, dim, len, [&](const T* src, SizeType stride, T* v, int64_t* idx, SizeType os,
+                                                      detail::SortScratch<T>& s) {
+            s.pairs.resize(len);
+            for (SizeType i = 0; i < len; ++i) {
+                s.pairs[i] = {src[i * stride], i};
+            }
+            std::nth_element(s.pairs.begin(), s.pairs.begin() + kth, s.pairs.end(),
+                             [](const auto& a, const auto& b) { return detail::before(a, b, false); });
+            for (SizeType i = 0; i < len; ++i) {
+                v[i * os] = s.pairs[i].first;
+                idx[i * os] = s.pairs[i].second;
+            }
+        });
+    }
+
+    // The k-th smallest element (0-based) of every lane along dim, which is removed from the output shape
+    template <typename T>
+    auto kthvalue(const Tensor<T>& input, SizeType k, SizeType dim) -> std::pair<Tensor<T>, Tensor<int64_t>> {
+        const SizeType len = dim >= 0 && dim < input.dim() ? input.shape(dim) : 0;
+        if (k < 0 || k >= len) {
+            throw std::runtime_error("kthvalue: k out of range");
+        }
+        auto result = detail::map_lanes(input, dim, 1, [&](const T* src, SizeType stride, T* v, int64_t* idx,
+                                                           SizeType, detail::SortScratch<T>& s) {
+            s.pairs.resize(len);
+            for (SizeType i = 0; i < len; ++i) {
+                s.pairs[i] = {src[i * stride], i};
+            }
+            std::nth_element(s.pairs.begin(), s.pairs.begin() + k, s.pairs.end(),
+                             [](const auto& a, const auto& b) { return detail::before(a, b, false); });
+            *v = s.pairs[k].first;
+            *idx = s.pairs[k].second;
+        });
+
+        IndexType shape = input.shape();
+        shape.erase(shape.begin() + dim);
+        if (shape.empty()) {
+            shape.push_back(1);
+        }
+        result.first.reshape_(shape);
+        result.second.reshape_(shape);
+        return result;
+    }
+};  // namespace tt::inline v1
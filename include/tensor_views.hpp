@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "tensor.hpp"
+#include "utils/Check.hpp"
+
+namespace tt::inline v1 {
+    // The whole tensor, with the same shape and strides
+    template <typename T>
+    auto Tensor<T>::view() const -> Tensor {
+        return Tensor(this->data_, this->offset_, this->indexer_);
+    }
+
+    // Elements [start, start + length) along dim
+    template <typename T>
+    auto Tensor<T>::narrow(SizeType dim, SizeType start, SizeType length) const -> Tensor {
+        TINYTEN_CHECK(dim >= 0 && dim < this->dim(), "narrow: dim out of bounds");
+        TINYTEN_CHECK(start >= 0 && length >= 0 && start + length <= this->shape(dim), "narrow: range out of bounds");
+        IndexType shape = this->shape();
+        shape[dim] = length;
+        return Tensor(this->data_, this->offset_ + start * this->stride(dim),
+                      TensorIndexer<T>(shape, this->strides(), tt::calc_strides(shape)));
+    }
+
+    // The slice at `index` along dim, with dim removed. Selecting from a 1-D tensor gives shape {1}.
+    template <typename T>
+    auto Tensor<T>::select(SizeType dim, SizeType index) const -> Tensor {
+        TINYTEN_CHECK(dim >= 0 && dim < this->dim(), "select: dim out of bounds");
+        TINYTEN_CHECK(index >= 0 && index < this->shape(dim), "select: index out of bounds");
+        IndexType shape = this->shape();
+        IndexType strides = this->strides();
+        shape.erase(shape.begin() + dim);
+        strides.erase(strides.begin() + dim);
+        if (shape.empty()) {
+            shape.push_back(1);
+            strides.push_back(1);
+        }
+        return Tensor(this->data_, this->offset_ + index * this->stride(dim),
+                      TensorIndexer<T>(shape, strides, tt::calc_strides(shape)));
+    }
+
+    // Reverses the order of the elements along each of dims, through negative strides
+    template <typename T>
+    auto Tensor<T>::flip(const IndexType& dims) const -> Tensor {
+        IndexType strides = this->strides();
+        SizeType offset = this->offset_;
+        std::vector<bool> flipped(this->dim(), false);
+        for (SizeType d : dims) {
+            TINYTEN_CHECK(d >= 0 && d < this->dim(), "flip: dim out of bounds");
+            TINYTEN_CHECK(!flipped[d], "flip: dim repeated");
+            flipped[d] = true;
+            if (this->shape(d) > 0) {
+                offset += (this->shape(d) - 1) * strides[d];
+            }
+            strides[d] = -strides[d];
+        }
+        return Tensor(this->data_, offset, TensorIndexer<T>(this->shape(), strides, tt::calc_strides(this->shape())));
+    }
+
+    // Elements (i, i + offset) of the matrices spanned by dim1 and dim2 (below the main diagonal for a negative
+    // offset). Both dims are removed and the diagonal becomes the last dim.
+    template <typename T>
+    auto Tensor<T>::diagonal(SizeType offset, SizeType dim1, SizeType dim2) const -> Tensor {
+        TINYTEN_CHECK(dim1 >= 0 && dim1 < this->dim() && dim2 >= 0 && dim2 < this->dim() && dim1 != dim2,
+                      "diagonal: dims out of bounds");
+        const SizeType rows = this->shape(dim1) - std::max<SizeType>(0, -offset);
+        const SizeType cols = this->shape(dim2) - std::max<SizeType>(0, offset);
+        const SizeType length = std::max<SizeType>(0, std::min(rows, cols));
+        SizeType start = this->offset_;
+        if (length > 0) {
+            start += offset >= 0 ? offset * this->stride(dim2) : -offset * this->stride(dim1);
+        }
+        IndexType shape;
+        IndexType strides;
+        for (SizeType d = 0; d < this->dim(); ++d) {
+            if (d != dim1 && d != dim2) {
+                shape.push_back(this->shape(d));
+                strides.push_back(this->stride(d));
+            }
+        }
+        shape.push_back(length);
+        strides.push_back(this->stride(dim1) + this->stride(dim2));
+        return Tensor(this->data_, start, TensorIndexer<T>(shape, strides, tt::calc_strides(shape)));
+    }
+
+    // Sliding windows: dim becomes the (shape(dim) - size) / step + 1 window positions and a new last dim of
+    // `size` walks each window. Windows overlap when step < size; writes through such a view alias.
+    template <typename T>
+    auto Tensor<T>::unfold(SizeType dim, SizeType size, SizeType step) const -> Tensor {
+        TINYTEN_CHECK(dim >= 0 && dim < this->dim(), "unfold: dim out of bounds");
+        TINYTEN_CHECK(size >= 0 && size <= this->shape(dim) && step > 0, "unfold: window out of bounds");
+        IndexType shape = this->shape();
+        IndexType strides = this->strides();
+        shape[dim] = (this->shape(dim) - size) / step + 1;
+        strides[dim] = this->stride(dim) * step;
+        shape.push_back(size);
+        strides.push_back(this->stride(dim));
+        return Tensor(this->data_, this->offset_, TensorIndexer<T>(shape, strides, tt::calc_strides(shape)));
+    }
+
+    // Any layout over this tensor's buffer, starting `offset` elements past its first element. Strides may be
+    // negative, zero or overlapping; every element the view can reach must lie inside the buffer.
+    template <typename T>
+    auto Tensor<T>::as_strided(const IndexType& shape, const IndexType& strides, SizeType offset) const -> Tensor {
+        TINYTEN_CHECK(shape.size() == strides.size() && !shape.empty(), "as_strided: shape and strides differ in rank");
+        const SizeType start = this->offset_ + offset;
+        SizeType lo = start;
+        SizeType hi = start;
+        bool empty = false;
+        for (size_t d = 0; d < shape.size(); ++d) {
+            TINYTEN_CHECK(shape[d] >= 0, "as_strided: negative size");
+            empty = empty || shape[d] == 0;
+            if (shape[d] > 0) {
+                (strides[d] < 0 ? lo : hi) += (shape[d] - 1) * strides[d];
+            }
+        }
+        TINYTEN_CHECK(empty || (lo >= 0 && hi < static_cast<SizeType>(this->data_->size())),
+                      "as_strided: view reaches outside the buffer");
+        return Tensor(this->data_, start, TensorIndexer<T>(shape, strides, tt::calc_strides(shape)));
+    }
+
+    namespace detail {
+        // The tensor itself if its elements are already laid out densely in order, else a contiguous copy
+        template <typename T>
+        auto packed(const Tensor<T>& t) -> Tensor<T> {
+            return t._is_contiguous() ? t.view() : t.contiguous();
+        }
+    }  // namespace detail
+};  // namespace tt::inline v1
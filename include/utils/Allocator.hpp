@@ -0,0 +1,452 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "Memory.hpp"
+#include "Numa.hpp"
+#include "SharedMemory.hpp"
+#include "ThreadPool.hpp"
+
+namespace tt::inline v1 {
+    // How large tensor buffers are backed. Small buffers always come from operator new.
+    //  - huge_pages: map with MAP_HUGETLB, or failing that a huge-page aligned mapping with MADV_HUGEPAGE, or failing
+    //    that normal pages
+    //  - lock: mlock the buffer (best effort, limited by RLIMIT_MEMLOCK)
+    //  - pooled: keep freed mappings in a process-wide cache and hand them out again to buffers of the same size and
+    //    options instead of unmapping them
+    //  - shared: place the buffer at the start of this shared memory segment instead (see shared_tensor.hpp); the
+    //    other options are ignored, and copies of the buffer are private
+    struct StorageOptions {
+        NumaPolicy numa{};
+        bool huge_pages = false;
+        bool lock = false;
+        bool pooled = false;
+        std::shared_ptr<detail::SharedSegment> shared;
+
+        friend auto operator==(const StorageOptions& a, const StorageOptions& b) -> bool {
+            return a.numa.kind == b.numa.kind && a.numa.node == b.numa.node && a.huge_pages == b.huge_pages &&
+                   a.lock == b.lock && a.pooled == b.pooled && a.shared == b.shared;
+        }
+    };
+
+    namespace detail {
+        // Buffers at least this large are mapped directly and first-touched in parallel
+        constexpr size_t NUMA_MIN_BYTES = size_t{1} << 21;
+        constexpr size_t BUFFER_ALIGNMENT = 64;
+
+        inline auto page_size() -> size_t {
+#if defined(__linux__)
+            static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            return size;
+#else
+            return 4096;
+#endif
+        }
+
+        inline auto huge_page_size() -> size_t {
+            static const size_t size = [] {
+                size_t kb = 2048;
+#if defined(__linux__)
+                std::ifstream meminfo("/proc/meminfo");
+                std::string key;
+                while (meminfo >> key) {
+                    if (key == "Hugepagesize:") {
+                        meminfo >> kb;
+                        break;
+                    }
+                    meminfo.ignore(256, '\n');
+                }
+#endif
+                return kb * 1024;
+            }();
+            return size;
+        }
+
+        struct StorageOptionsSlot {
+            std::mutex mutex;
+            StorageOptions options;
+        };
+
+        inline auto storage_options_slot() -> StorageOptionsSlot& {
+            static StorageOptionsSlot slot;
+            return slot;
+        }
+
+        // Zeroes [ptr, ptr + bytes) page by page over the thread pool, split exactly as parallel_for splits any
+        // other range, so under first-touch the pages of chunk t end up on the node of pool thread t
+        inline void first_touch(void* ptr, size_t bytes) {
+            const size_t page = page_size();
+            const auto pages = static_cast<int64_t>((bytes + page - 1) / page);
+            auto* base = static_cast<unsigned char*>(ptr);
+            tt::parallel_for(0, pages, 1, [&](int64_t lo, int64_t hi) {
+                const size_t begin = static_cast<size_t>(lo) * page;
+                const size_t end = std::min(static_cast<size_t>(hi) * page, bytes);
+                std::memset(base + begin, 0, end - begin);
+            });
+        }
+
+        // Size of the mapping backing a buffer of `bytes`
+        inline auto mapping_size(size_t bytes, const StorageOptions& options) -> size_t {
+            const size_t unit = options.huge_pages ? huge_page_size() : page_size();
+            return (bytes + unit - 1) / unit * unit;
+        }
+
+        // Freed mappings kept for reuse, matched on exact size and options. Never destroyed, so buffers of static
+        // tensors can still be released into it during program exit.
+        class RegionCache {
+          public:
+            static auto instance() -> RegionCache& {
+                static auto* cache = new RegionCache();
+                return *cache;
+            }
+
+            auto take(size_t bytes, const StorageOptions& options) -> void* {
+                std::lock_guard lock(this->mutex_);
+                for (auto it = this->regions_.begin(); it != this->regions_.end(); ++it) {
+                    if (it->bytes == bytes && it->options == options) {
+                        void* ptr = it->ptr;
+                        this->cached_bytes_ -= bytes;
+                        this->regions_.erase(it);
+                        MemoryAccounting::instance().uncache(bytes);
+                        return ptr;
+                    }
+                }
+                return nullptr;
+            }
+
+            // False when the region does not fit under the limit and must be unmapped by the caller
+            auto give(void* ptr, size_t bytes, const StorageOptions& options) -> bool {
+                std::lock_guard lock(this->mutex_);
+                if (this->cached_bytes_ + bytes > this->limit_) {
+                    return false;
+                }
+                this->regions_.push_back({ptr, bytes, options});
+                this->cached_bytes_ += bytes;
+                MemoryAccounting::instance().cache(bytes);
+                return true;
+            }
+
+            void set_limit(size_t bytes) {
+                std::lock_guard lock(this->mutex_);
+                this->limit_ = bytes;
+            }
+
+            [[nodiscard]] auto cached_bytes() -> size_t {
+                std::lock_guard lock(this->mutex_);
+                return this->cached_bytes_;
+            }
+
+            void clear();
+
+          private:
+            struct Region {
+                void* ptr;
+                size_t bytes;
+                StorageOptions options;
+            };
+
+            std::mutex mutex_;
+            std::vector<Region> regions_;
+            size_t cached_bytes_ = 0;
+            size_t limit_ = size_t{1} << 30;
+
+            // the memory accounting empties the cache when an allocation would exceed the budget
+            RegionCache() {
+                MemoryAccounting::instance().set_reclaim([] { RegionCache::instance().clear(); });
+            }
+        };
+
+#if defined(__linux__)
+        // A huge-page aligned anonymous mapping of `bytes` (a multiple of the huge page size), trimmed out of a larger
+        // one, advised for transparent huge pages
+        inline auto map_aligned_thp(size_t bytes) -> void* {
+            const size_t align = huge_page_size();
+            void* raw = mmap(nullptr, bytes + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) {
+                return nullptr;
+            }
+            const auto addr = reinterpret_cast<uintptr_t>(raw);
+            const uintptr_t aligned = (addr + align - 1) / align * align;
+            if (aligned > addr) {
+                munmap(raw, aligned - addr);
+            }
+            if (const size_t tail = addr + bytes + align - (aligned + bytes); tail > 0) {
+                munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+            }
+            void* ptr = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+            madvise(ptr, bytes, MADV_HUGEPAGE);
+#endif
+            return ptr;
+        }
+
+        inline auto map_region(size_t bytes, const StorageOptions& options) -> void* {
+            if (options.pooled) {
+                if (void* ptr = RegionCache::instance().take(bytes, options)) {
+                    first_touch(ptr, bytes);
+                    return ptr;
+                }
+            }
+
+            void* ptr = nullptr;
+            if (options.huge_pages) {
+#if defined(MAP_HUGETLB)
+                ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (ptr == MAP_FAILED) {
+                    ptr = nullptr;
+                }
+#endif
+                if (ptr == nullptr) {
+                    ptr = map_aligned_thp(bytes);
+                }
+            }
+            if (ptr == nullptr) {
+                ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (ptr == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+            }
+            numa_bind(ptr, bytes, options.numa);
+            first_touch(ptr, bytes);
+            if (options.lock) {
+                mlock(ptr, bytes);
+            }
+            return ptr;
+        }
+
+        inline void unmap_region(void* ptr, size_t bytes, const StorageOptions& options) {
+            if (options.pooled && RegionCache::instance().give(ptr, bytes, options)) {
+                return;
+            }
+            munmap(ptr, bytes);
+        }
+
+        inline void RegionCache::clear() {
+            std::lock_guard lock(this->mutex_);
+            for (const auto& region : this->regions_) {
+                munmap(region.ptr, region.bytes);
+                MemoryAccounting::instance().uncache(region.bytes);
+            }
+            this->regions_.clear();
+            this->cached_bytes_ = 0;
+        }
+#else
+        inline void RegionCache::clear() {}
+#endif
+    }  // namespace detail
+
+    // Options used by buffers allocated from now on, including the NUMA policy (see set_numa_policy)
+    inline void set_storage_options(const StorageOptions& options) {
+        if (options.shared) {
+            throw std::runtime_error("set_storage_options: a shared memory segment holds a single buffer");
+        }
+        auto& slot = detail::storage_options_slot();
+        {
+            std::lock_guard lock(slot.mutex);
+            slot.options = options;
+        }
+        set_numa_policy(options.numa);
+    }
+
+    inline auto get_storage_options() -> StorageOptions {
+        auto& slot = detail::storage_options_slot();
+        StorageOptions options;
+        {
+            std::lock_guard lock(slot.mutex);
+            options = slot.options;
+        }
+        options.numa = get_numa_policy();
+        return options;
+    }
+
+    // Upper bound on the bytes held by the cache of pooled mappings (1 GiB by default)
+    inline void set_region_cache_limit(size_t bytes) {
+        detail::RegionCache::instance().set_limit(bytes);
+    }
+
+    inline auto region_cache_bytes() -> size_t {
+        return detail::RegionCache::instance().cached_bytes();
+    }
+
+    // Unmaps every cached region
+    inline void clear_region_cache() {
+        detail::RegionCache::instance().clear();
+    }
+
+    // Allocator behind tensor buffers. Memory is always handed out zeroed, so value-initializing arithmetic elements
+    // is skipped instead of being done a second time by the (single) constructing thread. Large buffers are mapped
+    // with mmap according to the StorageOptions captured when the allocator was created, placed according to their
+    // NumaPolicy and first-touched in parallel. A buffer in a shared memory segment is not zeroed: it holds whatever
+    // the segment holds, which is what lets another process's tensor be opened in place. It takes a reference on the
+    // segment for as long as it lives.
+    //
+    // Every buffer is counted in the memory accounting (see utils/Memory.hpp) under its backend and under the
+    // MemoryScope tag in effect on the thread that created the allocator. Buffers in a shared memory segment count
+    // no bytes of their own; the segment is charged once, when the first buffer attaches to it.
+    template <typename T>
+    class Allocator {
+      public:
+        using value_type = T;
+        // the buffer stays with the allocator that counted it
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        Allocator() noexcept : options_(get_storage_options()), tag_(detail::current_memory_tag()) {}
+
+        explicit Allocator(const StorageOptions& options) noexcept
+            : options_(options), tag_(detail::current_memory_tag()) {}
+
+        explicit Allocator(NumaPolicy policy) noexcept
+            : options_(get_storage_options()), tag_(detail::current_memory_tag()) {
+            this->options_.numa = policy;
+        }
+
+        template <typename U>
+        Allocator(const Allocator<U>& other) noexcept : options_(other.options()), tag_(other.tag()) {}
+
+        [[nodiscard]] auto options() const noexcept -> const StorageOptions& {
+            return this->options_;
+        }
+
+        [[nodiscard]] auto policy() const noexcept -> NumaPolicy {
+            return this->options_.numa;
+        }
+
+        [[nodiscard]] auto tag() const noexcept -> detail::MemoryTag* {
+            return this->tag_;
+        }
+
+        [[nodiscard]] auto allocate(size_t n) -> T* {
+            const auto [backend, footprint] = this->footprint(n);
+            auto& accounting = detail::MemoryAccounting::instance();
+            accounting.acquire(footprint, backend, this->tag_);
+            T* ptr = nullptr;
+            try {
+                ptr = this->allocate_buffer(n);
+            } catch (...) {
+                accounting.release(footprint, backend, this->tag_);
+                throw;
+            }
+            if (accounting.tracking()) {
+                accounting.track(ptr, this->options_.shared ? n * sizeof(T) : footprint, backend, this->tag_,
+                                 sizeof(T));
+            }
+            return ptr;
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept {
+            const auto [backend, footprint] = this->footprint(n);
+            auto& accounting = detail::MemoryAccounting::instance();
+            if (accounting.tracking()) {
+                accounting.untrack(ptr);
+            }
+            accounting.release(footprint, backend, this->tag_);
+            this->deallocate_buffer(ptr, n);
+        }
+
+        // Copies of a buffer in shared memory are private
+        [[nodiscard]] auto select_on_container_copy_construction() const -> Allocator {
+            Allocator copy(*this);
+            copy.options_.shared.reset();
+            return copy;
+        }
+
+        template <typename U, typename... Args>
+        void construct(U* ptr, Args&&... args) {
+            if constexpr (sizeof...(Args) == 0 && std::is_arithmetic_v<U>) {
+                // already zero
+            } else {
+                ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+            }
+        }
+
+        // Buffers may only be released by an allocator with the same options, which determine the mapping
+        template <typename U>
+        friend auto operator==(const Allocator& a, const Allocator<U>& b) noexcept -> bool {
+            return a.options() == b.options();
+        }
+
+      private:
+        StorageOptions options_;
+        detail::MemoryTag* tag_;
+
+        // Backend of a buffer of n elements and the bytes it takes there
+        [[nodiscard]] auto footprint(size_t n) const noexcept -> std::pair<StorageBackend, size_t> {
+            const size_t bytes = n * sizeof(T);
+            if (this->options_.shared) {
+                return {StorageBackend::Shared, 0};
+            }
+#if defined(__linux__)
+            if (bytes >= detail::NUMA_MIN_BYTES) {
+                return {StorageBackend::Mapped, detail::mapping_size(bytes, this->options_)};
+            }
+#endif
+            return {StorageBackend::Heap, bytes};
+        }
+
+        [[nodiscard]] auto allocate_buffer(size_t n) -> T* {
+            const size_t bytes = n * sizeof(T);
+            if (this->options_.shared) {
+                if (bytes > this->options_.shared->bytes()) {
+                    throw std::bad_alloc();
+                }
+                const auto& segment = this->options_.shared;
+                if (segment->attach(this->tag_)) {
+                    try {
+                        detail::MemoryAccounting::instance().acquire(segment->bytes(), StorageBackend::Shared,
+                                                                     this->tag_, 0);
+                    } catch (...) {
+                        segment->detach();
+                        throw;
+                    }
+                }
+                segment->retain();
+                return static_cast<T*>(segment->data());
+            }
+#if defined(__linux__)
+            if (bytes >= detail::NUMA_MIN_BYTES) {
+                return static_cast<T*>(detail::map_region(detail::mapping_size(bytes, this->options_), this->options_));
+            }
+#endif
+            void* ptr = ::operator new(bytes, std::align_val_t{std::max(alignof(T), detail::BUFFER_ALIGNMENT)});
+            std::memset(ptr, 0, bytes);
+            return static_cast<T*>(ptr);
+        }
+
+        void deallocate_buffer(T* ptr, size_t n) noexcept {
+            if (this->options_.shared) {
+                const auto& segment = this->options_.shared;
+                if (const auto [last, tag] = segment->detach(); last) {
+                    detail::MemoryAccounting::instance().release(segment->bytes(), StorageBackend::Shared, tag, 0);
+                }
+                segment->release();
+                return;
+            }
+            const size_t bytes = n * sizeof(T);
+#if defined(__linux__)
+            if (bytes >= detail::NUMA_MIN_BYTES) {
+                detail::unmap_region(ptr, detail::mapping_size(bytes, this->options_), this->options_);
+                return;
+            }
+#endif
+            ::operator delete(ptr, std::align_val_t{std::max(alignof(T), detail::BUFFER_ALIGNMENT)});
+        }
+    };
+};  // namespace tt::inline v1
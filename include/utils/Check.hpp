@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdexcept>
+
+// Runtime checks come in two tiers:
+//  - argument checks (operand shapes, view ranges, reshape sizes), done once per operation
+//  - element checks (rank and range of the indices of an element access), done on every access
+//
+// TINYTEN_CHECKS selects which tiers are compiled in:
+//  - TINYTEN_CHECKS_NONE: neither; violating a precondition is undefined behaviour
+//  - TINYTEN_CHECKS_DEBUG (default): argument checks, and element checks unless NDEBUG is defined, so element
+//    access compiles to a bare load in release builds
+//  - TINYTEN_CHECKS_ALWAYS: both, in every build type
+//
+// A failed check throws std::runtime_error. The policy should be the same in every translation unit of a program.
+#define TINYTEN_CHECKS_NONE 0
+#define TINYTEN_CHECKS_DEBUG 1
+#define TINYTEN_CHECKS_ALWAYS 2
+
+#ifndef TINYTEN_CHECKS
+#define TINYTEN_CHECKS TINYTEN_CHECKS_DEBUG
+#endif
+
+#if TINYTEN_CHECKS == TINYTEN_CHECKS_NONE
+#define TINYTEN_CHECK_ARGUMENTS 0
+#define TINYTEN_CHECK_ELEMENTS 0
+#elif TINYTEN_CHECKS == TINYTEN_CHECKS_ALWAYS || !defined(NDEBUG)
+#define TINYTEN_CHECK_ARGUMENTS 1
+#define TINYTEN_CHECK_ELEMENTS 1
+#else
+#define TINYTEN_CHECK_ARGUMENTS 1
+#define TINYTEN_CHECK_ELEMENTS 0
+#endif
+
+// The condition is still compiled when a tier is off, but never evaluated
+#define TINYTEN_CHECK(cond, message)                   \
+    do {                                               \
+        if constexpr (TINYTEN_CHECK_ARGUMENTS) {       \
+            if (!(cond)) [[unlikely]] {                \
+                ::tt::detail::check_failed(message);   \
+            }                                          \
+        }                                              \
+    } while (false)
+
+#define TINYTEN_CHECK_INDEX(cond, message)             \
+    do {                                               \
+        if constexpr (TINYTEN_CHECK_ELEMENTS) {        \
+            if (!(cond)) [[unlikely]] {                \
+                ::tt::detail::check_failed(message);   \
+            }                                          \
+        }                                              \
+    } while (false)
+
+namespace tt::inline v1 {
+    enum class CheckPolicy { None, Debug, Always };
+
+    inline constexpr CheckPolicy check_policy = TINYTEN_CHECKS == TINYTEN_CHECKS_NONE     ? CheckPolicy::None
+                                                : TINYTEN_CHECKS == TINYTEN_CHECKS_ALWAYS ? CheckPolicy::Always
+                                                                                          : CheckPolicy::Debug;
+
+    // Whether each tier is compiled into this translation unit
+    inline constexpr bool checks_arguments = TINYTEN_CHECK_ARGUMENTS;
+    inline constexpr bool checks_elements = TINYTEN_CHECK_ELEMENTS;
+
+    namespace detail {
+        [[noreturn]] inline void check_failed(const char* message) {
+            throw std::runtime_error(message);
+        }
+    }  // namespace detail
+};  // namespace tt::inline v1
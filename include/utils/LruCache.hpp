@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+namespace tt::inline v1 {
+    namespace detail {
+        // Map holding at most `capacity` entries, dropping the least recently used one to make room. Not
+        // synchronized.
+        template <typename K, typename V>
+        class LruCache {
+          public:
+            explicit LruCache(size_t capacity) : capacity_(capacity) {}
+
+            // The value of key, now the most recently used, or nullptr
+            auto find(const K& key) -> V* {
+                auto it = this->index_.find(key);
+                if (it == this->index_.end()) {
+                    return nullptr;
+                }
+                this->order_.splice(this->order_.begin(), this->order_, it->second);
+                return &it->second->second;
+            }
+
+            // Adds a key that is not in the cache
+            auto insert(const K& key, V value) -> V& {
+                this->order_.emplace_front(key, std::move(value));
+                this->index_.emplace(key, this->order_.begin());
+                if (this->order_.size() > this->capacity_) {
+                    this->index_.erase(this->order_.back().first);
+                    this->order_.pop_back();
+                }
+                return this->order_.front().second;
+            }
+
+            [[nodiscard]] auto size() const noexcept -> size_t {
+                return this->order_.size();
+            }
+
+          private:
+            using Order = std::list<std::pair<K, V>>;
+
+            size_t capacity_;
+            Order order_;
+            std::map<K, typename Order::iterator> index_;
+        };
+    }  // namespace detail
+};  // namespace tt::inline v1
@@ -0,0 +1,481 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace tt::inline v1 {
+    // Where a tensor buffer lives: operator new, an anonymous mapping (see StorageOptions) or a shared memory segment
+    enum class StorageBackend { Heap, Mapped, Shared };
+
+    inline constexpr size_t NUM_STORAGE_BACKENDS = 3;
+
+    inline auto backend_name(StorageBackend backend) -> const char* {
+        switch (backend) {
+            case StorageBackend::Heap:
+                return "heap";
+            case StorageBackend::Mapped:
+                return "mapped";
+            case StorageBackend::Shared:
+                return "shared";
+        }
+        return "unknown";
+    }
+
+    // Bytes held by live tensor buffers, the most held at once since the last reset_peak_memory, and the number of
+    // live buffers. Mapped buffers count whole pages. A shared memory segment counts once per mapping in this
+    // process, under the tag of the first buffer placed over it, however many buffers use it. Freed mappings parked
+    // in the region cache are not buffers and are counted separately (see resident_memory).
+    struct MemoryUsage {
+        size_t current = 0;
+        size_t peak = 0;
+        size_t buffers = 0;
+    };
+
+    // Limits on resident tensor memory, the bytes of all live buffers plus those parked in the region cache; 0
+    // disables a limit. An allocation over either limit first empties the region cache. If that is not enough,
+    // on_pressure(current, requested) is called when an allocation takes usage over the soft limit, and when it would
+    // exceed the hard limit, before the allocation is retried once and then fails with MemoryBudgetExceeded. It may
+    // free memory (e.g. drop caches); allocations it makes itself do not call it again.
+    struct MemoryBudget {
+        size_t soft = 0;
+        size_t hard = 0;
+        std::function<void(size_t current, size_t requested)> on_pressure;
+    };
+
+    class MemoryBudgetExceeded : public std::bad_alloc {
+      public:
+        MemoryBudgetExceeded(size_t requested, size_t current, size_t limit)
+            : message_("memory budget exceeded: " + std::to_string(requested) + " bytes requested, " +
+                       std::to_string(current) + " of " + std::to_string(limit) + " in use") {}
+
+        [[nodiscard]] auto what() const noexcept -> const char* override {
+            return this->message_.c_str();
+        }
+
+      private:
+        std::string message_;
+    };
+
+    // A buffer alive when memory_snapshot was taken. shape and site are those of the tensor constructor that
+    // allocated it (empty for buffers allocated otherwise, e.g. by copies). bytes is what the buffer spans; buffers
+    // over one shared memory segment are listed each, though the segment is counted once in MemoryUsage.
+    struct LiveAllocation {
+        const void* ptr = nullptr;
+        size_t bytes = 0;
+        StorageBackend backend = StorageBackend::Heap;
+        std::string tag;
+        size_t element_size = 0;
+        IndexType shape;
+        std::string site;
+    };
+
+    namespace detail {
+        struct MemoryCounter {
+            std::atomic<size_t> current{0};
+            std::atomic<size_t> peak{0};
+            std::atomic<size_t> buffers{0};
+
+            void add(size_t bytes, size_t count = 1) noexcept {
+                const size_t now = this->current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+                this->buffers.fetch_add(count, std::memory_order_relaxed);
+                this->raise_peak(now);
+            }
+
+            void sub(size_t bytes, size_t count = 1) noexcept {
+                this->current.fetch_sub(bytes, std::memory_order_relaxed);
+                this->buffers.fetch_sub(count, std::memory_order_relaxed);
+            }
+
+            void raise_peak(size_t now) noexcept {
+                size_t peak_now = this->peak.load(std::memory_order_relaxed);
+                while (now > peak_now && !this->peak.compare_exchange_weak(peak_now, now, std::memory_order_relaxed)) {
+                }
+            }
+
+            [[nodiscard]] auto usage() const noexcept -> MemoryUsage {
+                return {this->current.load(std::memory_order_relaxed), this->peak.load(std::memory_order_relaxed),
+                        this->buffers.load(std::memory_order_relaxed)};
+            }
+        };
+
+        // Interned and never freed, so allocators can keep a plain pointer
+        struct MemoryTag {
+            std::string name;
+            MemoryCounter counter;
+        };
+
+        inline auto current_memory_tag() -> MemoryTag*& {
+            thread_local MemoryTag* tag = nullptr;
+            return tag;
+        }
+
+        // Process-wide counters per backend and tag, the budget, and (when tracking is on) a registry of live
+        // buffers. Never destroyed, so buffers of static tensors can still be released during program exit.
+        class MemoryAccounting {
+          public:
+            static auto instance() -> MemoryAccounting& {
+                static auto* accounting = new MemoryAccounting();
+                return *accounting;
+            }
+
+            auto tag(const std::string& name) -> MemoryTag* {
+                std::lock_guard lock(this->tags_mutex_);
+                auto& slot = this->tags_[name];
+                if (!slot) {
+                    slot = std::make_unique<MemoryTag>();
+                    slot->name = name;
+                }
+                return slot.get();
+            }
+
+            // Counts `bytes` about to be allocated for `count` buffers (0 for bytes added to an existing one), or
+            // throws MemoryBudgetExceeded. Over a limit, the region cache is emptied before on_pressure is called.
+            void acquire(size_t bytes, StorageBackend backend, MemoryTag* tag, size_t count = 1) {
+                const size_t hard = this->hard_.load(std::memory_order_relaxed);
+                size_t now = this->total_.current.load(std::memory_order_relaxed);
+                bool reclaimed = false;
+                bool relieved = false;
+                for (;;) {
+                    if (hard != 0 && bytes > 0 && now + this->cached() + bytes > hard) {
+                        if (!reclaimed) {
+                            reclaimed = true;
+                            if (this->reclaim()) {
+                                now = this->total_.current.load(std::memory_order_relaxed);
+                                continue;
+                            }
+                        }
+                        if (relieved || !this->pressure(now + this->cached(), bytes)) {
+                            throw MemoryBudgetExceeded(bytes, now + this->cached(), hard);
+                        }
+                        relieved = true;
+                        now = this->total_.current.load(std::memory_order_relaxed);
+                    } else if (this->total_.current.compare_exchange_weak(now, now + bytes,
+                                                                          std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                this->total_.buffers.fetch_add(count, std::memory_order_relaxed);
+                this->total_.raise_peak(now + bytes);
+                this->backends_[static_cast<size_t>(backend)].add(bytes, count);
+                if (tag != nullptr) {
+                    tag->counter.add(bytes, count);
+                }
+                const size_t soft = this->soft_.load(std::memory_order_relaxed);
+                if (soft != 0 && bytes > 0 && now + this->cached() + bytes > soft) {
+                    this->reclaim();
+                    const size_t before = now + this->cached();
+                    if (before <= soft && before + bytes > soft) {
+                        try {
+                            this->pressure(before + bytes, bytes);
+                        } catch (...) {
+                            this->release(bytes, backend, tag, count);
+                            throw;
+                        }
+                    }
+                }
+            }
+
+            void release(size_t bytes, StorageBackend backend, MemoryTag* tag, size_t count = 1) noexcept {
+                this->total_.sub(bytes, count);
+                this->backends_[static_cast<size_t>(backend)].sub(bytes, count);
+                if (tag != nullptr) {
+                    tag->counter.sub(bytes, count);
+                }
+            }
+
+            ////////////////////////////////////////////////////////////////////
+            // Region cache: freed mappings kept for reuse stay resident until the cache lets them go
+            ////////////////////////////////////////////////////////////////////
+            void cache(size_t bytes) noexcept {
+                this->cached_.add(bytes);
+            }
+
+            void uncache(size_t bytes) noexcept {
+                this->cached_.sub(bytes);
+            }
+
+            [[nodiscard]] auto cached() const noexcept -> size_t {
+                return this->cached_.current.load(std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] auto cached_usage() const noexcept -> MemoryUsage {
+                return this->cached_.usage();
+            }
+
+            // Set by the region cache: unmaps every region it holds
+            void set_reclaim(void (*reclaim)()) noexcept {
+                this->reclaim_.store(reclaim, std::memory_order_relaxed);
+            }
+
+            [[nodiscard]] auto usage() const noexcept -> MemoryUsage {
+                return this->total_.usage();
+            }
+
+            [[nodiscard]] auto usage(StorageBackend backend) const noexcept -> MemoryUsage {
+                return this->backends_[static_cast<size_t>(backend)].usage();
+            }
+
+            [[nodiscard]] auto tag_usage() -> std::vector<std::pair<std::string, MemoryUsage>> {
+                std::lock_guard lock(this->tags_mutex_);
+                std::vector<std::pair<std::string, MemoryUsage>> result;
+                for (const auto& [name, tag] : this->tags_) {
+                    result.emplace_back(name, tag->counter.usage());
+                }
+                return result;
+            }
+
+            void reset_peak() {
+                auto reset = [](MemoryCounter& counter) {
+                    counter.peak.store(counter.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                };
+                reset(this->total_);
+                reset(this->cached_);
+                for (auto& counter : this->backends_) {
+                    reset(counter);
+                }
+                std::lock_guard lock(this->tags_mutex_);
+                for (auto& [name, tag] : this->tags_) {
+                    reset(tag->counter);
+                }
+            }
+
+            void set_budget(MemoryBudget budget) {
+                std::lock_guard lock(this->budget_mutex_);
+                this->soft_.store(budget.soft, std::memory_order_relaxed);
+                this->hard_.store(budget.hard, std::memory_order_relaxed);
+                this->budget_ = std::move(budget);
+            }
+
+            [[nodiscard]] auto budget() -> MemoryBudget {
+                std::lock_guard lock(this->budget_mutex_);
+                return this->budget_;
+            }
+
+            ////////////////////////////////////////////////////////////////////
+            // Registry of live buffers
+            ////////////////////////////////////////////////////////////////////
+            [[nodiscard]] auto tracking() const noexcept -> bool {
+                return this->tracking_.load(std::memory_order_relaxed);
+            }
+
+            void set_tracking(bool on) {
+                std::lock_guard lock(this->live_mutex_);
+                this->tracking_.store(on, std::memory_order_relaxed);
+                if (!on) {
+                    this->live_.clear();
+                }
+            }
+
+            void track(const void* ptr, size_t bytes, StorageBackend backend, MemoryTag* tag, size_t element_size) {
+                std::lock_guard lock(this->live_mutex_);
+                if (this->tracking()) {
+                    this->live_.emplace(ptr, LiveAllocation{ptr, bytes, backend, tag != nullptr ? tag->name : "",
+                                                            element_size, {}, {}});
+                }
+            }
+
+            void untrack(const void* ptr) noexcept {
+                std::lock_guard lock(this->live_mutex_);
+                // buffers over one shared segment start at the same address, any of them will do
+                if (auto it = this->live_.find(ptr); it != this->live_.end()) {
+                    this->live_.erase(it);
+                }
+            }
+
+            void annotate(const void* ptr, const IndexType& shape, const std::source_location& site) {
+                std::lock_guard lock(this->live_mutex_);
+                auto [lo, hi] = this->live_.equal_range(ptr);
+                for (auto it = lo; it != hi; ++it) {
+                    if (it->second.site.empty()) {
+                        it->second.shape = shape;
+                        it->second.site = std::string(site.file_name()) + ":" + std::to_string(site.line()) + " (" +
+                                          site.function_name() + ")";
+                        return;
+                    }
+                }
+            }
+
+            // Largest first
+            [[nodiscard]] auto snapshot() -> std::vector<LiveAllocation> {
+                std::vector<LiveAllocation> result;
+                {
+                    std::lock_guard lock(this->live_mutex_);
+                    result.reserve(this->live_.size());
+                    for (const auto& [ptr, allocation] : this->live_) {
+                        result.push_back(allocation);
+                    }
+                }
+                std::stable_sort(result.begin(), result.end(),
+                                 [](const LiveAllocation& a, const LiveAllocation& b) { return a.bytes > b.bytes; });
+                return result;
+            }
+
+          private:
+            MemoryCounter total_;
+            std::array<MemoryCounter, NUM_STORAGE_BACKENDS> backends_;
+            MemoryCounter cached_;
+            std::atomic<void (*)()> reclaim_{nullptr};
+
+            std::mutex tags_mutex_;
+            std::map<std::string, std::unique_ptr<MemoryTag>> tags_;
+
+            std::mutex budget_mutex_;
+            MemoryBudget budget_;
+            std::atomic<size_t> soft_{0};
+            std::atomic<size_t> hard_{0};
+
+            std::mutex live_mutex_;
+            std::atomic<bool> tracking_{false};
+            std::unordered_multimap<const void*, LiveAllocation> live_;
+
+            MemoryAccounting() {
+                const char* env = std::getenv("TINYTEN_TRACK_MEMORY");
+                this->tracking_.store(env != nullptr && env[0] == '1', std::memory_order_relaxed);
+            }
+
+            // Empties the region cache; false if it held nothing
+            auto reclaim() -> bool {
+                void (*reclaim)() = this->reclaim_.load(std::memory_order_relaxed);
+                if (reclaim == nullptr || this->cached() == 0) {
+                    return false;
+                }
+                reclaim();
+                return true;
+            }
+
+            // Calls on_pressure unless this thread is already inside it; false if there is none to call
+            auto pressure(size_t current, size_t requested) -> bool {
+                thread_local bool inside = false;
+                if (inside) {
+                    return false;
+                }
+                std::function<void(size_t, size_t)> callback = this->budget().on_pressure;
+                if (!callback) {
+                    return false;
+                }
+                inside = true;
+                try {
+                    callback(current, requested);
+                } catch (...) {
+                    inside = false;
+                    throw;
+                }
+                inside = false;
+                return true;
+            }
+        };
+    }  // namespace detail
+
+    // Tags the tensor buffers this thread allocates while the scope is open. Nested scopes tag as "outer/inner".
+    class MemoryScope {
+      public:
+        explicit MemoryScope(const std::string& tag) : previous_(detail::current_memory_tag()) {
+            const std::string name = this->previous_ != nullptr ? this->previous_->name + "/" + tag : tag;
+            detail::current_memory_tag() = detail::MemoryAccounting::instance().tag(name);
+        }
+
+        MemoryScope(const MemoryScope&) = delete;
+        auto operator=(const MemoryScope&) -> MemoryScope& = delete;
+
+        ~MemoryScope() {
+            detail::current_memory_tag() = this->previous_;
+        }
+
+      private:
+        detail::MemoryTag* previous_;
+    };
+
+    inline auto memory_usage() -> MemoryUsage {
+        return detail::MemoryAccounting::instance().usage();
+    }
+
+    inline auto memory_usage(StorageBackend backend) -> MemoryUsage {
+        return detail::MemoryAccounting::instance().usage(backend);
+    }
+
+    // Usage of buffers allocated under the scope tagged exactly `tag` (nested scopes are counted separately)
+    inline auto memory_usage(const std::string& tag) -> MemoryUsage {
+        return detail::MemoryAccounting::instance().tag(tag)->counter.usage();
+    }
+
+    // Bytes of live buffers plus the freed mappings parked in the region cache: the tensor memory held resident,
+    // which is what the budget limits
+    inline auto resident_memory() -> size_t {
+        auto& accounting = detail::MemoryAccounting::instance();
+        return accounting.usage().current + accounting.cached();
+    }
+
+    inline void reset_peak_memory() {
+        detail::MemoryAccounting::instance().reset_peak();
+    }
+
+    inline void set_memory_budget(MemoryBudget budget) {
+        detail::MemoryAccounting::instance().set_budget(std::move(budget));
+    }
+
+    inline auto get_memory_budget() -> MemoryBudget {
+        return detail::MemoryAccounting::instance().budget();
+    }
+
+    // Records every live buffer for memory_snapshot, at the cost of a locked map update per allocation. Off by
+    // default; TINYTEN_TRACK_MEMORY=1 turns it on from the start. Buffers allocated while it was off are not listed.
+    inline void set_memory_tracking(bool on) {
+        detail::MemoryAccounting::instance().set_tracking(on);
+    }
+
+    inline auto memory_tracking() -> bool {
+        return detail::MemoryAccounting::instance().tracking();
+    }
+
+    inline auto memory_snapshot() -> std::vector<LiveAllocation> {
+        return detail::MemoryAccounting::instance().snapshot();
+    }
+
+    // Usage per backend, of the region cache and per tag, then the tracked live buffers, largest first
+    inline void dump_memory(std::ostream& out) {
+        auto& accounting = detail::MemoryAccounting::instance();
+        auto line = [&out](const std::string& name, const MemoryUsage& usage) {
+            out << "  " << name << ": " << usage.current << " bytes in " << usage.buffers << " buffers, peak "
+                << usage.peak << "\n";
+        };
+        out << "TinyTen memory\n";
+        line("total", accounting.usage());
+        for (size_t b = 0; b < NUM_STORAGE_BACKENDS; ++b) {
+            line(backend_name(static_cast<StorageBackend>(b)), accounting.usage(static_cast<StorageBackend>(b)));
+        }
+        line("region cache", accounting.cached_usage());
+        for (const auto& [name, usage] : accounting.tag_usage()) {
+            line("tag " + name, usage);
+        }
+        for (const auto& allocation : accounting.snapshot()) {
+            out << "  " << allocation.bytes << " bytes " << backend_name(allocation.backend) << " [";
+            for (size_t d = 0; d < allocation.shape.size(); ++d) {
+                out << (d > 0 ? ", " : "") << allocation.shape[d];
+            }
+            out << "] x" << allocation.element_size;
+            if (!allocation.tag.empty()) {
+                out << " tag " << allocation.tag;
+            }
+            if (!allocation.site.empty()) {
+                out << " at " << allocation.site;
+            }
+            out << "\n";
+        }
+    }
+};  // namespace tt::inline v1
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace tt::inline v1 {
+    // Bounded lock-free queue for many producers and a single consumer (after Vyukov's bounded MPMC queue). Every
+    // cell carries a sequence number telling whether it is free for the producer of a given ticket or holds a value
+    // for the consumer, so a push is one CAS on the enqueue ticket and a pop touches no shared counter at all.
+    template <typename T>
+    class MpscQueue {
+      public:
+        explicit MpscQueue(size_t capacity) : mask_(capacity - 1), cells_(std::make_unique<Cell[]>(capacity)) {
+            if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+                throw std::runtime_error("MpscQueue: capacity must be a power of two");
+            }
+            for (size_t i = 0; i < capacity; ++i) {
+                this->cells_[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscQueue(const MpscQueue&) = delete;
+        auto operator=(const MpscQueue&) -> MpscQueue& = delete;
+
+        // Fails (leaving value untouched) when the queue is full
+        auto try_push(T& value) -> bool {
+            size_t pos = this->enqueue_.load(std::memory_order_relaxed);
+            while (true) {
+                Cell& cell = this->cells_[pos & this->mask_];
+                const size_t seq = cell.seq.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (this->enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        cell.value.emplace(std::move(value));
+                        cell.seq.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = this->enqueue_.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer only
+        auto try_pop() -> std::optional<T> {
+            Cell& cell = this->cells_[this->dequeue_ & this->mask_];
+            if (cell.seq.load(std::memory_order_acquire) != this->dequeue_ + 1) {
+                return std::nullopt;
+            }
+            std::optional<T> value = std::move(cell.value);
+            cell.value.reset();
+            cell.seq.store(this->dequeue_ + this->mask_ + 1, std::memory_order_release);
+            this->dequeue_++;
+            return value;
+        }
+
+        // Consumer only
+        [[nodiscard]] auto empty() const -> bool {
+            return this->cells_[this->dequeue_ & this->mask_].seq.load(std::memory_order_acquire) != this->dequeue_ + 1;
+        }
+
+      private:
+        struct Cell {
+            std::atomic<size_t> seq;
+            std::optional<T> value;
+        };
+
+        const size_t mask_;
+        std::unique_ptr<Cell[]> cells_;
+        alignas(64) std::atomic<size_t> enqueue_{0};
+        alignas(64) size_t dequeue_ = 0;
+    };
+};  // namespace tt::inline v1
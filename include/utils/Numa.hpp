@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace tt::inline v1 {
+    // Where the pages of large tensor buffers are placed. FirstTouch leaves placement to the kernel's default policy,
+    // under which each page lands on the node of the pool thread that zeroes it; Interleave spreads pages round-robin
+    // over all nodes; Bind puts them on `node`.
+    struct NumaPolicy {
+        enum Kind { FirstTouch, Interleave, Bind };
+
+        Kind kind = FirstTouch;
+        int node = 0;
+    };
+
+    namespace detail {
+        inline auto numa_policy_slot() -> std::atomic<NumaPolicy>& {
+            static std::atomic<NumaPolicy> policy{NumaPolicy{}};
+            return policy;
+        }
+
+        // Highest node id listed in a sysfs range list such as "0-1,3"
+        inline auto parse_node_list(const std::string& list) -> int {
+            int max_node = -1;
+            int value = 0;
+            bool in_number = false;
+            for (char c : list) {
+                if (c >= '0' && c <= '9') {
+                    value = value * 10 + (c - '0');
+                    in_number = true;
+                } else {
+                    if (in_number) {
+                        max_node = std::max(max_node, value);
+                    }
+                    value = 0;
+                    in_number = false;
+                }
+            }
+            if (in_number) {
+                max_node = std::max(max_node, value);
+            }
+            return max_node;
+        }
+
+        // CPUs this process may run on, in id order
+        inline auto allowed_cpus() -> const std::vector<int>& {
+            static const std::vector<int> cpus = [] {
+                std::vector<int> result;
+#if defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                        if (CPU_ISSET(cpu, &set)) {
+                            result.push_back(cpu);
+                        }
+                    }
+                }
+#endif
+                return result;
+            }();
+            return cpus;
+        }
+
+        // Pins the calling thread to one CPU so that thread `index` of `count` keeps running next to the pages it
+        // first-touched. Threads are spread evenly over the allowed CPUs, which the kernel numbers node by node.
+        inline auto pin_current_thread(int64_t index, int64_t count) -> bool {
+#if defined(__linux__)
+            const auto& cpus = allowed_cpus();
+            if (cpus.empty() || count <= 0) {
+                return false;
+            }
+            const auto n = static_cast<int64_t>(cpus.size());
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[static_cast<size_t>((index % count) * n / count)], &set);
+            return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+            (void)index;
+            (void)count;
+            return false;
+#endif
+        }
+    }  // namespace detail
+
+    // Number of NUMA nodes, 1 when the machine (or platform) exposes none
+    inline auto numa_num_nodes() -> int {
+        static const int nodes = [] {
+#if defined(__linux__)
+            std::ifstream online("/sys/devices/system/node/online");
+            std::string list;
+            if (online && std::getline(online, list)) {
+                return std::max(detail::parse_node_list(list) + 1, 1);
+            }
+#endif
+            return 1;
+        }();
+        return nodes;
+    }
+
+    inline auto numa_available() -> bool {
+        return numa_num_nodes() > 1;
+    }
+
+    // Policy used by buffers allocated from now on; existing tensors (and copies of them) keep theirs
+    inline void set_numa_policy(NumaPolicy policy) {
+        detail::numa_policy_slot().store(policy);
+    }
+
+    inline auto get_numa_policy() -> NumaPolicy {
+        return detail::numa_policy_slot().load();
+    }
+
+    namespace detail {
+        // Applies an Interleave or Bind policy to a page-aligned range before it is touched. Failures are ignored:
+        // the range then simply keeps the default first-touch placement.
+        inline void numa_bind(void* ptr, size_t bytes, NumaPolicy policy) {
+#if defined(__linux__) && defined(SYS_mbind)
+            if (policy.kind == NumaPolicy::FirstTouch || !numa_available()) {
+                return;
+            }
+            // MPOL_BIND and MPOL_INTERLEAVE from <linux/mempolicy.h>
+            constexpr int mpol_bind = 2;
+            constexpr int mpol_interleave = 3;
+            constexpr size_t bits = 8 * sizeof(unsigned long);
+            const int nodes = numa_num_nodes();
+            std::vector<unsigned long> mask((static_cast<size_t>(nodes) + bits - 1) / bits);
+            auto set_node = [&mask](int node) { mask[node / bits] |= 1UL << (node % bits); };
+            if (policy.kind == NumaPolicy::Bind) {
+                if (policy.node < 0 || policy.node >= nodes) {
+                    return;
+                }
+                set_node(policy.node);
+            } else {
+                for (int node = 0; node < nodes; ++node) {
+                    set_node(node);
+                }
+            }
+            const int mode = policy.kind == NumaPolicy::Bind ? mpol_bind : mpol_interleave;
+            syscall(SYS_mbind, ptr, bytes, mode, mask.data(), static_cast<unsigned long>(nodes) + 1, 0);
+#else
+            (void)ptr;
+            (void)bytes;
+            (void)policy;
+#endif
+        }
+    }  // namespace detail
+};  // namespace tt::inline v1
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace tt::inline v1 {
+    // Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3"). A stateless bijection from a
+    // 128-bit counter and a 64-bit key to 128 random bits, so any block of the stream can be computed independently.
+    struct Philox4x32 {
+        using Counter = std::array<uint32_t, 4>;
+        using Key = std::array<uint32_t, 2>;
+
+        static constexpr uint32_t M0 = 0xD2511F53;
+        static constexpr uint32_t M1 = 0xCD9E8D57;
+        static constexpr uint32_t W0 = 0x9E3779B9;
+        static constexpr uint32_t W1 = 0xBB67AE85;
+        static constexpr int ROUNDS = 10;
+
+        static constexpr auto round(Counter ctr, Key key) -> Counter {
+            const uint64_t p0 = static_cast<uint64_t>(M0) * ctr[0];
+            const uint64_t p1 = static_cast<uint64_t>(M1) * ctr[2];
+            return {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(p1),
+                    static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(p0)};
+        }
+
+        static constexpr auto generate(Counter ctr, Key key) -> Counter {
+            for (int r = 0; r < ROUNDS; ++r) {
+                if (r > 0) {
+                    key[0] += W0;
+                    key[1] += W1;
+                }
+                ctr = round(ctr, key);
+            }
+            return ctr;
+        }
+
+        // Blocks `first`, `first + 1`, ... of the stream selected by key, written lane-major into out[lane][i].
+        // The loop body is branch-free over the block index, which lets the compiler vectorize it across blocks.
+        template <int N>
+        static void generate_blocks(uint64_t first, uint64_t stream, Key key, uint32_t (&out)[4][N]) {
+            uint32_t c0[N], c1[N], c2[N], c3[N];
+            for (int i = 0; i < N; ++i) {
+                const uint64_t block = first + static_cast<uint64_t>(i);
+                c0[i] = static_cast<uint32_t>(block);
+                c1[i] = static_cast<uint32_t>(block >> 32);
+                c2[i] = static_cast<uint32_t>(stream);
+                c3[i] = static_cast<uint32_t>(stream >> 32);
+            }
+            for (int r = 0; r < ROUNDS; ++r) {
+                const uint32_t k0 = key[0] + static_cast<uint32_t>(r) * W0;
+                const uint32_t k1 = key[1] + static_cast<uint32_t>(r) * W1;
+                for (int i = 0; i < N; ++i) {
+                    const uint64_t p0 = static_cast<uint64_t>(M0) * c0[i];
+                    const uint64_t p1 = static_cast<uint64_t>(M1) * c2[i];
+                    const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[i] ^ k0;
+                    const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[i] ^ k1;
+                    c1[i] = static_cast<uint32_t>(p1);
+                    c3[i] = static_cast<uint32_t>(p0);
+                    c0[i] = n0;
+                    c2[i] = n2;
+                }
+            }
+            for (int i = 0; i < N; ++i) {
+                out[0][i] = c0[i];
+                out[1][i] = c1[i];
+                out[2][i] = c2[i];
+                out[3][i] = c3[i];
+            }
+        }
+    };
+};  // namespace tt::inline v1
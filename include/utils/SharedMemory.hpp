@@ -0,0 +1,183 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tt::inline v1 {
+    namespace detail {
+        struct MemoryTag;
+
+        // A POSIX shared memory segment mapped into this process. The segment starts with a header holding a
+        // reference count shared by every process that uses it: each tensor buffer over the segment, each handle in
+        // flight and each pool slot holds one reference, and the name is unlinked when the last one is released. The
+        // mapping itself lives as long as this object. A process that dies holding references leaves the segment in
+        // /dev/shm.
+        class SharedSegment {
+          public:
+            static constexpr size_t HEADER_BYTES = 64;
+
+            SharedSegment(const SharedSegment&) = delete;
+            auto operator=(const SharedSegment&) -> SharedSegment& = delete;
+
+            // A new segment of `bytes` data bytes, zero-filled, with one reference held by the caller
+            static auto create(const std::string& name, size_t bytes) -> std::shared_ptr<SharedSegment> {
+#if defined(__linux__)
+                const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+                if (fd < 0) {
+                    throw std::runtime_error("shared memory: cannot create " + name);
+                }
+                const size_t mapped = HEADER_BYTES + bytes;
+                if (ftruncate(fd, static_cast<off_t>(mapped)) != 0) {
+                    close(fd);
+                    shm_unlink(name.c_str());
+                    throw std::runtime_error("shared memory: cannot size " + name);
+                }
+                auto segment = SharedSegment::map(name, fd, mapped);
+                auto* header = segment->header();
+                header->bytes = bytes;
+                header->refs.store(1, std::memory_order_relaxed);
+                header->magic.store(MAGIC, std::memory_order_release);
+                return segment;
+#else
+                (void)bytes;
+                throw std::runtime_error("shared memory: not supported on this platform (" + name + ")");
+#endif
+            }
+
+            // Maps an existing segment without taking a reference
+            static auto open(const std::string& name) -> std::shared_ptr<SharedSegment> {
+#if defined(__linux__)
+                const int fd = shm_open(name.c_str(), O_RDWR, 0);
+                if (fd < 0) {
+                    throw std::runtime_error("shared memory: cannot open " + name);
+                }
+                struct stat st {};
+                if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_BYTES) {
+                    close(fd);
+                    throw std::runtime_error("shared memory: " + name + " is not a tensor segment");
+                }
+                auto segment = SharedSegment::map(name, fd, static_cast<size_t>(st.st_size));
+                if (segment->header()->magic.load(std::memory_order_acquire) != MAGIC ||
+                    HEADER_BYTES + segment->bytes() > segment->mapped_) {
+                    throw std::runtime_error("shared memory: " + name + " is not a tensor segment");
+                }
+                return segment;
+#else
+                throw std::runtime_error("shared memory: not supported on this platform (" + name + ")");
+#endif
+            }
+
+            ~SharedSegment() {
+#if defined(__linux__)
+                munmap(this->base_, this->mapped_);
+#endif
+            }
+
+            [[nodiscard]] auto name() const noexcept -> const std::string& {
+                return this->name_;
+            }
+
+            [[nodiscard]] auto data() const noexcept -> void* {
+                return static_cast<unsigned char*>(this->base_) + HEADER_BYTES;
+            }
+
+            [[nodiscard]] auto bytes() const noexcept -> size_t {
+                return this->header()->bytes;
+            }
+
+            [[nodiscard]] auto refs() const noexcept -> int64_t {
+                return this->header()->refs.load(std::memory_order_acquire);
+            }
+
+            void retain() noexcept {
+                this->header()->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void release() noexcept {
+                if (this->header()->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+#if defined(__linux__)
+                    shm_unlink(this->name_.c_str());
+#endif
+                }
+            }
+
+            // Tensor buffers of this process over the mapping. The memory accounting charges the segment once,
+            // under the tag of the first buffer attached, and releases it when the last one detaches.
+            auto attach(MemoryTag* tag) -> bool {
+                std::lock_guard lock(this->attach_mutex_);
+                if (this->attached_++ == 0) {
+                    this->charged_tag_ = tag;
+                    return true;
+                }
+                return false;
+            }
+
+            // Whether this was the last buffer, and the tag the segment was charged under
+            auto detach() -> std::pair<bool, MemoryTag*> {
+                std::lock_guard lock(this->attach_mutex_);
+                return {--this->attached_ == 0, this->charged_tag_};
+            }
+
+          private:
+            static constexpr uint64_t MAGIC = 0x74696e7974656e31;  // "tinyten1"
+
+            // Shared between processes, so only address-free (lock-free) atomics
+            struct Header {
+                std::atomic<uint64_t> magic;
+                std::atomic<int64_t> refs;
+                size_t bytes;
+            };
+            static_assert(sizeof(Header) <= HEADER_BYTES && std::atomic<int64_t>::is_always_lock_free);
+
+            std::string name_;
+            void* base_ = nullptr;
+            size_t mapped_ = 0;
+            std::mutex attach_mutex_;
+            int64_t attached_ = 0;
+            MemoryTag* charged_tag_ = nullptr;
+
+            SharedSegment(std::string name, void* base, size_t mapped)
+                : name_(std::move(name)), base_(base), mapped_(mapped) {}
+
+            [[nodiscard]] auto header() const noexcept -> Header* {
+                return static_cast<Header*>(this->base_);
+            }
+
+#if defined(__linux__)
+            // Maps and closes fd
+            static auto map(const std::string& name, int fd, size_t mapped) -> std::shared_ptr<SharedSegment> {
+                void* base = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd);
+                if (base == MAP_FAILED) {
+                    throw std::runtime_error("shared memory: cannot map " + name);
+                }
+                return std::shared_ptr<SharedSegment>(new SharedSegment(name, base, mapped));
+            }
+#endif
+        };
+
+        // A name unique to this process, e.g. /tinyten-1234-7
+        inline auto unique_segment_name(const std::string& prefix = "/tinyten") -> std::string {
+            static std::atomic<uint64_t> counter{0};
+#if defined(__linux__)
+            const auto pid = static_cast<uint64_t>(getpid());
+#else
+            const uint64_t pid = 0;
+#endif
+            return prefix + "-" + std::to_string(pid) + "-" + std::to_string(counter.fetch_add(1));
+        }
+    }  // namespace detail
+};  // namespace tt::inline v1
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdlib>
 #include <iterator>
 #include <utility>
+#include <vector>
 
 #include "utils.hpp"
 
@@ -20,7 +22,18 @@ struct StridedIterImpl {
           loc(loc),
           m_strides(strides),
           m_canon_strides(canon_strides),
-          m_is_contiguous(canon_strides == strides) {}
+          m_is_contiguous(canon_strides == strides) {
+        if (!this->m_is_contiguous) {
+            this->m_index.resize(strides.size());
+            // an empty tensor (canonical stride 0) is never dereferenced
+            for (size_t i = 0; i < strides.size() && canon_strides[i] != 0; ++i) {
+                auto [quot, rem] = std::div(loc, canon_strides[i]);
+                this->m_index[i] = quot;
+                this->m_offset += quot * strides[i];
+                loc = rem;
+            }
+        }
+    }
 
     auto operator*() const -> reference {
         return *this->_get_loc();
@@ -30,9 +43,21 @@ struct StridedIterImpl {
         return this->_get_loc();
     }
 
-    // Prefix increment
+    // Prefix increment. A strided layout (permuted, flipped, broadcast or overlapping) is walked like an odometer,
+    // so every step costs one stride addition in the common case instead of a division per dim.
     auto operator++() -> StridedIterImpl& {
         this->loc++;
+        if (!this->m_is_contiguous) {
+            for (auto d = static_cast<int64_t>(this->m_index.size()) - 1; d >= 0; --d) {
+                this->m_offset += this->m_strides[d];
+                // index < shape[d], with shape[d] = canon_strides[d - 1] / canon_strides[d]
+                if (d == 0 || ++this->m_index[d] * this->m_canon_strides[d] < this->m_canon_strides[d - 1]) {
+                    break;
+                }
+                this->m_offset -= this->m_strides[d] * this->m_index[d];
+                this->m_index[d] = 0;
+            }
+        }
         return *this;
     }
 
@@ -56,13 +81,17 @@ struct StridedIterImpl {
         if (this->m_is_contiguous) {
             return this->m_ptr_base + this->loc;
         } else {
-            return m_ptr_base + tt::ravel_unravel(this->loc, this->m_strides, this->m_canon_strides);
+            return this->m_ptr_base + this->m_offset;
         }
     }
 
     int64_t loc;
     const pointer m_ptr_base;
 
+    // Position of a strided iterator: its multi-index and the matching element offset
+    std::vector<int64_t> m_index;
+    int64_t m_offset = 0;
+
     const std::vector<int64_t>& m_strides;
     const std::vector<int64_t>& m_canon_strides;
 
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Numa.hpp"
+
+namespace tt::inline v1 {
+    // Fixed-size pool with static work assignment: in a run of `chunks` chunks, thread t (the caller being thread 0)
+    // always executes chunks t, t + size(), t + 2 * size(), ... so the same chunk of a buffer is always touched by
+    // the same thread from one parallel region to the next. With pinning, each worker is also bound to one CPU, so
+    // buffer pages first-touched by a chunk stay local to the thread that keeps processing that chunk.
+    class ThreadPool {
+      public:
+        explicit ThreadPool(int64_t num_threads, bool pin_threads = false)
+            : num_threads_(std::max<int64_t>(num_threads, 1)), pin_threads_(pin_threads) {
+            for (int64_t t = 1; t < this->num_threads_; ++t) {
+                this->workers_.emplace_back([this, t] { this->worker(t); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard lock(this->mutex_);
+                this->stop_ = true;
+            }
+            this->start_cv_.notify_all();
+            for (auto& worker : this->workers_) {
+                worker.join();
+            }
+        }
+
+        [[nodiscard]] auto size() const noexcept -> int64_t {
+            return this->num_threads_;
+        }
+
+        [[nodiscard]] auto pinned() const noexcept -> bool {
+            return this->pin_threads_;
+        }
+
+        // Calls f(chunk) for every chunk in [0, chunks) and blocks until all have finished. Runs inline when called
+        // from inside a parallel region or while another thread is using the pool.
+        template <typename F>
+        void run(int64_t chunks, F&& f) {
+            std::unique_lock run_lock(this->run_mutex_, std::try_to_lock);
+            if (chunks <= 1 || this->num_threads_ == 1 || in_parallel_region() || !run_lock.owns_lock()) {
+                for (int64_t c = 0; c < chunks; ++c) {
+                    f(c);
+                }
+                return;
+            }
+
+            {
+                std::lock_guard lock(this->mutex_);
+                this->job_ctx_ = &f;
+                this->job_call_ = [](void* ctx, int64_t chunk) {
+                    (*static_cast<std::remove_reference_t<F>*>(ctx))(chunk);
+                };
+                this->chunks_ = chunks;
+                this->remaining_ = static_cast<int64_t>(this->workers_.size());
+                this->error_ = nullptr;
+                this->generation_++;
+            }
+            this->start_cv_.notify_all();
+
+            in_parallel_region() = true;
+            this->execute(0);
+            in_parallel_region() = false;
+
+            std::unique_lock lock(this->mutex_);
+            this->done_cv_.wait(lock, [this] { return this->remaining_ == 0; });
+            if (this->error_) {
+                std::rethrow_exception(std::exchange(this->error_, nullptr));
+            }
+        }
+
+        static auto in_parallel_region() -> bool& {
+            thread_local bool active = false;
+            return active;
+        }
+
+      private:
+        const int64_t num_threads_;
+        const bool pin_threads_;
+        std::vector<std::thread> workers_;
+
+        std::mutex run_mutex_;
+        std::mutex mutex_;
+        std::condition_variable start_cv_;
+        std::condition_variable done_cv_;
+
+        void* job_ctx_ = nullptr;
+        void (*job_call_)(void*, int64_t) = nullptr;
+        int64_t chunks_ = 0;
+        int64_t remaining_ = 0;
+        uint64_t generation_ = 0;
+        bool stop_ = false;
+        std::exception_ptr error_;
+
+        void execute(int64_t thread) {
+            for (int64_t c = thread; c < this->chunks_; c += this->num_threads_) {
+                try {
+                    this->job_call_(this->job_ctx_, c);
+                } catch (...) {
+                    std::lock_guard lock(this->mutex_);
+                    if (!this->error_) {
+                        this->error_ = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        void worker(int64_t thread) {
+            if (this->pin_threads_) {
+                detail::pin_current_thread(thread, this->num_threads_);
+            }
+            in_parallel_region() = true;
+            uint64_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock lock(this->mutex_);
+                    this->start_cv_.wait(lock, [&] { return this->stop_ || this->generation_ != seen; });
+                    if (this->stop_) {
+                        return;
+                    }
+                    seen = this->generation_;
+                }
+
+                this->execute(thread);
+
+                std::lock_guard lock(this->mutex_);
+                if (--this->remaining_ == 0) {
+                    this->done_cv_.notify_one();
+                }
+            }
+        }
+    };
+
+    namespace detail {
+        inline auto default_num_threads() -> int64_t {
+            if (const char* env = std::getenv("TINYTEN_NUM_THREADS")) {
+                if (int64_t n = std::atoll(env); n > 0) {
+                    return n;
+                }
+            }
+            return std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        inline auto default_pin_threads() -> bool {
+            const char* env = std::getenv("TINYTEN_PIN_THREADS");
+            return env != nullptr && std::atoi(env) != 0;
+        }
+
+        inline auto pool_slot() -> std::unique_ptr<ThreadPool>& {
+            static std::unique_ptr<ThreadPool> pool =
+                std::make_unique<ThreadPool>(default_num_threads(), default_pin_threads());
+            return pool;
+        }
+    }  // namespace detail
+
+    inline auto thread_pool() -> ThreadPool& {
+        return *detail::pool_slot();
+    }
+
+    inline auto get_num_threads() -> int64_t {
+        return thread_pool().size();
+    }
+
+    // Replaces the global pool. Must not be called while a parallel region is running.
+    inline void set_num_threads(int64_t num_threads) {
+        auto& pool = detail::pool_slot();
+        if (pool->size() != num_threads) {
+            const bool pinned = pool->pinned();
+            pool.reset();
+            pool = std::make_unique<ThreadPool>(num_threads, pinned);
+        }
+    }
+
+    // Pins (or unpins) the pool's worker threads, one CPU each; the calling thread, which runs chunk 0, is left
+    // alone. Also settable with TINYTEN_PIN_THREADS=1. Must not be called while a parallel region is running.
+    inline void set_thread_pinning(bool pin) {
+        auto& pool = detail::pool_slot();
+        if (pool->pinned() != pin) {
+            const int64_t num_threads = pool->size();
+            pool.reset();
+            pool = std::make_unique<ThreadPool>(num_threads, pin);
+        }
+    }
+
+    // [lo, hi) bounds of chunk `chunk` when [0, n) is split into `chunks` near-equal parts
+    constexpr auto chunk_range(int64_t n, int64_t chunks, int64_t chunk) -> std::pair<int64_t, int64_t> {
+        return {n * chunk / chunks, n * (chunk + 1) / chunks};
+    }
+
+    // Calls f(lo, hi) over disjoint subranges covering [begin, end). Ranges no longer than `grain` run inline;
+    // otherwise the range is split into at most one chunk per pool thread.
+    template <typename F>
+    void parallel_for(int64_t begin, int64_t end, int64_t grain, F&& f) {
+        const int64_t n = end - begin;
+        if (n <= 0) {
+            return;
+        }
+        grain = std::max<int64_t>(grain, 1);
+        if (n <= grain || ThreadPool::in_parallel_region()) {
+            f(begin, end);
+            return;
+        }
+
+        auto& pool = thread_pool();
+        const int64_t chunks = std::min(pool.size(), (n + grain - 1) / grain);
+        pool.run(chunks, [&](int64_t chunk) {
+            auto [lo, hi] = chunk_range(n, chunks, chunk);
+            if (lo < hi) {
+                f(begin + lo, begin + hi);
+            }
+        });
+    }
+
+    // Calls f(lo, hi) over blocks of the rows [0, rows) of an offsets array (row i owns [offsets[i], offsets[i + 1])),
+    // in parallel. Blocks hold roughly equal numbers of elements plus rows, so a few long rows do not serialize the
+    // work the way an even split of the rows would.
+    template <typename F>
+    void parallel_for_segments(const int64_t* offsets, int64_t rows, F&& f) {
+        if (rows <= 0) {
+            return;
+        }
+        const int64_t work = offsets[rows] - offsets[0] + rows;
+        if (work < (1 << 14) || ThreadPool::in_parallel_region()) {
+            f(int64_t{0}, rows);
+            return;
+        }
+
+        auto& pool = thread_pool();
+        const int64_t chunks = pool.size();
+        // first row whose (elements + rows) prefix reaches the chunk boundary
+        auto boundary = [&](int64_t c) -> int64_t {
+            const int64_t target = work * c / chunks;
+            int64_t lo = 0;
+            int64_t hi = rows;
+            while (lo < hi) {
+                const int64_t mid = (lo + hi) / 2;
+                if (offsets[mid] - offsets[0] + mid < target) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo;
+        };
+        pool.run(chunks, [&](int64_t c) {
+            const int64_t lo = boundary(c);
+            const int64_t hi = c + 1 == chunks ? rows : boundary(c + 1);
+            if (lo < hi) {
+                f(lo, hi);
+            }
+        });
+    }
+};  // namespace tt::inline v1
@@ -39,7 +39,7 @@ namespace tt::inline v1 {
         return idx;
     }
 
-    static auto calc_strides(const std::vector<int64_t>& shape) -> std::vector<int64_t> {
+    static constexpr inline auto calc_strides(const std::vector<int64_t>& shape) -> std::vector<int64_t> {
         std::vector<int64_t> strides(shape.size(), 1);
         auto N = static_cast<int64_t>(shape.size());
         for (int64_t i = N - 2; i >= 0; --i) {
@@ -58,7 +58,8 @@ namespace tt::inline v1 {
                                      std::plus<>(), std::multiplies<>());
     }
 
-    static inline auto unravel_index(int64_t flat_index, const std::vector<int64_t>& strides) -> std::vector<int64_t> {
+    static constexpr inline auto unravel_index(int64_t flat_index, const std::vector<int64_t>& strides)
+        -> std::vector<int64_t> {
         std::vector<int64_t> idx(strides.size());
         std::transform(
             strides.begin(), strides.end(), idx.begin(), [&flat_index](int64_t stride) constexpr {
@@ -69,4 +70,34 @@ namespace tt::inline v1 {
         return idx;
     }
 
+    // Base offsets of every 1-D lane along `dim`, in row-major order of the remaining dimensions
+    static inline auto lane_offsets(const std::vector<int64_t>& shape, const std::vector<int64_t>& strides,
+                                    int64_t dim) -> std::vector<int64_t> {
+        std::vector<int64_t> outer_shape;
+        std::vector<int64_t> outer_strides;
+        for (size_t i = 0; i < shape.size(); ++i) {
+            if (static_cast<int64_t>(i) != dim) {
+                outer_shape.push_back(shape[i]);
+                outer_strides.push_back(strides[i]);
+            }
+        }
+
+        int64_t n = std::reduce(outer_shape.begin(), outer_shape.end(), int64_t{1}, std::multiplies<>());
+        std::vector<int64_t> offsets(n);
+        std::vector<int64_t> idx(outer_shape.size(), 0);
+        int64_t offset = 0;
+        for (int64_t k = 0; k < n; ++k) {
+            offsets[k] = offset;
+            for (auto j = static_cast<int64_t>(outer_shape.size()) - 1; j >= 0; --j) {
+                offset += outer_strides[j];
+                if (++idx[j] < outer_shape[j]) {
+                    break;
+                }
+                offset -= outer_strides[j] * outer_shape[j];
+                idx[j] = 0;
+            }
+        }
+        return offsets;
+    }
+
 }  // namespace tt::inline v1
\ No newline at end of file
@@ -2,10 +2,23 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_floating_point.hpp>
 #include <cstdint>
+#include <filesystem>
 #include <iostream>
+#include <optional>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+#if defined(__linux__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include "TinyTensor.hpp"
+#include "async.hpp"
+#include "autograd.hpp"
+#include "batching.hpp"
+#include "shared_tensor.hpp"
 #include "test_utils.hpp"
 
 using namespace tt;
@@ -218,6 +231,99 @@ TEST_CASE("Division", "[Tensor]") {
     REQUIRE(ten4(1, 2) == 1.0f / 3.0f);
 }
 
+TEST_CASE("Mixed dtypes", "[Tensor]") {
+    Tensor<int> ints = Tensor<int>::iota({2, 3}, 1);
+    Tensor<float> floats({2, 3}, 0.5f);
+
+    SECTION("Tensor and tensor") {
+        auto sum = ints + floats;
+        STATIC_REQUIRE(std::is_same_v<decltype(sum), Tensor<float>>);
+        REQUIRE(sum(1, 2) == 6.5f);
+
+        auto quot = floats / ints;
+        REQUIRE(quot(0, 1) == 0.25f);
+
+        auto wide = Tensor<int64_t>({2, 3}, 1) - ints;
+        STATIC_REQUIRE(std::is_same_v<decltype(wide), Tensor<int64_t>>);
+        REQUIRE(wide(1, 0) == -3);
+
+        // strided operands take the same path through iterators
+        auto prod = ints.permute({1, 0}) * Tensor<double>({3, 2}, 2.0);
+        STATIC_REQUIRE(std::is_same_v<decltype(prod), Tensor<double>>);
+        REQUIRE(prod(2, 0) == 6.0);
+        REQUIRE(prod(0, 1) == 8.0);
+
+        REQUIRE_THROWS(ints + Tensor<float>({3, 2}));
+    }
+
+    SECTION("Tensor and scalar") {
+        auto halves = floats * 2.0;
+        STATIC_REQUIRE(std::is_same_v<decltype(halves), Tensor<float>>);
+        REQUIRE(halves(0, 0) == 1.0f);
+
+        auto scaled = ints * 0.5;
+        STATIC_REQUIRE(std::is_same_v<decltype(scaled), Tensor<double>>);
+        REQUIRE(scaled(1, 2) == 3.0);
+
+        auto rev = 10 - ints;
+        REQUIRE(rev(0, 0) == 9);
+        REQUIRE((12 / ints)(1, 2) == 2);
+    }
+
+    SECTION("Compound assignment") {
+        ints += floats;  // computed in float, stored as int
+        REQUIRE(ints(0, 0) == 1);
+        floats *= ints;
+        REQUIRE(floats(1, 2) == 3.0f);
+        ints -= 1;
+        REQUIRE(ints(1, 2) == 5);
+        floats /= 2;
+        REQUIRE(floats(1, 2) == 1.5f);
+    }
+}
+
+TEST_CASE("DynTensor", "[Tensor]") {
+    SECTION("Runtime dtype") {
+        DynTensor ten(DType::Int16, {2, 3});
+        REQUIRE(ten.dtype() == DType::Int16);
+        REQUIRE(ten.element_size() == 2);
+        REQUIRE(ten.nbytes() == 12);
+        REQUIRE(std::string(dtype_name(ten.dtype())) == "int16");
+
+        // as<T> is a view of the same buffer
+        auto typed = ten.as<int16_t>();
+        typed(1, 2) = 7;
+        REQUIRE(static_cast<const int16_t*>(ten.data())[5] == 7);
+        REQUIRE(ten.shares_storage(DynTensor(typed.view())));
+        REQUIRE_THROWS(ten.as<float>());
+
+        auto as_double = ten.to(DType::Float64);
+        REQUIRE(as_double.is<double>());
+        REQUIRE(as_double.as<double>()(1, 2) == 7.0);
+        REQUIRE(!as_double.shares_storage(ten));
+    }
+
+    SECTION("Dispatch") {
+        DynTensor a = Tensor<int>::iota({2, 2}, 1);
+        DynTensor b = Tensor<float>({2, 2}, 0.5f);
+        auto sum = a + b;
+        REQUIRE(sum.dtype() == DType::Float32);
+        REQUIRE(sum.as<float>()(1, 1) == 4.5f);
+        REQUIRE((a * 2).dtype() == DType::Int32);
+        REQUIRE((a / 2.0).as<double>()(0, 1) == 1.0);
+
+        auto bytes = DynTensor(DType::UInt8, {4}) + DynTensor(DType::UInt8, {4});
+        REQUIRE(bytes.dtype() == DType::UInt8);
+
+        auto col = a.permute({1, 0}).select(1, 1);
+        REQUIRE(col.as<int>()(1) == 4);
+        REQUIRE(a.reshape({4}).shape() == IndexType{4});
+
+        auto largest = a.visit([](const auto& t) { return static_cast<double>(t.max()); });
+        REQUIRE(largest == 4.0);
+    }
+}
+
 TEST_CASE("ShapeIter", "[Tensor]") {
     Tensor<int> ten({1, 3, 4});
 
@@ -406,6 +512,75 @@ TEST_CASE("Strided-Indexing", "[Tensor]") {
     }
 }
 
+TEST_CASE("Strided views", "[Tensor]") {
+    auto ten = Tensor<int>::iota({3, 4});
+
+    SECTION("flip") {
+        auto f = ten.flip({1});
+        REQUIRE(f.shares_storage(ten));
+        REQUIRE(f.stride(1) == -1);
+        REQUIRE(f(0, 0) == 3);
+        REQUIRE(f(2, 3) == 8);
+        auto both = ten.flip({0, 1});
+        REQUIRE(std::vector<int>(both.begin(), both.end()) == std::vector<int>{11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0});
+        REQUIRE(both.flat(1) == 10);
+        REQUIRE(both.sum(1)(0) == 11 + 10 + 9 + 8);
+        auto copy = both.contiguous();
+        REQUIRE(copy._is_contiguous());
+        REQUIRE(copy(0, 0) == 11);
+        f(0, 0) = 100;
+        REQUIRE(ten(0, 3) == 100);
+        REQUIRE_THROWS(ten.flip({2}));
+        REQUIRE_THROWS(ten.flip({0, 0}));
+    }
+
+    SECTION("diagonal") {
+        auto d = ten.diagonal();
+        REQUIRE(d.shape() == IndexType{3});
+        REQUIRE(std::vector<int>(d.begin(), d.end()) == std::vector<int>{0, 5, 10});
+        REQUIRE(ten.diagonal(1)(2) == 11);
+        REQUIRE(ten.diagonal(-1).shape() == IndexType{2});
+        REQUIRE(ten.diagonal(-1)(1) == 9);
+        REQUIRE(ten.diagonal(5).numel() == 0);
+        auto batched = Tensor<int>::iota({2, 3, 3}).diagonal(0, 1, 2);
+        REQUIRE(batched.shape() == IndexType{2, 3});
+        REQUIRE(batched(1, 2) == 9 + 8);
+        d(1) = -1;
+        REQUIRE(ten(1, 1) == -1);
+    }
+
+    SECTION("unfold") {
+        auto signal = Tensor<int>::iota({10});
+        auto windows = signal.unfold(0, 4, 2);
+        REQUIRE(windows.shape() == IndexType{4, 4});
+        REQUIRE(windows(0, 3) == 3);
+        REQUIRE(windows(3, 0) == 6);
+        REQUIRE(windows(3, 3) == 9);
+        REQUIRE(windows.shares_storage(signal));
+        // the windows overlap, so their sums read elements more than once
+        REQUIRE(windows.sum(1)(1) == 2 + 3 + 4 + 5);
+        REQUIRE(ten.unfold(1, 2, 1).shape() == IndexType{3, 3, 2});
+        REQUIRE(ten.unfold(1, 2, 1)(2, 1, 1) == 10);
+        REQUIRE_THROWS(signal.unfold(0, 11, 1));
+    }
+
+    SECTION("as_strided") {
+        // a broadcast row: every row reads the same four elements
+        auto rows = ten.as_strided({5, 4}, {0, 1});
+        REQUIRE(rows(4, 2) == 2);
+        auto copy = Tensor<int>(rows);
+        REQUIRE(copy._is_contiguous());
+        copy(0, 2) = 7;
+        REQUIRE(copy(1, 2) == 2);
+        auto reversed = ten.as_strided({12}, {-1}, 11);
+        REQUIRE(reversed(0) == 11);
+        REQUIRE(reversed(11) == 0);
+        REQUIRE_THROWS(ten.as_strided({13}, {1}));
+        REQUIRE_THROWS(ten.as_strided({2}, {-1}));
+        REQUIRE_THROWS(ten.as_strided({2, 2}, {1}));
+    }
+}
+
 TEST_CASE("Benchmark Iter", "[Tensor]") {
     auto ten = Tensor<uint32_t>({100, 100, 100});
 
@@ -489,4 +664,2021 @@ TEST_CASE("Data iterators2", "[Tensor]") {
     BENCHMARK("Iter sum, strided") {
         auto sum = tena + tenb;
     };
-}
\ No newline at end of file
+}
+
+TEST_CASE("Reductions", "[Tensor]") {
+    auto ten = Tensor<float>::iota({2, 3});
+
+    REQUIRE(ten.sum() == 15.0f);
+    REQUIRE(ten.mean() == 2.5f);
+    REQUIRE(ten.max() == 5.0f);
+    REQUIRE(ten.min() == 0.0f);
+
+    auto rows = ten.sum(1);
+    REQUIRE(rows.shape() == IndexType{2});
+    REQUIRE(rows(0) == 3.0f);
+    REQUIRE(rows(1) == 12.0f);
+
+    auto cols = ten.max(0);
+    REQUIRE(cols.shape() == IndexType{3});
+    REQUIRE(cols(0) == 3.0f);
+    REQUIRE(cols(2) == 5.0f);
+
+    // reductions follow the strides of permuted tensors
+    auto perm = ten.permute({1, 0});
+    auto perm_rows = perm.mean(1);
+    REQUIRE(perm_rows(0) == 1.5f);
+    REQUIRE(perm_rows(2) == 3.5f);
+
+    REQUIRE_THROWS(ten.sum(2));
+}
+
+TEST_CASE("Matmul", "[Tensor]") {
+    auto a = Tensor<int>::iota({2, 3});
+    auto b = Tensor<int>::iota({3, 2});
+
+    auto c = matmul(a, b);
+    REQUIRE(c.shape() == IndexType{2, 2});
+    REQUIRE(c(0, 0) == 10);
+    REQUIRE(c(0, 1) == 13);
+    REQUIRE(c(1, 0) == 28);
+    REQUIRE(c(1, 1) == 40);
+
+    // a * a^T through a permuted (strided) operand
+    auto d = matmul(a, a.permute({1, 0}));
+    REQUIRE(d(0, 0) == 5);
+    REQUIRE(d(0, 1) == 14);
+    REQUIRE(d(1, 1) == 50);
+
+    REQUIRE_THROWS(matmul(a, a));
+}
+
+TEST_CASE("Einsum", "[Tensor]") {
+    auto a = Tensor<int>::iota({2, 3, 4});
+    auto b = Tensor<int>::iota({2, 4, 5});
+
+    SECTION("Batched matmul") {
+        auto c = einsum("bij,bjk->bik", a, b);
+        REQUIRE(c.shape() == IndexType{2, 3, 5});
+        for (SizeType i = 0; i < 2; ++i) {
+            auto expected = matmul(a.select(0, i), b.select(0, i));
+            for (SizeType r = 0; r < 3; ++r) {
+                for (SizeType col = 0; col < 5; ++col) {
+                    REQUIRE(c(i, r, col) == expected(r, col));
+                }
+            }
+        }
+        // transposed output and operand taken through permuted views
+        auto ct = einsum("bjk,bij->bki", b, a);
+        REQUIRE(ct(1, 4, 2) == c(1, 2, 4));
+    }
+
+    SECTION("Single operand") {
+        auto m = Tensor<int>::iota({3, 3});
+        auto t = einsum("ij->ji", m);
+        REQUIRE(t.shape() == IndexType{3, 3});
+        REQUIRE(t(0, 2) == m(2, 0));
+        REQUIRE(t._is_contiguous());
+        REQUIRE(einsum("ii->", m)(0) == 0 + 4 + 8);
+        REQUIRE(einsum("ii->i", m)(2) == 8);
+        REQUIRE(einsum("ij->i", m)(1) == 3 + 4 + 5);
+        REQUIRE(einsum("ij", m)(1, 0) == 3);
+    }
+
+    SECTION("Vectors") {
+        auto m = Tensor<int>::iota({2, 3});
+        auto v = Tensor<int>::iota({3}, 1);
+        auto mv = einsum("ij,j->i", m, v);
+        REQUIRE(mv(0) == 0 * 1 + 1 * 2 + 2 * 3);
+        REQUIRE(mv(1) == 3 * 1 + 4 * 2 + 5 * 3);
+        auto outer = einsum("i,j->ij", v, v);
+        REQUIRE(outer.shape() == IndexType{3, 3});
+        REQUIRE(outer(1, 2) == 6);
+        REQUIRE(einsum("i,i->", v, v)(0) == 14);
+        // implicit output: labels appearing once, sorted
+        REQUIRE(einsum("ji,j", m, Tensor<int>::iota({2}, 1)).shape() == IndexType{3});
+    }
+
+    SECTION("Chains pick a cheap order") {
+        auto x = Tensor<double>::iota({64, 2}, 1);
+        auto y = Tensor<double>::iota({2, 64}, 1);
+        auto z = Tensor<double>::iota({64, 3}, 1);
+        // (x y) z costs 64*64*2 + 64*64*3 multiply-adds, x (y z) only 2*64*3 + 64*2*3
+        REQUIRE(einsum_path("ij,jk,kl->il", {x.shape(), y.shape(), z.shape()}) ==
+                EinsumExpr::Path{{1, 2}, {0, 1}});
+        auto r = einsum("ij,jk,kl->il", x, y, z);
+        auto expected = matmul(matmul(x, y), z);
+        REQUIRE(r.shape() == expected.shape());
+        for (SizeType i = 0; i < 64; ++i) {
+            for (SizeType l = 0; l < 3; ++l) {
+                REQUIRE(r(i, l) == expected(i, l));
+            }
+        }
+
+        std::vector<Tensor<double>> ops;
+        for (int i = 0; i < 10; ++i) {
+            ops.push_back(Tensor<double>::iota({2, 2}, i));
+        }
+        std::vector<const Tensor<double>*> ptrs;
+        for (const auto& op : ops) {
+            ptrs.push_back(&op);
+        }
+        auto greedy = einsum("ab,bc,cd,de,ef,fg,gh,hi,ij,jk->ak", ptrs);
+        auto serial = ops[0];
+        for (int i = 1; i < 10; ++i) {
+            serial = matmul(serial, ops[i]);
+        }
+        REQUIRE(greedy(1, 1) == serial(1, 1));
+    }
+
+    SECTION("Caches are bounded") {
+        // a new set of shapes every call, as with dynamic batch sizes
+        for (SizeType n = 1; n <= 200; ++n) {
+            REQUIRE(einsum_path("ij,jk->ik", {{n, 2}, {2, 3}}).size() == 1);
+        }
+        REQUIRE(detail::einsum_entry("ij,jk->ik")->paths.size() <= EINSUM_PATHS_MAX);
+
+        // generated subscripts: one expression per pair of labels
+        for (char x = 'a'; x <= 'z'; ++x) {
+            for (char y = 'a'; y <= 'z'; ++y) {
+                if (x != y) {
+                    (void)einsum_path(std::string{x, y, '-', '>', y, x}, {{2, 3}});
+                }
+            }
+        }
+        REQUIRE(detail::einsum_cache().entries.size() <= EINSUM_CACHE_MAX);
+
+        // evicted expressions are parsed again
+        auto t = einsum("ij->ji", a.select(0, 0));
+        REQUIRE(t(2, 1) == a(0, 1, 2));
+    }
+
+    SECTION("Errors") {
+        REQUIRE_THROWS(einsum("ij,jk->ik", a.select(0, 0), a.select(0, 0)));
+        REQUIRE_THROWS(einsum("ij->ik", a.select(0, 0)));
+        REQUIRE_THROWS(einsum("ijk,k->i", a.select(0, 0), b));
+        REQUIRE_THROWS(einsum("ij,jk->ik", a.select(0, 0)));
+        REQUIRE_THROWS(einsum("i1->i", a));
+    }
+}
+
+TEST_CASE("Decompositions", "[Tensor]") {
+    Generator gen(11);
+    auto max_diff = [](const Tensor<double>& a, const Tensor<double>& b) {
+        REQUIRE(a.shape() == b.shape());
+        double diff = 0;
+        for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+            diff = std::max(diff, std::abs(*ia - *ib));
+        }
+        return diff;
+    };
+    auto eye = [](SizeType batch, SizeType n) {
+        Tensor<double> out({batch, n, n});
+        for (SizeType b = 0; b < batch; ++b) {
+            for (SizeType i = 0; i < n; ++i) {
+                out(b, i, i) = 1.0;
+            }
+        }
+        return out;
+    };
+    // well conditioned SPD matrices M M^T + n I
+    auto spd = [&](SizeType batch, SizeType n) {
+        auto m = Tensor<double>::randn({batch, n, n}, gen);
+        return einsum("bij,bkj->bik", m, m) + eye(batch, n) * static_cast<double>(n);
+    };
+    // sizes on the unrolled, unblocked and blocked paths
+    const std::vector<std::pair<SizeType, SizeType>> cases{{6, 1}, {5, 3}, {4, 8}, {3, 20}, {1, 150}};
+
+    SECTION("Cholesky") {
+        for (const auto& [batch, n] : cases) {
+            auto a = spd(batch, n);
+            auto l = cholesky(a);
+            REQUIRE(max_diff(einsum("bij,bkj->bik", l, l), a) < 1e-9 * static_cast<double>(n));
+            if (n > 1) {
+                REQUIRE(l(0, 0, n - 1) == 0.0);
+            }
+            auto u = cholesky(a, true);
+            REQUIRE(max_diff(einsum("bji->bij", u), l) == 0.0);
+
+            auto b = Tensor<double>::randn({batch, n, 2}, gen);
+            REQUIRE(max_diff(einsum("bij,bjk->bik", a, cholesky_solve(l, b)), b) < 1e-9 * static_cast<double>(n));
+        }
+        auto indefinite = eye(2, 3);
+        indefinite(1, 2, 2) = -1.0;
+        REQUIRE_THROWS(cholesky(indefinite));
+        REQUIRE_THROWS(cholesky(Tensor<double>({2, 3})));
+    }
+
+    SECTION("LU, solve and inverse") {
+        for (const auto& [batch, n] : cases) {
+            auto a = Tensor<double>::randn({batch, n, n}, gen) + eye(batch, n);
+            auto [packed, pivots] = lu(a);
+            REQUIRE(pivots.shape() == IndexType{batch, n});
+            // P A = L U
+            auto l = eye(batch, n);
+            Tensor<double> u({batch, n, n});
+            auto pa = a.contiguous();
+            for (SizeType b = 0; b < batch; ++b) {
+                for (SizeType i = 0; i < n; ++i) {
+                    for (SizeType j = 0; j < n; ++j) {
+                        (j < i ? l : u)(b, i, j) = packed(b, i, j);
+                    }
+                    for (SizeType j = 0; j < n; ++j) {
+                        std::swap(pa(b, i, j), pa(b, pivots(b, i), j));
+                    }
+                }
+            }
+            REQUIRE(max_diff(einsum("bij,bjk->bik", l, u), pa) < 1e-9 * static_cast<double>(n));
+
+            auto rhs = Tensor<double>::randn({batch, n, 3}, gen);
+            const double tol = 1e-8 * static_cast<double>(n);
+            REQUIRE(max_diff(einsum("bij,bjk->bik", a, solve(a, rhs)), rhs) < tol);
+            REQUIRE(max_diff(einsum("bij,bjk->bik", a, lu_solve(packed, pivots, rhs)), rhs) < tol);
+            REQUIRE(max_diff(einsum("bij,bjk->bik", a, inverse(a)), eye(batch, n)) < tol);
+        }
+        // one matrix shared by a batch of right-hand sides
+        auto a = Tensor<double>::randn({4, 4}, gen) + eye(1, 4).reshape({4, 4});
+        auto rhs = Tensor<double>::randn({5, 4, 2}, gen);
+        auto x = solve(a, rhs);
+        REQUIRE(max_diff(einsum("ij,bjk->bik", a, x), rhs) < 1e-10);
+
+        Tensor<double> singular({3, 3});
+        singular(0, 0) = 1.0;
+        REQUIRE_THROWS(inverse(singular));
+        REQUIRE_THROWS(solve(singular, Tensor<double>({3, 1})));
+        REQUIRE_THROWS(solve(a, Tensor<double>({3, 1})));
+    }
+
+    SECTION("Triangular solve") {
+        for (const auto& [batch, n] : cases) {
+            auto a = Tensor<double>::randn({batch, n, n}, gen) * 0.1 + eye(batch, n);
+            auto b = Tensor<double>::randn({batch, n, 4}, gen);
+            for (const bool upper : {false, true}) {
+                auto tri = a.contiguous();
+                for (SizeType m = 0; m < batch; ++m) {
+                    for (SizeType i = 0; i < n; ++i) {
+                        for (SizeType j = 0; j < n; ++j) {
+                            if (upper ? j < i : j > i) {
+                                tri(m, i, j) = 0.0;
+                            }
+                        }
+                    }
+                }
+                auto x = solve_triangular(a, b, upper);
+                REQUIRE(max_diff(einsum("bij,bjk->bik", tri, x), b) < 1e-9 * static_cast<double>(n));
+                auto unit = solve_triangular(a, b, upper, true);
+                for (SizeType m = 0; m < batch; ++m) {
+                    for (SizeType i = 0; i < n; ++i) {
+                        tri(m, i, i) = 1.0;
+                    }
+                }
+                REQUIRE(max_diff(einsum("bij,bjk->bik", tri, unit), b) < 1e-9 * static_cast<double>(n));
+            }
+        }
+    }
+
+    SECTION("QR") {
+        for (const auto& shape : std::vector<IndexType>{{3, 5, 5}, {2, 7, 4}, {2, 3, 6}, {1, 90, 70}}) {
+            auto a = Tensor<double>::randn(shape, gen);
+            auto [q, r] = qr(a);
+            const SizeType k = std::min(shape[1], shape[2]);
+            REQUIRE(q.shape() == IndexType{shape[0], shape[1], k});
+            REQUIRE(r.shape() == IndexType{shape[0], k, shape[2]});
+            REQUIRE(max_diff(einsum("bij,bjk->bik", q, r), a) < 1e-10 * static_cast<double>(shape[1]));
+            REQUIRE(max_diff(einsum("bji,bjk->bik", q, q), eye(shape[0], k)) < 1e-12 * static_cast<double>(shape[1]));
+            REQUIRE(r(0, k - 1, 0) == 0.0);
+        }
+        // float and an exactly rank-deficient column
+        Tensor<float> f({3, 2});
+        f(0, 1) = 1.0f;
+        f(2, 1) = 2.0f;
+        auto [q, r] = qr(f);
+        REQUIRE(r(0, 0) == 0.0f);
+        REQUIRE(r(0, 1) == 1.0f);
+        REQUIRE(std::abs(std::abs(r(1, 1)) - 2.0f) < 1e-6f);
+    }
+}
+
+TEST_CASE("Join", "[Tensor]") {
+    auto a = Tensor<int>::iota({2, 3});
+    auto b = Tensor<int>::iota({2, 2}, 10);
+
+    SECTION("Cat") {
+        auto c = cat<int>({a, b}, 1);
+        REQUIRE(c.shape() == IndexType{2, 5});
+        REQUIRE(c(0, 2) == 2);
+        REQUIRE(c(0, 3) == 10);
+        REQUIRE(c(1, 0) == 3);
+        REQUIRE(c(1, 4) == 13);
+
+        // strided inputs go through the same path
+        auto rows = cat<int>({a.permute({1, 0}), a.permute({1, 0})}, 0);
+        REQUIRE(rows.shape() == IndexType{6, 2});
+        REQUIRE(rows(1, 1) == 4);
+        REQUIRE(rows(4, 0) == 1);
+
+        // a reusable output buffer
+        Tensor<int> out({4, 3}, -1);
+        cat_into<int>({a, a}, 0, out);
+        REQUIRE(out(3, 2) == 5);
+        REQUIRE_THROWS(cat_into<int>({a}, 0, out));
+        REQUIRE_THROWS(cat<int>({a, b}, 0));
+
+        auto big = Tensor<int64_t>::iota({300, 400});
+        auto joined = cat<int64_t>({big, big, big}, 1);
+        REQUIRE(joined.shape() == IndexType{300, 1200});
+        REQUIRE(joined(299, 1199) == big(299, 399));
+        REQUIRE(joined.sum() == 3 * big.sum());
+    }
+
+    SECTION("Stack") {
+        auto s = stack<int>({a, a}, 1);
+        REQUIRE(s.shape() == IndexType{2, 2, 3});
+        REQUIRE(s(1, 0, 2) == 5);
+        REQUIRE(s(1, 1, 2) == 5);
+        REQUIRE(stack<int>({a, a}, 2).shape() == IndexType{2, 3, 2});
+        REQUIRE_THROWS(stack<int>({a, b}, 0));
+    }
+
+    SECTION("Views") {
+        auto parts = split(a, 2, 1);
+        REQUIRE(parts.size() == 2);
+        REQUIRE(parts[0].shape() == IndexType{2, 2});
+        REQUIRE(parts[1].shape() == IndexType{2, 1});
+        REQUIRE(parts[1](1, 0) == 5);
+        REQUIRE(parts[1].shares_storage(a));
+
+        // writes through a view land in the original tensor
+        parts[0](1, 1) = 40;
+        REQUIRE(a(1, 1) == 40);
+        REQUIRE(parts[0].sum() == 0 + 1 + 3 + 40);
+
+        // copies of a view own just its elements
+        Tensor<int> copy = parts[1];
+        REQUIRE(!copy.shares_storage(a));
+        REQUIRE(copy.numel() == 2);
+        REQUIRE(copy(1, 0) == 5);
+
+        auto rows = chunk(a, 2, 0);
+        REQUIRE(rows.size() == 2);
+        REQUIRE(rows[1].storage_offset() == 3);
+        REQUIRE(rows[1].data() == a.data() + 3);
+        REQUIRE(*rows[1].stlbegin() == 3);
+        REQUIRE(std::distance(rows[1].stlbegin(), rows[1].stlend()) == 3);
+
+        auto sizes = split(a, IndexType{1, 2}, 1);
+        REQUIRE(sizes[1].shape() == IndexType{2, 2});
+        REQUIRE(sizes[1](0, 0) == 1);
+        REQUIRE_THROWS(split(a, IndexType{1, 1}, 1));
+
+        auto cols = unbind(a, 1);
+        REQUIRE(cols.size() == 3);
+        REQUIRE(cols[2].shape() == IndexType{2});
+        REQUIRE(cols[2](1) == 5);
+
+        // round trip
+        auto back = stack(cols, 1);
+        REQUIRE(back.shape() == a.shape());
+        REQUIRE(back(1, 1) == 40);
+    }
+}
+
+TEST_CASE("Sort", "[Tensor]") {
+    Tensor<int> ten({2, 5});
+    const std::vector<int> digits{3, 1, 4, 1, 5, 9, 2, 6, 5, 3};
+    std::copy(digits.begin(), digits.end(), ten.data());
+
+    SECTION("Sort") {
+        auto [values, indices] = sort(ten, 1);
+        REQUIRE(values.shape() == IndexType{2, 5});
+        REQUIRE(values(0, 0) == 1);
+        REQUIRE(values(0, 4) == 5);
+        REQUIRE(values(1, 0) == 2);
+        REQUIRE(values(1, 4) == 9);
+        // ties keep their original order
+        REQUIRE(indices(0, 0) == 1);
+        REQUIRE(indices(0, 1) == 3);
+
+        auto desc = argsort(ten, 1, true);
+        REQUIRE(desc(1, 0) == 0);
+        REQUIRE(desc(1, 1) == 2);
+
+        // along dim 0 of a permuted view
+        auto [cols, col_idx] = sort(ten.permute({1, 0}), 1, true);
+        REQUIRE(cols.shape() == IndexType{5, 2});
+        REQUIRE(cols(0, 0) == 9);
+        REQUIRE(cols(0, 1) == 3);
+        REQUIRE(col_idx(0, 0) == 1);
+
+        REQUIRE_THROWS(sort(ten, 2));
+    }
+
+    SECTION("Radix") {
+        // long rows take the radix path, which must agree with a comparison sort
+        Generator gen(3);
+        auto f = Tensor<float>::randn({3, 5000}, gen);
+        f(1, 17) = -0.0f;
+        f(1, 18) = 0.0f;
+        auto [fv, fi] = sort(f, 1, true);
+        for (SizeType r = 0; r < 3; ++r) {
+            std::vector<float> row;
+            for (SizeType c = 0; c < 5000; ++c) {
+                row.push_back(f(r, c));
+            }
+            std::sort(row.begin(), row.end(), std::greater<>());
+            for (SizeType c = 0; c < 5000; ++c) {
+                REQUIRE(fv(r, c) == row[c]);
+                REQUIRE(f(r, fi(r, c)) == fv(r, c));
+            }
+        }
+
+        auto n = Tensor<int64_t>::randint(-1000, 1000, {4096}, gen);
+        auto [nv, ni] = sort(n, 0);
+        for (SizeType i = 1; i < 4096; ++i) {
+            REQUIRE(nv(i - 1) <= nv(i));
+            if (nv(i - 1) == nv(i)) {
+                REQUIRE(ni(i - 1) < ni(i));
+            }
+        }
+    }
+
+    SECTION("Signed zeros and NaNs") {
+        // short rows take the comparison sort, long ones the radix sort: both order -0.0 and 0.0 as equal and all
+        // NaNs as equal and after every number (before, descending), ties by position
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const std::vector<float> pattern{nan, -0.0f, 1.0f, 0.0f, -1.0f, -nan};
+        for (const SizeType reps : {SizeType{1}, SizeType{200}}) {
+            const auto len = static_cast<SizeType>(pattern.size()) * reps;
+            Tensor<float> x({len});
+            for (SizeType i = 0; i < len; ++i) {
+                x(i) = pattern[static_cast<size_t>(i) % pattern.size()];
+            }
+            for (const bool descending : {false, true}) {
+                std::vector<int64_t> expected(static_cast<size_t>(len));
+                std::iota(expected.begin(), expected.end(), 0);
+                auto rank = [&x](int64_t i) { return std::isnan(x(i)) ? std::pair(1, 0.0f) : std::pair(0, x(i)); };
+                std::stable_sort(expected.begin(), expected.end(), [&](int64_t a, int64_t b) {
+                    return descending ? rank(b) < rank(a) : rank(a) < rank(b);
+                });
+                auto indices = argsort(x, 0, descending);
+                REQUIRE(std::equal(expected.begin(), expected.end(), indices.data()));
+                // topk keeps the same order through the insertion buffer (k <= 16) and through selection
+                for (const SizeType k : {SizeType{3}, SizeType{17}}) {
+                    if (k <= len) {
+                        auto top = topk(x, k, 0, descending).second;
+                        REQUIRE(std::equal(expected.begin(), expected.begin() + k, top.data()));
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Topk") {
+        auto [values, indices] = topk(ten, 2, 1);
+        REQUIRE(values.shape() == IndexType{2, 2});
+        REQUIRE(values(0, 0) == 5);
+        REQUIRE(values(0, 1) == 4);
+        REQUIRE(indices(1, 0) == 0);
+        REQUIRE(indices(1, 1) == 2);
+
+        auto [low, low_idx] = topk(ten, 2, 1, false);
+        REQUIRE(low(0, 0) == 1);
+        REQUIRE(low(0, 1) == 1);
+        REQUIRE(low_idx(0, 0) == 1);
+        REQUIRE(low_idx(0, 1) == 3);
+
+        // large k goes through selection instead of the insertion buffer
+        auto big = Tensor<float>::iota({100});
+        auto [bv, bi] = topk(big, 40, 0);
+        REQUIRE(bv(0) == 99.0f);
+        REQUIRE(bv(39) == 60.0f);
+        REQUIRE(bi(39) == 60);
+
+        REQUIRE_THROWS(topk(ten, 6, 1));
+    }
+
+    SECTION("Partition") {
+        auto [kv, ki] = kthvalue(ten, 2, 1);
+        REQUIRE(kv.shape() == IndexType{2});
+        REQUIRE(kv(0) == 3);
+        REQUIRE(ki(0) == 0);
+        REQUIRE(kv(1) == 5);
+
+        auto [pv, pi] = partition(ten, 2, 1);
+        REQUIRE(pv(1, 2) == 5);
+        for (SizeType i = 0; i < 5; ++i) {
+            REQUIRE(ten(1, pi(1, i)) == pv(1, i));
+            REQUIRE((i < 2 ? pv(1, i) <= 5 : pv(1, i) >= 5));
+        }
+
+        REQUIRE_THROWS(kthvalue(ten, 5, 1));
+    }
+}
+
+TEST_CASE("Checks", "[Tensor]") {
+    Tensor<int> ten = Tensor<int>::iota({3, 4});
+
+    SECTION("Arguments") {
+        if constexpr (checks_arguments) {
+            REQUIRE_THROWS(ten + Tensor<int>({4, 3}));
+            REQUIRE_THROWS(ten.narrow(1, 2, 3));
+            REQUIRE_THROWS(ten.select(2, 0));
+            REQUIRE_THROWS(ten.shape(2));
+        }
+    }
+
+    SECTION("Elements") {
+        REQUIRE(ten(2, 3) == 11);
+        REQUIRE(ten(IndexType{1, 2}) == 6);
+        if constexpr (checks_elements) {
+            REQUIRE_THROWS(ten(3, 0));
+            REQUIRE_THROWS(ten(0, -1));
+            REQUIRE_THROWS(ten(1));
+            REQUIRE_THROWS(ten(IndexType{0, 0, 0}));
+            REQUIRE_THROWS(ten.flat(12));
+            REQUIRE_THROWS(ten.flat(-1));
+        }
+    }
+}
+
+TEST_CASE("Scan", "[Tensor]") {
+    Tensor<int> ten = Tensor<int>::iota({3, 4}, 1);
+
+    SECTION("Along either dim") {
+        auto rows = cumsum(ten, 1);
+        REQUIRE(rows(0, 3) == 10);
+        REQUIRE(rows(2, 1) == 9 + 10);
+        auto cols = cumsum(ten, 0);
+        REQUIRE(cols(2, 0) == 1 + 5 + 9);
+        REQUIRE(cumprod(ten, 1)(0, 3) == 24);
+
+        // strided input
+        auto t = cumsum(ten.permute({1, 0}), 1);
+        REQUIRE(t(0, 2) == cols(2, 0));
+
+        auto bits = scan(Tensor<int>::iota({5}, 1), 0, std::bit_or<>{});
+        REQUIRE(bits(1) == 3);
+        REQUIRE(bits(3) == 7);
+        REQUIRE_THROWS(cumsum(ten, 2));
+    }
+
+    SECTION("Running extremes") {
+        Tensor<float> x({6});
+        const float vals[] = {1.0f, 3.0f, 2.0f, 3.0f, 5.0f, 0.0f};
+        std::copy(vals, vals + 6, x.data());
+        auto [values, indices] = cummax(x, 0);
+        REQUIRE(values(2) == 3.0f);
+        REQUIRE(indices(2) == 1);
+        REQUIRE(indices(3) == 3);
+        REQUIRE(values(5) == 5.0f);
+        REQUIRE(indices(5) == 4);
+        auto [lows, low_idx] = cummin(x, 0);
+        REQUIRE(lows(4) == 1.0f);
+        REQUIRE(low_idx(5) == 5);
+    }
+
+    SECTION("Long lanes") {
+        const SizeType n = SizeType{1} << 20;
+        Tensor<int64_t> ones({2, n}, 1);
+        auto sums = cumsum(ones, 1);
+        bool ok = true;
+        for (SizeType i = 0; i < n; ++i) {
+            ok = ok && sums(0, i) == i + 1 && sums(1, i) == i + 1;
+        }
+        REQUIRE(ok);
+
+        auto wave = Tensor<int64_t>::iota({n});
+        std::transform(wave.data(), wave.data() + n, wave.data(), [](int64_t i) { return (i * 7919) % 100003; });
+        auto [values, indices] = cummax(wave, 0);
+        int64_t best = -1;
+        int64_t at = -1;
+        for (SizeType i = 0; i < n; ++i) {
+            if (wave(i) >= best) {
+                best = wave(i);
+                at = i;
+            }
+            ok = ok && values(i) == best && indices(i) == at;
+        }
+        REQUIRE(ok);
+    }
+}
+
+TEST_CASE("Histogram", "[Tensor]") {
+    Tensor<int64_t> ids({8});
+    const std::vector<int64_t> digits{3, 1, 4, 1, 5, 9, 2, 6};
+    std::copy(digits.begin(), digits.end(), ids.data());
+
+    SECTION("Bincount") {
+        auto counts = bincount(ids);
+        REQUIRE(counts.shape() == IndexType{10});
+        REQUIRE(counts(1) == 2);
+        REQUIRE(counts(7) == 0);
+        REQUIRE(counts(9) == 1);
+        REQUIRE(bincount(ids, 12).numel() == 12);
+
+        Tensor<double> weights({8}, 0.5);
+        auto sums = bincount(ids, weights);
+        REQUIRE(sums(1) == 1.0);
+        REQUIRE(sums(3) == 0.5);
+
+        // strided input
+        auto grid = Tensor<int64_t>::iota({4, 3});
+        REQUIRE(bincount(grid.permute({1, 0}))(11) == 1);
+        ids(2) = -1;
+        REQUIRE_THROWS(bincount(ids));
+    }
+
+    SECTION("Histogram") {
+        Tensor<float> x({6});
+        const float vals[] = {0.0f, 0.25f, 0.5f, 0.75f, 1.0f, 2.0f};
+        std::copy(vals, vals + 6, x.data());
+        auto fixed = histogram(x, 4, 0.0, 1.0);
+        REQUIRE(fixed.shape() == IndexType{4});
+        REQUIRE(fixed(0) == 1);
+        REQUIRE(fixed(3) == 2);  // 0.75 and the upper edge; 2.0 is outside
+
+        // the range of the data
+        auto spread = histogram(x, 2);
+        REQUIRE(spread(0) == 4);
+        REQUIRE(spread(1) == 2);
+
+        Tensor<float> edges({3});
+        const float bounds[] = {0.0f, 0.5f, 2.0f};
+        std::copy(bounds, bounds + 3, edges.data());
+        auto custom = histogram(x, edges);
+        REQUIRE(custom(0) == 2);
+        REQUIRE(custom(1) == 4);
+        REQUIRE_THROWS(histogram(x, x.flip({0})));
+    }
+
+    SECTION("Searchsorted") {
+        auto seq = Tensor<int64_t>::iota({5});
+        seq(3) = 2;  // 0 1 2 2 4
+        Tensor<int64_t> values({3});
+        const int64_t queries[] = {2, 3, 9};
+        std::copy(queries, queries + 3, values.data());
+        auto left = searchsorted(seq, values);
+        REQUIRE(left(0) == 2);
+        REQUIRE(left(1) == 4);
+        REQUIRE(left(2) == 5);
+        REQUIRE(searchsorted(seq, values, true)(0) == 4);
+    }
+
+    SECTION("Unique") {
+        Tensor<float> x({5});
+        const float vals[] = {2.0f, -0.0f, 2.0f, 0.0f, -1.0f};
+        std::copy(vals, vals + 5, x.data());
+        auto [values, inverse, counts] = unique(x);
+        REQUIRE(values.shape() == IndexType{3});
+        REQUIRE(values(0) == -1.0f);
+        REQUIRE(values(1) == 0.0f);
+        REQUIRE(counts(1) == 2);
+        REQUIRE(counts(2) == 2);
+        REQUIRE(inverse(0) == 2);
+        REQUIRE(inverse(3) == 1);
+
+        // NaNs of either sign are one value, last
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        Tensor<float> y({4});
+        const float with_nans[] = {nan, 1.0f, -nan, nan};
+        std::copy(with_nans, with_nans + 4, y.data());
+        auto [y_values, y_inverse, y_counts] = unique(y);
+        REQUIRE(y_values.shape() == IndexType{2});
+        REQUIRE(y_values(0) == 1.0f);
+        REQUIRE(std::isnan(y_values(1)));
+        REQUIRE(y_counts(1) == 3);
+        REQUIRE(y_inverse(2) == 1);
+    }
+
+    SECTION("Large inputs") {
+        // long enough to be split across threads, with few bins (private histograms) and many (atomic adds)
+        const SizeType n = SizeType{1} << 20;
+        for (const int64_t distinct : {int64_t{1000}, int64_t{1000003}}) {
+            auto col = Tensor<int64_t>::iota({n});
+            std::transform(col.data(), col.data() + n, col.data(),
+                           [distinct](int64_t i) { return (i * 7919) % distinct; });
+            std::vector<int64_t> expected(static_cast<size_t>(distinct), 0);
+            for (SizeType i = 0; i < n; ++i) {
+                expected[static_cast<size_t>(col(i))]++;
+            }
+            auto counts = bincount(col);
+            REQUIRE(std::equal(expected.begin(), expected.begin() + counts.numel(), counts.data()));
+
+            auto [values, inverse, unique_counts] = unique(col);
+            const auto seen = std::count_if(expected.begin(), expected.end(), [](int64_t c) { return c > 0; });
+            REQUIRE(values.numel() == seen);
+            REQUIRE(std::is_sorted(values.data(), values.data() + values.numel()));
+            bool ok = true;
+            for (SizeType r = 0; r < values.numel(); ++r) {
+                ok = ok && unique_counts(r) == expected[static_cast<size_t>(values(r))];
+            }
+            for (SizeType i = 0; i < n; ++i) {
+                ok = ok && values(inverse(i)) == col(i);
+            }
+            REQUIRE(ok);
+
+            auto sorted = values.view();
+            auto pos = searchsorted(sorted, col, true);
+            for (SizeType i = 0; i < n; ++i) {
+                const auto* at = std::upper_bound(sorted.data(), sorted.data() + sorted.numel(), col(i));
+                ok = ok && pos(i) == at - sorted.data();
+            }
+            REQUIRE(ok);
+        }
+    }
+}
+
+TEST_CASE("Masks", "[Tensor]") {
+    Tensor<float> ten = Tensor<float>::iota({3, 4});
+
+    SECTION("Comparisons") {
+        Mask big = ten >= 6;
+        REQUIRE(big(1, 1) == 0);
+        REQUIRE(big(1, 2) == 1);
+        REQUIRE(count_nonzero(big) == 6);
+        REQUIRE(any(big));
+        REQUIRE(!all(big));
+
+        Mask same = ten == Tensor<int>::iota({3, 4});
+        REQUIRE(all(same));
+        REQUIRE(count_nonzero(ten != ten) == 0);
+        REQUIRE(count_nonzero(ten < ten.permute({1, 0}).contiguous().reshape({3, 4})) == 5);
+
+        auto odd = Tensor<int>::iota({3, 4}) > 3;
+        REQUIRE(count_nonzero(logical_and(big, odd)) == 6);
+        REQUIRE(count_nonzero(logical_or(ten < 2, big)) == 8);
+        REQUIRE(count_nonzero(logical_xor(odd, big)) == 2);
+        REQUIRE(count_nonzero(logical_not(big)) == 6);
+    }
+
+    SECTION("Selection") {
+        auto clipped = where(ten > 5, Tensor<float>(ten.shape(), 5.0f), ten);
+        REQUIRE(clipped.max() == 5.0f);
+        REQUIRE(clipped(0, 3) == 3.0f);
+
+        // strided operands
+        auto t = ten.permute({1, 0});
+        auto flipped = where(t < 4, t, -1.0f);
+        REQUIRE(flipped(3, 0) == 3.0f);
+        REQUIRE(flipped(0, 1) == -1.0f);
+
+        auto filled = masked_fill(ten, ten < 3, 100.0f);
+        REQUIRE(filled(0, 2) == 100.0f);
+        REQUIRE(ten(0, 2) == 2.0f);
+        masked_fill_(ten, ten < 1, -5.0f);
+        REQUIRE(ten(0, 0) == -5.0f);
+    }
+
+    SECTION("Bit-packed") {
+        const SizeType n = 100000;
+        auto values = Tensor<int>::iota({n});
+        auto mask = BitMask::from_predicate(values, [](int x) { return x % 3 == 0; });
+        REQUIRE(mask.nbytes() * 8 <= n + 63);
+        REQUIRE(mask.count() == (n + 2) / 3);
+        REQUIRE(mask.test(99999));
+        REQUIRE(!mask.test(99998));
+
+        auto picked = masked_select(values, mask);
+        REQUIRE(picked.numel() == mask.count());
+        bool ok = true;
+        for (SizeType i = 0; i < picked.numel(); ++i) {
+            ok = ok && picked(i) == 3 * i;
+        }
+        REQUIRE(ok);
+
+        auto inverse = ~mask;
+        REQUIRE(inverse.count() == n - mask.count());
+        REQUIRE((inverse & mask).count() == 0);
+        REQUIRE((inverse | mask).all());
+        REQUIRE(BitMask::from_mask(mask.to_mask()).count() == mask.count());
+
+        mask.set(1, true);
+        REQUIRE(masked_select(values, mask)(1) == 1);
+        REQUIRE(masked_select(ten, ten >= 10).numel() == 2);
+    }
+}
+
+template <typename A, typename B>
+concept CanAdd = requires(A a, B b) { a + b; };
+
+template <typename A, typename B>
+concept CanMatmul = requires(A a, B b) { matmul(a, b); };
+
+template <typename A>
+concept CanIndexOnce = requires(A a) { a(0); };
+
+TEST_CASE("Static tensor", "[Tensor]") {
+    SECTION("Constant evaluation") {
+        constexpr StaticTensor<int, 2, 3> a{1, 2, 3, 4, 5, 6};
+        constexpr auto b = StaticTensor<int, 2, 3>::full(2);
+        constexpr auto c = a * b + a;
+        static_assert(c(1, 2) == 18);
+        static_assert(c.sum() == 63);
+        static_assert(StaticTensor<int, 2, 3, 4>::static_strides[0] == 12);
+        static_assert(tt::calc_strides({2, 3, 4})[0] == 12);
+
+        constexpr auto squares = StaticTensor<int, 16>::generate([](SizeType i) { return static_cast<int>(i * i); });
+        static_assert(squares(15) == 225);
+
+        constexpr auto m = matmul(a, transpose(a));
+        static_assert(std::is_same_v<std::remove_const_t<decltype(m)>, StaticTensor<int, 2, 2>>);
+        static_assert(m(0, 1) == 32 && m(1, 1) == 77);
+        REQUIRE(m(1, 0) == 32);
+    }
+
+    SECTION("Shape mismatches do not compile") {
+        using A = StaticTensor<float, 2, 3>;
+        using B = StaticTensor<float, 3, 2>;
+        STATIC_REQUIRE(CanAdd<A, A>);
+        STATIC_REQUIRE(!CanAdd<A, B>);
+        STATIC_REQUIRE(CanMatmul<A, B>);
+        STATIC_REQUIRE(!CanMatmul<A, A>);
+        STATIC_REQUIRE(!CanIndexOnce<A>);
+    }
+
+    SECTION("Conversion") {
+        auto t = StaticTensor<float, 2, 2>::iota(1.0f).to_tensor();
+        REQUIRE(t.shape() == IndexType{2, 2});
+        REQUIRE(t(1, 0) == 3.0f);
+        t(1, 0) = 7.0f;
+        auto s = StaticTensor<float, 2, 2>::from_tensor(t);
+        REQUIRE(s(1, 0) == 7.0f);
+        REQUIRE_THROWS(StaticTensor<float, 4>::from_tensor(t));
+    }
+
+    SECTION("Checks") {
+        auto s = StaticTensor<int, 2, 3>::iota(0);
+        REQUIRE(s(1, 2) == 5);
+        if constexpr (checks_arguments) {
+            REQUIRE_THROWS(s.shape(2));
+        }
+        if constexpr (checks_elements) {
+            REQUIRE_THROWS(s(2, 0));
+            REQUIRE_THROWS(s(0, -1));
+            REQUIRE_THROWS(s.flat(6));
+            REQUIRE_THROWS(std::as_const(s).flat(-1));
+        }
+    }
+}
+
+TEST_CASE("Batching", "[Tensor]") {
+    SECTION("Queue") {
+        MpscQueue<int> queue(4);
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(queue.try_push(i));
+        }
+        int extra = 4;
+        REQUIRE(!queue.try_push(extra));
+        REQUIRE(*queue.try_pop() == 0);
+        REQUIRE(queue.try_push(extra));
+        for (int i = 1; i <= 4; ++i) {
+            REQUIRE(*queue.try_pop() == i);
+        }
+        REQUIRE(queue.empty());
+        REQUIRE(!queue.try_pop());
+        REQUIRE_THROWS(MpscQueue<int>(6));
+    }
+
+    SECTION("Producers") {
+        BatcherOptions options;
+        options.max_batch_size = 8;
+        options.max_delay = std::chrono::microseconds(200);
+        options.queue_capacity = 16;
+        DynamicBatcher<float> batcher({3}, [](const Tensor<float>& batch) { return batch + batch; }, options);
+
+        constexpr int producers = 4;
+        constexpr int per_producer = 50;
+        std::vector<std::vector<std::future<Tensor<float>>>> futures(producers);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < per_producer; ++i) {
+                    futures[p].push_back(batcher.submit(Tensor<float>({3}, static_cast<float>(p * 1000 + i))));
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (int p = 0; p < producers; ++p) {
+            for (int i = 0; i < per_producer; ++i) {
+                auto row = futures[p][i].get();
+                REQUIRE(row.shape() == IndexType{3});
+                REQUIRE(row(2) == 2.0f * static_cast<float>(p * 1000 + i));
+            }
+        }
+        REQUIRE(batcher.batches_run() >= producers * per_producer / 8);
+        REQUIRE_THROWS(batcher.submit(Tensor<float>({4})));
+    }
+
+    SECTION("Deadline and errors") {
+        BatcherOptions options;
+        options.max_batch_size = 64;
+        options.max_delay = std::chrono::microseconds(500);
+        // an identity function must not hand out views of the reused batch buffer
+        DynamicBatcher<int> identity({2}, [](const Tensor<int>& batch) { return batch; }, options);
+        auto first = identity.submit(Tensor<int>({2}, 7)).get();
+        auto second = identity.submit(Tensor<int>({2}, 9)).get();
+        REQUIRE(first(0) == 7);
+        REQUIRE(second(1) == 9);
+
+        DynamicBatcher<int> failing({2}, [](const Tensor<int>&) -> Tensor<int> { throw std::runtime_error("boom"); },
+                                    options);
+        auto result = failing.submit(Tensor<int>({2}, 1));
+        REQUIRE_THROWS(result.get());
+    }
+
+    SECTION("No lost wakeups") {
+        // single-sample batches: the worker goes to sleep with no deadline after every request, so a wakeup lost
+        // between a producer's push and the worker's sleep leaves a request queued forever
+        BatcherOptions options;
+        options.max_batch_size = 1;
+        DynamicBatcher<int> batcher({1}, [](const Tensor<int>& batch) { return batch; }, options);
+
+        constexpr int producers = 8;
+        constexpr int per_producer = 2000;
+        std::atomic<int> completed{0};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < per_producer; ++i) {
+                    auto future = batcher.submit(Tensor<int>({1}, p * per_producer + i));
+                    if (future.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+                        return;
+                    }
+                    if (future.get()(0) == p * per_producer + i) {
+                        completed++;
+                    }
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        REQUIRE(completed.load() == producers * per_producer);
+    }
+}
+
+namespace {
+    auto async_pipeline(Tensor<float> a, Tensor<float> b) -> Task<float> {
+        auto sum = co_await async_add(a, b);
+        auto prod = co_await async_mul(sum, b);
+        co_return co_await async_sum(prod);
+    }
+}  // namespace
+
+TEST_CASE("Async", "[Tensor]") {
+    Executor ex(3);
+
+    SECTION("Coroutines") {
+        auto a = Tensor<float>::iota({2, 3});
+        Tensor<float> b({2, 3}, 2.0f);
+        // (a + 2) * 2 summed
+        REQUIRE(async_pipeline(a, b).get() == 54.0f);
+
+        auto rows = async_sum(a, 1, ex).get();
+        REQUIRE(rows(1) == 12.0f);
+        REQUIRE(async_mean(a, ex).get() == 2.5f);
+        REQUIRE_THROWS(async_add(a, Tensor<float>({3, 2}), ex));
+    }
+
+    SECTION("Dependencies") {
+        Tensor<int> x({100000}, 0);
+        Tensor<int> y({100000}, 0);
+        // each in-place update must see the previous one; reads are ordered after the writes they follow
+        std::vector<Task<int>> sums;
+        for (int i = 0; i < 20; ++i) {
+            async_map_(x, [](int v) { return v + 1; }, ex);
+            sums.push_back(async_sum(x, ex));
+        }
+        async_copy(x, y, ex);
+        async_map_(x, [](int v) { return v * 0; }, ex);
+        auto y_sum = async_sum(y, ex);
+        auto x_sum = async_sum(x, ex);
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(sums[i].get() == (i + 1) * 100000);
+        }
+        REQUIRE(y_sum.get() == 20 * 100000);
+        REQUIRE(x_sum.get() == 0);
+
+        // views share the buffer, so they are ordered with the tensor they view
+        auto half = x.narrow(0, 0, 50000);
+        async_map_(half, [](int v) { return v + 2; }, ex);
+        REQUIRE(async_sum(x, ex).get() == 100000);
+    }
+
+    SECTION("IO") {
+        const auto path = (std::filesystem::temp_directory_path() / "tinyten_async_test.bin").string();
+        auto a = Tensor<double>::iota({4, 5});
+        auto saved = async_save(a.permute({1, 0}), path, ex);
+        Tensor<double> b({5, 4});
+        saved.get();
+        async_load(path, b, 0, ex).get();
+        REQUIRE(b(0, 1) == 5.0);
+        REQUIRE(b(4, 3) == 19.0);
+
+        Tensor<double> tail({2});
+        async_load(path, tail, 18 * sizeof(double), ex).get();
+        REQUIRE(tail(0) == b.flat(18));
+        REQUIRE(tail(1) == b.flat(19));
+        std::filesystem::remove(path);
+
+        REQUIRE_THROWS(async_load(path, b, 0, ex).get());
+    }
+}
+
+TEST_CASE("Autograd", "[Tensor]") {
+    using namespace tt::autograd;
+
+    auto x0 = Tensor<double>::iota({2, 3}, 0.1);
+    auto w0 = Tensor<double>::iota({3, 3}, -0.4);
+    std::transform(w0.begin(), w0.end(), w0.begin(), [](double v) { return v / 4.0; });
+
+    // f(x, w) = mean(sin(x) * (x @ w) / (cos(x) + 2)) + sum(reshape(permute(x)))
+    auto f = [](Tape<double>& tape, Var<double> x, Var<double> w) {
+        auto two = tape.leaf(Tensor<double>(x.value().shape(), 2.0), false);
+        auto y = sin(x) * matmul(x, w) / (cos(x) + two);
+        return mean(y) + sum(sum(reshape(permute(x, {1, 0}), {6, 1}), 1));
+    };
+
+    auto numeric_grad = [&](Tensor<double> x, Tensor<double> w, bool wrt_x) {
+        Tensor<double>& p = wrt_x ? x : w;
+        Tensor<double> grad(p.shape());
+        const double eps = 1e-6;
+        for (SizeType i = 0; i < p.numel(); i++) {
+            Tape<double> tape;
+            double orig = p.flat(i);
+            p.flat(i) = orig + eps;
+            double hi = f(tape, tape.leaf(x), tape.leaf(w)).value().flat(0);
+            tape.reset();
+            p.flat(i) = orig - eps;
+            double lo = f(tape, tape.leaf(x), tape.leaf(w)).value().flat(0);
+            p.flat(i) = orig;
+            grad.flat(i) = (hi - lo) / (2 * eps);
+        }
+        return grad;
+    };
+
+    auto gx = numeric_grad(x0, w0, true);
+    auto gw = numeric_grad(x0, w0, false);
+
+    SECTION("Gradients match finite differences") {
+        Tape<double> tape;
+        // run twice to exercise buffer reuse after reset
+        for (int iter = 0; iter < 2; iter++) {
+            tape.reset();
+            auto x = tape.leaf(x0);
+            auto w = tape.leaf(w0);
+            auto out = f(tape, x, w);
+            tape.backward(out);
+
+            for (SizeType i = 0; i < gx.numel(); i++) {
+                REQUIRE_THAT(x.grad().flat(i), Catch::Matchers::WithinAbs(gx.flat(i), 1e-6));
+            }
+            for (SizeType i = 0; i < gw.numel(); i++) {
+                REQUIRE_THAT(w.grad().flat(i), Catch::Matchers::WithinAbs(gw.flat(i), 1e-6));
+            }
+        }
+    }
+
+    SECTION("Checkpointed gradients match") {
+        Tape<double> tape;
+        auto x = tape.leaf(x0);
+        auto w = tape.leaf(w0);
+        auto out = tape.checkpoint(
+            [&f](Tape<double>& t, const std::vector<Var<double>>& in) { return f(t, in[0], in[1]); }, {x, w});
+        auto loss = tan(out);
+        // intermediate values are released by backward(), so read it first
+        const double scale = 1.0 + std::pow(std::tan(out.value().flat(0)), 2);
+        tape.backward(loss);
+
+        for (SizeType i = 0; i < gx.numel(); i++) {
+            REQUIRE_THAT(x.grad().flat(i), Catch::Matchers::WithinAbs(gx.flat(i) * scale, 1e-5));
+        }
+        for (SizeType i = 0; i < gw.numel(); i++) {
+            REQUIRE_THAT(w.grad().flat(i), Catch::Matchers::WithinAbs(gw.flat(i) * scale, 1e-5));
+        }
+    }
+
+    SECTION("Constants have no gradient") {
+        Tape<double> tape;
+        auto x = tape.leaf(x0, false);
+        auto out = sum(sin(x));
+        REQUIRE_THROWS(tape.backward(out));
+    }
+
+    SECTION("Non-square matmul") {
+        // d sum(A B) / dA[i][k] is the sum of row k of B, and / dB[k][j] the sum of column k of A
+        Tape<double> tape;
+        auto a0 = Tensor<double>::iota({3, 4}, 0.5);
+        auto b0 = Tensor<double>::iota({4, 5}, -2.0);
+        auto a = tape.leaf(a0);
+        auto b = tape.leaf(b0);
+        tape.backward(sum(matmul(a, b)));
+        for (SizeType i = 0; i < 3; i++) {
+            for (SizeType k = 0; k < 4; k++) {
+                double row = 0.0;
+                for (SizeType j = 0; j < 5; j++) {
+                    row += b0(k, j);
+                }
+                REQUIRE_THAT(a.grad()(i, k), Catch::Matchers::WithinAbs(row, 1e-12));
+            }
+        }
+        for (SizeType k = 0; k < 4; k++) {
+            double col = 0.0;
+            for (SizeType i = 0; i < 3; i++) {
+                col += a0(i, k);
+            }
+            for (SizeType j = 0; j < 5; j++) {
+                REQUIRE_THAT(b.grad()(k, j), Catch::Matchers::WithinAbs(col, 1e-12));
+            }
+        }
+    }
+
+    SECTION("Backward twice") {
+        Tape<double> tape;
+        auto x = tape.leaf(x0);
+        auto y = sin(x) * x;
+        auto loss = sum(y);
+        tape.backward(loss);
+        const Tensor<double> first = x.grad();
+
+        // the intermediate values are gone: a second pass is rejected before any gradient changes
+        REQUIRE_THROWS(tape.backward(loss));
+        REQUIRE_THROWS(y.value());
+        REQUIRE(x.value().numel() == x0.numel());
+        REQUIRE(loss.value().numel() == 1);
+        for (SizeType i = 0; i < first.numel(); i++) {
+            REQUIRE(x.grad().flat(i) == first.flat(i));
+        }
+    }
+}
+
+TEST_CASE("Sparse", "[Tensor]") {
+    // 0 1 0 0
+    // 0 0 0 0
+    // 2 0 3 0
+    Tensor<float> dense({3, 4});
+    dense(0, 1) = 1.0f;
+    dense(2, 0) = 2.0f;
+    dense(2, 2) = 3.0f;
+
+    SECTION("CSR round trip") {
+        auto csr = SparseCSR<float>::from_dense(dense);
+        REQUIRE(csr.nnz() == 3);
+        REQUIRE(csr.crow_indices().data()[1] == 1);
+        REQUIRE(csr.crow_indices().data()[2] == 1);
+        REQUIRE(csr.col_indices().data()[2] == 2);
+
+        auto back = csr.to_dense();
+        for (SizeType i = 0; i < dense.numel(); i++) {
+            REQUIRE(back.flat(i) == dense.flat(i));
+        }
+
+        // from a strided (transposed) view
+        auto csr_t = SparseCSR<float>::from_dense(dense.permute({1, 0}));
+        REQUIRE(csr_t.shape() == IndexType{4, 3});
+        REQUIRE(csr_t.to_dense()(2, 2) == 3.0f);
+        REQUIRE(csr_t.to_dense()(1, 0) == 1.0f);
+    }
+
+    SECTION("COO round trip and coalesce") {
+        auto coo = SparseCOO<float>::from_dense(dense);
+        REQUIRE(coo.nnz() == 3);
+        REQUIRE(coo.sum() == 6.0f);
+
+        Tensor<int64_t> indices({2, 3});
+        // (2, 2), (0, 1), (2, 2)
+        std::vector<int64_t> idx{2, 0, 2, 2, 1, 2};
+        std::copy(idx.begin(), idx.end(), indices.data());
+        SparseCOO<float> dup({3, 4}, indices, Tensor<float>::iota({3}, 1.0f));
+
+        auto co = dup.coalesce();
+        REQUIRE(co.nnz() == 2);
+        REQUIRE(co.values().data()[0] == 2.0f);
+        REQUIRE(co.values().data()[1] == 4.0f);
+        REQUIRE(dup.to_dense()(2, 2) == 4.0f);
+
+        auto csr = dup.to_csr();
+        REQUIRE(csr.nnz() == 2);
+        REQUIRE(csr.to_dense()(0, 1) == 2.0f);
+        REQUIRE(csr.to_coo().to_dense()(2, 2) == 4.0f);
+
+        REQUIRE_THROWS(SparseCOO<float>({3, 4}, indices, Tensor<float>({2})));
+    }
+
+    SECTION("Elementwise ops keep sparsity") {
+        auto csr = SparseCSR<float>::from_dense(dense);
+
+        auto scaled = csr * 2.0f;
+        REQUIRE(scaled.nnz() == 3);
+        REQUIRE(scaled.to_dense()(2, 2) == 6.0f);
+
+        auto prod = csr * Tensor<float>::iota({3, 4});
+        REQUIRE(prod.nnz() == 3);
+        REQUIRE(prod.to_dense()(2, 2) == 30.0f);
+
+        Tensor<float> other({3, 4});
+        other(2, 2) = -3.0f;
+        other(1, 3) = 5.0f;
+        auto sum = csr + SparseCSR<float>::from_dense(other);
+        REQUIRE(sum.nnz() == 4);
+        REQUIRE(sum.to_dense()(2, 2) == 0.0f);
+        REQUIRE(sum.to_dense()(1, 3) == 5.0f);
+        REQUIRE(sum.to_dense()(0, 1) == 1.0f);
+    }
+
+    SECTION("Reductions skip zeros") {
+        auto csr = SparseCSR<float>::from_dense(dense);
+        REQUIRE(csr.sum() == 6.0f);
+        REQUIRE(csr.sum(1)(2) == 5.0f);
+        REQUIRE(csr.sum(0)(0) == 2.0f);
+        REQUIRE(csr.max() == 3.0f);
+        REQUIRE(csr.min() == 0.0f);
+        REQUIRE((csr * -1.0f).min() == -3.0f);
+
+        // the error names the reduction that failed
+        SparseCSR<float> empty({0, 4}, Tensor<int64_t>({1}), Tensor<int64_t>({0}), Tensor<float>({0}));
+        std::string message;
+        try {
+            (void)empty.min();
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        REQUIRE(message == "min: tensor is empty");
+        REQUIRE_THROWS(empty.max());
+    }
+
+    SECTION("SpMV and SpMM match dense matmul") {
+        auto big = Tensor<double>::randn({2000, 200});
+        std::transform(big.begin(), big.end(), big.begin(), [](double v) { return v > 1.5 ? v : 0.0; });
+        auto csr = SparseCSR<double>::from_dense(big);
+
+        auto x = Tensor<double>::randn({200, 7});
+        auto expected = matmul(big, x);
+        auto got = matmul(csr, x);
+        for (SizeType i = 0; i < expected.numel(); i++) {
+            REQUIRE_THAT(got.flat(i), Catch::Matchers::WithinAbs(expected.flat(i), 1e-9));
+        }
+
+        auto v = x.permute({1, 0}).contiguous().reshape({7 * 200});
+        auto col = Tensor<double>({200});
+        std::copy(v.data(), v.data() + 200, col.data());
+        auto y = matmul(csr, col);
+        for (SizeType i = 0; i < 2000; i++) {
+            REQUIRE_THAT(y(i), Catch::Matchers::WithinAbs(expected(i, 0), 1e-9));
+        }
+    }
+}
+
+TEST_CASE("FFT", "[Tensor]") {
+    // O(n^2) reference along the last dim of a 1-D signal
+    auto naive_dft = [](const Tensor<complex128>& x) {
+        const SizeType n = x.numel();
+        Tensor<complex128> out({n});
+        for (SizeType f = 0; f < n; ++f) {
+            complex128 acc{};
+            for (SizeType t = 0; t < n; ++t) {
+                const double angle = -2.0 * std::numbers::pi * static_cast<double>((t * f) % n) / n;
+                acc += x(t) * complex128(std::cos(angle), std::sin(angle));
+            }
+            out(f) = acc;
+        }
+        return out;
+    };
+    auto max_error = [](const auto& a, const auto& b) {
+        double err = 0.0;
+        auto it = b.begin();
+        for (const auto& v : a) {
+            err = std::max(err, static_cast<double>(std::abs(v - *it++)));
+        }
+        return err;
+    };
+    auto signal = [](const IndexType& shape) {
+        auto re = Tensor<double>::randn(shape);
+        auto im = Tensor<double>::randn(shape);
+        return to_complex(re, im);
+    };
+
+    SECTION("Matches the direct DFT") {
+        // powers of two, mixed radices, a generic radix and Bluestein lengths
+        for (SizeType n : {1, 2, 3, 4, 5, 6, 8, 12, 16, 17, 30, 49, 64, 97, 120, 1000, 1031}) {
+            auto x = signal({n});
+            auto spectrum = fft(x);
+            REQUIRE(max_error(spectrum, naive_dft(x)) < 1e-9 * static_cast<double>(n));
+            REQUIRE(max_error(ifft(spectrum), x) < 1e-12 * static_cast<double>(n));
+        }
+        REQUIRE(fft_plan<double>(1000) == fft_plan<double>(1000));
+    }
+
+    SECTION("Real transforms") {
+        for (SizeType n : {1, 2, 5, 8, 9, 18, 34, 256}) {
+            auto x = Tensor<double>::randn({n});
+            auto half = rfft(x);
+            auto full = fft(x);
+            REQUIRE(half.shape() == IndexType{n / 2 + 1});
+            REQUIRE(max_error(half, full.narrow(0, 0, n / 2 + 1)) < 1e-10 * static_cast<double>(n));
+            REQUIRE(max_error(irfft(half, n), x) < 1e-12 * static_cast<double>(n));
+
+            // the imaginary parts of the zero and (even n) Nyquist frequencies are ignored
+            half(0) += std::complex<double>(0.0, 5.0);
+            if (n % 2 == 0) {
+                half(n / 2) += std::complex<double>(0.0, 3.0);
+            }
+            REQUIRE(max_error(irfft(half, n), x) < 1e-12 * static_cast<double>(n));
+        }
+        REQUIRE_THROWS(irfft(rfft(Tensor<double>::randn({8})), 10));
+    }
+
+    SECTION("Plan cache is bounded") {
+        for (SizeType n = 1; n <= 2 * static_cast<SizeType>(FFT_PLAN_CACHE_MAX); ++n) {
+            (void)fft_plan<float>(n);
+        }
+        REQUIRE(detail::fft_plan_cache<float>().plans.size() == FFT_PLAN_CACHE_MAX);
+        // a plan still in use outlives its eviction
+        auto held = fft_plan<float>(1031);
+        for (SizeType n = 1; n <= static_cast<SizeType>(FFT_PLAN_CACHE_MAX); ++n) {
+            (void)fft_plan<float>(n);
+        }
+        REQUIRE(held->size() == 1031);
+        REQUIRE(fft_plan<float>(1031) != held);
+    }
+
+    SECTION("Along a dim and N-D") {
+        auto x = signal({6, 10, 4});
+        auto along0 = fft(x, 0);
+        for (SizeType j = 0; j < 10; ++j) {
+            auto lane = x.select(2, 1).select(1, j).contiguous();
+            auto expected = naive_dft(lane);
+            for (SizeType i = 0; i < 6; ++i) {
+                REQUIRE(std::abs(along0(i, j, 1) - expected(i)) < 1e-9);
+            }
+        }
+
+        auto all = fftn(x);
+        REQUIRE(max_error(all, fft(fft(fft(x, 0), 1), 2)) < 1e-9);
+        REQUIRE(max_error(ifftn(all), x) < 1e-12);
+
+        auto real_part = real(x);
+        auto r = rfftn(real_part);
+        REQUIRE(r.shape() == IndexType{6, 10, 3});
+        REQUIRE(max_error(r, fftn(to_complex(real_part)).narrow(2, 0, 3)) < 1e-9);
+        REQUIRE(max_error(irfftn(r, 4), real_part) < 1e-12);
+
+        // many short lanes, spread over the pool
+        auto batch = Tensor<float>::randn({512, 24});
+        auto round_trip = irfft(rfft(batch), 24);
+        REQUIRE(max_error(round_trip, batch) < 1e-5);
+    }
+
+    SECTION("Complex helpers") {
+        auto z = to_complex(Tensor<float>({2}, 3.0f), Tensor<float>({2}, 4.0f));
+        REQUIRE(abs(z)(0) == 5.0f);
+        REQUIRE(imag(conj(z))(1) == -4.0f);
+        REQUIRE(real(z)(0) == 3.0f);
+        auto sum = z + z;
+        REQUIRE(sum(1) == complex64(6.0f, 8.0f));
+    }
+}
+
+TEST_CASE("Ragged", "[Tensor]") {
+    // three sequences of 2-feature vectors, of lengths 2, 0 and 3
+    auto values = Tensor<float>::iota({5, 2});
+    auto r = RaggedTensor<float>::from_lengths({2, 0, 3}, values.view());
+
+    SECTION("Layout") {
+        REQUIRE(r.num_segments() == 3);
+        REQUIRE(r.num_rows() == 5);
+        REQUIRE(r.inner_numel() == 2);
+        REQUIRE(r.max_length() == 3);
+        REQUIRE(r.length(1) == 0);
+        REQUIRE(r.lengths()(2) == 3);
+        REQUIRE(r.segment(2).shape() == IndexType{3, 2});
+        REQUIRE(r.segment(2)(0, 1) == 5.0f);
+
+        auto packed = RaggedTensor<float>::from_tensors({values.narrow(0, 0, 2), values.narrow(0, 2, 3)});
+        REQUIRE(packed.offsets()(1) == 2);
+        REQUIRE(packed.values()(4, 1) == 9.0f);
+
+        REQUIRE_THROWS(RaggedTensor<float>::from_lengths({2, 2}, values));
+        REQUIRE_THROWS(RaggedTensor<float>::from_tensors({values, Tensor<float>({2, 3})}));
+    }
+
+    SECTION("Elementwise") {
+        auto doubled = r * 2;
+        REQUIRE(doubled.values()(4, 0) == 16.0f);
+        REQUIRE(doubled.same_layout(r));
+        auto sum = r + doubled;
+        REQUIRE(sum.values()(1, 1) == 9.0f);
+        auto promoted = r + 0.5;
+        REQUIRE(std::is_same_v<decltype(promoted), RaggedTensor<float>>);
+        auto other = RaggedTensor<float>::from_lengths({1, 1, 3}, values);
+        REQUIRE_THROWS(r + other);
+        REQUIRE(r.map([](float x) { return -x; }).values()(3, 0) == -6.0f);
+    }
+
+    SECTION("Segment reductions") {
+        auto s = segment_sum(r);
+        REQUIRE(s.shape() == IndexType{3, 2});
+        REQUIRE(s(0, 0) == 0.0f + 2.0f);
+        REQUIRE(s(1, 0) == 0.0f);
+        REQUIRE(s(2, 1) == 5.0f + 7.0f + 9.0f);
+        REQUIRE(segment_mean(r)(2, 0) == 6.0f);
+        REQUIRE(segment_max(r)(0, 1) == 3.0f);
+        REQUIRE(segment_min(r)(2, 1) == 5.0f);
+
+        // raw offsets are validated like a RaggedTensor's
+        Tensor<int64_t> offsets({4});
+        const int64_t bounds[] = {0, 4, 2, 5};
+        std::copy(bounds, bounds + 4, offsets.data());
+        REQUIRE_THROWS(segment_sum(r.values(), offsets));
+
+        // many segments of uneven length, split across the pool
+        std::vector<int64_t> lengths;
+        for (int64_t i = 0; i < 2000; ++i) {
+            lengths.push_back(i % 37);
+        }
+        const int64_t total = std::reduce(lengths.begin(), lengths.end(), int64_t{0});
+        auto big = RaggedTensor<int64_t>::from_lengths(lengths, Tensor<int64_t>({total}, 1));
+        auto counts = segment_sum(big);
+        for (int64_t i = 0; i < 2000; ++i) {
+            REQUIRE(counts(i) == i % 37);
+        }
+    }
+
+    SECTION("Padded conversion") {
+        auto [padded, mask] = r.to_padded(-1.0f);
+        REQUIRE(padded.shape() == IndexType{3, 3, 2});
+        REQUIRE(mask.shape() == IndexType{3, 3});
+        REQUIRE(padded(0, 1, 1) == 3.0f);
+        REQUIRE(padded(0, 2, 0) == -1.0f);
+        REQUIRE(padded(1, 0, 0) == -1.0f);
+        REQUIRE(padded(2, 2, 1) == 9.0f);
+        REQUIRE(count_nonzero(mask) == 5);
+
+        auto back = RaggedTensor<float>::from_padded(padded, mask);
+        REQUIRE(back.same_layout(r));
+        REQUIRE(back.values()(4, 1) == 9.0f);
+        auto by_length = RaggedTensor<float>::from_padded(padded, std::vector<int64_t>{1, 0, 2});
+        REQUIRE(by_length.num_rows() == 3);
+        REQUIRE(by_length.values()(2, 0) == 6.0f);
+    }
+}
+
+TEST_CASE("Blocked layouts", "[Tensor]") {
+    // small integers keep every sum exact
+    auto values = [](IndexType shape) {
+        return Tensor<double>::iota(std::move(shape)).map([](double x) { return std::fmod(x, 7.0) - 3.0; });
+    };
+    auto same = [](const Tensor<double>& a, const Tensor<double>& b) {
+        return a.shape() == b.shape() && std::equal(a.begin(), a.end(), b.begin());
+    };
+    // C = 10 is not a multiple of the block, so the last block is padded
+    auto plain = values({2, 10, 5, 6});
+    auto x = BlockedTensor<double>::from_tensor(plain, {1, 4});
+
+    SECTION("Reorder") {
+        REQUIRE(x.storage().shape() == IndexType{2, 3, 5, 6, 4});
+        REQUIRE(x(1, 9, 4, 5) == plain(1, 9, 4, 5));
+        REQUIRE(x(0, 5, 2, 3) == x.storage()(0, 1, 2, 3, 1));
+        REQUIRE(x.storage()(0, 2, 0, 0, 3) == 0.0);
+        REQUIRE(same(x.to_tensor(), plain));
+        auto narrowed = plain.narrow(3, 1, 4);
+        REQUIRE(same(BlockedTensor<double>::from_tensor(narrowed, {1, 4}).to_tensor(), narrowed.contiguous()));
+        REQUIRE_THROWS(x(0, 10, 0, 0));
+
+        // blocking a middle dim of a rank-3 tensor
+        auto t = values({3, 5, 2});
+        REQUIRE(same(BlockedTensor<double>::from_tensor(t, {2, 8}).to_tensor(), t));
+        REQUIRE_THROWS(BlockedTensor<double>(IndexType{3, 5}, BlockedLayout{2, 8}));
+    }
+
+    SECTION("Elementwise and reductions") {
+        auto y = x + x * 2.0;
+        REQUIRE(same(y.to_tensor(), plain * 3.0));
+        REQUIRE(y.storage()(1, 2, 4, 5, 2) == 0.0);
+        auto shifted = x + 5.0;
+        REQUIRE(shifted.storage()(1, 2, 4, 5, 3) == 0.0);
+        REQUIRE(shifted.sum() == (plain + 5.0).sum());
+        REQUIRE(x.sum() == plain.sum());
+        REQUIRE(x.max() == plain.max());
+        // the padding zeros must not be picked up as the maximum
+        REQUIRE((x - 10.0).max() == plain.max() - 10.0);
+        REQUIRE((x + 10.0).min() == plain.min() + 10.0);
+        REQUIRE(same(x.sum(2).to_tensor(), plain.sum(2)));
+        REQUIRE(x.sum(0).layout().dim == 0);
+        REQUIRE(same(x.sum_blocked_dim(), plain.sum(1)));
+        REQUIRE_THROWS(x.sum(1));
+        REQUIRE_THROWS(x + BlockedTensor<double>::from_tensor(plain, {1, 8}));
+
+        // the error names the reduction that failed
+        auto empty = BlockedTensor<double>::from_tensor(Tensor<double>({0, 4, 1, 1}), {1, 4});
+        std::string message;
+        try {
+            (void)empty.min();
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        REQUIRE(message == "min: tensor is empty");
+    }
+
+    SECTION("Convolution and pooling") {
+        auto w = values({6, 10, 3, 3});
+        auto bias = Tensor<double>::iota({6});
+        for (const Conv2dOptions& opts : {Conv2dOptions{}, Conv2dOptions{{2, 1}, {1, 2}, {1, 2}, 1}}) {
+            auto packed = PackedConv2dWeight<double>::from_tensor(w, 4);
+            auto out = conv2d(x, packed, bias, opts);
+            REQUIRE(out.layout() == BlockedLayout{1, 4});
+            REQUIRE(same(out.to_tensor(), conv2d(plain, w, bias, opts)));
+            REQUIRE(out.storage()(0, 1, 0, 0, 3) == 0.0);
+            REQUIRE(same(conv2d(x, w, opts).to_tensor(), conv2d(plain, w, opts)));
+        }
+        REQUIRE_THROWS(conv2d(x, values({6, 8, 3, 3})));
+        REQUIRE_THROWS(conv2d(x, values({6, 5, 3, 3}), {{1, 1}, {0, 0}, {1, 1}, 2}));
+
+        const Pool2dOptions pool{{3, 3}, {2, 2}, {1, 1}, {1, 1}};
+        REQUIRE(same(max_pool2d(x, pool).to_tensor(), max_pool2d(plain, pool)));
+        REQUIRE(same(avg_pool2d(x).to_tensor(), avg_pool2d(plain)));
+
+        // every tap of the only window is padding
+        const Pool2dOptions empty_window{{1, 2}, {1, 1}, {0, 1}, {1, 2}};
+        auto lone = BlockedTensor<double>::from_tensor(Tensor<double>({1, 3, 1, 1}, 5.0), {1, 4});
+        REQUIRE_THROWS(avg_pool2d(lone, empty_window));
+        REQUIRE_THROWS(max_pool2d(lone, empty_window));
+    }
+}
+
+TEST_CASE("Convolution", "[Tensor]") {
+    // straightforward reference implementation
+    auto reference = [](const Tensor<double>& in, const Tensor<double>& w, const Conv2dOptions& o) {
+        const SizeType N = in.shape(0), C = in.shape(1), H = in.shape(2), W = in.shape(3);
+        const SizeType K = w.shape(0), KH = w.shape(2), KW = w.shape(3);
+        const SizeType Cg = C / o.groups, Kg = K / o.groups;
+        const SizeType OH = (H + 2 * o.padding[0] - o.dilation[0] * (KH - 1) - 1) / o.stride[0] + 1;
+        const SizeType OW = (W + 2 * o.padding[1] - o.dilation[1] * (KW - 1) - 1) / o.stride[1] + 1;
+        Tensor<double> out({N, K, OH, OW});
+        for (auto& idx : out.shape_iter()) {
+            const SizeType n = idx[0], k = idx[1], oh = idx[2], ow = idx[3];
+            double acc = 0;
+            for (SizeType c = 0; c < Cg; c++) {
+                for (SizeType kh = 0; kh < KH; kh++) {
+                    for (SizeType kw = 0; kw < KW; kw++) {
+                        SizeType ih = oh * o.stride[0] - o.padding[0] + kh * o.dilation[0];
+                        SizeType iw = ow * o.stride[1] - o.padding[1] + kw * o.dilation[1];
+                        if (ih >= 0 && ih < H && iw >= 0 && iw < W) {
+                            acc += in(n, (k / Kg) * Cg + c, ih, iw) * w(k, c, kh, kw);
+                        }
+                    }
+                }
+            }
+            out(idx) = acc;
+        }
+        return out;
+    };
+
+    auto check = [&](IndexType in_shape, IndexType w_shape, Conv2dOptions opts) {
+        auto in = Tensor<double>::randn(in_shape);
+        auto w = Tensor<double>::randn(w_shape);
+        auto expected = reference(in, w, opts);
+        for (auto algo : {ConvAlgorithm::Auto, ConvAlgorithm::Im2col, ConvAlgorithm::Direct}) {
+            auto got = conv2d(in, w, opts, algo);
+            REQUIRE(got.shape() == expected.shape());
+            for (SizeType i = 0; i < got.numel(); i++) {
+                REQUIRE_THAT(got.flat(i), Catch::Matchers::WithinAbs(expected.flat(i), 1e-9));
+            }
+        }
+    };
+
+    SECTION("Plain") {
+        check({2, 3, 9, 8}, {4, 3, 3, 3}, {});
+    }
+    SECTION("Stride, padding and dilation") {
+        check({2, 3, 11, 10}, {5, 3, 3, 2}, {{2, 3}, {1, 2}, {2, 1}, 1});
+    }
+    SECTION("Groups") {
+        check({3, 4, 7, 7}, {6, 2, 3, 3}, {{1, 1}, {1, 1}, {1, 1}, 2});
+    }
+    SECTION("Depthwise") {
+        check({1, 4, 6, 6}, {4, 1, 3, 3}, {{1, 1}, {1, 1}, {1, 1}, 4});
+    }
+    SECTION("Pointwise") {
+        check({2, 8, 5, 5}, {3, 8, 1, 1}, {});
+    }
+
+    SECTION("Bias and 1-D") {
+        auto in = Tensor<float>::iota({1, 1, 5});
+        Tensor<float> w({1, 1, 2}, 1.0f);
+        auto out = conv1d(in, w, 1, 1);
+        REQUIRE(out.shape() == IndexType{1, 1, 6});
+        REQUIRE(out(0, 0, 0) == 0.0f);
+        REQUIRE(out(0, 0, 1) == 1.0f);
+        REQUIRE(out(0, 0, 4) == 7.0f);
+        REQUIRE(out(0, 0, 5) == 4.0f);
+
+        auto in2 = Tensor<float>::iota({1, 1, 2, 2});
+        Tensor<float> w2({2, 1, 1, 1}, 2.0f);
+        auto out2 = conv2d(in2, w2, Tensor<float>::iota({2}, 10.0f));
+        REQUIRE(out2(0, 0, 1, 1) == 16.0f);
+        REQUIRE(out2(0, 1, 1, 1) == 17.0f);
+    }
+
+    SECTION("Invalid arguments") {
+        auto in = Tensor<float>({1, 3, 4, 4});
+        REQUIRE_THROWS(conv2d(in, Tensor<float>({2, 2, 3, 3})));
+        REQUIRE_THROWS(conv2d(in, Tensor<float>({2, 3, 5, 5})));
+        REQUIRE_THROWS(conv2d(in, Tensor<float>({2, 3, 3, 3}), {{1, 1}, {0, 0}, {1, 1}, 2}));
+    }
+}
+
+TEST_CASE("Pooling", "[Tensor]") {
+    auto in = Tensor<float>::iota({1, 2, 4, 4});
+
+    auto mx = max_pool2d(in);
+    REQUIRE(mx.shape() == IndexType{1, 2, 2, 2});
+    REQUIRE(mx(0, 0, 0, 0) == 5.0f);
+    REQUIRE(mx(0, 0, 1, 1) == 15.0f);
+    REQUIRE(mx(0, 1, 0, 1) == 23.0f);
+
+    auto avg = avg_pool2d(in, {{3, 3}, {1, 1}, {1, 1}});
+    REQUIRE(avg.shape() == IndexType{1, 2, 4, 4});
+    REQUIRE(avg(0, 0, 0, 0) == (0.0f + 1 + 4 + 5) / 4);
+    REQUIRE(avg(0, 0, 1, 1) == 5.0f);
+
+    auto seq = Tensor<float>::iota({1, 1, 6});
+    auto mx1 = max_pool1d(seq, 3, 3);
+    REQUIRE(mx1.shape() == IndexType{1, 1, 2});
+    REQUIRE(mx1(0, 0, 1) == 5.0f);
+    REQUIRE(avg_pool1d(seq, 2, 2)(0, 0, 2) == 4.5f);
+
+    // both taps of the only window are padding (dilation 2 skips the single column): rejected by both pools
+    const Pool2dOptions empty_window{{1, 2}, {1, 1}, {0, 1}, {1, 2}};
+    REQUIRE_THROWS(avg_pool2d(Tensor<float>({1, 1, 1, 1}, 5.0f), empty_window));
+    REQUIRE_THROWS(max_pool2d(Tensor<float>({1, 1, 1, 1}, 5.0f), empty_window));
+    REQUIRE_THROWS(avg_pool2d(Tensor<int>({1, 1, 1, 1}, 5), empty_window));
+    // a dilated window can also straddle the input (taps at -1 and 2 of two columns); windows that reach it are fine
+    REQUIRE_THROWS(max_pool2d(Tensor<float>({1, 1, 1, 2}), {{1, 2}, {1, 1}, {0, 1}, {1, 3}}));
+    auto edges = max_pool2d(Tensor<float>::iota({1, 1, 3, 3}), {{2, 2}, {1, 1}, {1, 1}, {2, 2}});
+    REQUIRE(edges.shape() == IndexType{1, 1, 3, 3});
+    REQUIRE(edges(0, 0, 0, 0) == 4.0f);
+}
+
+TEST_CASE("Numa", "[Tensor]") {
+    REQUIRE(numa_num_nodes() >= 1);
+    REQUIRE(detail::parse_node_list("0-1,3") == 3);
+    REQUIRE(detail::parse_node_list("0") == 0);
+
+    SECTION("Allocation") {
+        // large buffers are mapped and first-touched by the pool, small ones come from operator new; both start zeroed
+        Tensor<float> big({1024, 1024});
+        Tensor<float> small({3, 3});
+        REQUIRE(big.max() == 0.0f);
+        REQUIRE(big.min() == 0.0f);
+        REQUIRE(small.sum() == 0.0f);
+        REQUIRE(reinterpret_cast<uintptr_t>(small.data()) % 64 == 0);
+
+        Tensor<int> filled({1 << 20}, 7);
+        REQUIRE(filled.sum() == 7 << 20);
+        auto copy = filled;
+        REQUIRE(copy.flat((1 << 20) - 1) == 7);
+    }
+
+    SECTION("Policies") {
+        // without several nodes the policies fall back to plain first touch
+        const auto previous = get_numa_policy();
+        set_numa_policy({NumaPolicy::Interleave});
+        Tensor<double> interleaved({512, 1024}, 1.0);
+        set_numa_policy({NumaPolicy::Bind, 0});
+        Tensor<double> bound({512, 1024}, 2.0);
+        set_numa_policy({NumaPolicy::Bind, 1 << 20});
+        Tensor<double> invalid({512, 1024}, 3.0);
+        set_numa_policy(previous);
+
+        REQUIRE(interleaved.sum() == 512.0 * 1024.0);
+        REQUIRE(bound.flat(12345) == 2.0);
+        REQUIRE(invalid.flat(54321) == 3.0);
+        REQUIRE(Allocator<float>(NumaPolicy{NumaPolicy::Bind, 0}).policy().kind == NumaPolicy::Bind);
+    }
+
+    SECTION("Huge pages and pooling") {
+        StorageOptions options;
+        options.huge_pages = true;
+        options.lock = true;
+        options.pooled = true;
+
+        const float* first = nullptr;
+        {
+            Tensor<float> a({1024, 1024}, options);
+            REQUIRE(a.storage_options() == options);
+            REQUIRE(a.sum() == 0.0f);
+            a(3, 4) = 5.0f;
+            first = a.data();
+            // copies keep the backing of the tensor they copy
+            auto b = a;
+            REQUIRE(b.storage_options() == options);
+            REQUIRE(b(3, 4) == 5.0f);
+        }
+        REQUIRE(region_cache_bytes() >= 2 * sizeof(float) * 1024 * 1024);
+
+        // a buffer of the same size and options reuses a cached region, zeroed again
+        Tensor<float> c({1024, 1024}, options);
+        REQUIRE((c.data() == first || region_cache_bytes() > 0));
+        REQUIRE(c(3, 4) == 0.0f);
+
+        // globally selected options apply to tensors created afterwards
+        const auto previous = get_storage_options();
+        set_storage_options(options);
+        Tensor<double> d({1 << 19});
+        set_storage_options(previous);
+        REQUIRE(d.storage_options().huge_pages);
+        REQUIRE(!Tensor<double>({1 << 19}).storage_options().pooled);
+
+        clear_region_cache();
+        REQUIRE(region_cache_bytes() == 0);
+    }
+
+    SECTION("Pinning") {
+        set_thread_pinning(true);
+        REQUIRE(thread_pool().pinned());
+        Tensor<float> big({2048, 1024});
+        REQUIRE(big.sum() == 0.0f);
+        set_thread_pinning(false);
+        REQUIRE(!thread_pool().pinned());
+    }
+}
+
+TEST_CASE("Shared memory", "[Tensor]") {
+    SECTION("Handles") {
+        std::string name;
+        {
+            auto t = to_shared(Tensor<float>::iota({3, 4}));
+            REQUIRE(is_shared(t));
+            REQUIRE(t(2, 1) == 9.0f);
+
+            // a transposed view travels as text and is opened in place over a second mapping
+            auto transposed = t.view();
+            transposed.permute_({1, 0});
+            auto handle = SharedTensorHandle::from_string(share(transposed).to_string());
+            name = handle.name;
+            auto v = open_shared<float>(handle);
+            REQUIRE(v.shape() == IndexType{4, 3});
+            REQUIRE(v(1, 2) == 9.0f);
+            v(0, 0) = 42.0f;
+            REQUIRE(t(0, 0) == 42.0f);
+
+            // copies are private
+            auto copy = t;
+            REQUIRE(!is_shared(copy));
+            copy(0, 0) = 1.0f;
+            REQUIRE(v(0, 0) == 42.0f);
+
+            auto second = share(t.select(0, 1));
+            REQUIRE_THROWS(open_shared<double>(second));
+            DynTensor dyn = open_shared(second);
+            REQUIRE(dyn.dtype() == DType::Float32);
+            REQUIRE(dyn.as<float>()(3) == 7.0f);
+
+            release_shared(share(t));
+            REQUIRE_THROWS(share(Tensor<float>({2})));
+            REQUIRE_THROWS(SharedTensorHandle::from_string("name 3"));
+        }
+        // the last reference unlinked the segment
+        REQUIRE_THROWS(open_shared<float>(SharedTensorHandle{name, DType::Float32, {1}, {1}, 0}));
+    }
+
+#if defined(__linux__)
+    SECTION("Across processes") {
+        auto t = shared_tensor<int32_t>({64});
+        const auto handle = share(t).to_string();
+        const pid_t pid = fork();
+        if (pid == 0) {
+            {
+                auto child = open_shared<int32_t>(SharedTensorHandle::from_string(handle));
+                for (int32_t i = 0; i < 64; ++i) {
+                    child(i) = 2 * i;
+                }
+            }
+            // _exit skips destructors, so the child's reference is dropped above
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(t(63) == 126);
+    }
+#endif
+
+    SECTION("Pool") {
+        SharedTensorPool<int32_t> pool({4, 2}, 2);
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        REQUIRE(a.shape() == IndexType{4, 2});
+        REQUIRE(a.data() != b.data());
+        REQUIRE(!pool.try_acquire());
+
+        // a handle in flight keeps its slot busy until it is opened and dropped
+        a(3, 1) = 5;
+        auto handle = share(a);
+        a = Tensor<int32_t>();
+        REQUIRE(!pool.try_acquire());
+        REQUIRE(open_shared<int32_t>(handle)(3, 1) == 5);
+        auto recycled = pool.try_acquire();
+        REQUIRE(recycled);
+        REQUIRE((*recycled)(3, 1) == 5);
+
+        std::thread consumer([&b] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            b = Tensor<int32_t>();
+        });
+        auto c = pool.acquire();
+        consumer.join();
+        REQUIRE(c.numel() == 8);
+    }
+}
+
+TEST_CASE("Memory accounting", "[Tensor]") {
+    SECTION("Usage per backend and tag") {
+        const auto total = memory_usage().current;
+        const auto heap = memory_usage(StorageBackend::Heap).current;
+        const auto mapped = memory_usage(StorageBackend::Mapped).current;
+        {
+            MemoryScope scope("decode");
+            Tensor<float> small({256});
+            Tensor<float> big({1024, 1024});
+            REQUIRE(memory_usage(StorageBackend::Heap).current == heap + 1024);
+            REQUIRE(memory_usage(StorageBackend::Mapped).current == mapped + 4 * 1024 * 1024);
+            REQUIRE(memory_usage("decode").current == 1024 + 4 * 1024 * 1024);
+            REQUIRE(memory_usage("decode").buffers == 2);
+            {
+                MemoryScope inner("resize");
+                Tensor<double> resized({8});
+                REQUIRE(memory_usage("decode/resize").current == 64);
+            }
+            REQUIRE(memory_usage("decode/resize").current == 0);
+            REQUIRE(memory_usage("decode/resize").peak == 64);
+        }
+        REQUIRE(memory_usage("decode").current == 0);
+        REQUIRE(memory_usage("decode").peak == 1024 + 4 * 1024 * 1024);
+        REQUIRE(memory_usage().current == total);
+        REQUIRE(memory_usage().peak >= total + 1024 + 4 * 1024 * 1024);
+        reset_peak_memory();
+        REQUIRE(memory_usage("decode").peak == 0);
+    }
+
+    SECTION("Budget") {
+        const size_t base = memory_usage().current;
+        std::optional<Tensor<float>> cache = Tensor<float>({1024});
+        size_t calls = 0;
+        set_memory_budget({base + 6000, base + 12000, [&](size_t, size_t) {
+                               ++calls;
+                               cache.reset();
+                           }});
+        // crossing the soft limit evicts the cache
+        Tensor<float> a({1024});
+        REQUIRE(calls == 1);
+        REQUIRE(!cache);
+        Tensor<float> b({1024});
+        REQUIRE(calls == 2);
+        // nothing left to evict: the hard limit fails the allocation cleanly
+        REQUIRE_THROWS_AS(Tensor<float>({1024}), MemoryBudgetExceeded);
+        REQUIRE(calls == 3);
+        REQUIRE(memory_usage().current == base + 8192);
+
+        set_memory_budget({0, base + 100, {}});
+        REQUIRE_THROWS_AS(Tensor<float>({1024}), std::bad_alloc);
+        set_memory_budget({});
+        REQUIRE(Tensor<float>({1024}).numel() == 1024);
+    }
+
+    SECTION("Snapshot") {
+        set_memory_tracking(true);
+        {
+            MemoryScope scope("batch");
+            Tensor<int16_t> t({3, 5});
+            auto snapshot = memory_snapshot();
+            auto it = std::find_if(snapshot.begin(), snapshot.end(),
+                                   [&t](const LiveAllocation& a) { return a.ptr == t.data(); });
+            REQUIRE(it != snapshot.end());
+            REQUIRE(it->shape == IndexType{3, 5});
+            REQUIRE(it->bytes == 30);
+            REQUIRE(it->element_size == 2);
+            REQUIRE(it->backend == StorageBackend::Heap);
+            REQUIRE(it->tag == "batch");
+            REQUIRE(it->site.find("main.cpp") != std::string::npos);
+
+            std::ostringstream out;
+            dump_memory(out);
+            REQUIRE(out.str().find("[3, 5] x2 tag batch") != std::string::npos);
+        }
+        auto snapshot = memory_snapshot();
+        REQUIRE(std::none_of(snapshot.begin(), snapshot.end(),
+                             [](const LiveAllocation& a) { return a.tag == "batch"; }));
+        set_memory_tracking(false);
+        REQUIRE(memory_snapshot().empty());
+    }
+
+#if defined(__linux__)
+    SECTION("Region cache and shared segments") {
+        clear_region_cache();
+        const size_t big = 4 * 1024 * 1024;
+        StorageOptions pooled;
+        pooled.pooled = true;
+        { Tensor<float> parked({1024, 1024}, pooled); }
+        REQUIRE(region_cache_bytes() == big);
+        REQUIRE(resident_memory() == memory_usage().current + big);
+
+        // the parked mapping counts against the budget and is unmapped before on_pressure is asked for memory
+        size_t calls = 0;
+        set_memory_budget({0, resident_memory() + big / 2, [&](size_t, size_t) { ++calls; }});
+        { Tensor<float> fresh({1024, 1024}); }
+        REQUIRE(calls == 0);
+        REQUIRE(region_cache_bytes() == 0);
+        REQUIRE(resident_memory() == memory_usage().current);
+        set_memory_budget({});
+
+        // two buffers over one segment: the segment is charged once, until the last of them is gone
+        const auto before = memory_usage(StorageBackend::Shared);
+        {
+            auto first = shared_tensor<float>({1024});
+            Tensor<float> second({1024}, first.storage_options());
+            REQUIRE(second.data() == first.data());
+            REQUIRE(memory_usage(StorageBackend::Shared).current == before.current + 4096);
+            REQUIRE(memory_usage(StorageBackend::Shared).buffers == before.buffers + 2);
+            first = Tensor<float>();
+            REQUIRE(memory_usage(StorageBackend::Shared).current == before.current + 4096);
+        }
+        REQUIRE(memory_usage(StorageBackend::Shared).current == before.current);
+        REQUIRE(memory_usage(StorageBackend::Shared).buffers == before.buffers);
+    }
+#endif
+}
+
+TEST_CASE("Random", "[Tensor]") {
+    SECTION("Philox known answers") {
+        auto zero = Philox4x32::generate({0, 0, 0, 0}, {0, 0});
+        REQUIRE(zero == Philox4x32::Counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+
+        auto ones = Philox4x32::generate({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff});
+        REQUIRE(ones == Philox4x32::Counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+
+        auto pi = Philox4x32::generate({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+        REQUIRE(pi == Philox4x32::Counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+        // the batched generator agrees with the scalar one
+        uint32_t bits[4][8];
+        Philox4x32::generate_blocks<8>(5, 0, {7, 9}, bits);
+        auto fifth = Philox4x32::generate({5, 0, 0, 0}, {7, 9});
+        REQUIRE(bits[0][0] == fifth[0]);
+        REQUIRE(bits[3][0] == fifth[3]);
+    }
+
+    SECTION("Reproducible regardless of thread count") {
+        auto threads = get_num_threads();
+        Generator gen(42);
+        set_num_threads(1);
+        auto a = Tensor<float>::randn({1000, 37}, gen);
+        gen.manual_seed(42);
+        set_num_threads(4);
+        auto b = Tensor<float>::randn({1000, 37}, gen);
+        set_num_threads(threads);
+        for (SizeType i = 0; i < a.numel(); i++) {
+            REQUIRE(a.flat(i) == b.flat(i));
+        }
+
+        // consecutive draws continue the stream
+        auto c = Tensor<float>::randn({1000, 37}, gen);
+        REQUIRE(c.flat(0) != b.flat(0));
+        gen.manual_seed(42);
+        gen.set_offset((1000 * 37 + 3) / 4);
+        auto d = Tensor<float>::randn({1000, 37}, gen);
+        REQUIRE(c.flat(0) == d.flat(0));
+    }
+
+    SECTION("Distributions") {
+        Generator gen(7);
+        auto u = Tensor<double>::rand({100000}, gen);
+        REQUIRE(u.min() >= 0.0);
+        REQUIRE(u.max() < 1.0);
+        REQUIRE_THAT(u.mean(), Catch::Matchers::WithinAbs(0.5, 0.01));
+
+        auto n = Tensor<float>::randn({100001}, gen);
+        auto sq = n * n;
+        REQUIRE_THAT(n.mean(), Catch::Matchers::WithinAbs(0.0, 0.02));
+        REQUIRE_THAT(sq.mean(), Catch::Matchers::WithinAbs(1.0, 0.02));
+
+        auto r = Tensor<int64_t>::randint(-3, 5, {10000}, gen);
+        REQUIRE(r.min() == -3);
+        REQUIRE(r.max() == 4);
+
+        auto m = Tensor<float>::bernoulli(0.25, {100000}, gen);
+        REQUIRE_THAT(m.mean(), Catch::Matchers::WithinAbs(0.25, 0.01));
+        REQUIRE(Tensor<float>::bernoulli(0.0, {100}, gen).max() == 0.0f);
+        REQUIRE(Tensor<float>::bernoulli(1.0, {100}, gen).min() == 1.0f);
+
+        REQUIRE_THROWS(Tensor<int>::randint(3, 3, {4}, gen));
+        REQUIRE_THROWS(Tensor<float>::bernoulli(1.5, {4}, gen));
+    }
+
+    BENCHMARK("randn 1M") {
+        return Tensor<float>::randn({1000, 1000});
+    };
+}